@@ -585,6 +585,16 @@ nxt_proto_setup(nxt_task_t *task, nxt_process_t *process)
 static nxt_int_t
 nxt_proto_start(nxt_task_t *task, nxt_process_data_t *data)
 {
+    nxt_int_t  ret;
+
+    if (nxt_app->preload != NULL) {
+        ret = nxt_app->preload(task, data);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            nxt_proto_exiting = 1;
+            return ret;
+        }
+    }
+
     nxt_debug(task, "prototype waiting for clone messages");
 
     return NXT_OK;
@@ -603,6 +613,10 @@ nxt_proto_start_process_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 
     rt = task->thread->runtime;
 
+    if (nxt_slow_path(nxt_proto_exiting)) {
+        goto failed;
+    }
+
     process = nxt_process_new(rt);
     if (nxt_slow_path(process == NULL)) {
         goto failed;
@@ -55,6 +55,7 @@ typedef struct {
     uint32_t                   threads;
     uint32_t                   thread_stack_size;
     nxt_conf_value_t           *targets;
+    uint8_t                    preload;  /* 1 bit */
 } nxt_python_app_conf_t;
 
 
@@ -160,6 +161,12 @@ struct nxt_app_module_s {
 
     nxt_application_setup_t    setup;
     nxt_process_start_t        start;
+
+    /*
+     * Called in the prototype process with the application credentials
+     * to initialize the application before processes are forked from it.
+     */
+    nxt_process_start_t        preload;
 };
 
 
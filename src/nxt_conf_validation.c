@@ -86,6 +86,22 @@ nxt_inline nxt_int_t nxt_conf_vldt_unsupported(nxt_conf_validation_t *vldt,
 
 static nxt_int_t nxt_conf_vldt_mtypes(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
+#if (NXT_HAVE_ZLIB)
+static nxt_int_t nxt_conf_vldt_gzip_level(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+#endif
+static nxt_int_t nxt_conf_vldt_compression_min_length(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_open_file_cache_number(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_cache_size(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_action_cache(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_action_cache_number(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_action_sendfile_header(
+    nxt_conf_validation_t *vldt, nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_mtypes_type(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
 static nxt_int_t nxt_conf_vldt_mtypes_extension(nxt_conf_validation_t *vldt,
@@ -176,6 +192,8 @@ static nxt_int_t nxt_conf_vldt_app_name(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_forwarded(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_accept_batch(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_app(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
 static nxt_int_t nxt_conf_vldt_object(nxt_conf_validation_t *vldt,
@@ -206,12 +224,22 @@ static nxt_int_t nxt_conf_vldt_java_option(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value);
 static nxt_int_t nxt_conf_vldt_upstream(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
+static nxt_int_t nxt_conf_vldt_upstream_balancing(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_upstream_number(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_health_check_uri(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_server(nxt_conf_validation_t *vldt,
     nxt_str_t *name, nxt_conf_value_t *value);
+static nxt_int_t nxt_conf_vldt_server_max_fails(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_server_weight(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
 static nxt_int_t nxt_conf_vldt_access_log(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
+static nxt_int_t nxt_conf_vldt_access_log_number(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data);
 
 static nxt_int_t nxt_conf_vldt_isolation(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data);
@@ -239,9 +267,18 @@ static nxt_int_t nxt_conf_vldt_js_module_element(nxt_conf_validation_t *vldt,
 
 
 static nxt_conf_vldt_object_t  nxt_conf_vldt_setting_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_health_check_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_http_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_websocket_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_static_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_open_file_cache_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_compression_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_cache_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_action_cache_members[];
+static nxt_conf_vldt_object_t  nxt_conf_vldt_action_sendfile_members[];
+#if (NXT_HAVE_ZLIB)
+static nxt_conf_vldt_object_t  nxt_conf_vldt_gzip_members[];
+#endif
 static nxt_conf_vldt_object_t  nxt_conf_vldt_forwarded_members[];
 static nxt_conf_vldt_object_t  nxt_conf_vldt_client_ip_members[];
 #if (NXT_TLS)
@@ -349,6 +386,21 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_http_members[] = {
     }, {
         .name       = nxt_string("body_temp_path"),
         .type       = NXT_CONF_VLDT_STRING,
+    }, {
+        .name       = nxt_string("body_streaming"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    }, {
+        .name       = nxt_string("http2"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+    }, {
+        .name       = nxt_string("proxy_keepalive"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+    }, {
+        .name       = nxt_string("proxy_keepalive_requests"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+    }, {
+        .name       = nxt_string("proxy_keepalive_timeout"),
+        .type       = NXT_CONF_VLDT_INTEGER,
     }, {
         .name       = nxt_string("discard_unsafe_fields"),
         .type       = NXT_CONF_VLDT_BOOLEAN,
@@ -362,6 +414,16 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_http_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object,
         .u.members  = nxt_conf_vldt_static_members,
+    }, {
+        .name       = nxt_string("compression"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_compression_members,
+    }, {
+        .name       = nxt_string("cache"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_cache_members,
     }, {
         .name       = nxt_string("log_route"),
         .type       = NXT_CONF_VLDT_BOOLEAN,
@@ -396,11 +458,94 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_static_members[] = {
         .name       = nxt_string("mime_types"),
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_mtypes,
+    }, {
+        .name       = nxt_string("open_file_cache"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_open_file_cache_members,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_open_file_cache_members[] = {
+    {
+        .name       = nxt_string("max"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_open_file_cache_number,
+        .u.string   = "max",
+    }, {
+        .name       = nxt_string("valid"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_open_file_cache_number,
+        .u.string   = "valid",
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_compression_members[] = {
+    {
+        .name       = nxt_string("gzip"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+#if (NXT_HAVE_ZLIB)
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_gzip_members,
+#else
+        .validator  = nxt_conf_vldt_unsupported,
+        .u.string   = "gzip",
+#endif
+    }, {
+        .name       = nxt_string("types"),
+        .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
+        .validator  = nxt_conf_vldt_match_patterns,
+    }, {
+        .name       = nxt_string("min_length"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_compression_min_length,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_cache_members[] = {
+    {
+        .name       = nxt_string("path"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .flags      = NXT_CONF_VLDT_REQUIRED,
+    }, {
+        .name       = nxt_string("max_size"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_cache_size,
+        .u.string   = "max_size",
+    }, {
+        .name       = nxt_string("index_size"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_cache_size,
+        .u.string   = "index_size",
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+#if (NXT_HAVE_ZLIB)
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_gzip_members[] = {
+    {
+        .name       = nxt_string("level"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_gzip_level,
     },
 
     NXT_CONF_VLDT_END
 };
 
+#endif
+
 
 static nxt_conf_vldt_object_t  nxt_conf_vldt_listener_members[] = {
     {
@@ -421,6 +566,17 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_listener_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object,
         .u.members  = nxt_conf_vldt_client_ip_members
+    }, {
+        .name       = nxt_string("accept_batch"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_accept_batch,
+    }, {
+        .name       = nxt_string("reuseport"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+#if !(NXT_HAVE_REUSEPORT)
+        .validator  = nxt_conf_vldt_unsupported,
+        .u.string   = "reuseport",
+#endif
     },
 
 #if (NXT_TLS)
@@ -498,6 +654,20 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_tls_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object,
         .u.members  = nxt_conf_vldt_session_members,
+    }, {
+        .name       = nxt_string("ktls"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+#if !(NXT_HAVE_OPENSSL_KTLS)
+        .validator  = nxt_conf_vldt_unsupported,
+        .u.string   = "ktls",
+#endif
+    }, {
+        .name       = nxt_string("handshake_offload"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+#if !(NXT_HAVE_OPENSSL_CLIENT_HELLO_CB)
+        .validator  = nxt_conf_vldt_unsupported,
+        .u.string   = "handshake_offload",
+#endif
     },
 
     NXT_CONF_VLDT_END
@@ -710,12 +880,87 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_pass_action_members[] = {
         .type       = NXT_CONF_VLDT_STRING,
         .validator  = nxt_conf_vldt_pass,
         .flags      = NXT_CONF_VLDT_TSTR,
+    }, {
+        .name       = nxt_string("cache"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_action_cache,
+    }, {
+        .name       = nxt_string("sendfile"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_action_sendfile_members,
     },
 
     NXT_CONF_VLDT_NEXT(nxt_conf_vldt_action_common_members)
 };
 
 
+static nxt_conf_vldt_object_t  nxt_conf_vldt_action_cache_members[] = {
+    {
+        .name       = nxt_string("key"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .flags      = NXT_CONF_VLDT_TSTR,
+    }, {
+        .name       = nxt_string("valid"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_action_cache_number,
+        .u.string   = "valid",
+    }, {
+        .name       = nxt_string("lock_timeout"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_action_cache_number,
+        .u.string   = "lock_timeout",
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_action_sendfile_members[] = {
+    {
+        .name       = nxt_string("header"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .validator  = nxt_conf_vldt_action_sendfile_header,
+    }, {
+        .name       = nxt_string("share"),
+        .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
+        .validator  = nxt_conf_vldt_share,
+        .flags      = NXT_CONF_VLDT_REQUIRED,
+    }, {
+        .name       = nxt_string("index"),
+        .type       = NXT_CONF_VLDT_STRING,
+    }, {
+        .name       = nxt_string("types"),
+        .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
+        .validator  = nxt_conf_vldt_match_patterns,
+    }, {
+        .name       = nxt_string("chroot"),
+        .type       = NXT_CONF_VLDT_STRING,
+#if !(NXT_HAVE_OPENAT2)
+        .validator  = nxt_conf_vldt_unsupported,
+        .u.string   = "chroot",
+#endif
+        .flags      = NXT_CONF_VLDT_TSTR,
+    }, {
+        .name       = nxt_string("follow_symlinks"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+#if !(NXT_HAVE_OPENAT2)
+        .validator  = nxt_conf_vldt_unsupported,
+        .u.string   = "follow_symlinks",
+#endif
+    }, {
+        .name       = nxt_string("traverse_mounts"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
+#if !(NXT_HAVE_OPENAT2)
+        .validator  = nxt_conf_vldt_unsupported,
+        .u.string   = "traverse_mounts",
+#endif
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
 static nxt_conf_vldt_object_t  nxt_conf_vldt_return_action_members[] = {
     {
         .name       = nxt_string("return"),
@@ -743,6 +988,9 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_share_action_members[] = {
         .name       = nxt_string("types"),
         .type       = NXT_CONF_VLDT_STRING | NXT_CONF_VLDT_ARRAY,
         .validator  = nxt_conf_vldt_match_patterns,
+    }, {
+        .name       = nxt_string("precompressed"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
     }, {
         .name       = nxt_string("fallback"),
         .type       = NXT_CONF_VLDT_OBJECT,
@@ -780,6 +1028,10 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_proxy_action_members[] = {
         .name       = nxt_string("proxy"),
         .type       = NXT_CONF_VLDT_STRING,
         .validator  = nxt_conf_vldt_proxy,
+    }, {
+        .name       = nxt_string("cache"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_action_cache,
     },
 
     NXT_CONF_VLDT_NEXT(nxt_conf_vldt_action_common_members)
@@ -822,6 +1074,9 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_python_common_members[] = {
         .name       = nxt_string("thread_stack_size"),
         .type       = NXT_CONF_VLDT_INTEGER,
         .validator  = nxt_conf_vldt_thread_stack_size,
+    }, {
+        .name       = nxt_string("preload"),
+        .type       = NXT_CONF_VLDT_BOOLEAN,
     },
 
     NXT_CONF_VLDT_NEXT(nxt_conf_vldt_common_members)
@@ -1192,6 +1447,9 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_app_processes_members[] = {
     }, {
         .name       = nxt_string("idle_timeout"),
         .type       = NXT_CONF_VLDT_INTEGER,
+    }, {
+        .name       = nxt_string("queue_time"),
+        .type       = NXT_CONF_VLDT_INTEGER,
     },
 
     NXT_CONF_VLDT_END
@@ -1365,6 +1623,50 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_members[] = {
         .type       = NXT_CONF_VLDT_OBJECT,
         .validator  = nxt_conf_vldt_object_iterator,
         .u.object   = nxt_conf_vldt_server,
+    }, {
+        .name       = nxt_string("balancing"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .validator  = nxt_conf_vldt_upstream_balancing,
+    }, {
+        .name       = nxt_string("hash"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .flags      = NXT_CONF_VLDT_TSTR,
+    }, {
+        .name       = nxt_string("health_check"),
+        .type       = NXT_CONF_VLDT_OBJECT,
+        .validator  = nxt_conf_vldt_object,
+        .u.members  = nxt_conf_vldt_upstream_health_check_members,
+    },
+
+    NXT_CONF_VLDT_END
+};
+
+
+static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_health_check_members[] = {
+    {
+        .name       = nxt_string("uri"),
+        .type       = NXT_CONF_VLDT_STRING,
+        .validator  = nxt_conf_vldt_health_check_uri,
+    }, {
+        .name       = nxt_string("interval"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_number,
+        .u.string   = "interval",
+    }, {
+        .name       = nxt_string("timeout"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_number,
+        .u.string   = "timeout",
+    }, {
+        .name       = nxt_string("passes"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_number,
+        .u.string   = "passes",
+    }, {
+        .name       = nxt_string("fails"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_number,
+        .u.string   = "fails",
     },
 
     NXT_CONF_VLDT_END
@@ -1376,6 +1678,15 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_upstream_server_members[] = {
         .name       = nxt_string("weight"),
         .type       = NXT_CONF_VLDT_NUMBER,
         .validator  = nxt_conf_vldt_server_weight,
+    }, {
+        .name       = nxt_string("max_fails"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_server_max_fails,
+    }, {
+        .name       = nxt_string("fail_timeout"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_upstream_number,
+        .u.string   = "fail_timeout",
     },
 
     NXT_CONF_VLDT_END
@@ -1393,6 +1704,16 @@ static nxt_conf_vldt_object_t  nxt_conf_vldt_access_log_members[] = {
         .name       = nxt_string("if"),
         .type       = NXT_CONF_VLDT_STRING,
         .validator  = nxt_conf_vldt_if,
+    }, {
+        .name       = nxt_string("buffer"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_access_log_number,
+        .u.string   = "buffer",
+    }, {
+        .name       = nxt_string("flush"),
+        .type       = NXT_CONF_VLDT_INTEGER,
+        .validator  = nxt_conf_vldt_access_log_number,
+        .u.string   = "flush",
     },
 
     NXT_CONF_VLDT_END
@@ -1695,6 +2016,121 @@ nxt_conf_vldt_mtypes_extension(nxt_conf_validation_t *vldt,
 }
 
 
+static nxt_int_t
+nxt_conf_vldt_open_file_cache_number(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  number;
+
+    number = nxt_conf_get_number(value);
+
+    if (number <= 0) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must be "
+                                   "greater than zero.", data);
+    }
+
+    if (number > 1000000) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must "
+                                   "not exceed 1,000,000.", data);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_cache_size(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
+    void *data)
+{
+    if (nxt_conf_get_number(value) <= 0) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must be "
+                                   "greater than zero.", data);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_action_cache(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    static nxt_str_t  path = nxt_string("/settings/http/cache");
+
+    if (nxt_conf_get_path(vldt->conf, &path) == NULL) {
+        return nxt_conf_vldt_error(vldt, "The \"cache\" action option "
+                                   "requires the \"cache\" HTTP setting.");
+    }
+
+    return nxt_conf_vldt_object(vldt, value,
+                                nxt_conf_vldt_action_cache_members);
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_action_cache_number(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    if (nxt_conf_get_number(value) < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must not "
+                                   "be negative.", data);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_action_sendfile_header(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    nxt_str_t  name;
+
+    nxt_conf_get_string(value, &name);
+
+    if (name.length == 0) {
+        return nxt_conf_vldt_error(vldt, "The \"header\" name must not "
+                                   "be empty.");
+    }
+
+    return NXT_OK;
+}
+
+
+#if (NXT_HAVE_ZLIB)
+
+static nxt_int_t
+nxt_conf_vldt_gzip_level(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
+    void *data)
+{
+    int64_t  level;
+
+    level = nxt_conf_get_number(value);
+
+    if (level < 1 || level > 9) {
+        return nxt_conf_vldt_error(vldt, "The \"gzip\" compression level "
+                                   "must be in the 1-9 range.");
+    }
+
+    return NXT_OK;
+}
+
+#endif
+
+
+static nxt_int_t
+nxt_conf_vldt_compression_min_length(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    if (nxt_conf_get_number(value) < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"min_length\" number must not "
+                                   "be negative.");
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_conf_vldt_listener(nxt_conf_validation_t *vldt, nxt_str_t *name,
     nxt_conf_value_t *value)
@@ -1723,6 +2159,28 @@ nxt_conf_vldt_listener(nxt_conf_validation_t *vldt, nxt_str_t *name,
 }
 
 
+static nxt_int_t
+nxt_conf_vldt_accept_batch(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  batch;
+
+    batch = nxt_conf_get_number(value);
+
+    if (batch < 1) {
+        return nxt_conf_vldt_error(vldt, "The \"accept_batch\" number must "
+                                   "be equal to or greater than 1.");
+    }
+
+    if (batch > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"accept_batch\" number must "
+                                   "not exceed %d.", NXT_INT32_T_MAX);
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_conf_vldt_action(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
     void *data)
@@ -2826,6 +3284,7 @@ typedef struct {
     int64_t  spare;
     int64_t  max;
     int64_t  idle_timeout;
+    int64_t  queue_time;
 } nxt_conf_vldt_processes_conf_t;
 
 
@@ -2847,6 +3306,12 @@ static nxt_conf_map_t  nxt_conf_vldt_processes_conf_map[] = {
         NXT_CONF_MAP_INT64,
         offsetof(nxt_conf_vldt_processes_conf_t, idle_timeout),
     },
+
+    {
+        nxt_string("queue_time"),
+        NXT_CONF_MAP_INT64,
+        offsetof(nxt_conf_vldt_processes_conf_t, queue_time),
+    },
 };
 
 
@@ -2882,6 +3347,7 @@ nxt_conf_vldt_processes(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
     proc.spare = 0;
     proc.max = 1;
     proc.idle_timeout = 15;
+    proc.queue_time = 0;
 
     ret = nxt_conf_map_object(vldt->pool, value,
                               nxt_conf_vldt_processes_conf_map,
@@ -2926,6 +3392,16 @@ nxt_conf_vldt_processes(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
                                    "exceed %d.", NXT_INT32_T_MAX / 1000);
     }
 
+    if (proc.queue_time < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"queue_time\" number must not "
+                                   "be negative.");
+    }
+
+    if (proc.queue_time > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"queue_time\" number must not "
+                                   "exceed %d.", NXT_INT32_T_MAX);
+    }
+
     return NXT_OK;
 }
 
@@ -3267,9 +3743,12 @@ nxt_conf_vldt_upstream(nxt_conf_validation_t *vldt, nxt_str_t *name,
     nxt_conf_value_t *value)
 {
     nxt_int_t         ret;
-    nxt_conf_value_t  *conf;
+    nxt_str_t         str;
+    nxt_conf_value_t  *conf, *hash;
 
     static nxt_str_t  servers = nxt_string("servers");
+    static nxt_str_t  balancing = nxt_string("balancing");
+    static nxt_str_t  hash_str = nxt_string("hash");
 
     ret = nxt_conf_vldt_type(vldt, name, value, NXT_CONF_VLDT_OBJECT);
 
@@ -3289,10 +3768,99 @@ nxt_conf_vldt_upstream(nxt_conf_validation_t *vldt, nxt_str_t *name,
                                    "\"servers\" object value.", name);
     }
 
+    hash = nxt_conf_get_object_member(value, &hash_str, NULL);
+    conf = nxt_conf_get_object_member(value, &balancing, NULL);
+
+    if (conf == NULL) {
+        return NXT_OK;
+    }
+
+    nxt_conf_get_string(conf, &str);
+
+    if (nxt_str_eq(&str, "hash", 4)) {
+        if (hash == NULL) {
+            return nxt_conf_vldt_error(vldt, "The \"%V\" upstream must "
+                                       "contain \"hash\" string value.", name);
+        }
+
+    } else if (hash != NULL) {
+        return nxt_conf_vldt_error(vldt, "The \"hash\" option of the \"%V\" "
+                                   "upstream requires \"hash\" balancing.",
+                                   name);
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_upstream_number(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  number;
+
+    number = nxt_conf_get_number(value);
+
+    if (number <= 0) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must be "
+                                   "greater than zero.", data);
+    }
+
+    if (number > 1000000) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must "
+                                   "not exceed 1,000,000.", data);
+    }
+
     return NXT_OK;
 }
 
 
+static nxt_int_t
+nxt_conf_vldt_health_check_uri(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    nxt_str_t  uri;
+
+    nxt_conf_get_string(value, &uri);
+
+    if (uri.length == 0 || uri.start[0] != '/') {
+        return nxt_conf_vldt_error(vldt, "The \"uri\" must start "
+                                   "with \"/\".");
+    }
+
+    if (memchr(uri.start, ' ', uri.length) != NULL
+        || memchr(uri.start, '\r', uri.length) != NULL
+        || memchr(uri.start, '\n', uri.length) != NULL)
+    {
+        return nxt_conf_vldt_error(vldt, "The \"uri\" must not contain "
+                                   "spaces or line breaks.");
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_conf_vldt_upstream_balancing(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    nxt_str_t  balancing;
+
+    nxt_conf_get_string(value, &balancing);
+
+    if (nxt_str_eq(&balancing, "round_robin", 11)
+        || nxt_str_eq(&balancing, "least_connections", 17)
+        || nxt_str_eq(&balancing, "hash", 4))
+    {
+        return NXT_OK;
+    }
+
+    return nxt_conf_vldt_error(vldt, "The \"balancing\" can either be "
+                                     "\"round_robin\", \"least_connections\", "
+                                     "or \"hash\".");
+}
+
+
 static nxt_int_t
 nxt_conf_vldt_server(nxt_conf_validation_t *vldt, nxt_str_t *name,
     nxt_conf_value_t *value)
@@ -3321,6 +3889,28 @@ nxt_conf_vldt_server(nxt_conf_validation_t *vldt, nxt_str_t *name,
 }
 
 
+static nxt_int_t
+nxt_conf_vldt_server_max_fails(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  number;
+
+    number = nxt_conf_get_number(value);
+
+    if (number < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"max_fails\" number must not "
+                                   "be negative.");
+    }
+
+    if (number > 1000000) {
+        return nxt_conf_vldt_error(vldt, "The \"max_fails\" number must "
+                                   "not exceed 1,000,000.");
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_conf_vldt_server_weight(nxt_conf_validation_t *vldt,
     nxt_conf_value_t *value, void *data)
@@ -3446,3 +4036,25 @@ nxt_conf_vldt_access_log(nxt_conf_validation_t *vldt, nxt_conf_value_t *value,
 
     return NXT_OK;
 }
+
+
+static nxt_int_t
+nxt_conf_vldt_access_log_number(nxt_conf_validation_t *vldt,
+    nxt_conf_value_t *value, void *data)
+{
+    int64_t  number;
+
+    number = nxt_conf_get_number(value);
+
+    if (number < 0) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must not "
+                                   "be negative.", data);
+    }
+
+    if (number > NXT_INT32_T_MAX) {
+        return nxt_conf_vldt_error(vldt, "The \"%s\" number must not "
+                                   "exceed %d.", data, NXT_INT32_T_MAX);
+    }
+
+    return NXT_OK;
+}
@@ -102,6 +102,9 @@ typedef struct {
     uint32_t                      batch;
     uint32_t                      count;
 
+    /* The time the listen socket has been ready since, 0 if drained. */
+    nxt_nsec_t                    pending;
+
     /* An accept() interface is cached to minimize memory accesses. */
     nxt_work_handler_t            accept;
 
@@ -161,6 +164,7 @@ struct nxt_conn_s {
     uint8_t                       block_write;  /* 1 bit */
     uint8_t                       delayed;      /* 1 bit */
     uint8_t                       idle;         /* 1 bit */
+    uint8_t                       read_ahead;   /* 1 bit */
 
 #define NXT_CONN_SENDFILE_OFF     0
 #define NXT_CONN_SENDFILE_ON      1
@@ -168,6 +172,7 @@ struct nxt_conn_s {
 
     uint8_t                       sendfile;     /* 2 bits */
     uint8_t                       tcp_nodelay;  /* 1 bit */
+    uint8_t                       http2;        /* 1 bit */
 
     nxt_queue_link_t              link;
 };
@@ -237,6 +242,8 @@ void nxt_conn_connect_error(nxt_task_t *task, void *obj, void *data);
 
 NXT_EXPORT nxt_listen_event_t *nxt_listen_event(nxt_task_t *task,
     nxt_listen_socket_t *ls);
+NXT_EXPORT nxt_listen_event_t *nxt_listen_event_socket(nxt_task_t *task,
+    nxt_listen_socket_t *ls, nxt_socket_t s);
 void nxt_conn_io_accept(nxt_task_t *task, void *obj, void *data);
 NXT_EXPORT void nxt_conn_accept(nxt_task_t *task, nxt_listen_event_t *lev,
     nxt_conn_t *c);
@@ -24,6 +24,8 @@ static void nxt_conn_listen_handler(nxt_task_t *task, void *obj,
     void *data);
 static nxt_conn_t *nxt_conn_accept_next(nxt_task_t *task,
     nxt_listen_event_t *lev);
+static nxt_nsec_t nxt_conn_accept_time(void);
+static nxt_bool_t nxt_conn_accept_backlog(nxt_listen_event_t *lev);
 static void nxt_conn_accept_close_idle(nxt_task_t *task,
     nxt_listen_event_t *lev);
 static void nxt_conn_accept_close_idle_handler(nxt_task_t *task, void *obj,
@@ -36,6 +38,14 @@ static void nxt_conn_listen_timer_handler(nxt_task_t *task, void *obj,
 
 nxt_listen_event_t *
 nxt_listen_event(nxt_task_t *task, nxt_listen_socket_t *ls)
+{
+    return nxt_listen_event_socket(task, ls, ls->socket);
+}
+
+
+nxt_listen_event_t *
+nxt_listen_event_socket(nxt_task_t *task, nxt_listen_socket_t *ls,
+    nxt_socket_t s)
 {
     nxt_listen_event_t  *lev;
     nxt_event_engine_t  *engine;
@@ -43,7 +53,7 @@ nxt_listen_event(nxt_task_t *task, nxt_listen_socket_t *ls)
     lev = nxt_zalloc(sizeof(nxt_listen_event_t));
 
     if (nxt_fast_path(lev != NULL)) {
-        lev->socket.fd = ls->socket;
+        lev->socket.fd = s;
 
         engine = task->thread->engine;
         lev->batch = engine->batch;
@@ -120,14 +130,31 @@ nxt_conn_accept_alloc(nxt_task_t *task, nxt_listen_event_t *lev)
 }
 
 
+/*
+ * Up to lev->batch connections are accepted per readiness event, zero
+ * means until the backlog is drained.  The accept work queue is processed
+ * till it is empty, so the batch is accepted in a row and then the other
+ * work queues run before the level-triggered event is reported again.
+ * The accept latency is measured only for batched listeners, the others
+ * drain the backlog without yielding.
+ */
+
 static void
 nxt_conn_listen_handler(nxt_task_t *task, void *obj, void *data)
 {
     nxt_listen_event_t  *lev;
+    nxt_event_engine_t  *engine;
 
     lev = obj;
     lev->ready = lev->batch;
 
+    engine = task->thread->engine;
+    engine->accept_events_cnt++;
+
+    if (lev->batch != 0 && lev->pending == 0) {
+        lev->pending = nxt_conn_accept_time();
+    }
+
     lev->accept(task, lev, data);
 }
 
@@ -187,6 +214,7 @@ nxt_conn_io_accept(nxt_task_t *task, void *obj, void *data)
 void
 nxt_conn_accept(nxt_task_t *task, nxt_listen_event_t *lev, nxt_conn_t *c)
 {
+    nxt_nsec_t          latency;
     nxt_conn_t          *next;
     nxt_event_engine_t  *engine;
 
@@ -200,6 +228,29 @@ nxt_conn_accept(nxt_task_t *task, nxt_listen_event_t *lev, nxt_conn_t *c)
 
     engine->accepted_conns_cnt++;
 
+    /*
+     * The latency is the time the connection could wait in the backlog
+     * while the engine was busy with other work.  The engine time is
+     * cached per poll, so the clock is read directly.
+     */
+    if (lev->pending != 0) {
+        latency = nxt_conn_accept_time() - lev->pending;
+
+        engine->accept_latency += latency;
+
+        if (latency > engine->accept_latency_max) {
+            engine->accept_latency_max = latency;
+        }
+
+        /*
+         * If the batch has drained the backlog exactly, the next readiness
+         * event is reported for a new connection only.
+         */
+        if (lev->ready == 0 && !nxt_conn_accept_backlog(lev)) {
+            lev->pending = 0;
+        }
+    }
+
     nxt_conn_idle(engine, c);
 
     c->listen = lev;
@@ -250,6 +301,30 @@ nxt_conn_accept_next(nxt_task_t *task, nxt_listen_event_t *lev)
 }
 
 
+static nxt_nsec_t
+nxt_conn_accept_time(void)
+{
+    nxt_monotonic_time_t  now;
+
+    nxt_monotonic_time(&now);
+
+    return now.monotonic;
+}
+
+
+static nxt_bool_t
+nxt_conn_accept_backlog(nxt_listen_event_t *lev)
+{
+    struct pollfd  pfd;
+
+    pfd.fd = lev->socket.fd;
+    pfd.events = POLLIN;
+    pfd.revents = 0;
+
+    return (poll(&pfd, 1, 0) == 1);
+}
+
+
 static void
 nxt_conn_accept_close_idle(nxt_task_t *task, nxt_listen_event_t *lev)
 {
@@ -327,6 +402,8 @@ nxt_conn_accept_error(nxt_task_t *task, nxt_listen_event_t *lev,
 
     case NXT_EAGAIN:
         nxt_debug(task, "%s(%d) %E", accept_syscall, lev->socket.fd, err);
+
+        lev->pending = 0;
         return;
 
     case ECONNABORTED:
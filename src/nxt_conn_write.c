@@ -198,7 +198,7 @@ nxt_conn_io_sendfile(nxt_task_t *task, nxt_sendbuf_t *sb)
     b = sb->buf;
 
     for ( ;; ) {
-        size = b->file_end - b->file_pos;
+        size = nxt_min(b->file_end - b->file_pos, (nxt_off_t) sb->limit);
 
         n = nxt_sendfile(b->file->fd, sb->socket, b->file_pos, size);
 
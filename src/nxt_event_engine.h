@@ -225,6 +225,49 @@ extern const nxt_event_interface_t  nxt_epoll_level_engine;
 #endif
 
 
+#if (NXT_HAVE_IO_URING)
+
+typedef struct nxt_io_uring_slot_s    nxt_io_uring_slot_t;
+typedef struct nxt_io_uring_accept_s  nxt_io_uring_accept_t;
+
+typedef struct {
+    int                           fd;
+    uint32_t                      sq_mask;
+    uint32_t                      sq_entries;
+    uint32_t                      sq_tail;
+    uint32_t                      cq_mask;
+
+    uint32_t                      *sq_khead;
+    uint32_t                      *sq_ktail;
+    uint32_t                      *cq_khead;
+    uint32_t                      *cq_ktail;
+
+    struct io_uring_sqe           *sqes;
+    struct io_uring_cqe           *cqes;
+
+    void                          *ring;
+    size_t                        ring_size;
+    size_t                        sqes_size;
+
+    nxt_io_uring_slot_t           *slots;
+    nxt_uint_t                    nslots;
+
+    nxt_socket_t                  *changes;
+    nxt_uint_t                    nchanges;
+    nxt_uint_t                    mchanges;
+
+    nxt_io_uring_accept_t         *zombies;
+
+    struct io_uring_buf_ring      *buf_ring;
+    u_char                        *bufs;
+    uint16_t                      buf_tail;
+} nxt_io_uring_engine_t;
+
+extern const nxt_event_interface_t  nxt_io_uring_engine;
+
+#endif
+
+
 #if (NXT_HAVE_EVENTPORT)
 
 typedef struct {
@@ -429,6 +472,9 @@ struct nxt_event_engine_s {
 #if (NXT_HAVE_EPOLL)
         nxt_epoll_engine_t     epoll;
 #endif
+#if (NXT_HAVE_IO_URING)
+        nxt_io_uring_engine_t  io_uring;
+#endif
 #if (NXT_HAVE_EVENTPORT)
         nxt_eventport_engine_t eventport;
 #endif
@@ -481,6 +527,12 @@ struct nxt_event_engine_s {
     nxt_queue_t                joints;
     nxt_queue_t                listen_connections;
     nxt_queue_t                idle_connections;
+    nxt_queue_t                idle_peers;    /* of nxt_conn_t */
+    nxt_uint_t                 idle_peers_n;
+    nxt_queue_t                app_requests;  /* of nxt_http_request_t */
+    void                       *access_log;   /* router log buffer */
+    void                       *open_file_cache;  /* router static files */
+    void                       *compress;     /* router compressors */
     nxt_array_t                *mem_cache;
 
     nxt_atomic_uint_t          accepted_conns_cnt;
@@ -488,6 +540,10 @@ struct nxt_event_engine_s {
     nxt_atomic_uint_t          closed_conns_cnt;
     nxt_atomic_uint_t          requests_cnt;
 
+    nxt_atomic_uint_t          accept_events_cnt;
+    uint64_t                   accept_latency;      /* nsec */
+    uint64_t                   accept_latency_max;  /* nsec */
+
     nxt_queue_link_t           link;
     // STUB: router link
     nxt_queue_link_t           link0;
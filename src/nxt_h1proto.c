@@ -8,6 +8,7 @@
 #include <nxt_http.h>
 #include <nxt_upstream.h>
 #include <nxt_h1proto.h>
+#include <nxt_h2proto.h>
 #include <nxt_websocket.h>
 #include <nxt_websocket_header.h>
 
@@ -42,6 +43,14 @@ static nxt_int_t nxt_h1p_websocket_version(void *ctx, nxt_http_field_t *field,
 static nxt_int_t nxt_h1p_transfer_encoding(void *ctx, nxt_http_field_t *field,
     uintptr_t data);
 static void nxt_h1p_request_body_read(nxt_task_t *task, nxt_http_request_t *r);
+static void nxt_h1p_request_body_rest_read(nxt_task_t *task,
+    nxt_http_request_t *r);
+static void nxt_h1p_conn_request_body_stream(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_h1p_conn_request_body_stream_error(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_h1p_conn_request_body_stream_timeout(nxt_task_t *task,
+    void *obj, void *data);
 static void nxt_h1p_conn_request_body_read(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_h1p_request_local_addr(nxt_task_t *task, nxt_http_request_t *r);
@@ -81,7 +90,6 @@ static void nxt_h1p_idle_response_timeout(nxt_task_t *task, void *obj,
 static nxt_msec_t nxt_h1p_idle_response_timer_value(nxt_conn_t *c,
     uintptr_t data);
 static void nxt_h1p_shutdown(nxt_task_t *task, nxt_conn_t *c);
-static void nxt_h1p_closing(nxt_task_t *task, nxt_conn_t *c);
 static void nxt_h1p_conn_ws_shutdown(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_conn_closing(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_conn_free(nxt_task_t *task, void *obj, void *data);
@@ -107,8 +115,20 @@ static void nxt_h1p_peer_error(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_peer_send_timeout(nxt_task_t *task, void *obj, void *data);
 static void nxt_h1p_peer_read_timeout(nxt_task_t *task, void *obj, void *data);
 static nxt_msec_t nxt_h1p_peer_timer_value(nxt_conn_t *c, uintptr_t data);
+static void nxt_h1p_peer_retry(nxt_http_peer_t *peer, nxt_bool_t sent);
 static void nxt_h1p_peer_close(nxt_task_t *task, nxt_http_peer_t *peer);
 static void nxt_h1p_peer_free(nxt_task_t *task, void *obj, void *data);
+static nxt_conn_t *nxt_h1p_peer_idle_get(nxt_event_engine_t *engine,
+    nxt_sockaddr_t *sa);
+static void nxt_h1p_peer_keepalive(nxt_task_t *task, nxt_http_peer_t *peer,
+    nxt_conn_t *c);
+static void nxt_h1p_peer_idle_close_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_h1p_peer_idle_timeout(nxt_task_t *task, void *obj, void *data);
+static nxt_msec_t nxt_h1p_peer_idle_timer_value(nxt_conn_t *c, uintptr_t data);
+static void nxt_h1p_peer_idle_close(nxt_task_t *task, nxt_conn_t *c);
+static nxt_int_t nxt_h1p_peer_connection(void *ctx, nxt_http_field_t *field,
+    uintptr_t data);
 static nxt_int_t nxt_h1p_peer_transfer_encoding(void *ctx,
     nxt_http_field_t *field, uintptr_t data);
 
@@ -119,6 +139,7 @@ static const nxt_conn_state_t  nxt_h1p_shutdown_state;
 static const nxt_conn_state_t  nxt_h1p_idle_state;
 static const nxt_conn_state_t  nxt_h1p_header_parse_state;
 static const nxt_conn_state_t  nxt_h1p_read_body_state;
+static const nxt_conn_state_t  nxt_h1p_read_body_stream_state;
 static const nxt_conn_state_t  nxt_h1p_request_send_state;
 static const nxt_conn_state_t  nxt_h1p_timeout_response_state;
 static const nxt_conn_state_t  nxt_h1p_keepalive_state;
@@ -130,6 +151,7 @@ static const nxt_conn_state_t  nxt_h1p_peer_header_read_state;
 static const nxt_conn_state_t  nxt_h1p_peer_header_read_timer_state;
 static const nxt_conn_state_t  nxt_h1p_peer_read_state;
 static const nxt_conn_state_t  nxt_h1p_peer_close_state;
+static const nxt_conn_state_t  nxt_h1p_peer_idle_state;
 
 
 const nxt_http_proto_table_t  nxt_http_proto[3] = {
@@ -151,7 +173,16 @@ const nxt_http_proto_table_t  nxt_http_proto[3] = {
 
         .ws_frame_start   = nxt_h1p_websocket_frame_start,
     },
-    /* NXT_HTTP_PROTO_H2      */
+    /* NXT_HTTP_PROTO_H2 */
+    {
+        .body_read        = nxt_h2p_request_body_read,
+        .local_addr       = nxt_h2p_request_local_addr,
+        .header_send      = nxt_h2p_request_header_send,
+        .send             = nxt_h2p_request_send,
+        .body_bytes_sent  = nxt_h2p_request_body_bytes_sent,
+        .discard          = nxt_h2p_request_discard,
+        .close            = nxt_h2p_request_close,
+    },
     /* NXT_HTTP_PROTO_DEVNULL */
 };
 
@@ -184,7 +215,7 @@ static nxt_http_field_proc_t           nxt_h1p_fields[] = {
 static nxt_lvlhsh_t                    nxt_h1p_peer_fields_hash;
 
 static nxt_http_field_proc_t           nxt_h1p_peer_fields[] = {
-    { nxt_string("Connection"),        &nxt_http_proxy_skip, 0 },
+    { nxt_string("Connection"),        &nxt_h1p_peer_connection, 0 },
     { nxt_string("Transfer-Encoding"), &nxt_h1p_peer_transfer_encoding, 0 },
     { nxt_string("Server"),            &nxt_http_proxy_skip, 0 },
     { nxt_string("Date"),              &nxt_http_proxy_date, 0 },
@@ -233,10 +264,12 @@ nxt_http_conn_init(nxt_task_t *task, void *obj, void *data)
     c->write_work_queue = &engine->fast_work_queue;
 
     c->read_state = &nxt_h1p_idle_state;
+    c->read_ahead = 1;
 
 #if (NXT_TLS)
     if (skcf->tls != NULL) {
         c->read_state = &nxt_http_idle_state;
+        c->read_ahead = 0;
     }
 #endif
 
@@ -452,6 +485,11 @@ nxt_h1p_conn_proto_init(nxt_task_t *task, void *obj, void *data)
 
     nxt_debug(task, "h1p conn proto init");
 
+    if (nxt_h2p_conn_test(task, c)) {
+        nxt_h2p_conn_init(task, c);
+        return;
+    }
+
     h1p = nxt_mp_zget(c->mem_pool, sizeof(nxt_h1proto_t));
     if (nxt_slow_path(h1p == NULL)) {
         nxt_h1p_closing(task, c);
@@ -495,6 +533,8 @@ nxt_h1p_conn_request_init(nxt_task_t *task, void *obj, void *data)
         r->tls = (c->u.tls != NULL);
 #endif
 
+        r->sendfile = (c->sendfile != NXT_CONN_SENDFILE_OFF);
+
         r->task = c->task;
         task = &r->task;
         c->socket.task = task;
@@ -856,16 +896,20 @@ nxt_h1p_request_body_read(nxt_task_t *task, nxt_http_request_t *r)
 {
     size_t             size, body_length, body_buffer_size, body_rest;
     ssize_t            res;
-    nxt_str_t          *tmp_path, tmp_name;
     nxt_buf_t          *in, *b;
+    nxt_bool_t         stream;
     nxt_conn_t         *c;
     nxt_h1proto_t      *h1p;
+    nxt_socket_conf_t  *skcf;
     nxt_http_status_t  status;
 
-    static const nxt_str_t tmp_name_pattern = nxt_string("/req-XXXXXXXX");
-
     h1p = r->proto.h1;
 
+    if (r->body_rest != 0) {
+        nxt_h1p_request_body_rest_read(task, r);
+        return;
+    }
+
     nxt_debug(task, "h1p request body read %O te:%d",
               r->content_length_n, h1p->transfer_encoding);
 
@@ -890,22 +934,23 @@ nxt_h1p_request_body_read(nxt_task_t *task, nxt_http_request_t *r)
 
     body_length = (size_t) r->content_length_n;
 
-    body_buffer_size = nxt_min(r->conf->socket_conf->body_buffer_size,
-                               body_length);
+    skcf = r->conf->socket_conf;
 
-    if (body_length > body_buffer_size) {
-        tmp_path = &r->conf->socket_conf->body_temp_path;
+    body_buffer_size = nxt_min(skcf->body_buffer_size, body_length);
 
-        tmp_name.length = tmp_path->length + tmp_name_pattern.length;
+    in = h1p->conn->read;
 
-        b = nxt_buf_file_alloc(r->mem_pool,
-                               body_buffer_size + sizeof(nxt_file_t)
-                               + tmp_name.length + 1, 0);
+    size = nxt_buf_mem_used_size(&in->mem);
+    size = nxt_min(size, body_length);
+
+    stream = (body_length > body_buffer_size && skcf->body_streaming);
+
+    if (body_length > body_buffer_size && !stream) {
+        b = nxt_http_request_body_file(task, r, body_buffer_size);
 
     } else {
-        /* This initialization required for CentOS 6, gcc 4.4.7. */
-        tmp_path = NULL;
-        tmp_name.length = 0;
+        /* A streamed body buffer holds the whole preread part. */
+        body_buffer_size = nxt_max(body_buffer_size, size);
 
         b = nxt_buf_mem_alloc(r->mem_pool, body_buffer_size, 0);
     }
@@ -917,46 +962,9 @@ nxt_h1p_request_body_read(nxt_task_t *task, nxt_http_request_t *r)
 
     r->body = b;
 
-    if (body_length > body_buffer_size) {
-        tmp_name.start = nxt_pointer_to(b->mem.start, sizeof(nxt_file_t));
-
-        memcpy(tmp_name.start, tmp_path->start, tmp_path->length);
-        memcpy(tmp_name.start + tmp_path->length, tmp_name_pattern.start,
-               tmp_name_pattern.length);
-        tmp_name.start[tmp_name.length] = '\0';
-
-        b->file = (nxt_file_t *) b->mem.start;
-        nxt_memzero(b->file, sizeof(nxt_file_t));
-        b->file->fd = -1;
-        b->file->size = body_length;
-
-        b->mem.start += sizeof(nxt_file_t) + tmp_name.length + 1;
-        b->mem.pos = b->mem.start;
-        b->mem.free = b->mem.start;
-
-        b->file->fd = mkstemp((char *) tmp_name.start);
-        if (nxt_slow_path(b->file->fd == -1)) {
-            nxt_alert(task, "mkstemp(%s) failed %E", tmp_name.start, nxt_errno);
-
-            status = NXT_HTTP_INTERNAL_SERVER_ERROR;
-            goto error;
-        }
-
-        nxt_debug(task, "create body tmp file \"%V\", %d",
-                  &tmp_name, b->file->fd);
-
-        unlink((char *) tmp_name.start);
-    }
-
     body_rest = body_length;
 
-    in = h1p->conn->read;
-
-    size = nxt_buf_mem_used_size(&in->mem);
-
     if (size != 0) {
-        size = nxt_min(size, body_length);
-
         if (nxt_buf_is_file(b)) {
             res = nxt_fd_write(b->file->fd, in->mem.pos, size);
             if (nxt_slow_path(res < (ssize_t) size)) {
@@ -983,6 +991,18 @@ nxt_h1p_request_body_read(nxt_task_t *task, nxt_http_request_t *r)
         h1p->nbuffers++;
 
         c = h1p->conn;
+
+        if (stream) {
+            /*
+             * The rest of the body is read when a consumer requests it
+             * either to stream it or to complete the body.
+             */
+            r->body_rest = body_rest;
+            c->read = NULL;
+
+            goto ready;
+        }
+
         c->read = b;
         c->read_state = &nxt_h1p_read_body_state;
 
@@ -1011,6 +1031,158 @@ nxt_h1p_request_body_read(nxt_task_t *task, nxt_http_request_t *r)
 }
 
 
+static void
+nxt_h1p_request_body_rest_read(nxt_task_t *task, nxt_http_request_t *r)
+{
+    size_t             size, rest;
+    ssize_t            res;
+    nxt_buf_t          *in, *b;
+    nxt_conn_t         *c;
+    nxt_h1proto_t      *h1p;
+    nxt_http_status_t  status;
+
+    h1p = r->proto.h1;
+    c = h1p->conn;
+
+    rest = (size_t) r->body_rest;
+
+    nxt_debug(task, "h1p request body rest read %uz", rest);
+
+    if (r->body_handler == NULL) {
+        /* The consumer requires the whole body in a temporary file. */
+
+        in = r->body;
+
+        b = nxt_http_request_body_file(task, r,
+                                      r->conf->socket_conf->body_buffer_size);
+        if (nxt_slow_path(b == NULL)) {
+            status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+            goto error;
+        }
+
+        r->body = b;
+        r->body_rest = 0;
+
+        size = nxt_buf_mem_used_size(&in->mem);
+
+        res = nxt_fd_write(b->file->fd, in->mem.pos, size);
+        if (nxt_slow_path(res < (ssize_t) size)) {
+            status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+            goto error;
+        }
+
+        b->file_end = size;
+
+        c->read_state = &nxt_h1p_read_body_state;
+
+    } else {
+        b = r->body;
+
+        c->read_state = &nxt_h1p_read_body_stream_state;
+    }
+
+    if (rest >= (size_t) nxt_buf_mem_size(&b->mem)) {
+        b->mem.free = b->mem.start;
+
+    } else {
+        /* This required to avoid reading next request. */
+        b->mem.free = b->mem.end - rest;
+    }
+
+    b->mem.pos = b->mem.free;
+
+    c->read = b;
+
+    nxt_conn_read(task->thread->engine, c);
+
+    return;
+
+error:
+
+    h1p->keepalive = 0;
+
+    nxt_http_request_error(task, r, status);
+}
+
+
+static const nxt_conn_state_t  nxt_h1p_read_body_stream_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h1p_conn_request_body_stream,
+    .close_handler = nxt_h1p_conn_request_body_stream_error,
+    .error_handler = nxt_h1p_conn_request_body_stream_error,
+
+    .timer_handler = nxt_h1p_conn_request_body_stream_timeout,
+    .timer_value = nxt_h1p_conn_request_timer_value,
+    .timer_data = offsetof(nxt_socket_conf_t, body_read_timeout),
+    .timer_autoreset = 1,
+};
+
+
+static void
+nxt_h1p_conn_request_body_stream(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t           *b;
+    nxt_conn_t          *c;
+    nxt_h1proto_t       *h1p;
+    nxt_http_request_t  *r;
+
+    c = obj;
+    h1p = data;
+
+    r = h1p->request;
+    b = c->read;
+
+    r->body_rest -= nxt_buf_mem_used_size(&b->mem);
+
+    nxt_debug(task, "h1p conn request body stream, rest: %O", r->body_rest);
+
+    if (r->body_rest == 0) {
+        c->read = NULL;
+    }
+
+    r->body_handler(task, r, b);
+}
+
+
+static void
+nxt_h1p_conn_request_body_stream_error(nxt_task_t *task, void *obj,
+    void *data)
+{
+    nxt_h1proto_t       *h1p;
+    nxt_http_request_t  *r;
+
+    h1p = data;
+    r = h1p->request;
+
+    if (r != NULL && r->body_handler != NULL) {
+        r->body_handler(task, r, NULL);
+    }
+
+    nxt_h1p_conn_request_error(task, obj, data);
+}
+
+
+static void
+nxt_h1p_conn_request_body_stream_timeout(nxt_task_t *task, void *obj,
+    void *data)
+{
+    nxt_conn_t          *c;
+    nxt_h1proto_t       *h1p;
+    nxt_http_request_t  *r;
+
+    c = nxt_read_timer_conn(obj);
+    h1p = c->socket.data;
+    r = h1p->request;
+
+    if (r->body_handler != NULL) {
+        r->body_handler(task, r, NULL);
+    }
+
+    nxt_h1p_conn_request_timeout(task, obj, data);
+}
+
+
 static const nxt_conn_state_t  nxt_h1p_read_body_state
     nxt_aligned(64) =
 {
@@ -1309,6 +1481,9 @@ nxt_h1p_request_header_send(nxt_task_t *task, nxt_http_request_t *r,
             }
         }
 
+        /* The rest of a streamed request body will not be read. */
+        h1p->keepalive &= (r->body_rest == 0);
+
         if (http11 ^ h1p->keepalive) {
             conn = h1p->keepalive;
         }
@@ -1705,6 +1880,10 @@ nxt_h1p_request_close(nxt_task_t *task, nxt_http_proto_t proto,
 
     h1p = proto.h1;
     h1p->keepalive &= !h1p->request->inconsistent;
+
+    /* The rest of a streamed request body has not been read. */
+    h1p->keepalive &= (h1p->request->body_rest == 0);
+
     h1p->request = NULL;
 
     nxt_router_conf_release(task, joint);
@@ -2058,7 +2237,7 @@ nxt_h1p_conn_ws_shutdown(nxt_task_t *task, void *obj, void *data)
 }
 
 
-static void
+void
 nxt_h1p_closing(nxt_task_t *task, nxt_conn_t *c)
 {
     nxt_debug(task, "h1p closing");
@@ -2147,6 +2326,8 @@ nxt_h1p_peer_connect(nxt_task_t *task, nxt_http_peer_t *peer)
     nxt_h1proto_t       *h1p;
     nxt_fd_event_t      *socket;
     nxt_work_queue_t    *wq;
+    nxt_socket_conf_t   *skcf;
+    nxt_event_engine_t  *engine;
     nxt_http_request_t  *r;
 
     nxt_debug(task, "h1p peer connect");
@@ -2154,38 +2335,66 @@ nxt_h1p_peer_connect(nxt_task_t *task, nxt_http_peer_t *peer)
     peer->status = NXT_HTTP_UNSET;
     r = peer->request;
 
-    mp = nxt_mp_create(1024, 128, 256, 32);
+    engine = task->thread->engine;
+    skcf = r->conf->socket_conf;
 
-    if (nxt_slow_path(mp == NULL)) {
-        goto fail;
-    }
+    c = NULL;
 
-    h1p = nxt_mp_zalloc(mp, sizeof(nxt_h1proto_t));
-    if (nxt_slow_path(h1p == NULL)) {
-        goto fail;
+    if (skcf->proxy_keepalive != 0) {
+        c = nxt_h1p_peer_idle_get(engine, peer->server->sockaddr);
     }
 
-    ret = nxt_http_parse_request_init(&h1p->parser, r->mem_pool);
-    if (nxt_slow_path(ret != NXT_OK)) {
-        goto fail;
-    }
+    if (c != NULL) {
+        nxt_debug(task, "h1p peer keepalive connection reused");
 
-    c = nxt_conn_create(mp, task);
-    if (nxt_slow_path(c == NULL)) {
-        goto fail;
-    }
+        h1p = c->socket.data;
 
-    c->mem_pool = mp;
-    h1p->conn = c;
+        nxt_memzero(h1p, offsetof(nxt_h1proto_t, conn));
+
+    } else {
+        mp = nxt_mp_create(1024, 128, 256, 32);
+
+        if (nxt_slow_path(mp == NULL)) {
+            goto fail;
+        }
+
+        h1p = nxt_mp_zalloc(mp, sizeof(nxt_h1proto_t));
+        if (nxt_slow_path(h1p == NULL)) {
+            goto fail;
+        }
+
+        c = nxt_conn_create(mp, task);
+        if (nxt_slow_path(c == NULL)) {
+            goto fail;
+        }
+
+        c->mem_pool = mp;
+        h1p->conn = c;
+
+        if (skcf->proxy_keepalive != 0) {
+            /* The connection can outlive the configuration. */
+            c->remote = nxt_sockaddr_copy(mp, peer->server->sockaddr);
+            if (nxt_slow_path(c->remote == NULL)) {
+                goto fail;
+            }
+
+        } else {
+            c->remote = peer->server->sockaddr;
+        }
+
+        c->socket.write_ready = 1;
+        c->write_state = &nxt_h1p_peer_connect_state;
+    }
 
     peer->proto.h1 = h1p;
     h1p->request = r;
 
     c->socket.data = peer;
-    c->remote = peer->server->sockaddr;
 
-    c->socket.write_ready = 1;
-    c->write_state = &nxt_h1p_peer_connect_state;
+    ret = nxt_http_parse_request_init(&h1p->parser, r->mem_pool);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        goto fail;
+    }
 
     /*
      * TODO: queues should be implemented via client proto interface.
@@ -2204,7 +2413,12 @@ nxt_h1p_peer_connect(nxt_task_t *task, nxt_http_peer_t *peer)
     c->write_timer.work_queue = wq;
     /* TODO END */
 
-    nxt_conn_connect(task->thread->engine, c);
+    if (h1p->requests != 0) {
+        r->state->ready_handler(task, r, peer);
+        return;
+    }
+
+    nxt_conn_connect(engine, c);
 
     return;
 
@@ -2271,12 +2485,20 @@ nxt_h1p_peer_header_send(nxt_task_t *task, nxt_http_peer_t *peer)
     nxt_str_t           target;
     nxt_buf_t           *header, *body;
     nxt_conn_t          *c;
+    nxt_h1proto_t       *h1p;
     nxt_http_field_t    *field;
+    nxt_socket_conf_t   *skcf;
     nxt_http_request_t  *r;
 
     nxt_debug(task, "h1p peer header send");
 
     r = peer->request;
+    h1p = peer->proto.h1;
+    skcf = r->conf->socket_conf;
+
+    h1p->requests++;
+    h1p->keepalive = (h1p->requests < skcf->proxy_keepalive_requests
+                      && skcf->proxy_keepalive != 0);
 
     ret = nxt_h1p_peer_request_target(r, &target);
     if (nxt_slow_path(ret != NXT_OK)) {
@@ -2308,7 +2530,10 @@ nxt_h1p_peer_header_send(nxt_task_t *task, nxt_http_peer_t *peer)
     *p++ = ' ';
     p = nxt_cpymem(p, r->target.start, r->target.length);
     p = nxt_cpymem(p, " HTTP/1.1\r\n", 11);
-    p = nxt_cpymem(p, "Connection: close\r\n", 19);
+
+    if (!h1p->keepalive) {
+        p = nxt_cpymem(p, "Connection: close\r\n", 19);
+    }
 
     nxt_list_each(field, r->fields) {
 
@@ -2325,7 +2550,7 @@ nxt_h1p_peer_header_send(nxt_task_t *task, nxt_http_peer_t *peer)
     header->mem.free = p;
     size = p - header->mem.pos;
 
-    c = peer->proto.h1->conn;
+    c = h1p->conn;
     c->write = header;
     c->write_state = &nxt_h1p_peer_header_send_state;
 
@@ -2609,16 +2834,40 @@ nxt_h1p_peer_header_read_done(nxt_task_t *task, void *obj, void *data)
 
         h1p = peer->proto.h1;
 
-        if (h1p->chunked) {
-            if (r->resp.content_length != NULL) {
-                peer->status = NXT_HTTP_BAD_GATEWAY;
-                break;
+        if (h1p->chunked && r->resp.content_length != NULL) {
+            peer->status = NXT_HTTP_BAD_GATEWAY;
+            break;
+        }
+
+        if (peer->status == NXT_HTTP_NO_CONTENT
+            || peer->status == NXT_HTTP_NOT_MODIFIED
+            || nxt_str_eq(r->method, "HEAD", 4)
+            || (!h1p->chunked && r->resp.content_length_n == 0))
+        {
+            /* The response has no body. */
+
+            if (nxt_buf_mem_used_size(&b->mem) != 0) {
+                h1p->keepalive = 0;
             }
 
+            nxt_http_proxy_buf_mem_free(task, r, b);
+
+            peer->body = nxt_http_buf_last(r);
+            peer->closed = 1;
+
+            r->state->ready_handler(task, r, peer);
+            return;
+        }
+
+        if (h1p->chunked) {
             h1p->chunked_parse.mem_pool = c->mem_pool;
 
         } else if (r->resp.content_length_n > 0) {
             h1p->remainder = r->resp.content_length_n;
+
+        } else {
+            /* The response ends when the connection is closed. */
+            h1p->keepalive = 0;
         }
 
         if (nxt_buf_mem_used_size(&b->mem) != 0) {
@@ -2674,6 +2923,10 @@ nxt_h1p_peer_header_parse(nxt_http_peer_t *peer, nxt_buf_mem_t *bm)
             return NXT_ERROR;
         }
 
+        if (p[7] == '0') {
+            peer->proto.h1->keepalive = 0;
+        }
+
         status = nxt_int_parse(&p[9], 3);
 
         if (nxt_slow_path(status < 0)) {
@@ -2766,14 +3019,27 @@ nxt_h1p_peer_body_process(nxt_task_t *task, nxt_http_peer_t *peer,
             return;
         }
 
-        if (h1p->chunked_parse.last) {
+        if (h1p->chunked_parse.done) {
             nxt_buf_chain_add(&out, nxt_http_buf_last(peer->request));
             peer->closed = 1;
+
+            if (h1p->chunked_parse.trailing) {
+                h1p->keepalive = 0;
+            }
         }
 
     } else if (h1p->remainder > 0) {
         length = nxt_buf_chain_length(out);
         h1p->remainder -= length;
+
+        if (h1p->remainder <= 0) {
+            nxt_buf_chain_add(&out, nxt_http_buf_last(peer->request));
+            peer->closed = 1;
+
+            if (h1p->remainder < 0) {
+                h1p->keepalive = 0;
+            }
+        }
     }
 
     peer->body = out;
@@ -2794,6 +3060,7 @@ nxt_h1p_peer_closed(nxt_task_t *task, void *obj, void *data)
     nxt_debug(task, "h1p peer closed");
 
     r = peer->request;
+    peer->proto.h1->keepalive = 0;
 
     if (peer->header_received) {
         peer->body = nxt_http_buf_last(r);
@@ -2803,6 +3070,8 @@ nxt_h1p_peer_closed(nxt_task_t *task, void *obj, void *data)
         r->state->ready_handler(task, r, peer);
 
     } else {
+        nxt_h1p_peer_retry(peer, 1);
+
         peer->status = NXT_HTTP_BAD_GATEWAY;
 
         r->state->error_handler(task, r, peer);
@@ -2813,13 +3082,19 @@ nxt_h1p_peer_closed(nxt_task_t *task, void *obj, void *data)
 static void
 nxt_h1p_peer_error(nxt_task_t *task, void *obj, void *data)
 {
+    nxt_conn_t          *c;
     nxt_http_peer_t     *peer;
     nxt_http_request_t  *r;
 
+    c = obj;
     peer = data;
 
     nxt_debug(task, "h1p peer error");
 
+    peer->proto.h1->keepalive = 0;
+
+    nxt_h1p_peer_retry(peer, c->write == NULL);
+
     peer->status = NXT_HTTP_BAD_GATEWAY;
 
     r = peer->request;
@@ -2845,6 +3120,7 @@ nxt_h1p_peer_send_timeout(nxt_task_t *task, void *obj, void *data)
 
     peer = c->socket.data;
     peer->status = NXT_HTTP_GATEWAY_TIMEOUT;
+    peer->proto.h1->keepalive = 0;
 
     r = peer->request;
     r->state->error_handler(task, r, peer);
@@ -2869,6 +3145,7 @@ nxt_h1p_peer_read_timeout(nxt_task_t *task, void *obj, void *data)
 
     peer = c->socket.data;
     peer->status = NXT_HTTP_GATEWAY_TIMEOUT;
+    peer->proto.h1->keepalive = 0;
 
     r = peer->request;
     r->state->error_handler(task, r, peer);
@@ -2886,13 +3163,47 @@ nxt_h1p_peer_timer_value(nxt_conn_t *c, uintptr_t data)
 }
 
 
+/*
+ * A keep-alive connection can be closed by the upstream while a request
+ * is being sent.  Then the request is sent again over another connection
+ * unless a response has been started or a non-idempotent request has been
+ * sent completely.
+ */
+
+static void
+nxt_h1p_peer_retry(nxt_http_peer_t *peer, nxt_bool_t sent)
+{
+    nxt_str_t  *method;
+
+    if (peer->proto.h1->requests < 2 || peer->status >= 0) {
+        return;
+    }
+
+    if (sent) {
+        method = peer->request->method;
+
+        if (nxt_str_eq(method, "POST", 4)
+            || nxt_str_eq(method, "PATCH", 5)
+            || nxt_str_eq(method, "LOCK", 4))
+        {
+            return;
+        }
+    }
+
+    peer->retry = 1;
+}
+
+
 static void
 nxt_h1p_peer_close(nxt_task_t *task, nxt_http_peer_t *peer)
 {
+    nxt_bool_t  keepalive;
     nxt_conn_t  *c;
 
     nxt_debug(task, "h1p peer close");
 
+    keepalive = (peer->closed && peer->proto.h1->keepalive);
+
     peer->closed = 1;
 
     c = peer->proto.h1->conn;
@@ -2901,6 +3212,13 @@ nxt_h1p_peer_close(nxt_task_t *task, nxt_http_peer_t *peer)
     c->read_timer.task = task;
     c->write_timer.task = task;
 
+    if (keepalive && c->socket.fd != -1 && !c->socket.closed
+        && c->socket.error == 0)
+    {
+        nxt_h1p_peer_keepalive(task, peer, c);
+        return;
+    }
+
     if (c->socket.fd != -1) {
         c->write_state = &nxt_h1p_peer_close_state;
 
@@ -2932,6 +3250,162 @@ nxt_h1p_peer_free(nxt_task_t *task, void *obj, void *data)
 }
 
 
+static nxt_conn_t *
+nxt_h1p_peer_idle_get(nxt_event_engine_t *engine, nxt_sockaddr_t *sa)
+{
+    nxt_conn_t  *c;
+
+    nxt_queue_each(c, &engine->idle_peers, nxt_conn_t, link) {
+
+        if (nxt_sockaddr_cmp(c->remote, sa)) {
+            nxt_queue_remove(&c->link);
+            engine->idle_peers_n--;
+
+            nxt_fd_event_block_read(engine, &c->socket);
+            nxt_timer_disable(engine, &c->read_timer);
+
+            return c;
+        }
+
+    } nxt_queue_loop;
+
+    return NULL;
+}
+
+
+/*
+ * Idle upstream connections are kept in a per-engine queue, the most
+ * recently used first.  The least recently used connection is closed
+ * if the queue is full.
+ */
+
+static void
+nxt_h1p_peer_keepalive(nxt_task_t *task, nxt_http_peer_t *peer, nxt_conn_t *c)
+{
+    nxt_conn_t          *idle;
+    nxt_h1proto_t       *h1p;
+    nxt_queue_link_t    *link;
+    nxt_socket_conf_t   *skcf;
+    nxt_event_engine_t  *engine;
+
+    nxt_debug(task, "h1p peer keepalive");
+
+    engine = task->thread->engine;
+    skcf = peer->request->conf->socket_conf;
+
+    while (engine->idle_peers_n >= skcf->proxy_keepalive) {
+        link = nxt_queue_last(&engine->idle_peers);
+        idle = nxt_queue_link_data(link, nxt_conn_t, link);
+
+        nxt_h1p_peer_idle_close(task, idle);
+    }
+
+    h1p = peer->proto.h1;
+    h1p->request = NULL;
+    h1p->idle_timeout = skcf->proxy_keepalive_timeout;
+
+    c->socket.data = h1p;
+    c->read_state = &nxt_h1p_peer_idle_state;
+    c->write_state = &nxt_h1p_peer_close_state;
+
+    nxt_queue_insert_head(&engine->idle_peers, &c->link);
+    engine->idle_peers_n++;
+
+    nxt_conn_wait(c);
+}
+
+
+static const nxt_conn_state_t  nxt_h1p_peer_idle_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h1p_peer_idle_close_handler,
+    .close_handler = nxt_h1p_peer_idle_close_handler,
+    .error_handler = nxt_h1p_peer_idle_close_handler,
+
+    .timer_handler = nxt_h1p_peer_idle_timeout,
+    .timer_value = nxt_h1p_peer_idle_timer_value,
+};
+
+
+static void
+nxt_h1p_peer_idle_close_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t  *c;
+
+    c = obj;
+
+    nxt_debug(task, "h1p peer idle close");
+
+    /* The connection may have been reused after the event was posted. */
+
+    if (c->read_state == &nxt_h1p_peer_idle_state) {
+        nxt_h1p_peer_idle_close(task, c);
+    }
+}
+
+
+static void
+nxt_h1p_peer_idle_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    nxt_debug(task, "h1p peer idle timeout");
+
+    c = nxt_read_timer_conn(timer);
+
+    nxt_h1p_peer_idle_close(task, c);
+}
+
+
+static nxt_msec_t
+nxt_h1p_peer_idle_timer_value(nxt_conn_t *c, uintptr_t data)
+{
+    nxt_h1proto_t  *h1p;
+
+    h1p = c->socket.data;
+
+    return h1p->idle_timeout;
+}
+
+
+static void
+nxt_h1p_peer_idle_close(nxt_task_t *task, nxt_conn_t *c)
+{
+    nxt_event_engine_t  *engine;
+
+    engine = task->thread->engine;
+
+    nxt_queue_remove(&c->link);
+    engine->idle_peers_n--;
+
+    c->read_state = &nxt_h1p_peer_close_state;
+
+    nxt_conn_close(engine, c);
+}
+
+
+static nxt_int_t
+nxt_h1p_peer_connection(void *ctx, nxt_http_field_t *field, uintptr_t data)
+{
+    nxt_http_request_t  *r;
+
+    r = ctx;
+    field->skip = 1;
+
+    if (nxt_memcasestrn(field->value, field->value + field->value_length,
+                        "close", 5)
+        != NULL)
+    {
+        r->peer->proto.h1->keepalive = 0;
+    }
+
+    return NXT_OK;
+}
+
+
 static nxt_int_t
 nxt_h1p_peer_transfer_encoding(void *ctx, nxt_http_field_t *field,
     uintptr_t data)
@@ -49,6 +49,10 @@ struct nxt_h1proto_s {
      * be zeroed in a keep-alive connection.
      */
     nxt_conn_t                *conn;
+
+    /* The fields below are used by keep-alive upstream connections. */
+    uint32_t                  requests;
+    nxt_msec_t                idle_timeout;
 };
 
 #define nxt_h1p_is_http11(h1p)                                              \
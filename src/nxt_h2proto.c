@@ -0,0 +1,2735 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include <nxt_h2proto.h>
+
+
+/*
+ * nxt_h2p_conn_ prefix is used for connection handlers.
+ * nxt_h2p_frame_ prefix is used for received frame handlers.
+ * nxt_h2p_request_ prefix is used for HTTP/2 protocol request methods.
+ *
+ * A request stream is converted to an HTTP/1.1 header block which is
+ * parsed by the common HTTP parser, so the rest of the router sees
+ * the same request fields regardless of the protocol.  The request
+ * body is buffered before the request is passed on.  Response buffers
+ * are copied to DATA frames by a round-robin scheduler which honours
+ * the peer flow control windows.
+ */
+
+
+#define NXT_H2P_PREFACE              "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+#define NXT_H2P_FRAME_HEADER_SIZE    9
+#define NXT_H2P_FRAME_SIZE           16384
+#define NXT_H2P_MAX_WINDOW           0x7fffffff
+#define NXT_H2P_DEFAULT_WINDOW       65535
+#define NXT_H2P_STREAM_WINDOW        (1024 * 1024)
+#define NXT_H2P_CONN_WINDOW          (16 * 1024 * 1024)
+#define NXT_H2P_MAX_STREAMS          128
+#define NXT_H2P_OUT_SIZE             (4 * NXT_H2P_FRAME_SIZE)
+
+#define NXT_H2P_DATA                 0x0
+#define NXT_H2P_HEADERS              0x1
+#define NXT_H2P_PRIORITY             0x2
+#define NXT_H2P_RST_STREAM           0x3
+#define NXT_H2P_SETTINGS             0x4
+#define NXT_H2P_PUSH_PROMISE         0x5
+#define NXT_H2P_PING                 0x6
+#define NXT_H2P_GOAWAY               0x7
+#define NXT_H2P_WINDOW_UPDATE        0x8
+#define NXT_H2P_CONTINUATION         0x9
+
+#define NXT_H2P_END_STREAM           0x01
+#define NXT_H2P_ACK                  0x01
+#define NXT_H2P_END_HEADERS          0x04
+#define NXT_H2P_PADDED               0x08
+#define NXT_H2P_PRIORITY_FLAG        0x20
+
+#define NXT_H2P_HEADER_TABLE_SIZE    0x1
+#define NXT_H2P_ENABLE_PUSH          0x2
+#define NXT_H2P_MAX_CONCURRENT       0x3
+#define NXT_H2P_INITIAL_WINDOW_SIZE  0x4
+#define NXT_H2P_MAX_FRAME_SIZE       0x5
+
+#define NXT_H2P_NO_ERROR             0x0
+#define NXT_H2P_PROTOCOL_ERROR       0x1
+#define NXT_H2P_INTERNAL_ERROR       0x2
+#define NXT_H2P_FLOW_CONTROL_ERROR   0x3
+#define NXT_H2P_STREAM_CLOSED        0x5
+#define NXT_H2P_FRAME_SIZE_ERROR     0x6
+#define NXT_H2P_REFUSED_STREAM       0x7
+#define NXT_H2P_CANCEL               0x8
+#define NXT_H2P_COMPRESSION_ERROR    0x9
+#define NXT_H2P_ENHANCE_YOUR_CALM    0xb
+
+
+typedef struct {
+    u_char                    *payload;
+    size_t                    length;
+    uint32_t                  stream;
+    uint8_t                   type;
+    uint8_t                   flags;
+} nxt_h2p_frame_t;
+
+
+typedef nxt_uint_t (*nxt_h2p_frame_handler_t)(nxt_task_t *task,
+    nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame);
+
+
+/* An HTTP/1.1 header block built from a decoded HTTP/2 header list. */
+
+typedef struct {
+    nxt_http_request_t        *request;
+
+    u_char                    *start;
+    u_char                    *pos;
+    u_char                    *end;
+    size_t                    limit;
+
+    nxt_str_t                 method;
+    nxt_str_t                 scheme;
+    nxt_str_t                 path;
+    nxt_str_t                 authority;
+    nxt_array_t               *cookies;
+
+    nxt_http_status_t         status:16;
+    uint8_t                   regular;  /* 1 bit */
+    uint8_t                   host;     /* 1 bit */
+} nxt_h2p_header_t;
+
+
+static void nxt_h2p_conn_read(nxt_task_t *task, void *obj, void *data);
+static nxt_uint_t nxt_h2p_frame(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_frame_data(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_frame_headers(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_frame_priority(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_frame_rst_stream(nxt_task_t *task,
+    nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_frame_settings(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_frame_push_promise(nxt_task_t *task,
+    nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_frame_ping(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_frame_goaway(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_frame_window_update(nxt_task_t *task,
+    nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_frame_continuation(nxt_task_t *task,
+    nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame);
+static nxt_uint_t nxt_h2p_header_block(nxt_task_t *task, nxt_h2proto_t *h2p,
+    uint32_t id, nxt_uint_t flags, u_char *pos, u_char *end);
+static nxt_uint_t nxt_h2p_header_skip(nxt_h2proto_t *h2p, nxt_mp_t *mp,
+    u_char *pos, u_char *end);
+static nxt_uint_t nxt_h2p_stream_open(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_socket_conf_joint_t *joint, uint32_t id, nxt_uint_t flags,
+    u_char *pos, u_char *end);
+static nxt_http_status_t nxt_h2p_header_process(nxt_task_t *task,
+    nxt_h2p_stream_t *st, nxt_h2p_header_t *h);
+static void nxt_h2p_header_field(nxt_h2p_header_t *h,
+    nxt_hpack_field_t *field);
+static nxt_int_t nxt_h2p_header_request_line(nxt_h2p_header_t *h);
+static void nxt_h2p_header_end(nxt_h2p_header_t *h);
+static nxt_int_t nxt_h2p_header_append(nxt_h2p_header_t *h, u_char *name,
+    size_t name_length, u_char *value, size_t value_length);
+static nxt_int_t nxt_h2p_header_reserve(nxt_h2p_header_t *h, size_t size);
+static nxt_bool_t nxt_h2p_hop_by_hop(u_char *name, size_t length);
+static void nxt_h2p_request_body_buffer(nxt_task_t *task,
+    nxt_h2p_stream_t *st, u_char *data, size_t size);
+static void nxt_h2p_request_body_end(nxt_task_t *task, nxt_h2p_stream_t *st);
+static nxt_int_t nxt_h2p_request_body_done(nxt_http_request_t *r,
+    nxt_h2p_stream_t *st);
+static nxt_h2p_stream_t *nxt_h2p_stream_find(nxt_h2proto_t *h2p,
+    uint32_t id);
+static void nxt_h2p_stream_queue(nxt_h2proto_t *h2p, nxt_h2p_stream_t *st);
+static void nxt_h2p_stream_error(nxt_task_t *task, nxt_h2p_stream_t *st,
+    nxt_uint_t code);
+static void nxt_h2p_stream_abort(nxt_task_t *task, nxt_h2p_stream_t *st);
+static void nxt_h2p_send(nxt_task_t *task, nxt_h2proto_t *h2p);
+static nxt_int_t nxt_h2p_stream_data(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_stream_t *st);
+static nxt_buf_t *nxt_h2p_frame_alloc(nxt_h2proto_t *h2p, size_t size);
+static u_char *nxt_h2p_frame_header(u_char *p, size_t length,
+    nxt_uint_t type, nxt_uint_t flags, uint32_t id);
+static u_char *nxt_h2p_put_uint32(u_char *p, uint32_t value);
+static void nxt_h2p_frame_queue(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_buf_t *b);
+static void nxt_h2p_frame_completion(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_int_t nxt_h2p_rst_stream_send(nxt_task_t *task,
+    nxt_h2proto_t *h2p, uint32_t id, nxt_uint_t code);
+static nxt_int_t nxt_h2p_window_update_send(nxt_task_t *task,
+    nxt_h2proto_t *h2p, uint32_t id, uint32_t increment);
+static void nxt_h2p_goaway_send(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_uint_t code);
+static void nxt_h2p_conn_sent(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_send_error(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_send_timeout(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_h2p_conn_close(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_error(nxt_task_t *task, void *obj, void *data);
+static void nxt_h2p_conn_timeout(nxt_task_t *task, void *obj, void *data);
+static nxt_msec_t nxt_h2p_conn_timer_value(nxt_conn_t *c, uintptr_t data);
+static void nxt_h2p_conn_abort(nxt_task_t *task, nxt_h2proto_t *h2p);
+static void nxt_h2p_conn_close_test(nxt_task_t *task, nxt_h2proto_t *h2p);
+
+
+static const nxt_conn_state_t  nxt_h2p_read_state;
+static const nxt_conn_state_t  nxt_h2p_send_state;
+
+
+static const nxt_h2p_frame_handler_t  nxt_h2p_frame_handlers[] = {
+    nxt_h2p_frame_data,
+    nxt_h2p_frame_headers,
+    nxt_h2p_frame_priority,
+    nxt_h2p_frame_rst_stream,
+    nxt_h2p_frame_settings,
+    nxt_h2p_frame_push_promise,
+    nxt_h2p_frame_ping,
+    nxt_h2p_frame_goaway,
+    nxt_h2p_frame_window_update,
+    nxt_h2p_frame_continuation,
+};
+
+
+static nxt_lvlhsh_t                    nxt_h2p_fields_hash;
+
+static nxt_http_field_proc_t           nxt_h2p_fields[] = {
+    { nxt_string("Host"),              &nxt_http_request_host, 0 },
+    { nxt_string("Cookie"),            &nxt_http_request_field,
+        offsetof(nxt_http_request_t, cookie) },
+    { nxt_string("Referer"),           &nxt_http_request_field,
+        offsetof(nxt_http_request_t, referer) },
+    { nxt_string("User-Agent"),        &nxt_http_request_field,
+        offsetof(nxt_http_request_t, user_agent) },
+    { nxt_string("Content-Type"),      &nxt_http_request_field,
+        offsetof(nxt_http_request_t, content_type) },
+    { nxt_string("Content-Length"),    &nxt_http_request_content_length, 0 },
+    { nxt_string("Authorization"),     &nxt_http_request_field,
+        offsetof(nxt_http_request_t, authorization) },
+};
+
+
+nxt_int_t
+nxt_h2p_init(nxt_task_t *task)
+{
+    return nxt_http_fields_hash(&nxt_h2p_fields_hash,
+                                nxt_h2p_fields, nxt_nitems(nxt_h2p_fields));
+}
+
+
+/*
+ * HTTP/2 is used if it has been negotiated with ALPN or if a plain text
+ * connection starts with the connection preface ("prior knowledge").
+ */
+
+nxt_bool_t
+nxt_h2p_conn_test(nxt_task_t *task, nxt_conn_t *c)
+{
+    size_t                   size;
+    nxt_buf_t                *b;
+    nxt_socket_conf_joint_t  *joint;
+
+    joint = c->listen->socket.data;
+
+    if (joint == NULL || !joint->socket_conf->http2) {
+        return 0;
+    }
+
+#if (NXT_TLS)
+    if (c->u.tls != NULL) {
+        return c->http2;
+    }
+#endif
+
+    b = c->read;
+
+    size = nxt_buf_mem_used_size(&b->mem);
+    size = nxt_min(size, nxt_length(NXT_H2P_PREFACE));
+
+    return (size >= nxt_length("PRI ")
+            && memcmp(b->mem.pos, NXT_H2P_PREFACE, size) == 0);
+}
+
+
+void
+nxt_h2p_conn_init(nxt_task_t *task, nxt_conn_t *c)
+{
+    u_char                   *p;
+    size_t                   size;
+    nxt_buf_t                *in, *b, *out;
+    nxt_h2proto_t            *h2p;
+    nxt_event_engine_t       *engine;
+    nxt_socket_conf_joint_t  *joint;
+
+    nxt_debug(task, "h2p conn init");
+
+    engine = task->thread->engine;
+
+    in = c->read;
+    c->read = NULL;
+
+    size = nxt_buf_mem_used_size(&in->mem);
+
+    h2p = nxt_mp_zget(c->mem_pool, sizeof(nxt_h2proto_t));
+    if (nxt_slow_path(h2p == NULL)) {
+        goto fail;
+    }
+
+    b = nxt_buf_mem_alloc(c->mem_pool,
+                          nxt_max(size, NXT_H2P_FRAME_HEADER_SIZE
+                                        + NXT_H2P_FRAME_SIZE), 0);
+    if (nxt_slow_path(b == NULL)) {
+        goto fail;
+    }
+
+    if (nxt_slow_path(nxt_hpack_init(&h2p->hpack, c->mem_pool,
+                                     NXT_HPACK_TABLE_SIZE)
+                      != NXT_OK))
+    {
+        goto fail;
+    }
+
+    b->mem.free = nxt_cpymem(b->mem.free, in->mem.pos, size);
+
+    nxt_event_engine_buf_mem_free(engine, in);
+
+    joint = c->listen->socket.data;
+    joint->count++;
+
+    h2p->joint = joint;
+    h2p->conn = c;
+
+    nxt_queue_init(&h2p->streams);
+    nxt_queue_init(&h2p->send_queue);
+
+    /* The connection has been put in the idle queue by accept. */
+    h2p->idle = 1;
+
+    h2p->send_window = NXT_H2P_DEFAULT_WINDOW;
+    h2p->init_window = NXT_H2P_DEFAULT_WINDOW;
+    h2p->recv_window = NXT_H2P_CONN_WINDOW;
+
+    c->socket.data = h2p;
+    c->read = b;
+    c->read_state = &nxt_h2p_read_state;
+    c->write_state = &nxt_h2p_send_state;
+
+    if (!c->tcp_nodelay) {
+        nxt_conn_tcp_nodelay_on(task, c);
+    }
+
+    /* SETTINGS with two parameters and a connection WINDOW_UPDATE. */
+
+    out = nxt_h2p_frame_alloc(h2p, 2 * NXT_H2P_FRAME_HEADER_SIZE + 12 + 4);
+    if (nxt_slow_path(out == NULL)) {
+        h2p->closing = 1;
+        nxt_h2p_conn_close_test(task, h2p);
+        return;
+    }
+
+    p = nxt_h2p_frame_header(out->mem.free, 12, NXT_H2P_SETTINGS, 0, 0);
+
+    *p++ = 0; *p++ = NXT_H2P_MAX_CONCURRENT;
+    p = nxt_h2p_put_uint32(p, NXT_H2P_MAX_STREAMS);
+
+    *p++ = 0; *p++ = NXT_H2P_INITIAL_WINDOW_SIZE;
+    p = nxt_h2p_put_uint32(p, NXT_H2P_STREAM_WINDOW);
+
+    p = nxt_h2p_frame_header(p, 4, NXT_H2P_WINDOW_UPDATE, 0, 0);
+    p = nxt_h2p_put_uint32(p, NXT_H2P_CONN_WINDOW - NXT_H2P_DEFAULT_WINDOW);
+
+    out->mem.free = p;
+
+    nxt_h2p_frame_queue(task, h2p, out);
+
+    nxt_h2p_conn_read(task, c, h2p);
+
+    return;
+
+fail:
+
+    nxt_event_engine_buf_mem_free(engine, in);
+
+    nxt_h1p_closing(task, c);
+}
+
+
+static const nxt_conn_state_t  nxt_h2p_read_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h2p_conn_read,
+    .close_handler = nxt_h2p_conn_close,
+    .error_handler = nxt_h2p_conn_error,
+
+    .timer_handler = nxt_h2p_conn_timeout,
+    .timer_value = nxt_h2p_conn_timer_value,
+    .timer_data = offsetof(nxt_socket_conf_t, idle_timeout),
+    .timer_autoreset = 1,
+};
+
+
+static void
+nxt_h2p_conn_read(nxt_task_t *task, void *obj, void *data)
+{
+    u_char           *pos, *end;
+    size_t           size;
+    nxt_buf_t        *b;
+    nxt_uint_t       err;
+    nxt_conn_t       *c;
+    nxt_h2proto_t    *h2p;
+    nxt_h2p_frame_t  frame;
+
+    c = obj;
+    h2p = data;
+
+    nxt_debug(task, "h2p conn read");
+
+    if (h2p->closing) {
+        return;
+    }
+
+    b = c->read;
+
+    pos = b->mem.pos;
+    end = b->mem.free;
+
+    if (!h2p->preface) {
+        size = nxt_min((size_t) (end - pos), nxt_length(NXT_H2P_PREFACE));
+
+        if (memcmp(pos, NXT_H2P_PREFACE, size) != 0) {
+            nxt_log(task, NXT_LOG_INFO, "h2p invalid connection preface");
+
+            err = NXT_H2P_PROTOCOL_ERROR;
+            goto error;
+        }
+
+        if (size < nxt_length(NXT_H2P_PREFACE)) {
+            goto read;
+        }
+
+        pos += size;
+        h2p->preface = 1;
+    }
+
+    while (end - pos >= NXT_H2P_FRAME_HEADER_SIZE) {
+        frame.length = (pos[0] << 16) | (pos[1] << 8) | pos[2];
+
+        if (nxt_slow_path(frame.length > NXT_H2P_FRAME_SIZE)) {
+            err = NXT_H2P_FRAME_SIZE_ERROR;
+            goto error;
+        }
+
+        if ((size_t) (end - pos) < NXT_H2P_FRAME_HEADER_SIZE + frame.length) {
+            break;
+        }
+
+        frame.type = pos[3];
+        frame.flags = pos[4];
+        frame.stream = ((pos[5] & 0x7f) << 24) | (pos[6] << 16)
+                       | (pos[7] << 8) | pos[8];
+        frame.payload = pos + NXT_H2P_FRAME_HEADER_SIZE;
+
+        nxt_debug(task, "h2p frame type:%d flags:%02Xd stream:%uD length:%uz",
+                  frame.type, frame.flags, frame.stream, frame.length);
+
+        err = nxt_h2p_frame(task, h2p, &frame);
+
+        if (nxt_slow_path(err != NXT_H2P_NO_ERROR)) {
+            goto error;
+        }
+
+        if (nxt_slow_path(h2p->closing)) {
+            return;
+        }
+
+        pos = frame.payload + frame.length;
+    }
+
+read:
+
+    size = end - pos;
+
+    if (pos != b->mem.start) {
+        nxt_memmove(b->mem.start, pos, size);
+    }
+
+    b->mem.pos = b->mem.start;
+    b->mem.free = b->mem.start + size;
+
+    nxt_conn_read(task->thread->engine, c);
+
+    return;
+
+error:
+
+    nxt_log(task, NXT_LOG_INFO, "h2p connection error: %ui", err);
+
+    nxt_h2p_goaway_send(task, h2p, err);
+
+    nxt_h2p_conn_abort(task, h2p);
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_h2p_frame_t *frame)
+{
+    if (h2p->header_stream != 0
+        && (frame->type != NXT_H2P_CONTINUATION
+            || frame->stream != h2p->header_stream))
+    {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (!h2p->settings
+        && (frame->type != NXT_H2P_SETTINGS || (frame->flags & NXT_H2P_ACK)))
+    {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (frame->type >= nxt_nitems(nxt_h2p_frame_handlers)) {
+        /* Frames of unknown types are ignored. */
+        return NXT_H2P_NO_ERROR;
+    }
+
+    return nxt_h2p_frame_handlers[frame->type](task, h2p, frame);
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame_data(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    u_char            *p;
+    size_t            size, padding;
+    nxt_int_t         ret;
+    nxt_h2p_stream_t  *st;
+
+    if (nxt_slow_path(frame->stream == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    p = frame->payload;
+    size = frame->length;
+
+    if (frame->flags & NXT_H2P_PADDED) {
+        if (nxt_slow_path(size == 0 || p[0] >= size)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        padding = *p++;
+        size -= padding + 1;
+    }
+
+    /* The flow control accounts the whole frame payload. */
+
+    if (nxt_slow_path((int32_t) frame->length > h2p->recv_window)) {
+        return NXT_H2P_FLOW_CONTROL_ERROR;
+    }
+
+    h2p->recv_window -= frame->length;
+
+    if (h2p->recv_window < NXT_H2P_CONN_WINDOW / 2) {
+        ret = nxt_h2p_window_update_send(task, h2p, 0,
+                                         NXT_H2P_CONN_WINDOW
+                                         - h2p->recv_window);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_H2P_INTERNAL_ERROR;
+        }
+
+        h2p->recv_window = NXT_H2P_CONN_WINDOW;
+    }
+
+    st = nxt_h2p_stream_find(h2p, frame->stream);
+
+    if (st == NULL) {
+        if (frame->stream > h2p->last_stream) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        /* The stream has been already closed or reset. */
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(st->remote_closed)) {
+        nxt_h2p_stream_error(task, st, NXT_H2P_STREAM_CLOSED);
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path((int32_t) frame->length > st->recv_window)) {
+        nxt_h2p_stream_error(task, st, NXT_H2P_FLOW_CONTROL_ERROR);
+        return NXT_H2P_NO_ERROR;
+    }
+
+    st->recv_window -= frame->length;
+
+    nxt_h2p_request_body_buffer(task, st, p, size);
+
+    if (frame->flags & NXT_H2P_END_STREAM) {
+        nxt_h2p_request_body_end(task, st);
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (st->body_status != 0) {
+        if (st->body_wait) {
+            st->body_wait = 0;
+            nxt_h2p_request_body_read(task, st->request);
+        }
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (st->recv_window < NXT_H2P_STREAM_WINDOW / 2 && !st->reset) {
+        ret = nxt_h2p_window_update_send(task, h2p, st->id,
+                                         NXT_H2P_STREAM_WINDOW
+                                         - st->recv_window);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_H2P_INTERNAL_ERROR;
+        }
+
+        st->recv_window = NXT_H2P_STREAM_WINDOW;
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame_headers(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    u_char             *p;
+    size_t             size, padding, limit;
+    nxt_buf_t          *b;
+    nxt_socket_conf_t  *skcf;
+
+    if (nxt_slow_path(frame->stream == 0 || (frame->stream & 1) == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    p = frame->payload;
+    size = frame->length;
+
+    if (frame->flags & NXT_H2P_PADDED) {
+        if (nxt_slow_path(size == 0 || p[0] >= size)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        padding = *p++;
+        size -= padding + 1;
+    }
+
+    if (frame->flags & NXT_H2P_PRIORITY_FLAG) {
+        if (nxt_slow_path(size < 5)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        /* The priority information is ignored. */
+        p += 5;
+        size -= 5;
+    }
+
+    if (frame->flags & NXT_H2P_END_HEADERS) {
+        return nxt_h2p_header_block(task, h2p, frame->stream, frame->flags,
+                                    p, p + size);
+    }
+
+    skcf = h2p->joint->socket_conf;
+    limit = skcf->large_header_buffer_size * skcf->large_header_buffers;
+
+    if (nxt_slow_path(size > limit)) {
+        return NXT_H2P_ENHANCE_YOUR_CALM;
+    }
+
+    b = nxt_buf_mem_alloc(h2p->conn->mem_pool, limit, 0);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    b->mem.free = nxt_cpymem(b->mem.free, p, size);
+
+    h2p->header = b;
+    h2p->header_stream = frame->stream;
+    h2p->header_flags = frame->flags;
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame_priority(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    if (nxt_slow_path(frame->stream == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length != 5)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame_rst_stream(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    nxt_h2p_stream_t  *st;
+
+    if (nxt_slow_path(frame->stream == 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length != 4)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    st = nxt_h2p_stream_find(h2p, frame->stream);
+
+    if (st == NULL) {
+        return (frame->stream > h2p->last_stream) ? NXT_H2P_PROTOCOL_ERROR
+                                                  : NXT_H2P_NO_ERROR;
+    }
+
+    nxt_debug(task, "h2p stream %uD reset by peer", st->id);
+
+    st->remote_closed = 1;
+
+    nxt_h2p_stream_abort(task, st);
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame_settings(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    u_char            *p, *end;
+    int32_t           delta;
+    uint32_t          value;
+    nxt_buf_t         *b;
+    nxt_uint_t        id;
+    nxt_h2p_stream_t  *st;
+
+    if (nxt_slow_path(frame->stream != 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (frame->flags & NXT_H2P_ACK) {
+        return (frame->length == 0) ? NXT_H2P_NO_ERROR
+                                    : NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length % 6 != 0)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    h2p->settings = 1;
+
+    p = frame->payload;
+    end = p + frame->length;
+
+    while (p < end) {
+        id = (p[0] << 8) | p[1];
+        value = ((uint32_t) p[2] << 24) | (p[3] << 16) | (p[4] << 8) | p[5];
+        p += 6;
+
+        switch (id) {
+
+        case NXT_H2P_ENABLE_PUSH:
+            if (nxt_slow_path(value > 1)) {
+                return NXT_H2P_PROTOCOL_ERROR;
+            }
+
+            break;
+
+        case NXT_H2P_INITIAL_WINDOW_SIZE:
+            if (nxt_slow_path(value > NXT_H2P_MAX_WINDOW)) {
+                return NXT_H2P_FLOW_CONTROL_ERROR;
+            }
+
+            delta = (int32_t) value - h2p->init_window;
+            h2p->init_window = value;
+
+            nxt_queue_each(st, &h2p->streams, nxt_h2p_stream_t, link) {
+
+                if (nxt_slow_path(delta > 0
+                                  && st->send_window
+                                     > NXT_H2P_MAX_WINDOW - delta))
+                {
+                    return NXT_H2P_FLOW_CONTROL_ERROR;
+                }
+
+                st->send_window += delta;
+
+                if (st->out != NULL && st->send_window > 0) {
+                    nxt_h2p_stream_queue(h2p, st);
+                }
+
+            } nxt_queue_loop;
+
+            break;
+
+        case NXT_H2P_MAX_FRAME_SIZE:
+            if (nxt_slow_path(value < NXT_H2P_FRAME_SIZE
+                              || value > 0xffffff))
+            {
+                return NXT_H2P_PROTOCOL_ERROR;
+            }
+
+            /* Frames are never larger than the default size. */
+            break;
+
+        default:
+            /*
+             * The encoder does not use the dynamic table, and
+             * unknown settings are ignored.
+             */
+            break;
+        }
+    }
+
+    b = nxt_h2p_frame_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    b->mem.free = nxt_h2p_frame_header(b->mem.free, 0, NXT_H2P_SETTINGS,
+                                       NXT_H2P_ACK, 0);
+
+    nxt_h2p_frame_queue(task, h2p, b);
+
+    nxt_h2p_send(task, h2p);
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame_push_promise(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    /* Clients cannot push. */
+    return NXT_H2P_PROTOCOL_ERROR;
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame_ping(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    u_char     *p;
+    nxt_buf_t  *b;
+
+    if (nxt_slow_path(frame->stream != 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length != 8)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    if (frame->flags & NXT_H2P_ACK) {
+        return NXT_H2P_NO_ERROR;
+    }
+
+    b = nxt_h2p_frame_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE + 8);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_H2P_INTERNAL_ERROR;
+    }
+
+    p = nxt_h2p_frame_header(b->mem.free, 8, NXT_H2P_PING, NXT_H2P_ACK, 0);
+    b->mem.free = nxt_cpymem(p, frame->payload, 8);
+
+    nxt_h2p_frame_queue(task, h2p, b);
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame_goaway(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    if (nxt_slow_path(frame->stream != 0)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length < 8)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    nxt_debug(task, "h2p goaway received");
+
+    /* The started streams are completed, new ones are refused. */
+    h2p->goaway = 1;
+
+    if (h2p->nstreams == 0) {
+        nxt_h2p_conn_abort(task, h2p);
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame_window_update(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    u_char            *p;
+    int32_t           increment;
+    nxt_h2p_stream_t  *st;
+
+    if (nxt_slow_path(frame->length != 4)) {
+        return NXT_H2P_FRAME_SIZE_ERROR;
+    }
+
+    p = frame->payload;
+    increment = ((p[0] & 0x7f) << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+
+    if (frame->stream == 0) {
+        if (nxt_slow_path(increment == 0)) {
+            return NXT_H2P_PROTOCOL_ERROR;
+        }
+
+        if (nxt_slow_path(h2p->send_window > NXT_H2P_MAX_WINDOW - increment)) {
+            return NXT_H2P_FLOW_CONTROL_ERROR;
+        }
+
+        h2p->send_window += increment;
+
+        nxt_h2p_send(task, h2p);
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    st = nxt_h2p_stream_find(h2p, frame->stream);
+
+    if (st == NULL) {
+        return (frame->stream > h2p->last_stream) ? NXT_H2P_PROTOCOL_ERROR
+                                                  : NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(increment == 0)) {
+        nxt_h2p_stream_error(task, st, NXT_H2P_PROTOCOL_ERROR);
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (nxt_slow_path(st->send_window > NXT_H2P_MAX_WINDOW - increment)) {
+        nxt_h2p_stream_error(task, st, NXT_H2P_FLOW_CONTROL_ERROR);
+        return NXT_H2P_NO_ERROR;
+    }
+
+    st->send_window += increment;
+
+    if (st->out != NULL && st->send_window > 0) {
+        nxt_h2p_stream_queue(h2p, st);
+        nxt_h2p_send(task, h2p);
+    }
+
+    return NXT_H2P_NO_ERROR;
+}
+
+
+static nxt_uint_t
+nxt_h2p_frame_continuation(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_frame_t *frame)
+{
+    nxt_buf_t   *b;
+    nxt_uint_t  err;
+
+    b = h2p->header;
+
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_H2P_PROTOCOL_ERROR;
+    }
+
+    if (nxt_slow_path(frame->length
+                      > (size_t) nxt_buf_mem_free_size(&b->mem)))
+    {
+        return NXT_H2P_ENHANCE_YOUR_CALM;
+    }
+
+    b->mem.free = nxt_cpymem(b->mem.free, frame->payload, frame->length);
+
+    if ((frame->flags & NXT_H2P_END_HEADERS) == 0) {
+        return NXT_H2P_NO_ERROR;
+    }
+
+    err = nxt_h2p_header_block(task, h2p, h2p->header_stream,
+                               h2p->header_flags, b->mem.pos, b->mem.free);
+
+    h2p->header = NULL;
+    h2p->header_stream = 0;
+
+    nxt_mp_free(h2p->conn->mem_pool, b);
+
+    return err;
+}
+
+
+static nxt_uint_t
+nxt_h2p_header_block(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t flags, u_char *pos, u_char *end)
+{
+    nxt_uint_t               err;
+    nxt_h2p_stream_t         *st;
+    nxt_socket_conf_joint_t  *joint;
+
+    st = nxt_h2p_stream_find(h2p, id);
+
+    if (st != NULL) {
+        /* Trailer fields are decoded to keep the table state and ignored. */
+
+        err = nxt_h2p_header_skip(h2p, st->request->mem_pool, pos, end);
+        if (nxt_slow_path(err != NXT_H2P_NO_ERROR)) {
+            return err;
+        }
+
+        if (nxt_slow_path(st->remote_closed)) {
+            nxt_h2p_stream_error(task, st, NXT_H2P_STREAM_CLOSED);
+
+        } else if (nxt_slow_path((flags & NXT_H2P_END_STREAM) == 0)) {
+            nxt_h2p_stream_error(task, st, NXT_H2P_PROTOCOL_ERROR);
+
+        } else {
+            nxt_h2p_request_body_end(task, st);
+        }
+
+        return NXT_H2P_NO_ERROR;
+    }
+
+    if (id <= h2p->last_stream) {
+        err = nxt_h2p_header_skip(h2p, NULL, pos, end);
+        if (nxt_slow_path(err != NXT_H2P_NO_ERROR)) {
+            return err;
+        }
+
+        return (nxt_h2p_rst_stream_send(task, h2p, id, NXT_H2P_STREAM_CLOSED)
+                == NXT_OK) ? NXT_H2P_NO_ERROR : NXT_H2P_INTERNAL_ERROR;
+    }
+
+    h2p->last_stream = id;
+
+    joint = h2p->conn->listen->socket.data;
+
+    if (h2p->goaway || joint == NULL || h2p->nstreams >= NXT_H2P_MAX_STREAMS) {
+        err = nxt_h2p_header_skip(h2p, NULL, pos, end);
+        if (nxt_slow_path(err != NXT_H2P_NO_ERROR)) {
+            return err;
+        }
+
+        if (joint == NULL && !h2p->goaway) {
+            /*
+             * Listening socket had been closed,
+             * the connection is not used anymore.
+             */
+            nxt_h2p_goaway_send(task, h2p, NXT_H2P_NO_ERROR);
+            h2p->goaway = 1;
+        }
+
+        return (nxt_h2p_rst_stream_send(task, h2p, id, NXT_H2P_REFUSED_STREAM)
+                == NXT_OK) ? NXT_H2P_NO_ERROR : NXT_H2P_INTERNAL_ERROR;
+    }
+
+    return nxt_h2p_stream_open(task, h2p, joint, id, flags, pos, end);
+}
+
+
+static nxt_uint_t
+nxt_h2p_header_skip(nxt_h2proto_t *h2p, nxt_mp_t *mp, u_char *pos,
+    u_char *end)
+{
+    nxt_int_t          ret;
+    nxt_mp_t           *pool;
+    nxt_hpack_field_t  field;
+
+    pool = mp;
+
+    if (pool == NULL) {
+        pool = nxt_mp_create(1024, 128, 256, 32);
+        if (nxt_slow_path(pool == NULL)) {
+            return NXT_H2P_INTERNAL_ERROR;
+        }
+    }
+
+    do {
+        ret = nxt_hpack_decode(&h2p->hpack, pool, &pos, end, &field);
+    } while (ret == NXT_OK);
+
+    if (mp == NULL) {
+        nxt_mp_destroy(pool);
+    }
+
+    return (ret == NXT_DONE) ? NXT_H2P_NO_ERROR : NXT_H2P_COMPRESSION_ERROR;
+}
+
+
+static nxt_uint_t
+nxt_h2p_stream_open(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_socket_conf_joint_t *joint, uint32_t id, nxt_uint_t flags,
+    u_char *pos, u_char *end)
+{
+    nxt_int_t           ret;
+    nxt_uint_t          err;
+    nxt_conn_t          *c;
+    nxt_h2p_header_t    h;
+    nxt_h2p_stream_t    *st;
+    nxt_socket_conf_t   *skcf;
+    nxt_hpack_field_t   field;
+    nxt_http_status_t   status;
+    nxt_http_request_t  *r;
+
+    nxt_debug(task, "h2p stream %uD open", id);
+
+    c = h2p->conn;
+
+    r = nxt_http_request_create(task);
+    if (nxt_slow_path(r == NULL)) {
+        goto refuse;
+    }
+
+    st = nxt_mp_zget(r->mem_pool, sizeof(nxt_h2p_stream_t));
+    if (nxt_slow_path(st == NULL)) {
+        goto release;
+    }
+
+    ret = nxt_http_parse_request_init(&st->parser, r->mem_pool);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        goto release;
+    }
+
+    st->request = r;
+    st->h2p = h2p;
+    st->id = id;
+    st->send_window = h2p->init_window;
+    st->recv_window = NXT_H2P_STREAM_WINDOW;
+    st->remote_closed = ((flags & NXT_H2P_END_STREAM) != 0);
+
+    r->proto.h2 = st;
+    r->protocol = NXT_HTTP_PROTO_H2;
+    r->remote = c->remote;
+
+#if (NXT_TLS)
+    r->tls = (c->u.tls != NULL);
+#endif
+
+    /* The response buffers are copied to DATA frames. */
+    r->sendfile = 0;
+
+    r->task = c->task;
+    task = &r->task;
+
+    joint->count++;
+
+    r->conf = joint;
+    skcf = joint->socket_conf;
+    r->log_route = skcf->log_route;
+
+    st->parser.discard_unsafe_fields = skcf->discard_unsafe_fields;
+
+    nxt_queue_insert_tail(&h2p->streams, &st->link);
+    h2p->nstreams++;
+
+    if (h2p->idle) {
+        nxt_conn_active(task->thread->engine, c);
+        h2p->idle = 0;
+    }
+
+    nxt_memzero(&h, sizeof(nxt_h2p_header_t));
+
+    h.request = r;
+    h.limit = skcf->large_header_buffer_size * skcf->large_header_buffers;
+
+    for ( ;; ) {
+        ret = nxt_hpack_decode(&h2p->hpack, r->mem_pool, &pos, end, &field);
+
+        if (ret != NXT_OK) {
+            break;
+        }
+
+        nxt_h2p_header_field(&h, &field);
+    }
+
+    if (nxt_slow_path(ret != NXT_DONE)) {
+        st->reset = 1;
+        r->state->error_handler(task, r, st);
+
+        return NXT_H2P_COMPRESSION_ERROR;
+    }
+
+    nxt_h2p_header_end(&h);
+
+    status = nxt_h2p_header_process(task, st, &h);
+
+    if (nxt_fast_path(status == 0)) {
+
+#if (NXT_TLS)
+        if (c->u.tls == NULL && skcf->tls != NULL) {
+            status = NXT_HTTP_TO_HTTPS;
+            goto error;
+        }
+#endif
+
+        r->state->ready_handler(task, r, NULL);
+        return NXT_H2P_NO_ERROR;
+    }
+
+#if (NXT_TLS)
+error:
+#endif
+
+    nxt_http_request_error(task, r, status);
+
+    return NXT_H2P_NO_ERROR;
+
+release:
+
+    nxt_mp_release(r->mem_pool);
+
+refuse:
+
+    err = nxt_h2p_header_skip(h2p, NULL, pos, end);
+    if (nxt_slow_path(err != NXT_H2P_NO_ERROR)) {
+        return err;
+    }
+
+    return (nxt_h2p_rst_stream_send(task, h2p, id, NXT_H2P_REFUSED_STREAM)
+            == NXT_OK) ? NXT_H2P_NO_ERROR : NXT_H2P_INTERNAL_ERROR;
+}
+
+
+static nxt_http_status_t
+nxt_h2p_header_process(nxt_task_t *task, nxt_h2p_stream_t *st,
+    nxt_h2p_header_t *h)
+{
+    nxt_int_t           ret;
+    nxt_buf_mem_t       mem;
+    nxt_http_status_t   status;
+    nxt_http_request_t  *r;
+
+    r = st->request;
+    status = h->status;
+
+    if (status == 0) {
+        mem.start = h->start;
+        mem.pos = h->start;
+        mem.free = h->pos;
+        mem.end = h->end;
+
+        ret = nxt_http_parse_request(&st->parser, &mem);
+
+        switch (ret) {
+
+        case NXT_DONE:
+            /* The synthetic "HTTP/1.1" version precedes the line end. */
+            nxt_memcpy(st->parser.request_line_end - 8, "HTTP/2.0", 8);
+            nxt_memcpy(st->parser.version.str, "HTTP/2.0", 8);
+
+            r->request_line.start = st->parser.method.start;
+            r->request_line.length = st->parser.request_line_end
+                                     - r->request_line.start;
+
+            if (nxt_slow_path(r->log_route)) {
+                nxt_log(task, NXT_LOG_NOTICE, "http request line \"%V\"",
+                        &r->request_line);
+            }
+
+            break;
+
+        case NXT_HTTP_PARSE_TOO_LARGE_FIELD:
+            status = NXT_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE;
+            break;
+
+        case NXT_ERROR:
+            status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+            break;
+
+        default:
+            status = NXT_HTTP_BAD_REQUEST;
+            break;
+        }
+    }
+
+    r->target.start = st->parser.target_start;
+    r->target.length = st->parser.target_end - st->parser.target_start;
+
+    r->quoted_target = st->parser.quoted_target;
+
+    if (st->parser.version.ui64 != 0) {
+        r->version.start = st->parser.version.str;
+        r->version.length = sizeof(st->parser.version.str);
+    }
+
+    r->method = &st->parser.method;
+    r->path = &st->parser.path;
+    r->args = &st->parser.args;
+
+    r->fields = st->parser.fields;
+
+    ret = nxt_http_fields_process(r->fields, &nxt_h2p_fields_hash, r);
+
+    if (status == 0) {
+        status = ret;
+    }
+
+    return status;
+}
+
+
+static void
+nxt_h2p_header_field(nxt_h2p_header_t *h, nxt_hpack_field_t *field)
+{
+    u_char     *p, *end, ch;
+    nxt_str_t  *name, *value, *pseudo, *cookie;
+
+    if (h->status != 0) {
+        return;
+    }
+
+    name = &field->name;
+    value = &field->value;
+
+    end = value->start + value->length;
+
+    for (p = value->start; p < end; p++) {
+        if (nxt_slow_path(*p == '\0' || *p == '\r' || *p == '\n')) {
+            goto invalid;
+        }
+    }
+
+    if (nxt_slow_path(name->length == 0)) {
+        goto invalid;
+    }
+
+    if (name->start[0] == ':') {
+        if (nxt_slow_path(h->regular)) {
+            goto invalid;
+        }
+
+        if (nxt_str_eq(name, ":method", 7)) {
+            pseudo = &h->method;
+
+        } else if (nxt_str_eq(name, ":path", 5)) {
+            pseudo = &h->path;
+
+        } else if (nxt_str_eq(name, ":scheme", 7)) {
+            pseudo = &h->scheme;
+
+        } else if (nxt_str_eq(name, ":authority", 10)) {
+            pseudo = &h->authority;
+
+        } else {
+            goto invalid;
+        }
+
+        if (nxt_slow_path(pseudo->start != NULL)) {
+            goto invalid;
+        }
+
+        pseudo->start = nxt_mp_nget(h->request->mem_pool,
+                                    nxt_max(value->length, 1));
+        if (nxt_slow_path(pseudo->start == NULL)) {
+            h->status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+            return;
+        }
+
+        pseudo->length = value->length;
+        nxt_memcpy(pseudo->start, value->start, value->length);
+
+        return;
+    }
+
+    end = name->start + name->length;
+
+    for (p = name->start; p < end; p++) {
+        ch = *p;
+
+        if (nxt_slow_path(ch <= ' ' || ch >= 0x7f || ch == ':'
+                          || (ch >= 'A' && ch <= 'Z')))
+        {
+            goto invalid;
+        }
+    }
+
+    if (!h->regular) {
+        h->regular = 1;
+
+        if (nxt_slow_path(nxt_h2p_header_request_line(h) != NXT_OK)) {
+            return;
+        }
+    }
+
+    if (nxt_slow_path(nxt_h2p_hop_by_hop(name->start, name->length))) {
+        goto invalid;
+    }
+
+    if (nxt_str_eq(name, "te", 2)) {
+        if (nxt_slow_path(!nxt_str_eq(value, "trailers", 8))) {
+            goto invalid;
+        }
+
+        return;
+    }
+
+    if (nxt_str_eq(name, "cookie", 6)) {
+        /* Cookie crumbs are joined into one field. */
+
+        if (h->cookies == NULL) {
+            h->cookies = nxt_array_create(h->request->mem_pool, 4,
+                                          sizeof(nxt_str_t));
+            if (nxt_slow_path(h->cookies == NULL)) {
+                h->status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+                return;
+            }
+        }
+
+        cookie = nxt_array_add(h->cookies);
+        if (nxt_slow_path(cookie == NULL)) {
+            h->status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+            return;
+        }
+
+        cookie->length = value->length;
+        cookie->start = nxt_mp_nget(h->request->mem_pool,
+                                    nxt_max(value->length, 1));
+        if (nxt_slow_path(cookie->start == NULL)) {
+            h->status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+            return;
+        }
+
+        nxt_memcpy(cookie->start, value->start, value->length);
+
+        return;
+    }
+
+    if (nxt_str_eq(name, "host", 4)) {
+        h->host = 1;
+    }
+
+    (void) nxt_h2p_header_append(h, name->start, name->length,
+                                 value->start, value->length);
+
+    return;
+
+invalid:
+
+    h->status = NXT_HTTP_BAD_REQUEST;
+}
+
+
+static nxt_int_t
+nxt_h2p_header_request_line(nxt_h2p_header_t *h)
+{
+    u_char     *p;
+    size_t     size;
+    nxt_str_t  *str;
+    nxt_int_t  ret;
+
+    if (nxt_slow_path(h->method.length == 0 || h->path.length == 0
+                      || h->scheme.start == NULL))
+    {
+        goto invalid;
+    }
+
+    for (p = h->method.start; p < h->method.start + h->method.length; p++) {
+        if (nxt_slow_path(*p <= ' ' || *p >= 0x7f)) {
+            goto invalid;
+        }
+    }
+
+    str = &h->path;
+
+    if (nxt_slow_path(str->start[0] != '/'
+                      && !(str->length == 1 && str->start[0] == '*')))
+    {
+        goto invalid;
+    }
+
+    for (p = str->start; p < str->start + str->length; p++) {
+        if (nxt_slow_path(*p <= ' ' || *p == 0x7f)) {
+            goto invalid;
+        }
+    }
+
+    size = h->method.length + 1 + h->path.length
+           + nxt_length(" HTTP/1.1\r\n");
+
+    ret = nxt_h2p_header_reserve(h, size);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    p = nxt_cpymem(h->pos, h->method.start, h->method.length);
+    *p++ = ' ';
+    p = nxt_cpymem(p, h->path.start, h->path.length);
+    h->pos = nxt_cpymem(p, " HTTP/1.1\r\n", nxt_length(" HTTP/1.1\r\n"));
+
+    return NXT_OK;
+
+invalid:
+
+    h->status = NXT_HTTP_BAD_REQUEST;
+
+    return NXT_ERROR;
+}
+
+
+static void
+nxt_h2p_header_end(nxt_h2p_header_t *h)
+{
+    u_char      *p;
+    size_t      size;
+    nxt_str_t   *cookie;
+    nxt_int_t   ret;
+    nxt_uint_t  i;
+
+    if (h->status != 0) {
+        return;
+    }
+
+    if (!h->regular) {
+        h->regular = 1;
+
+        if (nxt_slow_path(nxt_h2p_header_request_line(h) != NXT_OK)) {
+            return;
+        }
+    }
+
+    if (!h->host && h->authority.start != NULL) {
+        ret = nxt_h2p_header_append(h, (u_char *) "Host", 4,
+                                    h->authority.start, h->authority.length);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return;
+        }
+    }
+
+    if (h->cookies != NULL) {
+        cookie = h->cookies->elts;
+        size = nxt_length("Cookie: \r\n");
+
+        for (i = 0; i < h->cookies->nelts; i++) {
+            size += cookie[i].length + nxt_length("; ");
+        }
+
+        ret = nxt_h2p_header_reserve(h, size);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return;
+        }
+
+        p = nxt_cpymem(h->pos, "Cookie: ", nxt_length("Cookie: "));
+
+        for (i = 0; i < h->cookies->nelts; i++) {
+            if (i != 0) {
+                *p++ = ';'; *p++ = ' ';
+            }
+
+            p = nxt_cpymem(p, cookie[i].start, cookie[i].length);
+        }
+
+        *p++ = '\r'; *p++ = '\n';
+
+        h->pos = p;
+    }
+
+    ret = nxt_h2p_header_reserve(h, 2);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return;
+    }
+
+    *h->pos++ = '\r'; *h->pos++ = '\n';
+}
+
+
+static nxt_int_t
+nxt_h2p_header_append(nxt_h2p_header_t *h, u_char *name, size_t name_length,
+    u_char *value, size_t value_length)
+{
+    u_char     *p;
+    nxt_int_t  ret;
+
+    ret = nxt_h2p_header_reserve(h, name_length + value_length
+                                    + nxt_length(": \r\n"));
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    p = nxt_cpymem(h->pos, name, name_length);
+    *p++ = ':'; *p++ = ' ';
+    p = nxt_cpymem(p, value, value_length);
+    *p++ = '\r'; *p++ = '\n';
+
+    h->pos = p;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_h2p_header_reserve(nxt_h2p_header_t *h, size_t size)
+{
+    u_char  *p;
+    size_t  used, alloc;
+
+    if ((size_t) (h->end - h->pos) >= size) {
+        return NXT_OK;
+    }
+
+    used = h->pos - h->start;
+
+    if (nxt_slow_path(used + size > h->limit)) {
+        h->status = NXT_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE;
+        return NXT_DECLINED;
+    }
+
+    alloc = nxt_max((size_t) (h->end - h->start) * 2, 1024);
+    alloc = nxt_max(alloc, used + size);
+    alloc = nxt_min(alloc, h->limit);
+
+    p = nxt_mp_alloc(h->request->mem_pool, alloc);
+    if (nxt_slow_path(p == NULL)) {
+        h->status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+        return NXT_ERROR;
+    }
+
+    if (h->start != NULL) {
+        nxt_memcpy(p, h->start, used);
+        nxt_mp_free(h->request->mem_pool, h->start);
+    }
+
+    h->start = p;
+    h->pos = p + used;
+    h->end = p + alloc;
+
+    return NXT_OK;
+}
+
+
+static nxt_bool_t
+nxt_h2p_hop_by_hop(u_char *name, size_t length)
+{
+    nxt_uint_t  i;
+
+    static const nxt_str_t  fields[] = {
+        nxt_string("Connection"),
+        nxt_string("Keep-Alive"),
+        nxt_string("Proxy-Connection"),
+        nxt_string("Transfer-Encoding"),
+        nxt_string("Upgrade"),
+    };
+
+    for (i = 0; i < nxt_nitems(fields); i++) {
+        if (length == fields[i].length
+            && nxt_memcasecmp(name, fields[i].start, length) == 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+
+static void
+nxt_h2p_request_body_buffer(nxt_task_t *task, nxt_h2p_stream_t *st,
+    u_char *data, size_t size)
+{
+    size_t              n;
+    ssize_t             res;
+    nxt_buf_t           *b, *fb;
+    nxt_socket_conf_t   *skcf;
+    nxt_http_request_t  *r;
+
+    if (st->body_status != 0 || st->reset || size == 0) {
+        return;
+    }
+
+    r = st->request;
+    skcf = r->conf->socket_conf;
+
+    st->body_received += size;
+
+    if (nxt_slow_path(r->content_length_n >= 0
+                      && st->body_received > r->content_length_n))
+    {
+        st->body_status = NXT_HTTP_BAD_REQUEST;
+        return;
+    }
+
+    if (nxt_slow_path(st->body_received > (nxt_off_t) skcf->max_body_size)) {
+        st->body_status = NXT_HTTP_PAYLOAD_TOO_LARGE;
+        return;
+    }
+
+    b = r->body;
+
+    if (b == NULL) {
+        if (r->content_length_n > (nxt_off_t) skcf->body_buffer_size) {
+            b = nxt_http_request_body_file(task, r, 0);
+
+        } else {
+            n = (r->content_length_n >= 0) ? (size_t) r->content_length_n
+                                           : skcf->body_buffer_size;
+
+            b = nxt_buf_mem_alloc(r->mem_pool, n, 0);
+        }
+
+        if (nxt_slow_path(b == NULL)) {
+            goto fail;
+        }
+
+        r->body = b;
+    }
+
+    if (!nxt_buf_is_file(b)
+        && (size_t) nxt_buf_mem_free_size(&b->mem) < size)
+    {
+        /* A body without "Content-Length" has outgrown the buffer. */
+
+        fb = nxt_http_request_body_file(task, r, 0);
+        if (nxt_slow_path(fb == NULL)) {
+            goto fail;
+        }
+
+        /* The file is closed with the request. */
+        r->body = fb;
+
+        n = nxt_buf_mem_used_size(&b->mem);
+        res = (n != 0) ? nxt_fd_write(fb->file->fd, b->mem.pos, n) : 0;
+
+        nxt_mp_free(r->mem_pool, b);
+
+        if (nxt_slow_path(res < (ssize_t) n)) {
+            goto fail;
+        }
+
+        fb->file_end = n;
+        b = fb;
+    }
+
+    if (nxt_buf_is_file(b)) {
+        res = nxt_fd_write(b->file->fd, data, size);
+        if (nxt_slow_path(res < (ssize_t) size)) {
+            goto fail;
+        }
+
+        b->file_end += size;
+
+    } else {
+        b->mem.free = nxt_cpymem(b->mem.free, data, size);
+    }
+
+    return;
+
+fail:
+
+    st->body_status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+}
+
+
+static void
+nxt_h2p_request_body_end(nxt_task_t *task, nxt_h2p_stream_t *st)
+{
+    st->remote_closed = 1;
+
+    if (st->body_wait) {
+        st->body_wait = 0;
+        nxt_h2p_request_body_read(task, st->request);
+    }
+}
+
+
+void
+nxt_h2p_request_body_read(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_h2p_stream_t   *st;
+    nxt_http_status_t  status;
+
+    st = r->proto.h2;
+
+    nxt_debug(task, "h2p request body read %O", st->body_received);
+
+    if (nxt_slow_path(st->reset)) {
+        r->state->error_handler(task, r, st);
+        return;
+    }
+
+    status = st->body_status;
+
+    if (status == 0) {
+        if (!st->remote_closed) {
+            /* The body is read when the stream is half-closed. */
+            st->body_wait = 1;
+            return;
+        }
+
+        if (nxt_slow_path(r->content_length_n > 0
+                          && st->body_received != r->content_length_n))
+        {
+            status = NXT_HTTP_BAD_REQUEST;
+
+        } else if (nxt_slow_path(nxt_h2p_request_body_done(r, st)
+                                 != NXT_OK))
+        {
+            status = NXT_HTTP_INTERNAL_SERVER_ERROR;
+        }
+    }
+
+    if (nxt_slow_path(status != 0)) {
+        nxt_http_request_error(task, r, status);
+        return;
+    }
+
+    r->state->ready_handler(task, r, NULL);
+}
+
+
+static nxt_int_t
+nxt_h2p_request_body_done(nxt_http_request_t *r, nxt_h2p_stream_t *st)
+{
+    u_char            *p, *name;
+    uint32_t          hash;
+    nxt_buf_t         *b;
+    nxt_uint_t        i;
+    nxt_http_field_t  *field;
+
+    b = r->body;
+
+    if (b == NULL) {
+        return NXT_OK;
+    }
+
+    if (nxt_buf_is_file(b)) {
+        b->file->size = st->body_received;
+
+        b->mem.start = NULL;
+        b->mem.end = NULL;
+        b->mem.pos = NULL;
+        b->mem.free = NULL;
+    }
+
+    if (r->content_length != NULL) {
+        return NXT_OK;
+    }
+
+    /* Applications learn the body length from the "Content-Length" field. */
+
+    r->content_length_n = st->body_received;
+
+    field = nxt_list_zero_add(r->fields);
+    if (nxt_slow_path(field == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_mp_nget(r->mem_pool, NXT_OFF_T_LEN);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_http_field_name_set(field, "Content-Length");
+
+    hash = NXT_HTTP_FIELD_HASH_INIT;
+    name = field->name;
+
+    for (i = 0; i < field->name_length; i++) {
+        hash = nxt_http_field_hash_char(hash, nxt_lowcase(name[i]));
+    }
+
+    field->hash = nxt_http_field_hash_end(hash) & 0xFFFF;
+
+    field->value = p;
+    field->value_length = nxt_sprintf(p, p + NXT_OFF_T_LEN, "%O",
+                                      st->body_received) - p;
+
+    r->content_length = field;
+
+    return NXT_OK;
+}
+
+
+void
+nxt_h2p_request_local_addr(nxt_task_t *task, nxt_http_request_t *r)
+{
+    r->local = nxt_conn_local_addr(task, r->proto.h2->h2p->conn);
+}
+
+
+void
+nxt_h2p_request_header_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_work_handler_t body_handler, void *data)
+{
+    u_char            *p, *block, *pos, *end;
+    size_t            size, length;
+    nxt_buf_t         *b;
+    nxt_uint_t        n, type, flags, end_stream;
+    nxt_h2proto_t     *h2p;
+    nxt_work_queue_t  *wq;
+    nxt_h2p_stream_t  *st;
+    nxt_http_field_t  *field;
+
+    st = r->proto.h2;
+    h2p = st->h2p;
+
+    nxt_debug(task, "h2p request header send");
+
+    r->header_sent = 1;
+
+    wq = &task->thread->engine->fast_work_queue;
+
+    end_stream = (body_handler == NULL
+                  || (r->method != NULL && nxt_str_eq(r->method, "HEAD", 4)));
+
+    if (st->reset || h2p->closing) {
+        goto done;
+    }
+
+    n = r->status;
+
+    if (n == NXT_HTTP_TO_HTTPS) {
+        n = NXT_HTTP_BAD_REQUEST;
+
+    } else if (n < NXT_HTTP_OK || n > NXT_HTTP_STATUS_MAX) {
+        n = NXT_HTTP_INTERNAL_SERVER_ERROR;
+    }
+
+    size = NXT_HPACK_STATUS_SIZE;
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (!field->skip
+            && !nxt_h2p_hop_by_hop(field->name, field->name_length))
+        {
+            size += nxt_hpack_field_size(field->name_length,
+                                         field->value_length);
+        }
+
+    } nxt_list_loop;
+
+    block = nxt_mp_alloc(r->mem_pool, size);
+    if (nxt_slow_path(block == NULL)) {
+        goto fail;
+    }
+
+    p = nxt_hpack_encode_status(block, n);
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (!field->skip
+            && !nxt_h2p_hop_by_hop(field->name, field->name_length))
+        {
+            p = nxt_hpack_encode_field(p, field->name, field->name_length,
+                                       field->value, field->value_length);
+        }
+
+    } nxt_list_loop;
+
+    length = p - block;
+    n = (length + NXT_H2P_FRAME_SIZE - 1) / NXT_H2P_FRAME_SIZE;
+
+    b = nxt_h2p_frame_alloc(h2p, length + n * NXT_H2P_FRAME_HEADER_SIZE);
+    if (nxt_slow_path(b == NULL)) {
+        nxt_mp_free(r->mem_pool, block);
+        goto fail;
+    }
+
+    /* The header block is split into HEADERS and CONTINUATION frames. */
+
+    type = NXT_H2P_HEADERS;
+    flags = end_stream ? NXT_H2P_END_STREAM : 0;
+
+    pos = block;
+    end = p;
+    p = b->mem.free;
+
+    do {
+        size = nxt_min((size_t) (end - pos), NXT_H2P_FRAME_SIZE);
+
+        if (pos + size == end) {
+            flags |= NXT_H2P_END_HEADERS;
+        }
+
+        p = nxt_h2p_frame_header(p, size, type, flags, st->id);
+        p = nxt_cpymem(p, pos, size);
+
+        pos += size;
+        type = NXT_H2P_CONTINUATION;
+        flags = 0;
+
+    } while (pos < end);
+
+    b->mem.free = p;
+
+    nxt_mp_free(r->mem_pool, block);
+
+    nxt_h2p_frame_queue(task, h2p, b);
+
+done:
+
+    if (end_stream) {
+        st->local_closed = 1;
+    }
+
+    if (body_handler != NULL) {
+        nxt_work_queue_add(wq, body_handler, task, r, data);
+
+    } else {
+        nxt_sendbuf_drain(task, wq, nxt_http_buf_last(r));
+    }
+
+    return;
+
+fail:
+
+    nxt_h2p_stream_error(task, st, NXT_H2P_INTERNAL_ERROR);
+
+    r->state->error_handler(task, r, st);
+}
+
+
+void
+nxt_h2p_request_send(nxt_task_t *task, nxt_http_request_t *r, nxt_buf_t *out)
+{
+    nxt_buf_t         **next;
+    nxt_h2proto_t     *h2p;
+    nxt_h2p_stream_t  *st;
+
+    nxt_debug(task, "h2p request send");
+
+    st = r->proto.h2;
+    h2p = st->h2p;
+
+    if (st->reset || st->local_closed || h2p->closing) {
+        nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, out);
+        return;
+    }
+
+    for (next = &st->out; *next != NULL; next = &(*next)->next) {
+        /* void */
+    }
+
+    *next = out;
+
+    nxt_h2p_stream_queue(h2p, st);
+
+    nxt_h2p_send(task, h2p);
+}
+
+
+nxt_off_t
+nxt_h2p_request_body_bytes_sent(nxt_task_t *task, nxt_http_proto_t proto)
+{
+    return proto.h2->body_sent;
+}
+
+
+void
+nxt_h2p_request_discard(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *last)
+{
+    nxt_h2p_stream_t  *st;
+
+    nxt_debug(task, "h2p request discard");
+
+    st = r->proto.h2;
+
+    if (!st->local_closed) {
+        nxt_h2p_stream_error(task, st, NXT_H2P_INTERNAL_ERROR);
+    }
+
+    nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, st->out);
+    st->out = NULL;
+
+    nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, last);
+}
+
+
+void
+nxt_h2p_request_close(nxt_task_t *task, nxt_http_proto_t proto,
+    nxt_socket_conf_joint_t *joint)
+{
+    nxt_conn_t        *c;
+    nxt_h2proto_t     *h2p;
+    nxt_h2p_stream_t  *st;
+
+    st = proto.h2;
+    h2p = st->h2p;
+    c = h2p->conn;
+
+    nxt_debug(task, "h2p request close, stream %uD", st->id);
+
+    nxt_router_conf_release(task, joint);
+
+    if (!st->reset && !h2p->closing) {
+        if (!st->local_closed) {
+            (void) nxt_h2p_rst_stream_send(task, h2p, st->id,
+                                           NXT_H2P_INTERNAL_ERROR);
+
+        } else if (!st->remote_closed) {
+            /* The rest of the request body is not needed. */
+            (void) nxt_h2p_rst_stream_send(task, h2p, st->id,
+                                           NXT_H2P_NO_ERROR);
+        }
+    }
+
+    if (st->queued) {
+        nxt_queue_remove(&st->send_link);
+        st->queued = 0;
+    }
+
+    nxt_queue_remove(&st->link);
+
+    h2p->nstreams--;
+
+    if (h2p->nstreams == 0 && !h2p->closing) {
+        if (h2p->goaway) {
+            nxt_h2p_conn_abort(task, h2p);
+            return;
+        }
+
+        nxt_conn_idle(task->thread->engine, c);
+        h2p->idle = 1;
+    }
+
+    nxt_h2p_conn_close_test(task, h2p);
+}
+
+
+static nxt_h2p_stream_t *
+nxt_h2p_stream_find(nxt_h2proto_t *h2p, uint32_t id)
+{
+    nxt_h2p_stream_t  *st;
+
+    nxt_queue_each(st, &h2p->streams, nxt_h2p_stream_t, link) {
+
+        if (st->id == id) {
+            return st;
+        }
+
+    } nxt_queue_loop;
+
+    return NULL;
+}
+
+
+static void
+nxt_h2p_stream_queue(nxt_h2proto_t *h2p, nxt_h2p_stream_t *st)
+{
+    if (!st->queued) {
+        nxt_queue_insert_tail(&h2p->send_queue, &st->send_link);
+        st->queued = 1;
+    }
+}
+
+
+static void
+nxt_h2p_stream_error(nxt_task_t *task, nxt_h2p_stream_t *st, nxt_uint_t code)
+{
+    nxt_h2proto_t  *h2p;
+
+    h2p = st->h2p;
+
+    nxt_debug(task, "h2p stream %uD error: %ui", st->id, code);
+
+    if (!st->reset && !h2p->closing) {
+        (void) nxt_h2p_rst_stream_send(task, h2p, st->id, code);
+    }
+
+    st->remote_closed = 1;
+
+    nxt_h2p_stream_abort(task, st);
+}
+
+
+/*
+ * No frames are sent for an aborted stream anymore.  The request is
+ * completed as usual, its response is discarded.
+ */
+
+static void
+nxt_h2p_stream_abort(nxt_task_t *task, nxt_h2p_stream_t *st)
+{
+    nxt_buf_t           *out;
+    nxt_http_request_t  *r;
+
+    if (st->reset) {
+        return;
+    }
+
+    st->reset = 1;
+
+    if (st->queued) {
+        nxt_queue_remove(&st->send_link);
+        st->queued = 0;
+    }
+
+    out = st->out;
+    st->out = NULL;
+
+    nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, out);
+
+    if (st->body_wait) {
+        st->body_wait = 0;
+
+        r = st->request;
+        r->state->error_handler(task, r, st);
+    }
+}
+
+
+static void
+nxt_h2p_send(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    nxt_int_t         ret;
+    nxt_queue_link_t  *link;
+    nxt_h2p_stream_t  *st;
+
+    while (h2p->out_size < NXT_H2P_OUT_SIZE
+           && !nxt_queue_is_empty(&h2p->send_queue)
+           && !h2p->closing)
+    {
+        link = nxt_queue_first(&h2p->send_queue);
+        st = nxt_queue_link_data(link, nxt_h2p_stream_t, send_link);
+
+        ret = nxt_h2p_stream_data(task, h2p, st);
+
+        if (ret == NXT_AGAIN) {
+            /* The connection window is exhausted. */
+            return;
+        }
+
+        if (nxt_slow_path(ret == NXT_ERROR)) {
+            nxt_h2p_goaway_send(task, h2p, NXT_H2P_INTERNAL_ERROR);
+            nxt_h2p_conn_abort(task, h2p);
+            return;
+        }
+
+        nxt_queue_remove(link);
+        st->queued = 0;
+
+        if (ret == NXT_OK) {
+            /* The streams are served in round-robin order. */
+            nxt_h2p_stream_queue(h2p, st);
+        }
+    }
+}
+
+
+/*
+ * Copies the response buffers of the stream to a DATA frame.  Returns
+ * NXT_OK if the stream has more data to send, NXT_DECLINED if the
+ * stream has nothing to send or its window is exhausted, and NXT_AGAIN
+ * if the connection window is exhausted.
+ */
+
+static nxt_int_t
+nxt_h2p_stream_data(nxt_task_t *task, nxt_h2proto_t *h2p,
+    nxt_h2p_stream_t *st)
+{
+    u_char            *p;
+    size_t            size, used, n;
+    ssize_t           res;
+    int32_t           window;
+    nxt_buf_t         *b, *frame;
+    nxt_bool_t        last, is_last;
+    nxt_work_queue_t  *wq;
+
+    wq = &task->thread->engine->fast_work_queue;
+
+    size = 0;
+    last = 0;
+
+    for (b = st->out; b != NULL; b = b->next) {
+        if (!nxt_buf_is_sync(b)) {
+            size += nxt_buf_used_size(b);
+        }
+
+        if (nxt_buf_is_last(b)) {
+            last = 1;
+            break;
+        }
+
+        if (size >= NXT_H2P_FRAME_SIZE) {
+            break;
+        }
+    }
+
+    if (size > NXT_H2P_FRAME_SIZE) {
+        size = NXT_H2P_FRAME_SIZE;
+        last = 0;
+    }
+
+    if (size != 0) {
+        window = nxt_min(st->send_window, h2p->send_window);
+
+        if (window <= 0) {
+            return (st->send_window <= 0) ? NXT_DECLINED : NXT_AGAIN;
+        }
+
+        if (size > (size_t) window) {
+            size = window;
+            last = 0;
+        }
+
+    } else if (!last) {
+        /* Only empty buffers. */
+        b = st->out;
+        st->out = NULL;
+
+        nxt_sendbuf_drain(task, wq, b);
+
+        return NXT_DECLINED;
+    }
+
+    frame = nxt_h2p_frame_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE + size);
+    if (nxt_slow_path(frame == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_h2p_frame_header(frame->mem.free, size, NXT_H2P_DATA,
+                             last ? NXT_H2P_END_STREAM : 0, st->id);
+
+    n = size;
+
+    for ( ;; ) {
+        b = st->out;
+
+        used = nxt_buf_is_sync(b) ? 0 : nxt_buf_used_size(b);
+        used = nxt_min(used, n);
+
+        if (used != 0) {
+            if (nxt_buf_is_file(b)) {
+                res = nxt_file_read(b->file, p, used, b->file_pos);
+                if (nxt_slow_path(res != (ssize_t) used)) {
+                    nxt_mp_free(h2p->conn->mem_pool, frame);
+                    h2p->out_size -= NXT_H2P_FRAME_HEADER_SIZE + size;
+                    return NXT_ERROR;
+                }
+
+                b->file_pos += used;
+
+            } else {
+                nxt_memcpy(p, b->mem.pos, used);
+                b->mem.pos += used;
+            }
+
+            p += used;
+            n -= used;
+        }
+
+        if (!nxt_buf_is_sync(b) && nxt_buf_used_size(b) != 0) {
+            break;
+        }
+
+        st->out = b->next;
+        b->next = NULL;
+
+        is_last = nxt_buf_is_last(b);
+
+        nxt_sendbuf_drain(task, wq, b);
+
+        if (is_last || (n == 0 && !last)) {
+            break;
+        }
+    }
+
+    frame->mem.free = p;
+
+    st->send_window -= size;
+    h2p->send_window -= size;
+    st->body_sent += size;
+
+    nxt_h2p_frame_queue(task, h2p, frame);
+
+    if (last) {
+        st->local_closed = 1;
+        return NXT_DECLINED;
+    }
+
+    return (st->out != NULL) ? NXT_OK : NXT_DECLINED;
+}
+
+
+static nxt_buf_t *
+nxt_h2p_frame_alloc(nxt_h2proto_t *h2p, size_t size)
+{
+    nxt_buf_t  *b;
+
+    b = nxt_buf_mem_alloc(h2p->conn->mem_pool, size, 0);
+
+    if (nxt_fast_path(b != NULL)) {
+        b->completion_handler = nxt_h2p_frame_completion;
+        b->parent = h2p;
+
+        h2p->out_size += size;
+    }
+
+    return b;
+}
+
+
+static u_char *
+nxt_h2p_frame_header(u_char *p, size_t length, nxt_uint_t type,
+    nxt_uint_t flags, uint32_t id)
+{
+    *p++ = (u_char) (length >> 16);
+    *p++ = (u_char) (length >> 8);
+    *p++ = (u_char) length;
+    *p++ = (u_char) type;
+    *p++ = (u_char) flags;
+
+    return nxt_h2p_put_uint32(p, id);
+}
+
+
+static u_char *
+nxt_h2p_put_uint32(u_char *p, uint32_t value)
+{
+    *p++ = (u_char) (value >> 24);
+    *p++ = (u_char) (value >> 16);
+    *p++ = (u_char) (value >> 8);
+    *p++ = (u_char) value;
+
+    return p;
+}
+
+
+static void
+nxt_h2p_frame_queue(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_buf_t *b)
+{
+    nxt_conn_t  *c;
+
+    if (nxt_slow_path(h2p->write_error)) {
+        nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, b);
+        return;
+    }
+
+    c = h2p->conn;
+
+    if (c->write == NULL) {
+        c->write = b;
+
+        nxt_conn_write(task->thread->engine, c);
+
+    } else {
+        *h2p->write_tail = b;
+    }
+
+    h2p->write_tail = &b->next;
+}
+
+
+static void
+nxt_h2p_frame_completion(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t      *b, *next;
+    nxt_h2proto_t  *h2p;
+
+    b = obj;
+    h2p = data;
+
+    do {
+        next = b->next;
+
+        h2p->out_size -= nxt_buf_mem_size(&b->mem);
+        nxt_mp_free(h2p->conn->mem_pool, b);
+
+        b = next;
+    } while (b != NULL);
+
+    nxt_h2p_send(task, h2p);
+}
+
+
+static nxt_int_t
+nxt_h2p_rst_stream_send(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    nxt_uint_t code)
+{
+    u_char     *p;
+    nxt_buf_t  *b;
+
+    b = nxt_h2p_frame_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE + 4);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_h2p_frame_header(b->mem.free, 4, NXT_H2P_RST_STREAM, 0, id);
+    b->mem.free = nxt_h2p_put_uint32(p, code);
+
+    nxt_h2p_frame_queue(task, h2p, b);
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_h2p_window_update_send(nxt_task_t *task, nxt_h2proto_t *h2p, uint32_t id,
+    uint32_t increment)
+{
+    u_char     *p;
+    nxt_buf_t  *b;
+
+    b = nxt_h2p_frame_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE + 4);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = nxt_h2p_frame_header(b->mem.free, 4, NXT_H2P_WINDOW_UPDATE, 0, id);
+    b->mem.free = nxt_h2p_put_uint32(p, increment);
+
+    nxt_h2p_frame_queue(task, h2p, b);
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_h2p_goaway_send(nxt_task_t *task, nxt_h2proto_t *h2p, nxt_uint_t code)
+{
+    u_char     *p;
+    nxt_buf_t  *b;
+
+    if (h2p->closing) {
+        return;
+    }
+
+    b = nxt_h2p_frame_alloc(h2p, NXT_H2P_FRAME_HEADER_SIZE + 8);
+    if (nxt_slow_path(b == NULL)) {
+        return;
+    }
+
+    p = nxt_h2p_frame_header(b->mem.free, 8, NXT_H2P_GOAWAY, 0, 0);
+    p = nxt_h2p_put_uint32(p, h2p->last_stream);
+    b->mem.free = nxt_h2p_put_uint32(p, code);
+
+    nxt_h2p_frame_queue(task, h2p, b);
+}
+
+
+static const nxt_conn_state_t  nxt_h2p_send_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_h2p_conn_sent,
+    .error_handler = nxt_h2p_conn_send_error,
+
+    .timer_handler = nxt_h2p_conn_send_timeout,
+    .timer_value = nxt_h2p_conn_timer_value,
+    .timer_data = offsetof(nxt_socket_conf_t, send_timeout),
+    .timer_autoreset = 1,
+};
+
+
+static void
+nxt_h2p_conn_sent(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t          *c;
+    nxt_h2proto_t       *h2p;
+    nxt_event_engine_t  *engine;
+
+    c = obj;
+    h2p = data;
+
+    nxt_debug(task, "h2p conn sent");
+
+    engine = task->thread->engine;
+
+    c->write = nxt_sendbuf_completion(task, &engine->fast_work_queue,
+                                      c->write);
+
+    if (c->write != NULL) {
+        nxt_conn_write(engine, c);
+        return;
+    }
+
+    if (h2p != NULL) {
+        nxt_h2p_conn_close_test(task, h2p);
+    }
+}
+
+
+static void
+nxt_h2p_conn_send_error(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t      *b;
+    nxt_conn_t     *c;
+    nxt_h2proto_t  *h2p;
+
+    c = obj;
+    h2p = data;
+
+    nxt_debug(task, "h2p conn send error");
+
+    h2p->write_error = 1;
+
+    b = c->write;
+    c->write = NULL;
+
+    nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, b);
+
+    nxt_h2p_conn_abort(task, h2p);
+}
+
+
+static void
+nxt_h2p_conn_send_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    nxt_debug(task, "h2p conn send timeout");
+
+    c = nxt_write_timer_conn(timer);
+    c->block_write = 1;
+
+    nxt_h2p_conn_send_error(task, c, c->socket.data);
+}
+
+
+static void
+nxt_h2p_conn_close(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_h2proto_t  *h2p;
+
+    h2p = data;
+
+    nxt_debug(task, "h2p conn close");
+
+    nxt_h2p_conn_abort(task, h2p);
+}
+
+
+static void
+nxt_h2p_conn_error(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_h2proto_t  *h2p;
+
+    h2p = data;
+
+    nxt_debug(task, "h2p conn error");
+
+    nxt_h2p_conn_abort(task, h2p);
+}
+
+
+static void
+nxt_h2p_conn_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t        *c;
+    nxt_timer_t       *timer;
+    nxt_h2proto_t     *h2p;
+    nxt_h2p_stream_t  *st;
+
+    timer = obj;
+
+    nxt_debug(task, "h2p conn timeout");
+
+    c = nxt_read_timer_conn(timer);
+    h2p = c->socket.data;
+
+    if (h2p->nstreams == 0) {
+        nxt_h2p_goaway_send(task, h2p, NXT_H2P_NO_ERROR);
+        nxt_h2p_conn_abort(task, h2p);
+        return;
+    }
+
+    /* Streams still receiving a request are timed out. */
+
+    nxt_queue_each(st, &h2p->streams, nxt_h2p_stream_t, link) {
+
+        if (!st->remote_closed) {
+            nxt_h2p_stream_error(task, st, NXT_H2P_CANCEL);
+        }
+
+    } nxt_queue_loop;
+
+    nxt_conn_read(task->thread->engine, c);
+}
+
+
+static nxt_msec_t
+nxt_h2p_conn_timer_value(nxt_conn_t *c, uintptr_t data)
+{
+    nxt_h2proto_t  *h2p;
+
+    h2p = c->socket.data;
+
+    return nxt_value_at(nxt_msec_t, h2p->joint->socket_conf, data);
+}
+
+
+static void
+nxt_h2p_conn_abort(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    nxt_conn_t          *c;
+    nxt_h2p_stream_t    *st;
+    nxt_event_engine_t  *engine;
+
+    if (h2p->closing) {
+        return;
+    }
+
+    nxt_debug(task, "h2p conn abort");
+
+    h2p->closing = 1;
+
+    c = h2p->conn;
+    c->block_read = 1;
+
+    engine = task->thread->engine;
+
+    nxt_timer_disable(engine, &c->read_timer);
+
+    if (h2p->header != NULL) {
+        nxt_mp_free(c->mem_pool, h2p->header);
+        h2p->header = NULL;
+        h2p->header_stream = 0;
+    }
+
+    nxt_queue_each(st, &h2p->streams, nxt_h2p_stream_t, link) {
+
+        nxt_h2p_stream_abort(task, st);
+
+    } nxt_queue_loop;
+
+    nxt_h2p_conn_close_test(task, h2p);
+}
+
+
+static void
+nxt_h2p_conn_close_test(nxt_task_t *task, nxt_h2proto_t *h2p)
+{
+    nxt_conn_t  *c;
+
+    c = h2p->conn;
+
+    if (!h2p->closing || h2p->closed || h2p->nstreams != 0
+        || c->write != NULL)
+    {
+        return;
+    }
+
+    nxt_debug(task, "h2p conn closing");
+
+    h2p->closed = 1;
+
+    if (h2p->idle) {
+        nxt_conn_active(task->thread->engine, c);
+        h2p->idle = 0;
+    }
+
+    nxt_router_conf_release(task, h2p->joint);
+
+    nxt_h1p_closing(task, c);
+}
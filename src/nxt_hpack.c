@@ -0,0 +1,634 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <nxt_hpack.h>
+
+
+/*
+ * HPACK, RFC 7541.  The decoder supports the whole format including
+ * Huffman coded strings and the dynamic table.  The encoder does not use
+ * the dynamic table and Huffman coding: response fields are sent as
+ * literals without indexing, the names are indexed in the static table
+ * where possible.
+ */
+
+
+#define NXT_HPACK_INT_SIZE  6
+
+
+struct nxt_hpack_entry_s {
+    nxt_str_t                 name;
+    nxt_str_t                 value;
+};
+
+
+static int64_t nxt_hpack_int_parse(u_char **pos, const u_char *end,
+    nxt_uint_t prefix);
+static nxt_int_t nxt_hpack_string_parse(nxt_mp_t *mp, u_char **pos,
+    const u_char *end, nxt_str_t *str);
+static u_char *nxt_hpack_huff_decode(u_char *dst, const u_char *src,
+    size_t length);
+static nxt_int_t nxt_hpack_index(nxt_hpack_t *hpack, uint64_t index,
+    nxt_hpack_field_t *field);
+static nxt_int_t nxt_hpack_entry_add(nxt_hpack_t *hpack, nxt_mp_t *mp,
+    nxt_hpack_field_t *field);
+static void nxt_hpack_evict(nxt_hpack_t *hpack, size_t size);
+static u_char *nxt_hpack_int_encode(u_char *p, nxt_uint_t prefix,
+    u_char flags, size_t value);
+
+
+static const nxt_hpack_field_t  nxt_hpack_static_table[] = {
+    { nxt_string(":authority"),                  nxt_null_string },
+    { nxt_string(":method"),                     nxt_string("GET") },
+    { nxt_string(":method"),                     nxt_string("POST") },
+    { nxt_string(":path"),                       nxt_string("/") },
+    { nxt_string(":path"),                       nxt_string("/index.html") },
+    { nxt_string(":scheme"),                     nxt_string("http") },
+    { nxt_string(":scheme"),                     nxt_string("https") },
+    { nxt_string(":status"),                     nxt_string("200") },
+    { nxt_string(":status"),                     nxt_string("204") },
+    { nxt_string(":status"),                     nxt_string("206") },
+    { nxt_string(":status"),                     nxt_string("304") },
+    { nxt_string(":status"),                     nxt_string("400") },
+    { nxt_string(":status"),                     nxt_string("404") },
+    { nxt_string(":status"),                     nxt_string("500") },
+    { nxt_string("accept-charset"),              nxt_null_string },
+    { nxt_string("accept-encoding"),             nxt_string("gzip, deflate") },
+    { nxt_string("accept-language"),             nxt_null_string },
+    { nxt_string("accept-ranges"),               nxt_null_string },
+    { nxt_string("accept"),                      nxt_null_string },
+    { nxt_string("access-control-allow-origin"), nxt_null_string },
+    { nxt_string("age"),                         nxt_null_string },
+    { nxt_string("allow"),                       nxt_null_string },
+    { nxt_string("authorization"),               nxt_null_string },
+    { nxt_string("cache-control"),               nxt_null_string },
+    { nxt_string("content-disposition"),         nxt_null_string },
+    { nxt_string("content-encoding"),            nxt_null_string },
+    { nxt_string("content-language"),            nxt_null_string },
+    { nxt_string("content-length"),              nxt_null_string },
+    { nxt_string("content-location"),            nxt_null_string },
+    { nxt_string("content-range"),               nxt_null_string },
+    { nxt_string("content-type"),                nxt_null_string },
+    { nxt_string("cookie"),                      nxt_null_string },
+    { nxt_string("date"),                        nxt_null_string },
+    { nxt_string("etag"),                        nxt_null_string },
+    { nxt_string("expect"),                      nxt_null_string },
+    { nxt_string("expires"),                     nxt_null_string },
+    { nxt_string("from"),                        nxt_null_string },
+    { nxt_string("host"),                        nxt_null_string },
+    { nxt_string("if-match"),                    nxt_null_string },
+    { nxt_string("if-modified-since"),           nxt_null_string },
+    { nxt_string("if-none-match"),               nxt_null_string },
+    { nxt_string("if-range"),                    nxt_null_string },
+    { nxt_string("if-unmodified-since"),         nxt_null_string },
+    { nxt_string("last-modified"),               nxt_null_string },
+    { nxt_string("link"),                        nxt_null_string },
+    { nxt_string("location"),                    nxt_null_string },
+    { nxt_string("max-forwards"),                nxt_null_string },
+    { nxt_string("proxy-authenticate"),          nxt_null_string },
+    { nxt_string("proxy-authorization"),         nxt_null_string },
+    { nxt_string("range"),                       nxt_null_string },
+    { nxt_string("referer"),                     nxt_null_string },
+    { nxt_string("refresh"),                     nxt_null_string },
+    { nxt_string("retry-after"),                 nxt_null_string },
+    { nxt_string("server"),                      nxt_null_string },
+    { nxt_string("set-cookie"),                  nxt_null_string },
+    { nxt_string("strict-transport-security"),   nxt_null_string },
+    { nxt_string("transfer-encoding"),           nxt_null_string },
+    { nxt_string("user-agent"),                  nxt_null_string },
+    { nxt_string("vary"),                        nxt_null_string },
+    { nxt_string("via"),                         nxt_null_string },
+    { nxt_string("www-authenticate"),            nxt_null_string },
+};
+
+
+/*
+ * The canonical Huffman code: the symbols sorted by the code length and
+ * the value, and the first code, the number of codes, and the offset of
+ * the first symbol for each code length.
+ */
+
+static const u_char  nxt_hpack_huff_syms[256] = {
+    0x30, 0x31, 0x32, 0x61, 0x63, 0x65, 0x69, 0x6f, 0x73, 0x74, 0x20, 0x25,
+    0x2d, 0x2e, 0x2f, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3d, 0x41,
+    0x5f, 0x62, 0x64, 0x66, 0x67, 0x68, 0x6c, 0x6d, 0x6e, 0x70, 0x72, 0x75,
+    0x3a, 0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x4b, 0x4c,
+    0x4d, 0x4e, 0x4f, 0x50, 0x51, 0x52, 0x53, 0x54, 0x55, 0x56, 0x57, 0x59,
+    0x6a, 0x6b, 0x71, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x26, 0x2a, 0x2c, 0x3b,
+    0x58, 0x5a, 0x21, 0x22, 0x28, 0x29, 0x3f, 0x27, 0x2b, 0x7c, 0x23, 0x3e,
+    0x00, 0x24, 0x40, 0x5b, 0x5d, 0x7e, 0x5e, 0x7d, 0x3c, 0x60, 0x7b, 0x5c,
+    0xc3, 0xd0, 0x80, 0x82, 0x83, 0xa2, 0xb8, 0xc2, 0xe0, 0xe2, 0x99, 0xa1,
+    0xa7, 0xac, 0xb0, 0xb1, 0xb3, 0xd1, 0xd8, 0xd9, 0xe3, 0xe5, 0xe6, 0x81,
+    0x84, 0x85, 0x86, 0x88, 0x92, 0x9a, 0x9c, 0xa0, 0xa3, 0xa4, 0xa9, 0xaa,
+    0xad, 0xb2, 0xb5, 0xb9, 0xba, 0xbb, 0xbd, 0xbe, 0xc4, 0xc6, 0xe4, 0xe8,
+    0xe9, 0x01, 0x87, 0x89, 0x8a, 0x8b, 0x8c, 0x8d, 0x8f, 0x93, 0x95, 0x96,
+    0x97, 0x98, 0x9b, 0x9d, 0x9e, 0xa5, 0xa6, 0xa8, 0xae, 0xaf, 0xb4, 0xb6,
+    0xb7, 0xbc, 0xbf, 0xc5, 0xe7, 0xef, 0x09, 0x8e, 0x90, 0x91, 0x94, 0x9f,
+    0xab, 0xce, 0xd7, 0xe1, 0xec, 0xed, 0xc7, 0xcf, 0xea, 0xeb, 0xc0, 0xc1,
+    0xc8, 0xc9, 0xca, 0xcd, 0xd2, 0xd5, 0xda, 0xdb, 0xee, 0xf0, 0xf2, 0xf3,
+    0xff, 0xcb, 0xcc, 0xd3, 0xd4, 0xd6, 0xdd, 0xde, 0xdf, 0xf1, 0xf4, 0xf5,
+    0xf6, 0xf7, 0xf8, 0xfa, 0xfb, 0xfc, 0xfd, 0xfe, 0x02, 0x03, 0x04, 0x05,
+    0x06, 0x07, 0x08, 0x0b, 0x0c, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13, 0x14,
+    0x15, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x7f, 0xdc,
+    0xf9, 0x0a, 0x0d, 0x16,
+};
+
+
+static const uint32_t  nxt_hpack_huff_first[31] = {
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000014, 0x0000005c, 0x000000f8, 0x00000000, 0x000003f8, 0x000007fa,
+    0x00000ffa, 0x00001ff8, 0x00003ffc, 0x00007ffc, 0x00000000, 0x00000000,
+    0x00000000, 0x0007fff0, 0x000fffe6, 0x001fffdc, 0x003fffd2, 0x007fffd8,
+    0x00ffffea, 0x01ffffec, 0x03ffffe0, 0x07ffffde, 0x0fffffe2, 0x00000000,
+    0x3ffffffc,
+};
+
+
+static const uint8_t  nxt_hpack_huff_count[31] = {
+     0,  0,  0,  0,  0, 10, 26, 32,  6,  0,  5,  3,
+     2,  6,  2,  3,  0,  0,  0,  3,  8, 13, 26, 29,
+    12,  4, 15, 19, 29,  0,  3,
+};
+
+
+static const uint8_t  nxt_hpack_huff_offset[31] = {
+      0,   0,   0,   0,   0,   0,  10,  36,  68,   0,  74,  79,
+     82,  84,  90,  92,   0,   0,   0,  95,  98, 106, 119, 145,
+    174, 186, 190, 205, 224,   0, 253,
+};
+
+
+nxt_int_t
+nxt_hpack_init(nxt_hpack_t *hpack, nxt_mp_t *mp, size_t limit)
+{
+    hpack->allocated = limit / NXT_HPACK_ENTRY_OVERHEAD;
+
+    hpack->entries = nxt_mp_zget(mp, hpack->allocated
+                                     * sizeof(nxt_hpack_entry_t *));
+    if (nxt_slow_path(hpack->entries == NULL)) {
+        return NXT_ERROR;
+    }
+
+    hpack->mem_pool = mp;
+    hpack->first = 0;
+    hpack->count = 0;
+    hpack->size = 0;
+    hpack->max_size = limit;
+    hpack->limit = limit;
+
+    return NXT_OK;
+}
+
+
+void
+nxt_hpack_free(nxt_hpack_t *hpack)
+{
+    if (hpack->entries != NULL) {
+        nxt_hpack_evict(hpack, hpack->max_size);
+    }
+}
+
+
+nxt_int_t
+nxt_hpack_decode(nxt_hpack_t *hpack, nxt_mp_t *mp, u_char **pos,
+    const u_char *end, nxt_hpack_field_t *field)
+{
+    u_char      ch, *p;
+    int64_t     n;
+    nxt_int_t   ret;
+    nxt_bool_t  indexing;
+
+    p = *pos;
+
+    for ( ;; ) {
+        if (p == end) {
+            *pos = p;
+            return NXT_DONE;
+        }
+
+        ch = *p;
+
+        if (ch & 0x80) {
+            /* Indexed header field. */
+
+            n = nxt_hpack_int_parse(&p, end, 7);
+            if (nxt_slow_path(n <= 0)) {
+                return NXT_ERROR;
+            }
+
+            *pos = p;
+
+            return nxt_hpack_index(hpack, n, field);
+        }
+
+        if ((ch & 0xe0) == 0x20) {
+            /* Dynamic table size update. */
+
+            n = nxt_hpack_int_parse(&p, end, 5);
+            if (nxt_slow_path(n < 0 || (size_t) n > hpack->limit)) {
+                return NXT_ERROR;
+            }
+
+            hpack->max_size = n;
+            nxt_hpack_evict(hpack, 0);
+
+            continue;
+        }
+
+        /*
+         * Literal header field with incremental indexing,
+         * without indexing, or never indexed.
+         */
+
+        indexing = ((ch & 0xc0) == 0x40);
+
+        n = nxt_hpack_int_parse(&p, end, indexing ? 6 : 4);
+        if (nxt_slow_path(n < 0)) {
+            return NXT_ERROR;
+        }
+
+        if (n == 0) {
+            ret = nxt_hpack_string_parse(mp, &p, end, &field->name);
+
+        } else {
+            ret = nxt_hpack_index(hpack, n, field);
+        }
+
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        ret = nxt_hpack_string_parse(mp, &p, end, &field->value);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        *pos = p;
+
+        if (indexing) {
+            return nxt_hpack_entry_add(hpack, mp, field);
+        }
+
+        return NXT_OK;
+    }
+}
+
+
+static int64_t
+nxt_hpack_int_parse(u_char **pos, const u_char *end, nxt_uint_t prefix)
+{
+    u_char      *p;
+    int64_t     value;
+    nxt_uint_t  max, shift;
+
+    p = *pos;
+    max = (1 << prefix) - 1;
+
+    value = *p++ & max;
+
+    if (value == (int64_t) max) {
+        shift = 0;
+
+        do {
+            if (nxt_slow_path(p == end || shift > 28)) {
+                return -1;
+            }
+
+            value += (int64_t) (*p & 0x7f) << shift;
+            shift += 7;
+
+        } while (*p++ & 0x80);
+    }
+
+    *pos = p;
+
+    return value;
+}
+
+
+static nxt_int_t
+nxt_hpack_string_parse(nxt_mp_t *mp, u_char **pos, const u_char *end,
+    nxt_str_t *str)
+{
+    u_char      *p, *dst;
+    int64_t     length;
+    nxt_bool_t  huffman;
+
+    p = *pos;
+
+    if (nxt_slow_path(p == end)) {
+        return NXT_ERROR;
+    }
+
+    huffman = ((*p & 0x80) != 0);
+
+    length = nxt_hpack_int_parse(&p, end, 7);
+    if (nxt_slow_path(length < 0 || length > end - p)) {
+        return NXT_ERROR;
+    }
+
+    if (!huffman) {
+        str->start = p;
+        str->length = length;
+
+        *pos = p + length;
+
+        return NXT_OK;
+    }
+
+    /* The shortest code is 5 bits long. */
+
+    dst = nxt_mp_nget(mp, length * 8 / 5 + 1);
+    if (nxt_slow_path(dst == NULL)) {
+        return NXT_ERROR;
+    }
+
+    str->start = dst;
+
+    dst = nxt_hpack_huff_decode(dst, p, length);
+    if (nxt_slow_path(dst == NULL)) {
+        return NXT_ERROR;
+    }
+
+    str->length = dst - str->start;
+
+    *pos = p + length;
+
+    return NXT_OK;
+}
+
+
+static u_char *
+nxt_hpack_huff_decode(u_char *dst, const u_char *src, size_t length)
+{
+    u_char      ch;
+    uint32_t    code, n;
+    nxt_uint_t  bits, i;
+
+    code = 0;
+    bits = 0;
+
+    while (length != 0) {
+        ch = *src++;
+        length--;
+
+        for (i = 0; i < 8; i++) {
+            code = (code << 1) | (ch >> 7);
+            ch <<= 1;
+            bits++;
+
+            n = code - nxt_hpack_huff_first[bits];
+
+            if (n < nxt_hpack_huff_count[bits]) {
+                *dst++ = nxt_hpack_huff_syms[nxt_hpack_huff_offset[bits] + n];
+
+                code = 0;
+                bits = 0;
+
+            } else if (nxt_slow_path(bits == 30)) {
+                /* EOS or an invalid code. */
+                return NULL;
+            }
+        }
+    }
+
+    /* The padding is a most significant part of the EOS code. */
+
+    if (nxt_slow_path(bits > 7 || code != ((uint32_t) 1 << bits) - 1)) {
+        return NULL;
+    }
+
+    return dst;
+}
+
+
+static nxt_int_t
+nxt_hpack_index(nxt_hpack_t *hpack, uint64_t index, nxt_hpack_field_t *field)
+{
+    nxt_hpack_entry_t  *entry;
+
+    if (index <= NXT_HPACK_STATIC_TABLE_SIZE) {
+        *field = nxt_hpack_static_table[index - 1];
+        return NXT_OK;
+    }
+
+    index -= NXT_HPACK_STATIC_TABLE_SIZE + 1;
+
+    if (nxt_slow_path(index >= hpack->count)) {
+        return NXT_ERROR;
+    }
+
+    entry = hpack->entries[(hpack->first + index) % hpack->allocated];
+
+    field->name = entry->name;
+    field->value = entry->value;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_hpack_entry_add(nxt_hpack_t *hpack, nxt_mp_t *mp,
+    nxt_hpack_field_t *field)
+{
+    u_char             *p;
+    size_t             size;
+    nxt_hpack_entry_t  *entry;
+
+    size = field->name.length + field->value.length
+           + NXT_HPACK_ENTRY_OVERHEAD;
+
+    if (size > hpack->max_size) {
+        /*
+         * The field is not added, but empties the table, so it is
+         * copied before eviction for the same reason as below.
+         */
+
+        p = nxt_mp_nget(mp, field->name.length + field->value.length);
+        if (nxt_slow_path(p == NULL)) {
+            return NXT_ERROR;
+        }
+
+        nxt_memcpy(p, field->name.start, field->name.length);
+        field->name.start = p;
+
+        p += field->name.length;
+
+        nxt_memcpy(p, field->value.start, field->value.length);
+        field->value.start = p;
+
+        nxt_hpack_evict(hpack, hpack->max_size);
+
+        return NXT_OK;
+    }
+
+    /*
+     * The entry is copied before eviction,
+     * because the name may refer to an evicted entry.
+     */
+
+    entry = nxt_mp_alloc(hpack->mem_pool, sizeof(nxt_hpack_entry_t)
+                                          + field->name.length
+                                          + field->value.length);
+    if (nxt_slow_path(entry == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = (u_char *) entry + sizeof(nxt_hpack_entry_t);
+
+    entry->name.start = p;
+    entry->name.length = field->name.length;
+    p = nxt_cpymem(p, field->name.start, field->name.length);
+
+    entry->value.start = p;
+    entry->value.length = field->value.length;
+    nxt_memcpy(p, field->value.start, field->value.length);
+
+    nxt_hpack_evict(hpack, size);
+
+    hpack->first = (hpack->first + hpack->allocated - 1) % hpack->allocated;
+    hpack->entries[hpack->first] = entry;
+    hpack->count++;
+    hpack->size += size;
+
+    field->name = entry->name;
+    field->value = entry->value;
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_hpack_evict(nxt_hpack_t *hpack, size_t size)
+{
+    nxt_uint_t         i;
+    nxt_hpack_entry_t  *entry;
+
+    while (hpack->count != 0 && hpack->size + size > hpack->max_size) {
+        hpack->count--;
+
+        i = (hpack->first + hpack->count) % hpack->allocated;
+
+        entry = hpack->entries[i];
+        hpack->entries[i] = NULL;
+
+        hpack->size -= entry->name.length + entry->value.length
+                       + NXT_HPACK_ENTRY_OVERHEAD;
+
+        nxt_mp_free(hpack->mem_pool, entry);
+    }
+}
+
+
+size_t
+nxt_hpack_field_size(size_t name_length, size_t value_length)
+{
+    return 1 + 2 * NXT_HPACK_INT_SIZE + name_length + value_length;
+}
+
+
+u_char *
+nxt_hpack_encode_status(u_char *p, nxt_uint_t status)
+{
+    switch (status) {
+
+    case 200:
+        *p++ = 0x88;
+        return p;
+
+    case 204:
+        *p++ = 0x89;
+        return p;
+
+    case 206:
+        *p++ = 0x8a;
+        return p;
+
+    case 304:
+        *p++ = 0x8b;
+        return p;
+
+    case 400:
+        *p++ = 0x8c;
+        return p;
+
+    case 404:
+        *p++ = 0x8d;
+        return p;
+
+    case 500:
+        *p++ = 0x8e;
+        return p;
+
+    default:
+        /* A literal without indexing with the ":status" name index. */
+        *p++ = 0x08;
+        *p++ = 3;
+
+        return nxt_sprintf(p, p + 3, "%03ui", status);
+    }
+}
+
+
+u_char *
+nxt_hpack_encode_field(u_char *p, u_char *name, size_t name_length,
+    u_char *value, size_t value_length)
+{
+    nxt_uint_t               i;
+    const nxt_hpack_field_t  *entry;
+
+    /* The pseudo-header fields are skipped. */
+
+    for (i = 14; i < NXT_HPACK_STATIC_TABLE_SIZE; i++) {
+        entry = &nxt_hpack_static_table[i];
+
+        if (entry->name.length == name_length
+            && nxt_strncasecmp(entry->name.start, name, name_length) == 0)
+        {
+            p = nxt_hpack_int_encode(p, 4, 0x00, i + 1);
+            goto value;
+        }
+    }
+
+    *p++ = 0x00;
+    p = nxt_hpack_int_encode(p, 7, 0x00, name_length);
+
+    for (i = 0; i < name_length; i++) {
+        *p++ = nxt_lowcase(name[i]);
+    }
+
+value:
+
+    p = nxt_hpack_int_encode(p, 7, 0x00, value_length);
+
+    return nxt_cpymem(p, value, value_length);
+}
+
+
+static u_char *
+nxt_hpack_int_encode(u_char *p, nxt_uint_t prefix, u_char flags, size_t value)
+{
+    size_t  max;
+
+    max = (1 << prefix) - 1;
+
+    if (value < max) {
+        *p++ = flags | value;
+        return p;
+    }
+
+    *p++ = flags | max;
+    value -= max;
+
+    while (value >= 0x80) {
+        *p++ = (value & 0x7f) | 0x80;
+        value >>= 7;
+    }
+
+    *p++ = value;
+
+    return p;
+}
@@ -0,0 +1,58 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_HPACK_H_INCLUDED_
+#define _NXT_HPACK_H_INCLUDED_
+
+
+#define NXT_HPACK_TABLE_SIZE         4096
+#define NXT_HPACK_ENTRY_OVERHEAD     32
+#define NXT_HPACK_STATIC_TABLE_SIZE  61
+
+
+typedef struct nxt_hpack_entry_s  nxt_hpack_entry_t;
+
+
+typedef struct {
+    nxt_str_t                 name;
+    nxt_str_t                 value;
+} nxt_hpack_field_t;
+
+
+/*
+ * The decoding context of a connection.  The dynamic table is a ring of
+ * entries, the newest entry has the lowest dynamic index.  The ring is
+ * sized to the maximum number of entries which fit in the table limit.
+ */
+
+typedef struct {
+    nxt_hpack_entry_t         **entries;
+    nxt_mp_t                  *mem_pool;
+
+    uint32_t                  allocated;
+    uint32_t                  first;
+    uint32_t                  count;
+
+    size_t                    size;
+    size_t                    max_size;
+    size_t                    limit;
+} nxt_hpack_t;
+
+
+nxt_int_t nxt_hpack_init(nxt_hpack_t *hpack, nxt_mp_t *mp, size_t limit);
+void nxt_hpack_free(nxt_hpack_t *hpack);
+nxt_int_t nxt_hpack_decode(nxt_hpack_t *hpack, nxt_mp_t *mp, u_char **pos,
+    const u_char *end, nxt_hpack_field_t *field);
+
+size_t nxt_hpack_field_size(size_t name_length, size_t value_length);
+u_char *nxt_hpack_encode_status(u_char *p, nxt_uint_t status);
+u_char *nxt_hpack_encode_field(u_char *p, u_char *name, size_t name_length,
+    u_char *value, size_t value_length);
+
+
+#define NXT_HPACK_STATUS_SIZE  5
+
+
+#endif  /* _NXT_HPACK_H_INCLUDED_ */
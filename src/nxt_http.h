@@ -19,6 +19,7 @@ typedef enum {
 
     NXT_HTTP_OK = 200,
     NXT_HTTP_NO_CONTENT = 204,
+    NXT_HTTP_PARTIAL_CONTENT = 206,
 
     NXT_HTTP_MULTIPLE_CHOICES = 300,
     NXT_HTTP_MOVED_PERMANENTLY = 301,
@@ -36,6 +37,7 @@ typedef enum {
     NXT_HTTP_LENGTH_REQUIRED = 411,
     NXT_HTTP_PAYLOAD_TOO_LARGE = 413,
     NXT_HTTP_URI_TOO_LONG = 414,
+    NXT_HTTP_RANGE_NOT_SATISFIABLE = 416,
     NXT_HTTP_UPGRADE_REQUIRED = 426,
     NXT_HTTP_REQUEST_HEADER_FIELDS_TOO_LARGE = 431,
 
@@ -74,6 +76,7 @@ typedef struct {
 
 
 typedef struct nxt_h1proto_s        nxt_h1proto_t;
+typedef struct nxt_h2p_stream_s     nxt_h2p_stream_t;
 
 struct nxt_h1p_websocket_timer_s {
     nxt_timer_t                     timer;
@@ -85,6 +88,7 @@ struct nxt_h1p_websocket_timer_s {
 typedef union {
     void                            *any;
     nxt_h1proto_t                   *h1;
+    nxt_h2p_stream_t                *h2;
 } nxt_http_proto_t;
 
 
@@ -114,6 +118,10 @@ typedef struct {
 
 
 typedef struct nxt_upstream_server_s  nxt_upstream_server_t;
+typedef struct nxt_http_compress_s    nxt_http_compress_t;
+typedef struct nxt_http_cache_ctx_s   nxt_http_cache_ctx_t;
+typedef struct nxt_http_cache_conf_s  nxt_http_cache_conf_t;
+typedef struct nxt_http_sendfile_conf_s  nxt_http_sendfile_conf_t;
 
 typedef struct {
     nxt_http_proto_t                proto;
@@ -126,6 +134,7 @@ typedef struct {
     nxt_http_protocol_t             protocol:8;       /* 2 bits */
     uint8_t                         header_received;  /* 1 bit  */
     uint8_t                         closed;           /* 1 bit  */
+    uint8_t                         retry;            /* 1 bit  */
 } nxt_http_peer_t;
 
 
@@ -136,6 +145,9 @@ struct nxt_http_request_s {
     nxt_mp_t                        *mem_pool;
 
     nxt_buf_t                       *body;
+    nxt_off_t                       body_rest;
+    nxt_work_handler_t              body_handler;
+    nxt_http_action_t               *body_action;
     nxt_buf_t                       *ws_frame;
     nxt_buf_t                       *out;
     const nxt_http_request_state_t  *state;
@@ -183,7 +195,13 @@ struct nxt_http_request_s {
     nxt_http_peer_t                 *peer;
     nxt_buf_t                       *last;
 
-    nxt_queue_link_t                app_link;   /* nxt_app_t.ack_waiting_req */
+#if (NXT_HAVE_COMPRESSION)
+    nxt_http_compress_t             *compress;
+#endif
+
+    nxt_http_cache_ctx_t            *cache;
+
+    nxt_queue_link_t                app_link;   /* nxt_event_engine_t.app_requests */
     nxt_event_engine_t              *engine;
     nxt_work_t                      err_work;
 
@@ -199,6 +217,7 @@ struct nxt_http_request_s {
     uint8_t                         app_target;
     nxt_http_protocol_t             protocol:8;   /* 2 bits */
     uint8_t                         tls;          /* 1 bit  */
+    uint8_t                         sendfile;     /* 1 bit  */
     uint8_t                         logged;       /* 1 bit  */
     uint8_t                         header_sent;  /* 1 bit  */
     uint8_t                         inconsistent; /* 1 bit  */
@@ -241,7 +260,10 @@ typedef struct {
     nxt_conf_value_t                *follow_symlinks;
     nxt_conf_value_t                *traverse_mounts;
     nxt_conf_value_t                *types;
+    nxt_conf_value_t                *precompressed;
     nxt_conf_value_t                *fallback;
+    nxt_conf_value_t                *cache;
+    nxt_conf_value_t                *sendfile;
 } nxt_http_action_conf_t;
 
 
@@ -260,6 +282,8 @@ struct nxt_http_action_s {
 
     nxt_tstr_t                      *rewrite;
     nxt_array_t                     *set_headers;  /* of nxt_http_field_t */
+    nxt_http_cache_conf_t           *cache;
+    nxt_http_sendfile_conf_t        *sendfile;
     nxt_http_action_t               *fallback;
 };
 
@@ -321,6 +345,7 @@ nxt_http_date(u_char *buf, struct tm *tm)
 
 nxt_int_t nxt_http_init(nxt_task_t *task);
 nxt_int_t nxt_h1p_init(nxt_task_t *task);
+nxt_int_t nxt_h2p_init(nxt_task_t *task);
 nxt_int_t nxt_http_response_hash_init(nxt_task_t *task);
 
 void nxt_http_conn_init(nxt_task_t *task, void *obj, void *data);
@@ -328,6 +353,10 @@ nxt_http_request_t *nxt_http_request_create(nxt_task_t *task);
 void nxt_http_request_error(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_status_t status);
 void nxt_http_request_read_body(nxt_task_t *task, nxt_http_request_t *r);
+void nxt_http_request_body_complete(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action);
+nxt_buf_t *nxt_http_request_body_file(nxt_task_t *task, nxt_http_request_t *r,
+    size_t size);
 void nxt_http_request_header_send(nxt_task_t *task, nxt_http_request_t *r,
     nxt_work_handler_t body_handler, void *data);
 void nxt_http_request_ws_frame_start(nxt_task_t *task, nxt_http_request_t *r,
@@ -349,6 +378,8 @@ nxt_int_t nxt_http_request_content_length(void *ctx, nxt_http_field_t *field,
 
 nxt_array_t *nxt_http_arguments_parse(nxt_http_request_t *r);
 nxt_array_t *nxt_http_cookies_parse(nxt_http_request_t *r);
+nxt_uint_t nxt_http_accept_encoding(nxt_http_request_t *r,
+    const nxt_str_t *codings, nxt_uint_t n);
 
 int64_t nxt_http_field_hash(nxt_mp_t *mp, nxt_str_t *name,
     nxt_bool_t case_sensitive, uint8_t encoding);
@@ -403,6 +434,35 @@ nxt_int_t nxt_http_static_mtypes_hash_add(nxt_mp_t *mp, nxt_lvlhsh_t *hash,
     const nxt_str_t *exten, nxt_str_t *type);
 nxt_str_t *nxt_http_static_mtype_get(nxt_lvlhsh_t *hash,
     const nxt_str_t *exten);
+void nxt_http_static_file_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_file_t *f, nxt_off_t start, nxt_off_t end);
+
+#if (NXT_HAVE_COMPRESSION)
+nxt_int_t nxt_http_compress_conf_create(nxt_task_t *task,
+    nxt_router_conf_t *rtcf, nxt_conf_value_t *conf);
+nxt_int_t nxt_http_compress_init(nxt_task_t *task, nxt_http_request_t *r);
+nxt_buf_t *nxt_http_compress(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *in);
+void nxt_http_compress_engine_free(nxt_task_t *task,
+    nxt_event_engine_t *engine);
+#endif
+
+nxt_int_t nxt_http_cache_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_conf_value_t *conf);
+nxt_int_t nxt_http_cache_conf_init(nxt_router_conf_t *rtcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf);
+nxt_int_t nxt_http_cache_handler(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action);
+nxt_int_t nxt_http_cache_init(nxt_task_t *task, nxt_http_request_t *r);
+void nxt_http_cache_write(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *out);
+void nxt_http_cache_close(nxt_task_t *task, nxt_http_request_t *r);
+
+nxt_int_t nxt_http_sendfile_conf_init(nxt_task_t *task,
+    nxt_router_temp_conf_t *tmcf, nxt_http_action_t *action,
+    nxt_http_action_conf_t *acf);
+nxt_int_t nxt_http_sendfile_init(nxt_task_t *task, nxt_http_request_t *r);
+void nxt_http_sendfile(nxt_task_t *task, nxt_http_request_t *r);
 
 nxt_http_action_t *nxt_http_application_handler(nxt_task_t *task,
     nxt_http_request_t *r, nxt_http_action_t *action);
@@ -437,6 +497,7 @@ void nxt_h1p_websocket_frame_start(nxt_task_t *task, nxt_http_request_t *r,
 void nxt_h1p_complete_buffers(nxt_task_t *task, nxt_h1proto_t *h1p,
     nxt_bool_t all);
 nxt_msec_t nxt_h1p_conn_request_timer_value(nxt_conn_t *c, uintptr_t data);
+void nxt_h1p_closing(nxt_task_t *task, nxt_conn_t *c);
 
 extern const nxt_conn_state_t  nxt_h1p_idle_close_state;
 
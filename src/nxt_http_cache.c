@@ -0,0 +1,1382 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+
+
+/*
+ * The response cache keeps application and proxied responses in files of
+ * the cache directory.  The index of the files is shared by all router
+ * threads: it resides in a shared memory zone of a fixed size and is
+ * protected by a spinlock that is never held over file operations.
+ *
+ * The first request that misses a key fills the entry, the other requests
+ * with the same key wait for it and are resumed on their own engines when
+ * the entry is filled or the response turns out to be uncacheable.  If the
+ * entry is not filled within "lock_timeout", a waiting request is passed
+ * to the action without caching.  The
+ * cache is bound to the configuration, because the cached responses
+ * depend on the routes and applications; the files are removed when
+ * the configuration is released.
+ *
+ * A file starts with the response status and header fields followed by
+ * the response body.
+ */
+
+
+typedef struct {
+    uint16_t                    status;
+    uint16_t                    nfields;
+    uint32_t                    size;
+} nxt_http_cache_header_t;
+
+
+typedef struct {
+    uint32_t                    name_length;
+    uint32_t                    value_length;
+} nxt_http_cache_field_t;
+
+
+typedef struct {
+    nxt_queue_link_t            link;     /* nxt_http_cache_t.lru */
+    nxt_queue_t                 waiters;  /* of nxt_http_cache_ctx_t */
+
+    nxt_str_t                   key;
+    uint32_t                    key_hash;
+
+    uint32_t                    number;
+    uint32_t                    header;
+    nxt_off_t                   size;
+    nxt_time_t                  expires;
+
+    uint8_t                     updating;  /* 1 bit */
+} nxt_http_cache_entry_t;
+
+
+struct nxt_http_cache_s {
+    nxt_thread_spinlock_t       lock;
+    nxt_lvlhsh_t                hash;
+    nxt_queue_t                 lru;      /* of nxt_http_cache_entry_t */
+
+    nxt_mem_zone_t              *zone;
+    size_t                      zone_size;
+    size_t                      zone_used;
+
+    nxt_off_t                   size;
+    uint32_t                    number;
+    uint32_t                    id;
+
+    nxt_str_t                   path;
+    nxt_off_t                   max_size;
+    size_t                      index_size;
+};
+
+
+struct nxt_http_cache_conf_s {
+    nxt_tstr_t                  *key;
+    nxt_int_t                   valid;
+    nxt_msec_t                  lock_timeout;
+};
+
+
+struct nxt_http_cache_ctx_s {
+    nxt_work_t                  work;
+    nxt_timer_t                 timer;
+    nxt_queue_link_t            link;     /* nxt_http_cache_entry_t.waiters */
+    nxt_event_engine_t          *engine;
+    nxt_http_request_t          *request;
+    nxt_http_action_t           *action;
+
+    nxt_str_t                   key;
+    uint32_t                    key_hash;
+
+    /* The entry filled by the request. */
+    nxt_http_cache_entry_t      *entry;
+    nxt_file_t                  file;
+    uint32_t                    number;
+    uint32_t                    header;
+    nxt_off_t                   size;
+    nxt_time_t                  expires;
+
+    uint8_t                     waiting;  /* 1 bit */
+    uint8_t                     bypass;   /* 1 bit */
+};
+
+
+#define NXT_HTTP_CACHE_INDEX_SIZE   (1024 * 1024)
+#define NXT_HTTP_CACHE_MAX_SIZE     (256 * 1024 * 1024)
+#define NXT_HTTP_CACHE_LOCK_TIMEOUT (5 * 1000)
+
+/* The size of the lvlhsh memory used by an entry is estimated. */
+#define NXT_HTTP_CACHE_ENTRY_SIZE   (sizeof(nxt_http_cache_entry_t) + 128)
+
+/* The maximum number of entries evicted at once. */
+#define NXT_HTTP_CACHE_EVICT        16
+
+/* The "/" and "XXXXXXXX-XXXXXXXX" file name followed by '\0'. */
+#define NXT_HTTP_CACHE_NAME_LEN     (1 + 8 + 1 + 8 + 1)
+
+
+static nxt_int_t nxt_http_cache_lookup(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *ctx);
+static nxt_http_cache_entry_t *nxt_http_cache_entry_add(
+    nxt_http_cache_t *cache, nxt_lvlhsh_query_t *lhq, uint32_t *stale,
+    nxt_uint_t *n);
+static nxt_bool_t nxt_http_cache_evict(nxt_http_cache_t *cache,
+    uint32_t *stale, nxt_uint_t *n);
+static void nxt_http_cache_entry_delete(nxt_http_cache_t *cache,
+    nxt_http_cache_entry_t *entry);
+static nxt_int_t nxt_http_cache_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_t *cache, nxt_http_cache_entry_t *hit);
+static nxt_int_t nxt_http_cache_header_parse(nxt_http_request_t *r, u_char *p,
+    size_t size);
+static nxt_time_t nxt_http_cache_valid(nxt_http_request_t *r, nxt_time_t now,
+    nxt_time_t valid);
+static nxt_time_t nxt_http_cache_max_age(nxt_http_field_t *field,
+    const char *name, size_t length);
+static u_char *nxt_http_cache_header(nxt_http_request_t *r, size_t *size);
+static void nxt_http_cache_fill_done(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *ctx);
+static void nxt_http_cache_fill_abort(nxt_task_t *task,
+    nxt_http_cache_t *cache, nxt_http_cache_ctx_t *ctx);
+static void nxt_http_cache_waiters(nxt_http_cache_entry_t *entry,
+    nxt_queue_t *waiters, nxt_bool_t bypass);
+static void nxt_http_cache_wake(nxt_queue_t *waiters);
+static void nxt_http_cache_wait_timeout(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_cache_resume(nxt_task_t *task, void *obj, void *data);
+static void nxt_http_cache_resume_timer(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_cache_continue(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *ctx);
+static void nxt_http_cache_unlink(nxt_http_cache_t *cache, uint32_t *stale,
+    nxt_uint_t n);
+static void nxt_http_cache_file_name(nxt_http_cache_t *cache, uint32_t number,
+    u_char *name);
+static void nxt_http_cache_destroy(nxt_task_t *task, void *obj, void *data);
+static nxt_int_t nxt_http_cache_test(nxt_lvlhsh_query_t *lhq, void *data);
+static void *nxt_http_cache_alloc(void *zone, size_t size);
+static void nxt_http_cache_free(void *zone, void *p);
+
+
+static const nxt_lvlhsh_proto_t  nxt_http_cache_proto  nxt_aligned(64) = {
+    NXT_LVLHSH_DEFAULT,
+    nxt_http_cache_test,
+    nxt_http_cache_alloc,
+    nxt_http_cache_free,
+};
+
+
+static const nxt_http_request_state_t  nxt_http_cache_state
+    nxt_aligned(64) =
+{
+    .error_handler = nxt_http_request_error_handler,
+};
+
+
+static nxt_conf_map_t  nxt_http_cache_map[] = {
+    {
+        nxt_string("path"),
+        NXT_CONF_MAP_STR_COPY,
+        offsetof(nxt_http_cache_t, path),
+    },
+
+    {
+        nxt_string("max_size"),
+        NXT_CONF_MAP_OFF,
+        offsetof(nxt_http_cache_t, max_size),
+    },
+
+    {
+        nxt_string("index_size"),
+        NXT_CONF_MAP_SIZE,
+        offsetof(nxt_http_cache_t, index_size),
+    },
+};
+
+
+static nxt_conf_map_t  nxt_http_cache_conf_map[] = {
+    {
+        nxt_string("valid"),
+        NXT_CONF_MAP_INT,
+        offsetof(nxt_http_cache_conf_t, valid),
+    },
+
+    {
+        nxt_string("lock_timeout"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_http_cache_conf_t, lock_timeout),
+    },
+};
+
+
+nxt_int_t
+nxt_http_cache_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_conf_value_t *conf)
+{
+    u_char            *start;
+    size_t            size, offset;
+    nxt_int_t         ret;
+    nxt_http_cache_t  *cache, hc;
+
+    static uint32_t  id;
+
+    nxt_memzero(&hc, sizeof(nxt_http_cache_t));
+
+    hc.max_size = NXT_HTTP_CACHE_MAX_SIZE;
+    hc.index_size = NXT_HTTP_CACHE_INDEX_SIZE;
+
+    ret = nxt_conf_map_object(rtcf->mem_pool, conf, nxt_http_cache_map,
+                              nxt_nitems(nxt_http_cache_map), &hc);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    while (hc.path.length > 1 && hc.path.start[hc.path.length - 1] == '/') {
+        hc.path.length--;
+    }
+
+    if (hc.path.length + NXT_HTTP_CACHE_NAME_LEN > PATH_MAX) {
+        nxt_alert(task, "cache path \"%V\" is too long", &hc.path);
+        return NXT_ERROR;
+    }
+
+    size = nxt_align_size(hc.index_size, nxt_pagesize);
+
+    start = nxt_mem_mmap(NULL, size, NXT_MEM_MAP_READ | NXT_MEM_MAP_WRITE,
+                         NXT_MEM_MAP_SHARED, -1, 0);
+    if (nxt_slow_path(start == NXT_MEM_MAP_FAILED)) {
+        return NXT_ERROR;
+    }
+
+    cache = (nxt_http_cache_t *) start;
+    *cache = hc;
+
+    cache->index_size = size;
+
+    offset = nxt_align_size(sizeof(nxt_http_cache_t), NXT_MAX_ALIGNMENT);
+
+    cache->zone = nxt_mem_zone_init(start + offset, size - offset,
+                                    nxt_pagesize);
+    if (nxt_slow_path(cache->zone == NULL)) {
+        nxt_alert(task, "cache index_size %uz is too small", size);
+        nxt_mem_munmap(start, size);
+        return NXT_ERROR;
+    }
+
+    cache->zone_size = size - offset;
+
+    nxt_queue_init(&cache->lru);
+
+    cache->id = ++id;
+
+    ret = nxt_mp_cleanup(rtcf->mem_pool, nxt_http_cache_destroy,
+                         &task->thread->engine->task, cache, NULL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_mem_munmap(start, size);
+        return NXT_ERROR;
+    }
+
+    rtcf->cache = cache;
+
+    return NXT_OK;
+}
+
+
+nxt_int_t
+nxt_http_cache_conf_init(nxt_router_conf_t *rtcf, nxt_http_action_t *action,
+    nxt_http_action_conf_t *acf)
+{
+    nxt_int_t              ret;
+    nxt_str_t              str;
+    nxt_conf_value_t       *cv;
+    nxt_http_cache_conf_t  *conf;
+
+    static nxt_str_t  key_path = nxt_string("/key");
+    static nxt_str_t  default_key = nxt_string("$host$request_uri");
+
+    if (nxt_slow_path(rtcf->cache == NULL)) {
+        return NXT_ERROR;
+    }
+
+    conf = nxt_mp_zget(rtcf->mem_pool, sizeof(nxt_http_cache_conf_t));
+    if (nxt_slow_path(conf == NULL)) {
+        return NXT_ERROR;
+    }
+
+    conf->lock_timeout = NXT_HTTP_CACHE_LOCK_TIMEOUT;
+
+    ret = nxt_conf_map_object(rtcf->mem_pool, acf->cache,
+                              nxt_http_cache_conf_map,
+                              nxt_nitems(nxt_http_cache_conf_map), conf);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    cv = nxt_conf_get_path(acf->cache, &key_path);
+
+    if (cv != NULL) {
+        nxt_conf_get_string(cv, &str);
+
+    } else {
+        str = default_key;
+    }
+
+    conf->key = nxt_tstr_compile(rtcf->tstr_state, &str, 0);
+    if (nxt_slow_path(conf->key == NULL)) {
+        return NXT_ERROR;
+    }
+
+    action->cache = conf;
+
+    return NXT_OK;
+}
+
+
+/*
+ * Returns NXT_OK if the request should be passed to the action, and
+ * NXT_DONE if the response has been served from the cache or the request
+ * waits for the entry being filled by another request.
+ */
+
+nxt_int_t
+nxt_http_cache_handler(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action)
+{
+    nxt_int_t             ret;
+    nxt_router_conf_t     *rtcf;
+    nxt_http_cache_ctx_t  *ctx;
+
+    if (r->cache != NULL
+        || r->authorization != NULL
+        || r->websocket_handshake
+        || !(nxt_str_eq(r->method, "GET", 3)
+             || nxt_str_eq(r->method, "HEAD", 4)))
+    {
+        return NXT_OK;
+    }
+
+    ctx = nxt_mp_zget(r->mem_pool, sizeof(nxt_http_cache_ctx_t));
+    if (nxt_slow_path(ctx == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ctx->request = r;
+    ctx->action = action;
+    ctx->file.fd = -1;
+
+    if (nxt_tstr_is_const(action->cache->key)) {
+        nxt_tstr_str(action->cache->key, &ctx->key);
+
+    } else {
+        rtcf = r->conf->socket_conf->router_conf;
+
+        ret = nxt_tstr_query_init(&r->tstr_query, rtcf->tstr_state,
+                                  &r->tstr_cache, r, r->mem_pool);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        nxt_tstr_query(task, r->tstr_query, action->cache->key, &ctx->key);
+
+        if (nxt_slow_path(nxt_tstr_query_failed(r->tstr_query))) {
+            return NXT_ERROR;
+        }
+    }
+
+    ctx->key_hash = nxt_djb_hash(ctx->key.start, ctx->key.length);
+
+    return nxt_http_cache_lookup(task, r, ctx);
+}
+
+
+static nxt_int_t
+nxt_http_cache_lookup(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *ctx)
+{
+    uint32_t                stale[NXT_HTTP_CACHE_EVICT];
+    nxt_int_t               ret;
+    nxt_uint_t              n;
+    nxt_time_t              now;
+    nxt_bool_t              head;
+    nxt_msec_t              timeout;
+    nxt_http_cache_t        *cache;
+    nxt_lvlhsh_query_t      lhq;
+    nxt_http_cache_entry_t  *entry, hit;
+
+    cache = r->conf->socket_conf->router_conf->cache;
+    timeout = ctx->action->cache->lock_timeout;
+
+    head = nxt_str_eq(r->method, "HEAD", 4);
+    now = nxt_thread_time(task->thread);
+    n = 0;
+
+    lhq.key = ctx->key;
+    lhq.key_hash = ctx->key_hash;
+    lhq.proto = &nxt_http_cache_proto;
+    lhq.pool = cache->zone;
+
+    ctx->engine = task->thread->engine;
+
+    nxt_thread_spin_lock(&cache->lock);
+
+    if (nxt_lvlhsh_find(&cache->hash, &lhq) == NXT_OK) {
+        entry = lhq.value;
+
+        if (entry->updating) {
+            if (timeout == 0) {
+                nxt_thread_spin_unlock(&cache->lock);
+                return NXT_OK;
+            }
+
+            nxt_work_set(&ctx->work, nxt_http_cache_resume, &ctx->engine->task,
+                         r, ctx);
+
+            nxt_queue_insert_tail(&entry->waiters, &ctx->link);
+            ctx->waiting = 1;
+
+            nxt_thread_spin_unlock(&cache->lock);
+
+            nxt_debug(task, "http cache wait: \"%V\"", &ctx->key);
+
+            nxt_mp_retain(r->mem_pool);
+            r->state = &nxt_http_cache_state;
+
+            ctx->timer.handler = nxt_http_cache_wait_timeout;
+            ctx->timer.work_queue = &ctx->engine->fast_work_queue;
+            ctx->timer.task = &ctx->engine->task;
+            ctx->timer.log = ctx->engine->task.log;
+            ctx->timer.bias = NXT_TIMER_DEFAULT_BIAS;
+
+            nxt_timer_add(ctx->engine, &ctx->timer, timeout);
+
+            return NXT_DONE;
+        }
+
+        if (now < entry->expires) {
+            nxt_queue_remove(&entry->link);
+            nxt_queue_insert_head(&cache->lru, &entry->link);
+
+            hit = *entry;
+
+            nxt_thread_spin_unlock(&cache->lock);
+
+            nxt_debug(task, "http cache hit: \"%V\"", &ctx->key);
+
+            ret = nxt_http_cache_send(task, r, cache, &hit);
+
+            /* The entry file may have been just evicted. */
+            return (ret == NXT_DECLINED) ? NXT_OK : ret;
+        }
+
+        if (head) {
+            nxt_thread_spin_unlock(&cache->lock);
+            return NXT_OK;
+        }
+
+        /* The expired entry is updated. */
+
+        nxt_queue_remove(&entry->link);
+
+        cache->size -= entry->size;
+        stale[n++] = entry->number;
+
+        entry->updating = 1;
+
+    } else {
+        if (head) {
+            nxt_thread_spin_unlock(&cache->lock);
+            return NXT_OK;
+        }
+
+        entry = nxt_http_cache_entry_add(cache, &lhq, stale, &n);
+    }
+
+    if (entry != NULL) {
+        entry->number = ++cache->number;
+        ctx->number = entry->number;
+    }
+
+    nxt_thread_spin_unlock(&cache->lock);
+
+    nxt_http_cache_unlink(cache, stale, n);
+
+    if (nxt_fast_path(entry != NULL)) {
+        nxt_debug(task, "http cache miss: \"%V\"", &ctx->key);
+
+        ctx->entry = entry;
+        r->cache = ctx;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_http_cache_entry_t *
+nxt_http_cache_entry_add(nxt_http_cache_t *cache, nxt_lvlhsh_query_t *lhq,
+    uint32_t *stale, nxt_uint_t *n)
+{
+    size_t                  size;
+    nxt_http_cache_entry_t  *entry;
+
+    size = NXT_HTTP_CACHE_ENTRY_SIZE + lhq->key.length;
+
+    /*
+     * The zone is kept half-empty, so an allocation does not fail
+     * because of fragmentation.
+     */
+
+    while (cache->zone_used + size > cache->zone_size / 2
+           && *n < NXT_HTTP_CACHE_EVICT)
+    {
+        if (!nxt_http_cache_evict(cache, stale, n)) {
+            break;
+        }
+    }
+
+    entry = nxt_mem_zone_zalloc(cache->zone,
+                                sizeof(nxt_http_cache_entry_t)
+                                + lhq->key.length);
+    if (nxt_slow_path(entry == NULL)) {
+        return NULL;
+    }
+
+    entry->key.length = lhq->key.length;
+    entry->key.start = nxt_pointer_to(entry, sizeof(nxt_http_cache_entry_t));
+    nxt_memcpy(entry->key.start, lhq->key.start, lhq->key.length);
+
+    entry->key_hash = lhq->key_hash;
+    entry->updating = 1;
+
+    nxt_queue_init(&entry->waiters);
+
+    lhq->replace = 0;
+    lhq->value = entry;
+
+    if (nxt_slow_path(nxt_lvlhsh_insert(&cache->hash, lhq) != NXT_OK)) {
+        nxt_mem_zone_free(cache->zone, entry);
+        return NULL;
+    }
+
+    cache->zone_used += size;
+
+    return entry;
+}
+
+
+static nxt_bool_t
+nxt_http_cache_evict(nxt_http_cache_t *cache, uint32_t *stale, nxt_uint_t *n)
+{
+    nxt_queue_link_t        *link;
+    nxt_http_cache_entry_t  *entry;
+
+    if (nxt_queue_is_empty(&cache->lru)) {
+        return 0;
+    }
+
+    link = nxt_queue_last(&cache->lru);
+    nxt_queue_remove(link);
+
+    entry = nxt_queue_link_data(link, nxt_http_cache_entry_t, link);
+
+    cache->size -= entry->size;
+    stale[(*n)++] = entry->number;
+
+    nxt_http_cache_entry_delete(cache, entry);
+
+    return 1;
+}
+
+
+static void
+nxt_http_cache_entry_delete(nxt_http_cache_t *cache,
+    nxt_http_cache_entry_t *entry)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key = entry->key;
+    lhq.key_hash = entry->key_hash;
+    lhq.proto = &nxt_http_cache_proto;
+    lhq.pool = cache->zone;
+
+    (void) nxt_lvlhsh_delete(&cache->hash, &lhq);
+
+    cache->zone_used -= NXT_HTTP_CACHE_ENTRY_SIZE + entry->key.length;
+
+    nxt_mem_zone_free(cache->zone, entry);
+}
+
+
+static nxt_int_t
+nxt_http_cache_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_t *cache, nxt_http_cache_entry_t *hit)
+{
+    u_char      *p;
+    ssize_t     n;
+    nxt_int_t   ret;
+    nxt_file_t  *f;
+
+    f = nxt_mp_zget(r->mem_pool, sizeof(nxt_file_t) + cache->path.length
+                                 + NXT_HTTP_CACHE_NAME_LEN);
+    if (nxt_slow_path(f == NULL)) {
+        return NXT_ERROR;
+    }
+
+    f->name = nxt_pointer_to(f, sizeof(nxt_file_t));
+
+    nxt_http_cache_file_name(cache, hit->number, f->name);
+
+    ret = nxt_file_open(task, f, NXT_FILE_RDONLY, NXT_FILE_OPEN, 0);
+    if (ret != NXT_OK) {
+        return NXT_DECLINED;
+    }
+
+    p = nxt_mp_nget(r->mem_pool, hit->header);
+    if (nxt_slow_path(p == NULL)) {
+        goto fail;
+    }
+
+    n = nxt_file_read(f, p, hit->header, 0);
+
+    if (nxt_slow_path(n != (ssize_t) hit->header)) {
+        nxt_file_close(task, f);
+        return NXT_DECLINED;
+    }
+
+    ret = nxt_http_cache_header_parse(r, p, hit->header);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        goto fail;
+    }
+
+    r->resp.content_length_n = hit->size - hit->header;
+
+    if (r->resp.content_length_n == 0 || nxt_str_eq(r->method, "HEAD", 4)) {
+        nxt_file_close(task, f);
+
+        nxt_http_request_header_send(task, r, NULL, NULL);
+
+        r->state = &nxt_http_cache_state;
+
+    } else {
+        nxt_http_static_file_send(task, r, f, hit->header, hit->size);
+    }
+
+    return NXT_DONE;
+
+fail:
+
+    nxt_file_close(task, f);
+
+    return NXT_ERROR;
+}
+
+
+static nxt_int_t
+nxt_http_cache_header_parse(nxt_http_request_t *r, u_char *p, size_t size)
+{
+    u_char                   *end;
+    nxt_uint_t               i;
+    nxt_http_field_t         *field;
+    nxt_http_cache_field_t   cf;
+    nxt_http_cache_header_t  header;
+
+    end = p + size;
+
+    nxt_memcpy(&header, p, sizeof(nxt_http_cache_header_t));
+    p += sizeof(nxt_http_cache_header_t);
+
+    for (i = 0; i < header.nfields; i++) {
+
+        if (nxt_slow_path((size_t) (end - p)
+                          < sizeof(nxt_http_cache_field_t)))
+        {
+            return NXT_ERROR;
+        }
+
+        nxt_memcpy(&cf, p, sizeof(nxt_http_cache_field_t));
+        p += sizeof(nxt_http_cache_field_t);
+
+        if (nxt_slow_path(cf.name_length > 255
+                          || (size_t) (end - p)
+                             < (size_t) cf.name_length + cf.value_length))
+        {
+            return NXT_ERROR;
+        }
+
+        field = nxt_list_zero_add(r->resp.fields);
+        if (nxt_slow_path(field == NULL)) {
+            return NXT_ERROR;
+        }
+
+        field->name = p;
+        field->name_length = cf.name_length;
+        p += cf.name_length;
+
+        field->value = p;
+        field->value_length = cf.value_length;
+        p += cf.value_length;
+    }
+
+    r->status = header.status;
+
+    return NXT_OK;
+}
+
+
+/*
+ * Called before the response header is sent.  The response is stored
+ * if it is cacheable, otherwise the waiting requests are released.
+ */
+
+nxt_int_t
+nxt_http_cache_init(nxt_task_t *task, nxt_http_request_t *r)
+{
+    u_char                *header;
+    size_t                size;
+    ssize_t               n;
+    nxt_int_t             ret;
+    nxt_time_t            now, valid;
+    nxt_http_cache_t      *cache;
+    nxt_http_cache_ctx_t  *ctx;
+
+    ctx = r->cache;
+
+    if (ctx == NULL) {
+        return NXT_OK;
+    }
+
+    cache = r->conf->socket_conf->router_conf->cache;
+
+    now = nxt_thread_time(task->thread);
+
+    if (r->status != NXT_HTTP_OK
+        || r->resp.content_length_n > cache->max_size)
+    {
+        goto bypass;
+    }
+
+    valid = nxt_http_cache_valid(r, now, ctx->action->cache->valid);
+
+    if (valid <= 0) {
+        goto bypass;
+    }
+
+    header = nxt_http_cache_header(r, &size);
+    if (nxt_slow_path(header == NULL)) {
+        nxt_http_cache_fill_abort(task, cache, ctx);
+        return NXT_ERROR;
+    }
+
+    ctx->file.name = nxt_mp_nget(r->mem_pool,
+                                 cache->path.length + NXT_HTTP_CACHE_NAME_LEN);
+    if (nxt_slow_path(ctx->file.name == NULL)) {
+        nxt_http_cache_fill_abort(task, cache, ctx);
+        return NXT_ERROR;
+    }
+
+    nxt_http_cache_file_name(cache, ctx->number, ctx->file.name);
+
+    ctx->file.log_level = NXT_LOG_ERR;
+
+    ret = nxt_file_open(task, &ctx->file, NXT_FILE_WRONLY, NXT_FILE_TRUNCATE,
+                        NXT_FILE_OWNER_ACCESS);
+    if (ret != NXT_OK) {
+        ctx->file.fd = -1;
+        goto bypass;
+    }
+
+    n = nxt_file_write(&ctx->file, header, size, 0);
+
+    if (nxt_slow_path(n != (ssize_t) size)) {
+        goto bypass;
+    }
+
+    ctx->header = size;
+    ctx->size = size;
+    ctx->expires = now + valid;
+
+    return NXT_OK;
+
+bypass:
+
+    nxt_http_cache_fill_abort(task, cache, ctx);
+
+    return NXT_OK;
+}
+
+
+static nxt_time_t
+nxt_http_cache_valid(nxt_http_request_t *r, nxt_time_t now, nxt_time_t valid)
+{
+    nxt_time_t        max_age, s_maxage, expires;
+    nxt_http_field_t  *field;
+
+    max_age = -1;
+    s_maxage = -1;
+    expires = -1;
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (field->skip) {
+            continue;
+        }
+
+        switch (field->name_length) {
+
+        case nxt_length("Cache-Control"):
+            if (nxt_strncasecmp(field->name, (u_char *) "Cache-Control", 13)
+                != 0)
+            {
+                break;
+            }
+
+            if (nxt_memcasestrn(field->value,
+                                field->value + field->value_length,
+                                "no-store", 8) != NULL
+                || nxt_memcasestrn(field->value,
+                                   field->value + field->value_length,
+                                   "no-cache", 8) != NULL
+                || nxt_memcasestrn(field->value,
+                                   field->value + field->value_length,
+                                   "private", 7) != NULL)
+            {
+                return 0;
+            }
+
+            max_age = nxt_http_cache_max_age(field, "max-age=", 8);
+            s_maxage = nxt_http_cache_max_age(field, "s-maxage=", 9);
+
+            break;
+
+        case nxt_length("Expires"):
+            if (nxt_strncasecmp(field->name, (u_char *) "Expires", 7) == 0) {
+                expires = nxt_time_parse(field->value, field->value_length);
+
+                /* An invalid date means that the response is expired. */
+                expires = (expires > now) ? expires - now : 0;
+            }
+
+            break;
+
+        case nxt_length("Set-Cookie"):
+            if (nxt_strncasecmp(field->name, (u_char *) "Set-Cookie", 10)
+                == 0)
+            {
+                return 0;
+            }
+
+            break;
+
+        case nxt_length("Vary"):
+            if (nxt_strncasecmp(field->name, (u_char *) "Vary", 4) == 0) {
+                return 0;
+            }
+
+            break;
+        }
+
+    } nxt_list_loop;
+
+    if (s_maxage >= 0) {
+        return s_maxage;
+    }
+
+    if (max_age >= 0) {
+        return max_age;
+    }
+
+    if (expires >= 0) {
+        return expires;
+    }
+
+    return valid;
+}
+
+
+static nxt_time_t
+nxt_http_cache_max_age(nxt_http_field_t *field, const char *name,
+    size_t length)
+{
+    u_char  *p, *start, *end;
+
+    end = field->value + field->value_length;
+
+    p = nxt_memcasestrn(field->value, end, name, length);
+
+    if (p == NULL
+        || (p != field->value && p[-1] != ',' && p[-1] != ' '
+            && p[-1] != '\t'))
+    {
+        return -1;
+    }
+
+    start = p + length;
+
+    for (p = start; p < end && *p >= '0' && *p <= '9'; p++) { /* void */ }
+
+    return nxt_int_parse(start, p - start);
+}
+
+
+static u_char *
+nxt_http_cache_header(nxt_http_request_t *r, size_t *size)
+{
+    u_char                   *start, *p;
+    nxt_http_field_t         *field;
+    nxt_http_cache_field_t   cf;
+    nxt_http_cache_header_t  header;
+
+    header.status = r->status;
+    header.nfields = 0;
+    header.size = sizeof(nxt_http_cache_header_t);
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (field->skip || field->hopbyhop
+            || field == r->resp.content_length || field == r->resp.date)
+        {
+            continue;
+        }
+
+        header.nfields++;
+        header.size += sizeof(nxt_http_cache_field_t) + field->name_length
+                       + field->value_length;
+
+    } nxt_list_loop;
+
+    start = nxt_mp_nget(r->mem_pool, header.size);
+    if (nxt_slow_path(start == NULL)) {
+        return NULL;
+    }
+
+    p = nxt_cpymem(start, &header, sizeof(nxt_http_cache_header_t));
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (field->skip || field->hopbyhop
+            || field == r->resp.content_length || field == r->resp.date)
+        {
+            continue;
+        }
+
+        cf.name_length = field->name_length;
+        cf.value_length = field->value_length;
+
+        p = nxt_cpymem(p, &cf, sizeof(nxt_http_cache_field_t));
+        p = nxt_cpymem(p, field->name, field->name_length);
+        p = nxt_cpymem(p, field->value, field->value_length);
+
+    } nxt_list_loop;
+
+    *size = header.size;
+
+    return start;
+}
+
+
+void
+nxt_http_cache_write(nxt_task_t *task, nxt_http_request_t *r, nxt_buf_t *out)
+{
+    size_t                size;
+    ssize_t               n;
+    nxt_buf_t             *b;
+    nxt_http_cache_t      *cache;
+    nxt_http_cache_ctx_t  *ctx;
+
+    ctx = r->cache;
+
+    if (ctx->file.fd == -1) {
+        /* The response is not stored. */
+        return;
+    }
+
+    cache = r->conf->socket_conf->router_conf->cache;
+
+    for (b = out; b != NULL; b = b->next) {
+
+        if (nxt_buf_is_sync(b)) {
+
+            if (nxt_buf_is_last(b)) {
+                nxt_http_cache_fill_done(task, r, ctx);
+                return;
+            }
+
+            continue;
+        }
+
+        if (nxt_slow_path(!nxt_buf_is_mem(b))) {
+            break;
+        }
+
+        size = nxt_buf_mem_used_size(&b->mem);
+
+        if (size == 0) {
+            continue;
+        }
+
+        if (ctx->size - ctx->header + (nxt_off_t) size > cache->max_size) {
+            break;
+        }
+
+        n = nxt_file_write(&ctx->file, b->mem.pos, size, ctx->size);
+
+        if (nxt_slow_path(n != (ssize_t) size)) {
+            break;
+        }
+
+        ctx->size += n;
+    }
+
+    if (b != NULL) {
+        nxt_http_cache_fill_abort(task, cache, ctx);
+    }
+}
+
+
+static void
+nxt_http_cache_fill_done(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *ctx)
+{
+    uint32_t                stale[NXT_HTTP_CACHE_EVICT];
+    nxt_uint_t              n;
+    nxt_queue_t             waiters;
+    nxt_http_cache_t        *cache;
+    nxt_http_cache_entry_t  *entry;
+
+    cache = r->conf->socket_conf->router_conf->cache;
+
+    nxt_file_close(task, &ctx->file);
+    ctx->file.fd = -1;
+
+    entry = ctx->entry;
+    ctx->entry = NULL;
+    r->cache = NULL;
+
+    nxt_debug(task, "http cache stored: \"%V\" %O", &ctx->key, ctx->size);
+
+    n = 0;
+    nxt_queue_init(&waiters);
+
+    nxt_thread_spin_lock(&cache->lock);
+
+    nxt_http_cache_waiters(entry, &waiters, 0);
+
+    entry->header = ctx->header;
+    entry->size = ctx->size;
+    entry->expires = ctx->expires;
+    entry->updating = 0;
+
+    nxt_queue_insert_head(&cache->lru, &entry->link);
+    cache->size += entry->size;
+
+    while (cache->size > cache->max_size && n < NXT_HTTP_CACHE_EVICT) {
+        (void) nxt_http_cache_evict(cache, stale, &n);
+    }
+
+    nxt_thread_spin_unlock(&cache->lock);
+
+    nxt_http_cache_unlink(cache, stale, n);
+
+    nxt_http_cache_wake(&waiters);
+}
+
+
+/*
+ * The entry is removed, and the waiting requests are passed to the action
+ * without caching, as otherwise they would be serialized when the response
+ * is not cacheable.
+ */
+
+static void
+nxt_http_cache_fill_abort(nxt_task_t *task, nxt_http_cache_t *cache,
+    nxt_http_cache_ctx_t *ctx)
+{
+    nxt_queue_t             waiters;
+    nxt_http_cache_entry_t  *entry;
+
+    if (ctx->file.fd != -1) {
+        nxt_file_close(task, &ctx->file);
+        ctx->file.fd = -1;
+
+        (void) nxt_file_delete(ctx->file.name);
+    }
+
+    entry = ctx->entry;
+    ctx->entry = NULL;
+
+    nxt_debug(task, "http cache bypass: \"%V\"", &ctx->key);
+
+    nxt_queue_init(&waiters);
+
+    nxt_thread_spin_lock(&cache->lock);
+
+    nxt_http_cache_waiters(entry, &waiters, 1);
+
+    nxt_http_cache_entry_delete(cache, entry);
+
+    nxt_thread_spin_unlock(&cache->lock);
+
+    nxt_http_cache_wake(&waiters);
+}
+
+
+/*
+ * The waiting requests are taken from the entry under the cache lock,
+ * so a request whose lock timer has expired is either still linked in
+ * the entry or is already being woken up.
+ */
+
+static void
+nxt_http_cache_waiters(nxt_http_cache_entry_t *entry, nxt_queue_t *waiters,
+    nxt_bool_t bypass)
+{
+    nxt_queue_link_t      *link;
+    nxt_http_cache_ctx_t  *ctx;
+
+    if (nxt_queue_is_empty(&entry->waiters)) {
+        return;
+    }
+
+    nxt_queue_add(waiters, &entry->waiters);
+    nxt_queue_init(&entry->waiters);
+
+    for (link = nxt_queue_first(waiters);
+         link != nxt_queue_tail(waiters);
+         link = nxt_queue_next(link))
+    {
+        ctx = nxt_queue_link_data(link, nxt_http_cache_ctx_t, link);
+
+        ctx->waiting = 0;
+        ctx->bypass = bypass;
+    }
+}
+
+
+static void
+nxt_http_cache_wake(nxt_queue_t *waiters)
+{
+    nxt_queue_link_t      *link, *next;
+    nxt_http_cache_ctx_t  *ctx;
+
+    for (link = nxt_queue_first(waiters);
+         link != nxt_queue_tail(waiters);
+         link = next)
+    {
+        next = nxt_queue_next(link);
+
+        ctx = nxt_queue_link_data(link, nxt_http_cache_ctx_t, link);
+
+        ctx->work.next = NULL;
+
+        nxt_event_engine_post(ctx->engine, &ctx->work);
+    }
+}
+
+
+static void
+nxt_http_cache_wait_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_bool_t            waiting;
+    nxt_timer_t           *timer;
+    nxt_http_cache_t      *cache;
+    nxt_http_request_t    *r;
+    nxt_http_cache_ctx_t  *ctx;
+
+    timer = obj;
+
+    ctx = nxt_timer_data(timer, nxt_http_cache_ctx_t, timer);
+    r = ctx->request;
+
+    cache = r->conf->socket_conf->router_conf->cache;
+
+    nxt_thread_spin_lock(&cache->lock);
+
+    waiting = ctx->waiting;
+
+    if (waiting) {
+        nxt_queue_remove(&ctx->link);
+        ctx->waiting = 0;
+    }
+
+    nxt_thread_spin_unlock(&cache->lock);
+
+    if (!waiting) {
+        /* The request has been already posted to be resumed. */
+        return;
+    }
+
+    nxt_debug(task, "http cache lock timeout: \"%V\"", &ctx->key);
+
+    ctx->bypass = 1;
+
+    nxt_http_cache_continue(task, r, ctx);
+}
+
+
+static void
+nxt_http_cache_resume(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_request_t    *r;
+    nxt_http_cache_ctx_t  *ctx;
+
+    r = obj;
+    ctx = data;
+
+    if (nxt_timer_delete(ctx->engine, &ctx->timer)) {
+        /* The request is resumed after the pending timer operations. */
+        ctx->timer.handler = nxt_http_cache_resume_timer;
+        nxt_timer_add(ctx->engine, &ctx->timer, 0);
+        return;
+    }
+
+    nxt_http_cache_continue(task, r, ctx);
+}
+
+
+static void
+nxt_http_cache_resume_timer(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_timer_t           *timer;
+    nxt_http_cache_ctx_t  *ctx;
+
+    timer = obj;
+
+    ctx = nxt_timer_data(timer, nxt_http_cache_ctx_t, timer);
+
+    nxt_http_cache_continue(task, ctx->request, ctx);
+}
+
+
+static void
+nxt_http_cache_continue(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_cache_ctx_t *ctx)
+{
+    nxt_int_t          ret;
+    nxt_http_action_t  *action;
+
+    if (r->error || r->proto.any == NULL) {
+        goto done;
+    }
+
+    ret = ctx->bypass ? NXT_OK : nxt_http_cache_lookup(task, r, ctx);
+
+    if (ret == NXT_OK) {
+        action = ctx->action->handler(task, r, ctx->action);
+
+        if (action == NXT_HTTP_ACTION_ERROR) {
+            ret = NXT_ERROR;
+
+        } else if (action != NULL) {
+            nxt_http_request_action(task, r, action);
+        }
+    }
+
+    if (nxt_slow_path(ret == NXT_ERROR)) {
+        nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+    }
+
+done:
+
+    nxt_mp_release(r->mem_pool);
+}
+
+
+void
+nxt_http_cache_close(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_http_cache_ctx_t  *ctx;
+
+    ctx = r->cache;
+    r->cache = NULL;
+
+    if (ctx->entry != NULL) {
+        nxt_http_cache_fill_abort(task,
+                                  r->conf->socket_conf->router_conf->cache,
+                                  ctx);
+    }
+}
+
+
+static void
+nxt_http_cache_unlink(nxt_http_cache_t *cache, uint32_t *stale, nxt_uint_t n)
+{
+    u_char      name[PATH_MAX];
+    nxt_uint_t  i;
+
+    for (i = 0; i < n; i++) {
+        nxt_http_cache_file_name(cache, stale[i], name);
+
+        (void) nxt_file_delete(name);
+    }
+}
+
+
+static void
+nxt_http_cache_file_name(nxt_http_cache_t *cache, uint32_t number,
+    u_char *name)
+{
+    (void) nxt_sprintf(name, name + cache->path.length
+                             + NXT_HTTP_CACHE_NAME_LEN,
+                       "%V/%08xD-%08xD%Z", &cache->path, cache->id, number);
+}
+
+
+static void
+nxt_http_cache_destroy(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_uint_t              n;
+    nxt_queue_link_t        *link;
+    nxt_http_cache_t        *cache;
+    nxt_http_cache_entry_t  *entry;
+    uint32_t                stale[NXT_HTTP_CACHE_EVICT];
+
+    cache = obj;
+
+    n = 0;
+
+    for (link = nxt_queue_first(&cache->lru);
+         link != nxt_queue_tail(&cache->lru);
+         link = nxt_queue_next(link))
+    {
+        entry = nxt_queue_link_data(link, nxt_http_cache_entry_t, link);
+
+        stale[n++] = entry->number;
+
+        if (n == NXT_HTTP_CACHE_EVICT) {
+            nxt_http_cache_unlink(cache, stale, n);
+            n = 0;
+        }
+    }
+
+    nxt_http_cache_unlink(cache, stale, n);
+
+    nxt_mem_munmap(cache, cache->index_size);
+}
+
+
+static nxt_int_t
+nxt_http_cache_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_http_cache_entry_t  *entry;
+
+    entry = data;
+
+    return nxt_strstr_eq(&lhq->key, &entry->key) ? NXT_OK : NXT_DECLINED;
+}
+
+
+static void *
+nxt_http_cache_alloc(void *zone, size_t size)
+{
+    return nxt_mem_zone_align(zone, size, size);
+}
+
+
+static void
+nxt_http_cache_free(void *zone, void *p)
+{
+    nxt_mem_zone_free(zone, p);
+}
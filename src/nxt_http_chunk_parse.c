@@ -156,7 +156,33 @@ nxt_http_chunk_parse(nxt_task_t *task, nxt_http_chunk_parse_t *hcp,
                         continue;
                     }
 
-                    return out;
+                    next = b->next;
+                    b->next = NULL;
+
+                    hcp->done = 1;
+                    hcp->trailing = (hcp->pos != b->mem.free || next != NULL);
+
+                    /*
+                     * The data after the last chunk are not passed on,
+                     * so the remaining buffers are completed here.
+                     */
+
+                    for ( ;; ) {
+                        if (b->retain == 0) {
+                            nxt_work_queue_add(
+                                    &task->thread->engine->fast_work_queue,
+                                    b->completion_handler, task, b, b->parent);
+                        }
+
+                        b = next;
+
+                        if (b == NULL) {
+                            return out;
+                        }
+
+                        next = b->next;
+                        b->next = NULL;
+                    }
                 }
 
                 goto chunk_error;
@@ -0,0 +1,810 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+
+#if (NXT_HAVE_ZLIB)
+#include <zlib.h>
+#endif
+
+
+/*
+ * The response body filter compresses application and proxied responses
+ * with the best content coding accepted by the client.  The compressor
+ * contexts are expensive to create, so the contexts of the completed
+ * requests are kept in a free list of the event engine and reused.
+ */
+
+typedef struct nxt_http_compress_encoding_s  nxt_http_compress_encoding_t;
+
+
+struct nxt_http_compress_s {
+    nxt_queue_link_t                    link;  /* engine free list */
+    const nxt_http_compress_encoding_t  *encoding;
+    int                                 level;
+
+    union {
+#if (NXT_HAVE_ZLIB)
+        z_stream                        zs;
+#endif
+        void                            *any;
+    } u;
+
+    /* The request part. */
+    nxt_buf_t                           *buf;
+    nxt_buf_t                           *out;
+    nxt_buf_t                           **last;
+};
+
+
+struct nxt_http_compress_encoding_s {
+    nxt_str_t                           name;
+    nxt_str_t                           path;
+    int                                 level;
+
+    nxt_int_t                           (*create)(nxt_http_compress_t *ctx);
+    nxt_int_t                           (*reset)(nxt_http_compress_t *ctx);
+    nxt_int_t                           (*compress)(nxt_http_compress_t *ctx,
+                                            nxt_buf_mem_t *in,
+                                            nxt_buf_mem_t *out,
+                                            nxt_bool_t last);
+    void                                (*free)(nxt_http_compress_t *ctx);
+};
+
+
+struct nxt_http_compress_conf_s {
+    nxt_http_route_rule_t               *types;
+    nxt_off_t                           min_length;
+    nxt_uint_t                          encodings;
+    int32_t                             level[];
+};
+
+
+typedef struct {
+    nxt_queue_t                         free;
+    nxt_uint_t                          count;
+} nxt_http_compress_cache_t;
+
+
+#define NXT_HTTP_COMPRESS_BUF_SIZE      (16 * 1024)
+#define NXT_HTTP_COMPRESS_MIN_LENGTH    256
+#define NXT_HTTP_COMPRESS_FREE_MAX      8
+
+
+static nxt_bool_t nxt_http_compress_eligible(nxt_http_request_t *r,
+    nxt_http_compress_conf_t *conf, nxt_http_field_t **content_length,
+    nxt_http_field_t **etag);
+static nxt_http_compress_t *nxt_http_compress_get(nxt_task_t *task,
+    const nxt_http_compress_encoding_t *encoding, int level);
+static void nxt_http_compress_release(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_int_t nxt_http_compress_buf(nxt_http_request_t *r,
+    nxt_http_compress_t *ctx, nxt_buf_mem_t *in, nxt_bool_t last);
+static void nxt_http_compress_buf_add(nxt_http_request_t *r,
+    nxt_http_compress_t *ctx);
+static void nxt_http_compress_buf_completion(nxt_task_t *task, void *obj,
+    void *data);
+
+#if (NXT_HAVE_ZLIB)
+static nxt_int_t nxt_http_compress_gzip_create(nxt_http_compress_t *ctx);
+static nxt_int_t nxt_http_compress_gzip_reset(nxt_http_compress_t *ctx);
+static nxt_int_t nxt_http_compress_gzip(nxt_http_compress_t *ctx,
+    nxt_buf_mem_t *in, nxt_buf_mem_t *out, nxt_bool_t last);
+static void nxt_http_compress_gzip_free(nxt_http_compress_t *ctx);
+#endif
+
+
+/* In the order of preference. */
+
+static const nxt_http_compress_encoding_t  nxt_http_compress_encodings[] = {
+#if (NXT_HAVE_ZLIB)
+    {
+        .name       = nxt_string("gzip"),
+        .path       = nxt_string("/gzip"),
+        .level      = 6,
+        .create     = nxt_http_compress_gzip_create,
+        .reset      = nxt_http_compress_gzip_reset,
+        .compress   = nxt_http_compress_gzip,
+        .free       = nxt_http_compress_gzip_free,
+    },
+#endif
+};
+
+
+#define NXT_HTTP_COMPRESS_ENCODINGS  nxt_nitems(nxt_http_compress_encodings)
+
+
+static nxt_conf_map_t  nxt_http_compress_conf[] = {
+    {
+        nxt_string("min_length"),
+        NXT_CONF_MAP_OFF,
+        offsetof(nxt_http_compress_conf_t, min_length),
+    },
+};
+
+
+static nxt_conf_map_t  nxt_http_compress_encoding_conf[] = {
+    {
+        nxt_string("level"),
+        NXT_CONF_MAP_INT32,
+        0,
+    },
+};
+
+
+nxt_int_t
+nxt_http_compress_conf_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_conf_value_t *conf)
+{
+    nxt_mp_t                  *mp;
+    nxt_int_t                 ret;
+    nxt_uint_t                i;
+    nxt_conf_value_t          *types, *value;
+    nxt_http_compress_conf_t  *ccf;
+
+    const nxt_http_compress_encoding_t  *encoding;
+
+    static nxt_str_t  types_path = nxt_string("/types");
+    static nxt_str_t  default_types = nxt_string(
+        "[\"text/*\", \"application/javascript\", \"application/json\","
+        " \"application/xml\", \"image/svg+xml\"]");
+
+    mp = rtcf->mem_pool;
+
+    ccf = nxt_mp_zget(mp, sizeof(nxt_http_compress_conf_t)
+                          + NXT_HTTP_COMPRESS_ENCODINGS * sizeof(int32_t));
+    if (nxt_slow_path(ccf == NULL)) {
+        return NXT_ERROR;
+    }
+
+    ccf->min_length = NXT_HTTP_COMPRESS_MIN_LENGTH;
+
+    ret = nxt_conf_map_object(mp, conf, nxt_http_compress_conf,
+                              nxt_nitems(nxt_http_compress_conf), ccf);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < NXT_HTTP_COMPRESS_ENCODINGS; i++) {
+        encoding = &nxt_http_compress_encodings[i];
+
+        value = nxt_conf_get_path(conf, (nxt_str_t *) &encoding->path);
+        if (value == NULL) {
+            continue;
+        }
+
+        ccf->level[i] = encoding->level;
+
+        ret = nxt_conf_map_object(mp, value, nxt_http_compress_encoding_conf,
+                                  nxt_nitems(nxt_http_compress_encoding_conf),
+                                  &ccf->level[i]);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        ccf->encodings |= 1 << i;
+    }
+
+    if (ccf->encodings == 0) {
+        return NXT_OK;
+    }
+
+    types = nxt_conf_get_path(conf, &types_path);
+
+    if (types == NULL) {
+        types = nxt_conf_json_parse_str(mp, &default_types);
+        if (nxt_slow_path(types == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    ccf->types = nxt_http_route_types_rule_create(task, mp, types);
+    if (nxt_slow_path(ccf->types == NULL)) {
+        return NXT_ERROR;
+    }
+
+    rtcf->compress = ccf;
+
+    return NXT_OK;
+}
+
+
+/*
+ * Called before the response header is sent.  The Content-Length field
+ * is removed, the Content-Encoding and Vary fields are added, and a
+ * strong ETag becomes weak since the body is not byte-for-byte the same.
+ * Only the responses with the body in memory buffers are compressed.
+ */
+
+nxt_int_t
+nxt_http_compress_init(nxt_task_t *task, nxt_http_request_t *r)
+{
+    u_char                    *p;
+    nxt_buf_t                 *b;
+    nxt_uint_t                i, accepted;
+    nxt_http_field_t          *field, *content_length, *etag;
+    nxt_http_compress_t       *ctx;
+    nxt_http_compress_conf_t  *conf;
+
+    const nxt_http_compress_encoding_t  *encoding;
+
+    static const nxt_str_t  codings[] = {
+#if (NXT_HAVE_ZLIB)
+        nxt_string("gzip"),
+#endif
+    };
+
+    conf = r->conf->socket_conf->router_conf->compress;
+
+    if (conf == NULL
+        || (r->status != NXT_HTTP_OK
+            && r->status != NXT_HTTP_FORBIDDEN
+            && r->status != NXT_HTTP_NOT_FOUND)
+        || nxt_str_eq(r->method, "HEAD", 4))
+    {
+        return NXT_OK;
+    }
+
+    for (b = r->out; b != NULL; b = b->next) {
+        if (nxt_buf_is_file(b)) {
+            return NXT_OK;
+        }
+    }
+
+    if (!nxt_http_compress_eligible(r, conf, &content_length, &etag)) {
+        return NXT_OK;
+    }
+
+    field = nxt_list_zero_add(r->resp.fields);
+    if (nxt_slow_path(field == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_http_field_set(field, "Vary", "Accept-Encoding");
+
+    accepted = nxt_http_accept_encoding(r, codings, nxt_nitems(codings))
+               & conf->encodings;
+
+    if (accepted == 0) {
+        return NXT_OK;
+    }
+
+    for (i = 0; (accepted & (1 << i)) == 0; i++) { /* void */ }
+
+    encoding = &nxt_http_compress_encodings[i];
+
+    ctx = nxt_http_compress_get(task, encoding, conf->level[i]);
+    if (nxt_slow_path(ctx == NULL)) {
+        return NXT_ERROR;
+    }
+
+    if (nxt_slow_path(nxt_mp_cleanup(r->mem_pool, nxt_http_compress_release,
+                                     &task->thread->engine->task, ctx, NULL)
+                      != NXT_OK))
+    {
+        nxt_http_compress_release(task, ctx, NULL);
+        return NXT_ERROR;
+    }
+
+    if (etag != NULL && etag->value_length > 0 && etag->value[0] == '"') {
+        p = nxt_mp_nget(r->mem_pool, etag->value_length + 2);
+        if (nxt_slow_path(p == NULL)) {
+            return NXT_ERROR;
+        }
+
+        p[0] = 'W';
+        p[1] = '/';
+        nxt_memcpy(p + 2, etag->value, etag->value_length);
+
+        etag->value = p;
+        etag->value_length += 2;
+    }
+
+    if (content_length != NULL) {
+        content_length->skip = 1;
+    }
+
+    r->resp.content_length = NULL;
+    r->resp.content_length_n = -1;
+
+    field = nxt_list_zero_add(r->resp.fields);
+    if (nxt_slow_path(field == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_http_field_name_set(field, "Content-Encoding");
+
+    field->value = encoding->name.start;
+    field->value_length = encoding->name.length;
+
+    ctx->buf = NULL;
+    ctx->out = NULL;
+    ctx->last = &ctx->out;
+
+    r->compress = ctx;
+
+    nxt_debug(task, "http compress: %V level %d", &encoding->name, ctx->level);
+
+    return NXT_OK;
+}
+
+
+static nxt_bool_t
+nxt_http_compress_eligible(nxt_http_request_t *r,
+    nxt_http_compress_conf_t *conf, nxt_http_field_t **content_length,
+    nxt_http_field_t **etag)
+{
+    u_char            *p, *end;
+    nxt_off_t         length;
+    nxt_int_t         ret;
+    nxt_http_field_t  *field, *content_type;
+
+    *content_length = NULL;
+    *etag = NULL;
+    content_type = NULL;
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (field->skip) {
+            continue;
+        }
+
+        switch (field->name_length) {
+
+        case nxt_length("ETag"):
+            if (nxt_strncasecmp(field->name, (u_char *) "ETag", 4) == 0) {
+                *etag = field;
+            }
+
+            break;
+
+        case nxt_length("Content-Type"):
+            if (nxt_strncasecmp(field->name, (u_char *) "Content-Type", 12)
+                == 0)
+            {
+                content_type = field;
+            }
+
+            break;
+
+        case nxt_length("Cache-Control"):
+            if (nxt_strncasecmp(field->name, (u_char *) "Cache-Control", 13)
+                == 0
+                && nxt_memcasestrn(field->value,
+                                   field->value + field->value_length,
+                                   "no-transform", 12)
+                   != NULL)
+            {
+                return 0;
+            }
+
+            break;
+
+        case nxt_length("Content-Length"):
+            if (nxt_strncasecmp(field->name, (u_char *) "Content-Length", 14)
+                == 0)
+            {
+                *content_length = field;
+            }
+
+            break;
+
+        case nxt_length("Content-Encoding"):
+            if (nxt_strncasecmp(field->name, (u_char *) "Content-Encoding", 16)
+                == 0)
+            {
+                return 0;
+            }
+
+            break;
+        }
+
+    } nxt_list_loop;
+
+    if (content_type == NULL) {
+        return 0;
+    }
+
+    if (*content_length != NULL) {
+        length = nxt_off_t_parse((*content_length)->value,
+                                 (*content_length)->value_length);
+
+        if (length >= 0 && length < nxt_max(conf->min_length, 1)) {
+            return 0;
+        }
+
+    } else if (r->resp.content_length_n >= 0
+               && r->resp.content_length_n < nxt_max(conf->min_length, 1))
+    {
+        return 0;
+    }
+
+    p = content_type->value;
+    end = p + content_type->value_length;
+
+    while (p < end && *p != ';' && *p != ' ' && *p != '\t') {
+        p++;
+    }
+
+    ret = nxt_http_route_test_rule(r, conf->types, content_type->value,
+                                   p - content_type->value);
+
+    return (ret == 1);
+}
+
+
+static nxt_http_compress_t *
+nxt_http_compress_get(nxt_task_t *task,
+    const nxt_http_compress_encoding_t *encoding, int level)
+{
+    nxt_queue_link_t           *link;
+    nxt_event_engine_t         *engine;
+    nxt_http_compress_t        *ctx;
+    nxt_http_compress_cache_t  *cache;
+
+    engine = task->thread->engine;
+    cache = engine->compress;
+
+    if (cache != NULL) {
+        for (link = nxt_queue_first(&cache->free);
+             link != nxt_queue_tail(&cache->free);
+             link = nxt_queue_next(link))
+        {
+            ctx = nxt_queue_link_data(link, nxt_http_compress_t, link);
+
+            if (ctx->encoding != encoding || ctx->level != level) {
+                continue;
+            }
+
+            nxt_queue_remove(link);
+            cache->count--;
+
+            if (nxt_slow_path(encoding->reset(ctx) != NXT_OK)) {
+                encoding->free(ctx);
+                nxt_free(ctx);
+                break;
+            }
+
+            nxt_debug(task, "http compress context reused");
+
+            return ctx;
+        }
+    }
+
+    ctx = nxt_zalloc(sizeof(nxt_http_compress_t));
+    if (nxt_slow_path(ctx == NULL)) {
+        return NULL;
+    }
+
+    ctx->encoding = encoding;
+    ctx->level = level;
+
+    if (nxt_slow_path(encoding->create(ctx) != NXT_OK)) {
+        nxt_alert(task, "%V compressor initialization failed",
+                  &encoding->name);
+        nxt_free(ctx);
+        return NULL;
+    }
+
+    return ctx;
+}
+
+
+static void
+nxt_http_compress_release(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_event_engine_t         *engine;
+    nxt_http_compress_t        *ctx;
+    nxt_http_compress_cache_t  *cache;
+
+    ctx = obj;
+
+    engine = task->thread->engine;
+    cache = engine->compress;
+
+    if (cache == NULL) {
+        cache = nxt_malloc(sizeof(nxt_http_compress_cache_t));
+
+        if (cache != NULL) {
+            nxt_queue_init(&cache->free);
+            cache->count = 0;
+
+            engine->compress = cache;
+        }
+    }
+
+    if (cache == NULL || cache->count == NXT_HTTP_COMPRESS_FREE_MAX) {
+        ctx->encoding->free(ctx);
+        nxt_free(ctx);
+        return;
+    }
+
+    nxt_queue_insert_head(&cache->free, &ctx->link);
+    cache->count++;
+}
+
+
+void
+nxt_http_compress_engine_free(nxt_task_t *task, nxt_event_engine_t *engine)
+{
+    nxt_queue_link_t           *link;
+    nxt_http_compress_t        *ctx;
+    nxt_http_compress_cache_t  *cache;
+
+    cache = engine->compress;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    engine->compress = NULL;
+
+    while (!nxt_queue_is_empty(&cache->free)) {
+        link = nxt_queue_first(&cache->free);
+        nxt_queue_remove(link);
+
+        ctx = nxt_queue_link_data(link, nxt_http_compress_t, link);
+
+        ctx->encoding->free(ctx);
+        nxt_free(ctx);
+    }
+
+    nxt_free(cache);
+}
+
+
+/*
+ * The input buffers are completed when the output produced from them
+ * has been sent, so the response source is not read faster than the
+ * client accepts the compressed data.  The input consumed without
+ * producing any output is completed at once.
+ */
+
+nxt_buf_t *
+nxt_http_compress(nxt_task_t *task, nxt_http_request_t *r, nxt_buf_t *in)
+{
+    nxt_buf_t            *b, *next, *last, *done, **done_last, *out;
+    nxt_http_compress_t  *ctx;
+
+    ctx = r->compress;
+
+    last = NULL;
+    done = NULL;
+    done_last = &done;
+
+    for (b = in; b != NULL; b = next) {
+        next = b->next;
+        b->next = NULL;
+
+        if (nxt_buf_is_last(b)) {
+            last = b;
+            continue;
+        }
+
+        *done_last = b;
+        done_last = &b->next;
+
+        /* File buffers are never passed to a compressed response. */
+
+        nxt_assert(!nxt_buf_is_file(b));
+
+        if (nxt_slow_path(nxt_buf_is_file(b))) {
+            goto fail;
+        }
+
+        if (nxt_buf_is_mem(b)) {
+            if (nxt_slow_path(nxt_http_compress_buf(r, ctx, &b->mem, 0)
+                              != NXT_OK))
+            {
+                goto fail;
+            }
+        }
+    }
+
+    if (last != NULL) {
+        if (nxt_slow_path(nxt_http_compress_buf(r, ctx, NULL, 1) != NXT_OK)) {
+            goto fail;
+        }
+
+        if (nxt_buf_mem_used_size(&ctx->buf->mem) != 0) {
+            nxt_http_compress_buf_add(r, ctx);
+        }
+    }
+
+    if (ctx->out != NULL) {
+        /* The last output buffer completes the consumed input. */
+        b = nxt_container_of(ctx->last, nxt_buf_t, next);
+        b->data = done;
+
+    } else if (done != NULL) {
+        nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, done);
+    }
+
+    *ctx->last = last;
+
+    out = ctx->out;
+
+    ctx->out = NULL;
+    ctx->last = &ctx->out;
+
+    return out;
+
+fail:
+
+    nxt_alert(task, "%V compression failed", &ctx->encoding->name);
+
+    if (ctx->out != NULL) {
+        nxt_http_compress_buf_completion(task, ctx->out, r);
+
+        ctx->out = NULL;
+        ctx->last = &ctx->out;
+    }
+
+    nxt_http_request_error_handler(task, r, r->proto.any);
+
+    *done_last = last;
+    nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue, done);
+
+    return NULL;
+}
+
+
+static nxt_int_t
+nxt_http_compress_buf(nxt_http_request_t *r, nxt_http_compress_t *ctx,
+    nxt_buf_mem_t *in, nxt_bool_t last)
+{
+    nxt_int_t  ret;
+    nxt_buf_t  *b;
+
+    for ( ;; ) {
+        b = ctx->buf;
+
+        if (b == NULL) {
+            b = nxt_buf_mem_alloc(r->mem_pool, NXT_HTTP_COMPRESS_BUF_SIZE, 0);
+            if (nxt_slow_path(b == NULL)) {
+                return NXT_ERROR;
+            }
+
+            b->completion_handler = nxt_http_compress_buf_completion;
+            b->parent = r;
+            b->data = NULL;
+
+            ctx->buf = b;
+        }
+
+        ret = ctx->encoding->compress(ctx, in, &b->mem, last);
+
+        if (ret != NXT_AGAIN) {
+            return ret;
+        }
+
+        /* The output buffer is full. */
+
+        nxt_http_compress_buf_add(r, ctx);
+    }
+}
+
+
+/*
+ * The partially filled buffer belongs to the request memory pool,
+ * the pool is retained only for the buffers passed for sending.
+ */
+
+static void
+nxt_http_compress_buf_add(nxt_http_request_t *r, nxt_http_compress_t *ctx)
+{
+    nxt_buf_t  *b;
+
+    b = ctx->buf;
+    ctx->buf = NULL;
+
+    *ctx->last = b;
+    ctx->last = &b->next;
+
+    nxt_mp_retain(r->mem_pool);
+}
+
+
+static void
+nxt_http_compress_buf_completion(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t           *b, *next;
+    nxt_http_request_t  *r;
+
+    b = obj;
+    r = data;
+
+    do {
+        next = b->next;
+
+        if (b->data != NULL) {
+            nxt_sendbuf_drain(task, &task->thread->engine->fast_work_queue,
+                              b->data);
+        }
+
+        nxt_mp_free(r->mem_pool, b);
+        nxt_mp_release(r->mem_pool);
+
+        b = next;
+    } while (b != NULL);
+}
+
+
+#if (NXT_HAVE_ZLIB)
+
+static nxt_int_t
+nxt_http_compress_gzip_create(nxt_http_compress_t *ctx)
+{
+    int  rc;
+
+    /* The window bits greater than 15 select the gzip format. */
+
+    rc = deflateInit2(&ctx->u.zs, ctx->level, Z_DEFLATED, 15 + 16, 8,
+                      Z_DEFAULT_STRATEGY);
+
+    return (rc == Z_OK) ? NXT_OK : NXT_ERROR;
+}
+
+
+static nxt_int_t
+nxt_http_compress_gzip_reset(nxt_http_compress_t *ctx)
+{
+    return (deflateReset(&ctx->u.zs) == Z_OK) ? NXT_OK : NXT_ERROR;
+}
+
+
+static nxt_int_t
+nxt_http_compress_gzip(nxt_http_compress_t *ctx, nxt_buf_mem_t *in,
+    nxt_buf_mem_t *out, nxt_bool_t last)
+{
+    int       rc;
+    z_stream  *zs;
+
+    zs = &ctx->u.zs;
+
+    if (in != NULL) {
+        zs->next_in = in->pos;
+        zs->avail_in = in->free - in->pos;
+
+    } else {
+        zs->next_in = NULL;
+        zs->avail_in = 0;
+    }
+
+    zs->next_out = out->free;
+    zs->avail_out = out->end - out->free;
+
+    rc = deflate(zs, last ? Z_FINISH : Z_NO_FLUSH);
+
+    if (in != NULL) {
+        in->pos = zs->next_in;
+    }
+
+    out->free = zs->next_out;
+
+    if (nxt_slow_path(rc == Z_STREAM_ERROR)) {
+        return NXT_ERROR;
+    }
+
+    if (rc == Z_STREAM_END) {
+        return NXT_OK;
+    }
+
+    if (zs->avail_out == 0) {
+        return NXT_AGAIN;
+    }
+
+    return last ? NXT_ERROR : NXT_OK;
+}
+
+
+static void
+nxt_http_compress_gzip_free(nxt_http_compress_t *ctx)
+{
+    (void) deflateEnd(&ctx->u.zs);
+}
+
+#endif
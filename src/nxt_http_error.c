@@ -40,6 +40,10 @@ nxt_http_request_error(nxt_task_t *task, nxt_http_request_t *r,
 
     r->status = status;
 
+#if (NXT_HAVE_COMPRESSION)
+    r->compress = NULL;
+#endif
+
     r->resp.fields = nxt_list_create(r->mem_pool, 8, sizeof(nxt_http_field_t));
     if (nxt_slow_path(r->resp.fields == NULL)) {
         goto fail;
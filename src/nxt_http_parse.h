@@ -105,6 +105,8 @@ typedef struct {
     uint8_t                   last;         /* 1 bit */
     uint8_t                   chunk_error;  /* 1 bit */
     uint8_t                   error;        /* 1 bit */
+    uint8_t                   done;         /* 1 bit */
+    uint8_t                   trailing;     /* 1 bit */
 } nxt_http_chunk_parse_t;
 
 
@@ -30,6 +30,8 @@ static void nxt_http_proxy_send_body(nxt_task_t *task, void *obj, void *data);
 static void nxt_http_proxy_buf_mem_completion(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_http_proxy_error(nxt_task_t *task, void *obj, void *data);
+static void nxt_http_proxy_server_free(nxt_task_t *task,
+    nxt_http_peer_t *peer);
 
 
 static const nxt_http_request_state_t  nxt_http_proxy_header_send_state;
@@ -74,7 +76,7 @@ nxt_http_proxy_init(nxt_mp_t *mp, nxt_http_action_t *action,
     }
 
     if (sa != NULL) {
-        up = nxt_mp_alloc(mp, sizeof(nxt_upstream_t));
+        up = nxt_mp_zalloc(mp, sizeof(nxt_upstream_t));
         if (nxt_slow_path(up == NULL)) {
             return NXT_ERROR;
         }
@@ -106,6 +108,11 @@ nxt_http_proxy(nxt_task_t *task, nxt_http_request_t *r,
 {
     nxt_upstream_t  *u;
 
+    if (r->body_rest != 0) {
+        nxt_http_request_body_complete(task, r, action);
+        return NULL;
+    }
+
     u = action->u.upstream;
 
     nxt_debug(task, "http proxy: \"%V\"", &u->name);
@@ -277,6 +284,18 @@ nxt_http_proxy_header_read(nxt_task_t *task, void *obj, void *data)
 
     r->state = &nxt_http_proxy_read_state;
 
+    if (nxt_slow_path(nxt_http_cache_init(task, r) != NXT_OK)) {
+        nxt_http_proxy_error(task, r, peer);
+        return;
+    }
+
+#if (NXT_HAVE_COMPRESSION)
+    if (nxt_slow_path(nxt_http_compress_init(task, r) != NXT_OK)) {
+        nxt_http_proxy_error(task, r, peer);
+        return;
+    }
+#endif
+
     nxt_http_request_header_send(task, r, nxt_http_proxy_send_body, peer);
 }
 
@@ -310,6 +329,7 @@ nxt_http_proxy_send_body(nxt_task_t *task, void *obj, void *data)
 
     } else {
         nxt_http_proto[peer->protocol].peer_close(task, peer);
+        nxt_http_proxy_server_free(task, peer);
 
         nxt_mp_release(r->mem_pool);
     }
@@ -383,12 +403,45 @@ nxt_http_proxy_error(nxt_task_t *task, void *obj, void *data)
 
     nxt_http_proto[peer->protocol].peer_close(task, peer);
 
+    if (peer->retry) {
+        /* A keep-alive connection has been closed by the upstream. */
+
+        peer->retry = 0;
+        peer->closed = 0;
+
+        r->state = &nxt_http_proxy_header_send_state;
+
+        nxt_http_proto[peer->protocol].peer_connect(task, peer);
+        return;
+    }
+
+    nxt_http_proxy_server_free(task, peer);
+
     nxt_mp_release(r->mem_pool);
 
     nxt_http_request_error(&r->task, r, peer->status);
 }
 
 
+static void
+nxt_http_proxy_server_free(nxt_task_t *task, nxt_http_peer_t *peer)
+{
+    nxt_bool_t             failed;
+    nxt_upstream_server_t  *us;
+
+    us = peer->server;
+
+    if (us->upstream->proto->free != NULL) {
+        /* Connection errors, timeouts, and 502-504 responses. */
+
+        failed = (peer->status >= NXT_HTTP_BAD_GATEWAY
+                  && peer->status <= NXT_HTTP_GATEWAY_TIMEOUT);
+
+        us->upstream->proto->free(task, us, failed);
+    }
+}
+
+
 nxt_int_t
 nxt_http_proxy_date(void *ctx, nxt_http_field_t *field, uintptr_t data)
 {
@@ -19,6 +19,8 @@ static nxt_sockaddr_t *nxt_http_request_client_ip_sockaddr(
 static void nxt_http_request_forward_protocol(nxt_http_request_t *r,
     nxt_http_field_t *field);
 static void nxt_http_request_ready(nxt_task_t *task, void *obj, void *data);
+static void nxt_http_request_body_completed(nxt_task_t *task, void *obj,
+    void *data);
 static void nxt_http_request_proto_info(nxt_task_t *task,
     nxt_http_request_t *r);
 static void nxt_http_request_mem_buf_completion(nxt_task_t *task, void *obj,
@@ -52,6 +54,7 @@ static nxt_http_name_value_t *nxt_http_cookie(nxt_array_t *array, u_char *name,
 
 static const nxt_http_request_state_t  nxt_http_request_init_state;
 static const nxt_http_request_state_t  nxt_http_request_body_state;
+static const nxt_http_request_state_t  nxt_http_request_body_complete_state;
 
 
 nxt_time_string_t  nxt_http_date_cache = {
@@ -75,6 +78,12 @@ nxt_http_init(nxt_task_t *task)
         return ret;
     }
 
+    ret = nxt_h2p_init(task);
+
+    if (ret != NXT_OK) {
+        return ret;
+    }
+
     return nxt_http_response_hash_init(task);
 }
 
@@ -567,6 +576,18 @@ nxt_http_request_action(nxt_task_t *task, nxt_http_request_t *r,
                 break;
             }
 
+            if (action->cache != NULL) {
+                ret = nxt_http_cache_handler(task, r, action);
+
+                if (ret == NXT_DONE) {
+                    return;
+                }
+
+                if (nxt_slow_path(ret != NXT_OK)) {
+                    break;
+                }
+            }
+
             action = action->handler(task, r, action);
 
             if (action == NULL) {
@@ -627,6 +648,102 @@ nxt_http_request_read_body(nxt_task_t *task, nxt_http_request_t *r)
 }
 
 
+/*
+ * A streamed request body is read on demand.  The actions which require
+ * the whole body read the rest of it first and then are resumed.
+ */
+
+void
+nxt_http_request_body_complete(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_action_t *action)
+{
+    nxt_debug(task, "http request body complete: %O", r->body_rest);
+
+    r->body_action = action;
+    r->state = &nxt_http_request_body_complete_state;
+
+    nxt_http_request_read_body(task, r);
+}
+
+
+static const nxt_http_request_state_t  nxt_http_request_body_complete_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_http_request_body_completed,
+    .error_handler = nxt_http_request_close_handler,
+};
+
+
+static void
+nxt_http_request_body_completed(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_http_action_t   *action;
+    nxt_http_request_t  *r;
+
+    r = obj;
+    action = r->body_action;
+
+    action = action->handler(task, r, action);
+
+    if (action == NXT_HTTP_ACTION_ERROR) {
+        nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+
+    } else if (action != NULL) {
+        nxt_http_request_action(task, r, action);
+    }
+}
+
+
+nxt_buf_t *
+nxt_http_request_body_file(nxt_task_t *task, nxt_http_request_t *r,
+    size_t size)
+{
+    nxt_buf_t  *b;
+    nxt_str_t  *tmp_path, tmp_name;
+
+    static const nxt_str_t tmp_name_pattern = nxt_string("/req-XXXXXXXX");
+
+    tmp_path = &r->conf->socket_conf->body_temp_path;
+
+    tmp_name.length = tmp_path->length + tmp_name_pattern.length;
+
+    b = nxt_buf_file_alloc(r->mem_pool,
+                           size + sizeof(nxt_file_t) + tmp_name.length + 1, 0);
+    if (nxt_slow_path(b == NULL)) {
+        return NULL;
+    }
+
+    tmp_name.start = nxt_pointer_to(b->mem.start, sizeof(nxt_file_t));
+
+    memcpy(tmp_name.start, tmp_path->start, tmp_path->length);
+    memcpy(tmp_name.start + tmp_path->length, tmp_name_pattern.start,
+           tmp_name_pattern.length);
+    tmp_name.start[tmp_name.length] = '\0';
+
+    b->file = (nxt_file_t *) b->mem.start;
+    nxt_memzero(b->file, sizeof(nxt_file_t));
+    b->file->fd = -1;
+    b->file->size = r->content_length_n;
+
+    b->mem.start += sizeof(nxt_file_t) + tmp_name.length + 1;
+    b->mem.pos = b->mem.start;
+    b->mem.free = b->mem.start;
+
+    b->file->fd = mkstemp((char *) tmp_name.start);
+    if (nxt_slow_path(b->file->fd == -1)) {
+        nxt_alert(task, "mkstemp(%s) failed %E", tmp_name.start, nxt_errno);
+        return NULL;
+    }
+
+    nxt_debug(task, "create body tmp file \"%V\", %d",
+              &tmp_name, b->file->fd);
+
+    unlink((char *) tmp_name.start);
+
+    return b;
+}
+
+
 void
 nxt_http_request_header_send(nxt_task_t *task, nxt_http_request_t *r,
     nxt_work_handler_t body_handler, void *data)
@@ -726,6 +843,19 @@ nxt_http_request_ws_frame_start(nxt_task_t *task, nxt_http_request_t *r,
 void
 nxt_http_request_send(nxt_task_t *task, nxt_http_request_t *r, nxt_buf_t *out)
 {
+    if (r->cache != NULL) {
+        nxt_http_cache_write(task, r, out);
+    }
+
+#if (NXT_HAVE_COMPRESSION)
+    if (r->compress != NULL) {
+        out = nxt_http_compress(task, r, out);
+        if (out == NULL) {
+            return;
+        }
+    }
+#endif
+
     if (nxt_fast_path(r->proto.any != NULL)) {
         nxt_http_proto[r->protocol].send(task, r, out);
     }
@@ -858,6 +988,10 @@ nxt_http_request_close_handler(nxt_task_t *task, void *obj, void *data)
         nxt_tstr_query_release(r->tstr_query);
     }
 
+    if (r->cache != NULL) {
+        nxt_http_cache_close(task, r);
+    }
+
     if (nxt_fast_path(proto.any != NULL)) {
         protocol = r->protocol;
 
@@ -1187,6 +1321,117 @@ nxt_http_cookie(nxt_array_t *array, u_char *name, size_t name_length,
 }
 
 
+/*
+ * Returns a bit mask of the content codings accepted by the client,
+ * the codings[] array order defines the bits.  Codings with a zero
+ * quality value are not accepted, other quality values are not taken
+ * into account.  The "*" coding stands for the codings not listed
+ * explicitly.
+ */
+
+nxt_uint_t
+nxt_http_accept_encoding(nxt_http_request_t *r, const nxt_str_t *codings,
+    nxt_uint_t n)
+{
+    u_char            *p, *end, *start;
+    size_t            length;
+    nxt_uint_t        i, accepted, listed;
+    nxt_bool_t        zero, any;
+    nxt_http_field_t  *field;
+
+    static const nxt_str_t  accept_encoding = nxt_string("Accept-Encoding");
+
+    accepted = 0;
+    listed = 0;
+    any = 0;
+
+    nxt_list_each(field, r->fields) {
+
+        if (field->name_length != accept_encoding.length
+            || nxt_strncasecmp(field->name, accept_encoding.start,
+                               accept_encoding.length) != 0)
+        {
+            continue;
+        }
+
+        p = field->value;
+        end = p + field->value_length;
+
+        while (p < end) {
+            while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+                p++;
+            }
+
+            start = p;
+
+            while (p < end
+                   && *p != ',' && *p != ';' && *p != ' ' && *p != '\t')
+            {
+                p++;
+            }
+
+            length = p - start;
+            zero = 0;
+
+            while (p < end && *p != ',') {
+
+                if (*p++ != ';') {
+                    continue;
+                }
+
+                while (p < end && (*p == ' ' || *p == '\t')) {
+                    p++;
+                }
+
+                if (end - p < 3
+                    || (p[0] != 'q' && p[0] != 'Q')
+                    || p[1] != '=')
+                {
+                    continue;
+                }
+
+                p += 2;
+                zero = (*p++ == '0');
+
+                if (p < end && *p == '.') {
+                    p++;
+
+                    while (p < end && *p == '0') {
+                        p++;
+                    }
+
+                    zero &= (p == end || (*p < '1' || *p > '9'));
+                }
+            }
+
+            if (length == 1 && *start == '*') {
+                any = !zero;
+                continue;
+            }
+
+            for (i = 0; i < n; i++) {
+                if (length == codings[i].length
+                    && nxt_strncasecmp(start, codings[i].start, length) == 0)
+                {
+                    listed |= 1 << i;
+
+                    if (!zero) {
+                        accepted |= 1 << i;
+                    }
+                }
+            }
+        }
+
+    } nxt_list_loop;
+
+    if (any) {
+        accepted |= ~listed & ((1 << n) - 1);
+    }
+
+    return accepted;
+}
+
+
 int64_t
 nxt_http_field_hash(nxt_mp_t *mp, nxt_str_t *name, nxt_bool_t case_sensitive,
     uint8_t encoding)
@@ -103,6 +103,10 @@ struct nxt_http_route_rule_s {
         } name;
     } u;
 
+    /* The last "compiled" positive patterns are looked up in the tree. */
+    nxt_radix_t                    *tree;
+    uint32_t                       compiled;
+
     nxt_http_route_pattern_t       pattern[0];
 };
 
@@ -125,6 +129,11 @@ struct nxt_http_route_addr_rule_s {
     /* The object must be the first field. */
     nxt_http_route_object_t        object:8;
     uint32_t                       items;
+
+    /* The "tree" indexes are used for large rules, positive first. */
+    nxt_http_route_addr_tree_t     *tree[2];
+    uint8_t                        positive;  /* 1 bit */
+
     nxt_http_route_addr_pattern_t  addr_pattern[0];
 };
 
@@ -143,8 +152,17 @@ typedef struct {
 } nxt_http_route_match_t;
 
 
+typedef struct {
+    nxt_http_route_object_t        object:8;
+    uintptr_t                      offset;
+    nxt_radix_t                    *tree;
+    nxt_array_t                    *rest;
+} nxt_http_route_index_t;
+
+
 struct nxt_http_route_s {
     nxt_str_t                      name;
+    nxt_http_route_index_t         *index;
     uint32_t                       items;
     nxt_http_route_match_t         *match[0];
 };
@@ -160,6 +178,18 @@ static nxt_http_route_t *nxt_http_route_create(nxt_task_t *task,
     nxt_router_temp_conf_t *tmcf, nxt_conf_value_t *cv);
 static nxt_http_route_match_t *nxt_http_route_match_create(nxt_task_t *task,
     nxt_router_temp_conf_t *tmcf, nxt_conf_value_t *cv);
+static nxt_int_t nxt_http_route_index_create(nxt_mp_t *mp,
+    nxt_http_route_t *route);
+static nxt_http_route_rule_t *nxt_http_route_index_rule(
+    nxt_http_route_match_t *match, nxt_http_route_object_t object,
+    uintptr_t offset);
+static nxt_int_t nxt_http_route_index_add(nxt_mp_t *mp,
+    nxt_http_route_index_t *index, nxt_http_route_pattern_slice_t *slice,
+    uint32_t n);
+static nxt_int_t nxt_http_route_index_merge(void *data, void **value,
+    void *parent);
+static nxt_array_t *nxt_http_route_index_union(nxt_mp_t *mp, nxt_array_t *one,
+    nxt_array_t *two);
 static nxt_http_route_table_t *nxt_http_route_table_create(nxt_task_t *task,
     nxt_mp_t *mp, nxt_conf_value_t *table_cv, nxt_http_route_object_t object,
     nxt_bool_t case_sensitive, nxt_http_uri_encoding_t encoding);
@@ -173,7 +203,13 @@ static nxt_http_route_rule_t *nxt_http_route_rule_create(nxt_task_t *task,
     nxt_mp_t *mp, nxt_conf_value_t *cv, nxt_bool_t case_sensitive,
     nxt_http_route_pattern_case_t pattern_case,
     nxt_http_uri_encoding_t encoding);
+static nxt_bool_t nxt_http_route_pattern_is_prefix(
+    nxt_http_route_pattern_t *pattern);
+static nxt_int_t nxt_http_route_rule_compile(nxt_mp_t *mp,
+    nxt_http_route_rule_t *rule);
 static int nxt_http_pattern_compare(const void *one, const void *two);
+static nxt_int_t nxt_http_route_addr_rule_compile(nxt_mp_t *mp,
+    nxt_http_route_addr_rule_t *addr_rule);
 static int nxt_http_addr_pattern_compare(const void *one, const void *two);
 static nxt_int_t nxt_http_route_pattern_create(nxt_task_t *task, nxt_mp_t *mp,
     nxt_conf_value_t *cv, nxt_http_route_pattern_t *pattern,
@@ -202,6 +238,10 @@ static nxt_int_t nxt_http_route_find(nxt_http_routes_t *routes, nxt_str_t *name,
 
 static nxt_http_action_t *nxt_http_route_handler(nxt_task_t *task,
     nxt_http_request_t *r, nxt_http_action_t *start);
+static nxt_http_action_t *nxt_http_route_index_handler(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_http_route_t *route);
+static nxt_array_t *nxt_http_route_index_find(nxt_http_route_index_t *index,
+    nxt_http_request_t *r);
 static nxt_http_action_t *nxt_http_route_match(nxt_task_t *task,
     nxt_http_request_t *r, nxt_http_route_match_t *match);
 static nxt_int_t nxt_http_route_table(nxt_http_request_t *r,
@@ -210,6 +250,8 @@ static nxt_int_t nxt_http_route_ruleset(nxt_http_request_t *r,
     nxt_http_route_ruleset_t *ruleset);
 static nxt_int_t nxt_http_route_rule(nxt_http_request_t *r,
     nxt_http_route_rule_t *rule);
+static nxt_int_t nxt_http_route_addr_rule_tree(
+    nxt_http_route_addr_rule_t *addr_rule, nxt_sockaddr_t *sa);
 static nxt_int_t nxt_http_route_header(nxt_http_request_t *r,
     nxt_http_route_rule_t *rule);
 static nxt_int_t nxt_http_route_arguments(nxt_http_request_t *r,
@@ -385,10 +427,302 @@ nxt_http_route_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         *m++ = match;
     }
 
+    if (nxt_slow_path(nxt_http_route_index_create(tmcf->router_conf->mem_pool,
+                                                  route)
+                      != NXT_OK))
+    {
+        return NULL;
+    }
+
     return route;
 }
 
 
+/*
+ * A route with many matches is compiled into an index over the request
+ * field (host, uri, or method) which is tested by the largest number of
+ * matches with positive exact or prefix patterns only.  The index maps each
+ * value to the list of matches which may accept it, while all the other
+ * matches are kept in the "rest" list.  Both lists are sorted, so merging
+ * them preserves the first-match semantics of sequential evaluation.
+ */
+
+#define NXT_HTTP_ROUTE_INDEX_MIN  8
+
+
+static const struct {
+    nxt_http_route_object_t  object;
+    uintptr_t                offset;
+} nxt_http_route_index_fields[] = {
+    { NXT_HTTP_ROUTE_STRING, offsetof(nxt_http_request_t, host) },
+    { NXT_HTTP_ROUTE_STRING_PTR, offsetof(nxt_http_request_t, path) },
+    { NXT_HTTP_ROUTE_STRING_PTR, offsetof(nxt_http_request_t, method) },
+};
+
+
+static nxt_int_t
+nxt_http_route_index_create(nxt_mp_t *mp, nxt_http_route_t *route)
+{
+    uint32_t                        i, *p;
+    uintptr_t                       offset;
+    nxt_int_t                       ret;
+    nxt_uint_t                      f, best, count, max;
+    nxt_http_route_rule_t           *rule;
+    nxt_http_route_index_t          *index;
+    nxt_http_route_object_t         object;
+    nxt_http_route_pattern_t        *pattern, *end;
+    nxt_http_route_pattern_slice_t  *slice;
+
+    route->index = NULL;
+
+    if (route->items < NXT_HTTP_ROUTE_INDEX_MIN) {
+        return NXT_OK;
+    }
+
+    best = 0;
+    max = 0;
+
+    for (f = 0; f < nxt_nitems(nxt_http_route_index_fields); f++) {
+        object = nxt_http_route_index_fields[f].object;
+        offset = nxt_http_route_index_fields[f].offset;
+        count = 0;
+
+        for (i = 0; i < route->items; i++) {
+            rule = nxt_http_route_index_rule(route->match[i], object, offset);
+            if (rule != NULL) {
+                count++;
+            }
+        }
+
+        if (count > max) {
+            max = count;
+            best = f;
+        }
+    }
+
+    if (max < NXT_HTTP_ROUTE_INDEX_MIN) {
+        return NXT_OK;
+    }
+
+    index = nxt_mp_zget(mp, sizeof(nxt_http_route_index_t));
+    if (nxt_slow_path(index == NULL)) {
+        return NXT_ERROR;
+    }
+
+    index->object = nxt_http_route_index_fields[best].object;
+    index->offset = nxt_http_route_index_fields[best].offset;
+
+    index->tree = nxt_radix_create(mp, 0);
+    if (nxt_slow_path(index->tree == NULL)) {
+        return NXT_ERROR;
+    }
+
+    index->rest = nxt_array_create(mp, route->items - max, sizeof(uint32_t));
+    if (nxt_slow_path(index->rest == NULL)) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < route->items; i++) {
+        rule = nxt_http_route_index_rule(route->match[i], index->object,
+                                         index->offset);
+        if (rule == NULL) {
+            p = nxt_array_add(index->rest);
+            if (nxt_slow_path(p == NULL)) {
+                return NXT_ERROR;
+            }
+
+            *p = i;
+            continue;
+        }
+
+        pattern = &rule->pattern[0];
+        end = pattern + rule->items;
+
+        while (pattern < end) {
+            slice = pattern->u.pattern_slices->elts;
+
+            ret = nxt_http_route_index_add(mp, index, slice, i);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NXT_ERROR;
+            }
+
+            pattern++;
+        }
+    }
+
+    ret = nxt_radix_walk(index->tree, nxt_http_route_index_merge, mp);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    route->index = index;
+
+    return NXT_OK;
+}
+
+
+static nxt_http_route_rule_t *
+nxt_http_route_index_rule(nxt_http_route_match_t *match,
+    nxt_http_route_object_t object, uintptr_t offset)
+{
+    nxt_http_route_rule_t     *rule;
+    nxt_http_route_test_t     *test, *end;
+    nxt_http_route_pattern_t  *pattern, *pend;
+
+    test = &match->test[0];
+    end = test + match->items;
+
+    for ( /* void */ ; test < end; test++) {
+        rule = test->rule;
+
+        if (rule->object != object || rule->u.offset != offset) {
+            continue;
+        }
+
+        if (rule->items == 0) {
+            /* An empty array matches any value. */
+            return NULL;
+        }
+
+        pattern = &rule->pattern[0];
+        pend = pattern + rule->items;
+
+        for ( /* void */ ; pattern < pend; pattern++) {
+            if (!nxt_http_route_pattern_is_prefix(pattern)) {
+                return NULL;
+            }
+        }
+
+        return rule;
+    }
+
+    return NULL;
+}
+
+
+static nxt_int_t
+nxt_http_route_index_add(nxt_mp_t *mp, nxt_http_route_index_t *index,
+    nxt_http_route_pattern_slice_t *slice, uint32_t n)
+{
+    void               **value;
+    uint32_t           *p;
+    nxt_array_t        *matches;
+    nxt_radix_match_t  type;
+
+    type = (slice->type == NXT_HTTP_ROUTE_PATTERN_EXACT) ? NXT_RADIX_EXACT
+                                                         : NXT_RADIX_PREFIX;
+
+    value = nxt_radix_insert(index->tree, slice->start, slice->length, type);
+    if (nxt_slow_path(value == NULL)) {
+        return NXT_ERROR;
+    }
+
+    matches = *value;
+
+    if (matches == NULL) {
+        matches = nxt_array_create(mp, 1, sizeof(uint32_t));
+        if (nxt_slow_path(matches == NULL)) {
+            return NXT_ERROR;
+        }
+
+        *value = matches;
+
+    } else {
+        p = nxt_array_last(matches);
+
+        if (*p == n) {
+            /* The same value is listed twice in one rule. */
+            return NXT_OK;
+        }
+    }
+
+    p = nxt_array_add(matches);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    *p = n;
+
+    return NXT_OK;
+}
+
+
+/*
+ * The matches of a prefix are added to all longer values, so a lookup
+ * needs only the list of the longest value that matches the request.
+ */
+
+static nxt_int_t
+nxt_http_route_index_merge(void *data, void **value, void *parent)
+{
+    nxt_mp_t     *mp;
+    nxt_array_t  *prefix;
+
+    mp = data;
+
+    if (value[NXT_RADIX_PREFIX] != NULL && parent != NULL) {
+        value[NXT_RADIX_PREFIX] = nxt_http_route_index_union(mp,
+                                                      value[NXT_RADIX_PREFIX],
+                                                      parent);
+        if (nxt_slow_path(value[NXT_RADIX_PREFIX] == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    prefix = (value[NXT_RADIX_PREFIX] != NULL) ? value[NXT_RADIX_PREFIX]
+                                               : parent;
+
+    if (value[NXT_RADIX_EXACT] != NULL && prefix != NULL) {
+        value[NXT_RADIX_EXACT] = nxt_http_route_index_union(mp,
+                                                      value[NXT_RADIX_EXACT],
+                                                      prefix);
+        if (nxt_slow_path(value[NXT_RADIX_EXACT] == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_array_t *
+nxt_http_route_index_union(nxt_mp_t *mp, nxt_array_t *one, nxt_array_t *two)
+{
+    uint32_t     *a, *a_end, *b, *b_end, *p;
+    nxt_array_t  *array;
+
+    array = nxt_array_create(mp, one->nelts + two->nelts, sizeof(uint32_t));
+    if (nxt_slow_path(array == NULL)) {
+        return NULL;
+    }
+
+    a = one->elts;
+    a_end = a + one->nelts;
+    b = two->elts;
+    b_end = b + two->nelts;
+
+    p = array->elts;
+
+    while (a < a_end || b < b_end) {
+
+        if (b == b_end || (a < a_end && *a < *b)) {
+            *p++ = *a++;
+
+        } else if (a == a_end || *b < *a) {
+            *p++ = *b++;
+
+        } else {
+            *p++ = *a++;
+            b++;
+        }
+    }
+
+    array->nelts = p - (uint32_t *) array->elts;
+
+    return array;
+}
+
+
 static nxt_http_route_match_t *
 nxt_http_route_match_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     nxt_conf_value_t *cv)
@@ -638,11 +972,26 @@ static nxt_conf_map_t  nxt_http_route_action_conf[] = {
         NXT_CONF_MAP_PTR,
         offsetof(nxt_http_action_conf_t, types)
     },
+    {
+        nxt_string("precompressed"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, precompressed)
+    },
     {
         nxt_string("fallback"),
         NXT_CONF_MAP_PTR,
         offsetof(nxt_http_action_conf_t, fallback)
     },
+    {
+        nxt_string("cache"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, cache)
+    },
+    {
+        nxt_string("sendfile"),
+        NXT_CONF_MAP_PTR,
+        offsetof(nxt_http_action_conf_t, sendfile)
+    },
 };
 
 
@@ -683,6 +1032,20 @@ nxt_http_action_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         }
     }
 
+    if (acf.cache != NULL) {
+        ret = nxt_http_cache_conf_init(rtcf, action, &acf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    if (acf.sendfile != NULL) {
+        ret = nxt_http_sendfile_conf_init(task, tmcf, action, &acf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
     if (acf.ret != NULL) {
         return nxt_http_return_init(rtcf, action, &acf);
     }
@@ -859,6 +1222,11 @@ nxt_http_route_rule_create(nxt_task_t *task, nxt_mp_t *mp,
         }
     }
 
+    ret = nxt_http_route_rule_compile(mp, rule);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NULL;
+    }
+
     return rule;
 }
 
@@ -900,10 +1268,83 @@ nxt_http_route_addr_rule_create(nxt_task_t *task, nxt_mp_t *mp,
             nxt_http_addr_pattern_compare);
     }
 
+    if (nxt_slow_path(nxt_http_route_addr_rule_compile(mp, addr_rule)
+                      != NXT_OK))
+    {
+        return NULL;
+    }
+
     return addr_rule;
 }
 
 
+/*
+ * Address patterns of a large rule, such as an allow or deny list, are
+ * moved into a tree for positive and a tree for negative patterns.  The
+ * rule does not match if any negative pattern matches, otherwise it
+ * matches if any positive pattern matches or if there are none.  Thus
+ * the order of patterns within each group does not matter.  Patterns
+ * which cannot be placed in a tree, like "unix", are tested sequentially.
+ */
+
+#define NXT_HTTP_ROUTE_ADDR_TREE_MIN  16
+
+
+static nxt_int_t
+nxt_http_route_addr_rule_compile(nxt_mp_t *mp,
+    nxt_http_route_addr_rule_t *addr_rule)
+{
+    uint32_t                       i, n;
+    nxt_int_t                      ret;
+    nxt_bool_t                     negative;
+    nxt_http_route_addr_tree_t     **tree;
+    nxt_http_route_addr_pattern_t  *pattern;
+
+    addr_rule->tree[0] = NULL;
+    addr_rule->tree[1] = NULL;
+    addr_rule->positive = 0;
+
+    if (addr_rule->items < NXT_HTTP_ROUTE_ADDR_TREE_MIN) {
+        return NXT_OK;
+    }
+
+    pattern = &addr_rule->addr_pattern[0];
+    n = 0;
+
+    for (i = 0; i < addr_rule->items; i++) {
+        negative = pattern[i].base.negative;
+
+        if (!negative) {
+            addr_rule->positive = 1;
+        }
+
+        tree = &addr_rule->tree[negative];
+
+        if (*tree == NULL) {
+            *tree = nxt_mp_zget(mp, sizeof(nxt_http_route_addr_tree_t));
+            if (nxt_slow_path(*tree == NULL)) {
+                return NXT_ERROR;
+            }
+        }
+
+        ret = nxt_http_route_addr_tree_add(mp, *tree, &pattern[i]);
+
+        if (ret == NXT_DECLINED) {
+            pattern[n++] = pattern[i];
+            continue;
+        }
+
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+    }
+
+    addr_rule->items = n;
+
+    return NXT_OK;
+}
+
+
 nxt_http_route_rule_t *
 nxt_http_route_types_rule_create(nxt_task_t *task, nxt_mp_t *mp,
     nxt_conf_value_t *types)
@@ -914,6 +1355,107 @@ nxt_http_route_types_rule_create(nxt_task_t *task, nxt_mp_t *mp,
 }
 
 
+static nxt_bool_t
+nxt_http_route_pattern_is_prefix(nxt_http_route_pattern_t *pattern)
+{
+    nxt_http_route_pattern_slice_t  *slice;
+
+    if (pattern->negative
+#if (NXT_HAVE_REGEX)
+        || pattern->regex
+#endif
+        || pattern->u.pattern_slices->nelts != 1)
+    {
+        return 0;
+    }
+
+    slice = pattern->u.pattern_slices->elts;
+
+    return (slice->type == NXT_HTTP_ROUTE_PATTERN_EXACT
+            || slice->type == NXT_HTTP_ROUTE_PATTERN_BEGIN);
+}
+
+
+/*
+ * Positive exact and prefix patterns of a large rule are moved to the end
+ * of the pattern array and compiled into a radix tree, so a rule with any
+ * number of such patterns is tested in a time proportional to the length
+ * of the value.  The order of positive patterns does not matter, because
+ * a rule matches if any of them matches.
+ */
+
+#define NXT_HTTP_ROUTE_RULE_TREE_MIN  8
+
+
+static nxt_int_t
+nxt_http_route_rule_compile(nxt_mp_t *mp, nxt_http_route_rule_t *rule)
+{
+    void                            **value;
+    uint32_t                        i, n, compiled;
+    nxt_http_route_pattern_t        *pattern, *tmp;
+    nxt_http_route_pattern_slice_t  *slice;
+
+    rule->tree = NULL;
+    rule->compiled = 0;
+
+    pattern = &rule->pattern[0];
+    compiled = 0;
+
+    for (i = 0; i < rule->items; i++) {
+        compiled += nxt_http_route_pattern_is_prefix(&pattern[i]);
+    }
+
+    if (compiled < NXT_HTTP_ROUTE_RULE_TREE_MIN) {
+        return NXT_OK;
+    }
+
+    tmp = nxt_mp_alloc(mp, rule->items * sizeof(nxt_http_route_pattern_t));
+    if (nxt_slow_path(tmp == NULL)) {
+        return NXT_ERROR;
+    }
+
+    rule->tree = nxt_radix_create(mp, !pattern[0].case_sensitive);
+    if (nxt_slow_path(rule->tree == NULL)) {
+        return NXT_ERROR;
+    }
+
+    n = 0;
+
+    for (i = 0; i < rule->items; i++) {
+        if (!nxt_http_route_pattern_is_prefix(&pattern[i])) {
+            tmp[n++] = pattern[i];
+        }
+    }
+
+    for (i = 0; i < rule->items; i++) {
+        if (!nxt_http_route_pattern_is_prefix(&pattern[i])) {
+            continue;
+        }
+
+        slice = pattern[i].u.pattern_slices->elts;
+
+        value = nxt_radix_insert(rule->tree, slice->start, slice->length,
+                                 (slice->type == NXT_HTTP_ROUTE_PATTERN_EXACT)
+                                 ? NXT_RADIX_EXACT : NXT_RADIX_PREFIX);
+        if (nxt_slow_path(value == NULL)) {
+            return NXT_ERROR;
+        }
+
+        /* The pattern is placed at pattern[n] after the reordering. */
+        *value = &pattern[n];
+
+        tmp[n++] = pattern[i];
+    }
+
+    nxt_memcpy(pattern, tmp, rule->items * sizeof(nxt_http_route_pattern_t));
+    nxt_mp_free(mp, tmp);
+
+    rule->compiled = compiled;
+
+    return NXT_OK;
+}
+
+
 static int
 nxt_http_pattern_compare(const void *one, const void *two)
 {
@@ -1570,6 +2112,10 @@ nxt_http_route_handler(nxt_task_t *task, nxt_http_request_t *r,
 
     route = start->u.route;
 
+    if (route->index != NULL && !r->log_route) {
+        return nxt_http_route_index_handler(task, r, route);
+    }
+
     for (i = 0; i < route->items; i++) {
         action = nxt_http_route_match(task, r, route->match[i]);
 
@@ -1600,6 +2146,78 @@ nxt_http_route_handler(nxt_task_t *task, nxt_http_request_t *r,
 }
 
 
+static nxt_http_action_t *
+nxt_http_route_index_handler(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_http_route_t *route)
+{
+    uint32_t           n, *cand, *cand_end, *rest, *rest_end;
+    nxt_array_t        *matches;
+    nxt_http_action_t  *action;
+
+    matches = nxt_http_route_index_find(route->index, r);
+
+    if (matches != NULL) {
+        cand = matches->elts;
+        cand_end = cand + matches->nelts;
+
+    } else {
+        cand = NULL;
+        cand_end = NULL;
+    }
+
+    rest = route->index->rest->elts;
+    rest_end = rest + route->index->rest->nelts;
+
+    while (cand < cand_end || rest < rest_end) {
+
+        if (rest == rest_end || (cand < cand_end && *cand < *rest)) {
+            n = *cand++;
+
+        } else {
+            n = *rest++;
+        }
+
+        action = nxt_http_route_match(task, r, route->match[n]);
+
+        if (action != NULL) {
+
+            if (action != NXT_HTTP_ACTION_ERROR) {
+                r->action = action;
+            }
+
+            return action;
+        }
+    }
+
+    nxt_http_request_error(task, r, NXT_HTTP_NOT_FOUND);
+
+    return NULL;
+}
+
+
+static nxt_array_t *
+nxt_http_route_index_find(nxt_http_route_index_t *index, nxt_http_request_t *r)
+{
+    void       *p;
+    nxt_str_t  *s;
+
+    p = nxt_pointer_to(r, index->offset);
+
+    if (index->object == NXT_HTTP_ROUTE_STRING) {
+        s = p;
+
+    } else {
+        s = *(nxt_str_t **) p;
+
+        if (s == NULL) {
+            return NULL;
+        }
+    }
+
+    return nxt_radix_find(index->tree, s->start, s->length);
+}
+
+
 static nxt_http_action_t *
 nxt_http_route_match(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_route_match_t *match)
@@ -1883,6 +2501,10 @@ nxt_http_route_addr_rule(nxt_http_request_t *r,
     nxt_bool_t                     matches;
     nxt_http_route_addr_pattern_t  *p;
 
+    if (addr_rule->tree[0] != NULL || addr_rule->tree[1] != NULL) {
+        return nxt_http_route_addr_rule_tree(addr_rule, sa);
+    }
+
     n = addr_rule->items;
 
     if (n == 0) {
@@ -1915,6 +2537,42 @@ nxt_http_route_addr_rule(nxt_http_request_t *r,
 }
 
 
+static nxt_int_t
+nxt_http_route_addr_rule_tree(nxt_http_route_addr_rule_t *addr_rule,
+    nxt_sockaddr_t *sa)
+{
+    nxt_http_route_addr_pattern_t  *p, *end;
+
+    if (addr_rule->tree[1] != NULL
+        && nxt_http_route_addr_tree_find(addr_rule->tree[1], sa))
+    {
+        return 0;
+    }
+
+    p = &addr_rule->addr_pattern[0];
+    end = p + addr_rule->items;
+
+    for ( /* void */ ; p < end; p++) {
+        if (nxt_http_route_addr_pattern_match(p, sa)) {
+            if (!p->base.negative) {
+                return 1;
+            }
+
+        } else if (p->base.negative) {
+            return 0;
+        }
+    }
+
+    if (addr_rule->tree[0] != NULL
+        && nxt_http_route_addr_tree_find(addr_rule->tree[0], sa))
+    {
+        return 1;
+    }
+
+    return !addr_rule->positive;
+}
+
+
 static nxt_int_t
 nxt_http_route_header(nxt_http_request_t *r, nxt_http_route_rule_t *rule)
 {
@@ -2085,7 +2743,7 @@ nxt_http_route_test_rule(nxt_http_request_t *r, nxt_http_route_rule_t *rule,
 
     ret = 1;
     pattern = &rule->pattern[0];
-    end = pattern + rule->items;
+    end = pattern + rule->items - rule->compiled;
 
     while (pattern < end) {
         ret = nxt_http_route_pattern(r, pattern, start, length);
@@ -2103,6 +2761,10 @@ nxt_http_route_test_rule(nxt_http_request_t *r, nxt_http_route_rule_t *rule,
         pattern++;
     }
 
+    if (rule->tree != NULL) {
+        return (nxt_radix_find(rule->tree, start, length) != NULL);
+    }
+
     return ret;
 }
 
@@ -8,9 +8,41 @@
 #include <nxt_http_route_addr.h>
 
 
+typedef struct {
+    uint16_t                    start;
+    uint16_t                    end;
+} nxt_http_route_addr_port_t;
+
+
+struct nxt_http_route_addr_node_s {
+    nxt_http_route_addr_node_t  *child[2];
+    nxt_array_t                 *ports;
+    uint8_t                     bits;
+    u_char                      key[0];
+};
+
+
 #if (NXT_INET6)
 static nxt_bool_t nxt_valid_ipv6_blocks(u_char *c, size_t len);
 #endif
+static nxt_int_t nxt_http_route_addr_tree_range(nxt_mp_t *mp,
+    nxt_http_route_addr_node_t **root, nxt_http_route_addr_base_t *base,
+    size_t size, u_char *prefix, nxt_uint_t bits, const u_char *start,
+    const u_char *end);
+static nxt_int_t nxt_http_route_addr_tree_insert(nxt_mp_t *mp,
+    nxt_http_route_addr_node_t **root, nxt_http_route_addr_base_t *base,
+    size_t size, const u_char *key, nxt_uint_t bits);
+static nxt_http_route_addr_node_t *nxt_http_route_addr_node_create(
+    nxt_mp_t *mp, size_t size, const u_char *key, nxt_uint_t bits);
+static nxt_bool_t nxt_http_route_addr_node_find(
+    nxt_http_route_addr_node_t *node, const u_char *addr, nxt_uint_t max,
+    in_port_t port);
+static nxt_uint_t nxt_http_route_addr_mask_bits(const u_char *mask,
+    size_t size);
+
+
+#define nxt_http_route_addr_bit(key, n)                                       \
+    (((key)[(n) / 8] >> (7 - (n) % 8)) & 1)
 
 
 nxt_int_t
@@ -313,6 +345,346 @@ nxt_http_route_addr_pattern_parse(nxt_mp_t *mp,
 }
 
 
+nxt_int_t
+nxt_http_route_addr_tree_add(nxt_mp_t *mp, nxt_http_route_addr_tree_t *tree,
+    nxt_http_route_addr_pattern_t *pattern)
+{
+    size_t                      size;
+    nxt_int_t                   ret;
+    nxt_uint_t                  bits;
+    const u_char                *start, *end;
+    nxt_http_route_addr_node_t  **root;
+    nxt_http_route_addr_base_t  *base;
+    u_char                      prefix[16];
+
+    base = &pattern->base;
+
+    switch (base->addr_family) {
+
+    case AF_UNSPEC:
+        /* "*:port" matches any address of both families. */
+
+        nxt_memzero(prefix, sizeof(prefix));
+
+        ret = nxt_http_route_addr_tree_insert(mp, &tree->inet, base,
+                                              sizeof(struct in_addr),
+                                              prefix, 0);
+#if (NXT_INET6)
+        if (nxt_fast_path(ret == NXT_OK)) {
+            ret = nxt_http_route_addr_tree_insert(mp, &tree->inet6, base,
+                                                  sizeof(struct in6_addr),
+                                                  prefix, 0);
+        }
+#endif
+        return ret;
+
+    case AF_INET:
+        root = &tree->inet;
+        size = sizeof(struct in_addr);
+        start = (u_char *) &pattern->addr.v4.start;
+        end = (u_char *) &pattern->addr.v4.end;
+        break;
+
+#if (NXT_INET6)
+    case AF_INET6:
+        root = &tree->inet6;
+        size = sizeof(struct in6_addr);
+        start = pattern->addr.v6.start.s6_addr;
+        end = pattern->addr.v6.end.s6_addr;
+        break;
+#endif
+
+    default:
+        return NXT_DECLINED;
+    }
+
+    switch (base->match_type) {
+
+    case NXT_HTTP_ROUTE_ADDR_ANY:
+        bits = 0;
+        break;
+
+    case NXT_HTTP_ROUTE_ADDR_EXACT:
+        bits = size * 8;
+        break;
+
+    case NXT_HTTP_ROUTE_ADDR_CIDR:
+        bits = nxt_http_route_addr_mask_bits(end, size);
+        break;
+
+    default: /* NXT_HTTP_ROUTE_ADDR_RANGE */
+        nxt_memzero(prefix, size);
+
+        return nxt_http_route_addr_tree_range(mp, root, base, size, prefix, 0,
+                                              start, end);
+    }
+
+    return nxt_http_route_addr_tree_insert(mp, root, base, size, start, bits);
+}
+
+
+/*
+ * A range is split into the largest prefixes which it contains
+ * by halving the prefix until it falls within the range.
+ */
+
+static nxt_int_t
+nxt_http_route_addr_tree_range(nxt_mp_t *mp, nxt_http_route_addr_node_t **root,
+    nxt_http_route_addr_base_t *base, size_t size, u_char *prefix,
+    nxt_uint_t bits, const u_char *start, const u_char *end)
+{
+    nxt_int_t   ret;
+    nxt_uint_t  i;
+    u_char      high[16];
+
+    nxt_memcpy(high, prefix, size);
+
+    for (i = bits; i < size * 8; i++) {
+        high[i / 8] |= 0x80 >> (i % 8);
+    }
+
+    if (memcmp(prefix, end, size) > 0 || memcmp(high, start, size) < 0) {
+        return NXT_OK;
+    }
+
+    if (memcmp(prefix, start, size) >= 0 && memcmp(high, end, size) <= 0) {
+        return nxt_http_route_addr_tree_insert(mp, root, base, size, prefix,
+                                               bits);
+    }
+
+    ret = nxt_http_route_addr_tree_range(mp, root, base, size, prefix,
+                                         bits + 1, start, end);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    nxt_memcpy(high, prefix, size);
+    high[bits / 8] |= 0x80 >> (bits % 8);
+
+    return nxt_http_route_addr_tree_range(mp, root, base, size, high,
+                                          bits + 1, start, end);
+}
+
+
+static nxt_int_t
+nxt_http_route_addr_tree_insert(nxt_mp_t *mp, nxt_http_route_addr_node_t **root,
+    nxt_http_route_addr_base_t *base, size_t size, const u_char *key,
+    nxt_uint_t bits)
+{
+    nxt_uint_t                  n, common;
+    nxt_http_route_addr_node_t  *node, *split, *leaf, **pnode;
+    nxt_http_route_addr_port_t  *port;
+
+    pnode = root;
+
+    for ( ;; ) {
+        node = *pnode;
+
+        if (node == NULL) {
+            node = nxt_http_route_addr_node_create(mp, size, key, bits);
+            if (nxt_slow_path(node == NULL)) {
+                return NXT_ERROR;
+            }
+
+            *pnode = node;
+            break;
+        }
+
+        n = nxt_min(node->bits, bits);
+
+        for (common = 0; common < n; common++) {
+            if (nxt_http_route_addr_bit(node->key, common)
+                != nxt_http_route_addr_bit(key, common))
+            {
+                break;
+            }
+        }
+
+        if (common == node->bits) {
+            if (node->bits == bits) {
+                break;
+            }
+
+            pnode = &node->child[nxt_http_route_addr_bit(key, node->bits)];
+            continue;
+        }
+
+        /* The node prefix diverges from the key or is longer than it. */
+
+        split = nxt_http_route_addr_node_create(mp, size, key, common);
+        if (nxt_slow_path(split == NULL)) {
+            return NXT_ERROR;
+        }
+
+        split->child[nxt_http_route_addr_bit(node->key, common)] = node;
+        *pnode = split;
+
+        if (common == bits) {
+            node = split;
+            break;
+        }
+
+        leaf = nxt_http_route_addr_node_create(mp, size, key, bits);
+        if (nxt_slow_path(leaf == NULL)) {
+            return NXT_ERROR;
+        }
+
+        split->child[nxt_http_route_addr_bit(key, common)] = leaf;
+        node = leaf;
+        break;
+    }
+
+    if (node->ports == NULL) {
+        node->ports = nxt_array_create(mp, 1,
+                                       sizeof(nxt_http_route_addr_port_t));
+        if (nxt_slow_path(node->ports == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    port = nxt_array_add(node->ports);
+    if (nxt_slow_path(port == NULL)) {
+        return NXT_ERROR;
+    }
+
+    port->start = base->port.start;
+    port->end = base->port.end;
+
+    return NXT_OK;
+}
+
+
+static nxt_http_route_addr_node_t *
+nxt_http_route_addr_node_create(nxt_mp_t *mp, size_t size, const u_char *key,
+    nxt_uint_t bits)
+{
+    nxt_uint_t                  i;
+    nxt_http_route_addr_node_t  *node;
+
+    node = nxt_mp_zget(mp, sizeof(nxt_http_route_addr_node_t) + size);
+    if (nxt_slow_path(node == NULL)) {
+        return NULL;
+    }
+
+    node->bits = bits;
+
+    for (i = 0; i < bits; i++) {
+        node->key[i / 8] |= key[i / 8] & (0x80 >> (i % 8));
+    }
+
+    return node;
+}
+
+
+nxt_bool_t
+nxt_http_route_addr_tree_find(nxt_http_route_addr_tree_t *tree,
+    nxt_sockaddr_t *sa)
+{
+    in_port_t            port;
+    struct sockaddr_in   *sin;
+#if (NXT_INET6)
+    struct sockaddr_in6  *sin6;
+#endif
+
+    switch (sa->u.sockaddr.sa_family) {
+
+    case AF_INET:
+        sin = &sa->u.sockaddr_in;
+        port = ntohs(sin->sin_port);
+
+        return nxt_http_route_addr_node_find(tree->inet,
+                                             (u_char *) &sin->sin_addr,
+                                             32, port);
+
+#if (NXT_INET6)
+    case AF_INET6:
+        sin6 = &sa->u.sockaddr_in6;
+        port = ntohs(sin6->sin6_port);
+
+        return nxt_http_route_addr_node_find(tree->inet6,
+                                             sin6->sin6_addr.s6_addr,
+                                             128, port);
+#endif
+
+    default:
+        return 0;
+    }
+}
+
+
+static nxt_bool_t
+nxt_http_route_addr_node_find(nxt_http_route_addr_node_t *node,
+    const u_char *addr, nxt_uint_t max, in_port_t port)
+{
+    u_char                      mask;
+    nxt_uint_t                  i, n, bytes;
+    nxt_http_route_addr_port_t  *p;
+
+    /* The number of leading address bytes that are already compared. */
+    i = 0;
+
+    while (node != NULL) {
+        bytes = node->bits / 8;
+
+        if (i < bytes) {
+            if (memcmp(&node->key[i], &addr[i], bytes - i) != 0) {
+                return 0;
+            }
+
+            i = bytes;
+        }
+
+        if (node->bits % 8 != 0) {
+            mask = 0xFF << (8 - node->bits % 8);
+
+            if ((addr[bytes] & mask) != node->key[bytes]) {
+                return 0;
+            }
+        }
+
+        if (node->ports != NULL) {
+            p = node->ports->elts;
+
+            for (n = 0; n < node->ports->nelts; n++) {
+                if (port >= p[n].start && port <= p[n].end) {
+                    return 1;
+                }
+            }
+        }
+
+        if (node->bits == max) {
+            return 0;
+        }
+
+        node = node->child[nxt_http_route_addr_bit(addr, node->bits)];
+    }
+
+    return 0;
+}
+
+
+static nxt_uint_t
+nxt_http_route_addr_mask_bits(const u_char *mask, size_t size)
+{
+    u_char      c;
+    nxt_uint_t  i, bits;
+
+    bits = 0;
+
+    for (i = 0; i < size; i++) {
+        for (c = mask[i]; c & 0x80; c <<= 1) {
+            bits++;
+        }
+
+        if (mask[i] != 0xFF) {
+            break;
+        }
+    }
+
+    return bits;
+}
+
+
 #if (NXT_INET6)
 
 static nxt_bool_t
@@ -68,7 +68,26 @@ typedef struct {
 } nxt_http_route_addr_pattern_t;
 
 
+typedef struct nxt_http_route_addr_node_s  nxt_http_route_addr_node_t;
+
+
+/*
+ * The tree is a path-compressed binary trie of address prefixes for
+ * each address family, every prefix node keeps the list of port ranges.
+ */
+typedef struct {
+    nxt_http_route_addr_node_t           *inet;
+#if (NXT_INET6)
+    nxt_http_route_addr_node_t           *inet6;
+#endif
+} nxt_http_route_addr_tree_t;
+
+
 NXT_EXPORT nxt_int_t nxt_http_route_addr_pattern_parse(nxt_mp_t *mp,
     nxt_http_route_addr_pattern_t *pattern, nxt_conf_value_t *cv);
+NXT_EXPORT nxt_int_t nxt_http_route_addr_tree_add(nxt_mp_t *mp,
+    nxt_http_route_addr_tree_t *tree, nxt_http_route_addr_pattern_t *pattern);
+NXT_EXPORT nxt_bool_t nxt_http_route_addr_tree_find(
+    nxt_http_route_addr_tree_t *tree, nxt_sockaddr_t *sa);
 
 #endif /* _NXT_HTTP_ROUTE_ADDR_H_INCLUDED_ */
@@ -0,0 +1,243 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+
+
+/*
+ * An application may hand its response over to the router by returning
+ * the configured header field with a path instead of the body.  The router
+ * releases the application process and serves the file as the "share"
+ * action of the "sendfile" option would serve a request with this path.
+ * The other application header fields are kept, except the ones describing
+ * the body that is replaced.
+ */
+
+
+struct nxt_http_sendfile_conf_s {
+    nxt_str_t                   header;
+    nxt_http_action_t           action;
+};
+
+
+static nxt_int_t nxt_http_sendfile_path(nxt_http_request_t *r,
+    nxt_http_field_t *field);
+static nxt_int_t nxt_http_sendfile_fields(nxt_http_request_t *r);
+
+
+static nxt_conf_map_t  nxt_http_sendfile_conf_map[] = {
+    {
+        nxt_string("header"),
+        NXT_CONF_MAP_STR_COPY,
+        offsetof(nxt_http_sendfile_conf_t, header),
+    },
+};
+
+
+nxt_int_t
+nxt_http_sendfile_conf_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
+    nxt_http_action_t *action, nxt_http_action_conf_t *acf)
+{
+    nxt_mp_t                  *mp;
+    nxt_int_t                 ret;
+    nxt_http_sendfile_conf_t  *conf;
+
+    mp = tmcf->router_conf->mem_pool;
+
+    conf = nxt_mp_zget(mp, sizeof(nxt_http_sendfile_conf_t));
+    if (nxt_slow_path(conf == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_str_set(&conf->header, "X-Accel-Redirect");
+
+    ret = nxt_conf_map_object(mp, acf->sendfile, nxt_http_sendfile_conf_map,
+                              nxt_nitems(nxt_http_sendfile_conf_map), conf);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    ret = nxt_http_action_init(task, tmcf, acf->sendfile, &conf->action);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    action->sendfile = conf;
+
+    return NXT_OK;
+}
+
+
+/*
+ * Returns NXT_OK if the application response has been replaced by a file,
+ * NXT_DECLINED if the response does not contain the header field, and
+ * NXT_ERROR if the header field value is invalid.
+ */
+
+nxt_int_t
+nxt_http_sendfile_init(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_int_t                 ret;
+    nxt_http_field_t          *field;
+    nxt_http_sendfile_conf_t  *conf;
+
+    conf = r->action->sendfile;
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (!field->skip
+            && field->name_length == conf->header.length
+            && nxt_strncasecmp(field->name, conf->header.start,
+                               conf->header.length) == 0)
+        {
+            goto found;
+        }
+
+    } nxt_list_loop;
+
+    return NXT_DECLINED;
+
+found:
+
+    ret = nxt_http_sendfile_path(r, field);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_log(task, NXT_LOG_ERR, "invalid \"%V\" header field value "
+                "in application response", &conf->header);
+
+        return NXT_ERROR;
+    }
+
+    field->skip = 1;
+
+    return nxt_http_sendfile_fields(r);
+}
+
+
+static nxt_int_t
+nxt_http_sendfile_path(nxt_http_request_t *r, nxt_http_field_t *field)
+{
+    u_char     *p, *end, *start;
+    nxt_str_t  *path;
+
+    static nxt_str_t  get = nxt_string("GET");
+
+    p = field->value;
+    end = p + field->value_length;
+
+    start = memchr(p, '?', field->value_length);
+    if (start != NULL) {
+        end = start;
+    }
+
+    if (p == end || *p != '/') {
+        return NXT_ERROR;
+    }
+
+    /* The path must not contain "." and ".." segments. */
+
+    while (p < end) {
+        start = ++p;
+
+        while (p < end && *p != '/') {
+            if (*p == '\0') {
+                return NXT_ERROR;
+            }
+
+            p++;
+        }
+
+        if ((p - start == 1 && start[0] == '.')
+            || (p - start == 2 && start[0] == '.' && start[1] == '.'))
+        {
+            return NXT_ERROR;
+        }
+    }
+
+    path = nxt_mp_get(r->mem_pool, sizeof(nxt_str_t));
+    if (nxt_slow_path(path == NULL)) {
+        return NXT_ERROR;
+    }
+
+    path->length = end - field->value;
+
+    path->start = nxt_mp_nget(r->mem_pool, path->length);
+    if (nxt_slow_path(path->start == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_memcpy(path->start, field->value, path->length);
+
+    r->path = path;
+
+    if (!nxt_str_eq(r->method, "HEAD", 4)) {
+        r->method = &get;
+    }
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_sendfile_fields(nxt_http_request_t *r)
+{
+    u_char            *p;
+    nxt_http_field_t  *field;
+
+    /*
+     * The application header fields reside in the port buffers that are
+     * released along with the application, so the kept ones are copied.
+     */
+
+    nxt_list_each(field, r->resp.fields) {
+
+        if (field == r->resp.content_length
+            || field == r->resp.content_type)
+        {
+            field->skip = 1;
+        }
+
+        if (field->skip) {
+            continue;
+        }
+
+        p = nxt_mp_nget(r->mem_pool, field->name_length + field->value_length);
+        if (nxt_slow_path(p == NULL)) {
+            return NXT_ERROR;
+        }
+
+        nxt_memcpy(p, field->name, field->name_length);
+        field->name = p;
+
+        p += field->name_length;
+
+        nxt_memcpy(p, field->value, field->value_length);
+        field->value = p;
+
+    } nxt_list_loop;
+
+    r->resp.content_length = NULL;
+    r->resp.content_type = NULL;
+    r->resp.content_length_n = -1;
+
+    return NXT_OK;
+}
+
+
+void
+nxt_http_sendfile(nxt_task_t *task, nxt_http_request_t *r)
+{
+    nxt_http_action_t  *action;
+
+    nxt_debug(task, "http sendfile: \"%V\"", r->path);
+
+    action = &r->action->sendfile->action;
+
+    action = action->handler(task, r, action);
+
+    if (action != NULL) {
+        nxt_http_request_action(task, r, action);
+    }
+}
@@ -5,6 +5,7 @@
 
 #include <nxt_router.h>
 #include <nxt_http.h>
+#include <nxt_open_file_cache.h>
 
 
 typedef struct {
@@ -25,6 +26,7 @@ typedef struct {
     nxt_uint_t                  resolve;
 #endif
     nxt_http_route_rule_t       *types;
+    uint8_t                     precompressed;  /* 1 bit */
 } nxt_http_static_conf_t;
 
 
@@ -39,8 +41,29 @@ typedef struct {
 } nxt_http_static_ctx_t;
 
 
-#define NXT_HTTP_STATIC_BUF_COUNT  2
-#define NXT_HTTP_STATIC_BUF_SIZE   (128 * 1024)
+typedef struct {
+    nxt_off_t                   start;
+    nxt_off_t                   end;
+} nxt_http_static_range_t;
+
+
+/* In the order of preference. */
+
+static const nxt_str_t  nxt_http_static_encodings[] = {
+    nxt_string("br"),
+    nxt_string("gzip"),
+};
+
+static const nxt_str_t  nxt_http_static_extens[] = {
+    nxt_string(".br"),
+    nxt_string(".gz"),
+};
+
+
+#define NXT_HTTP_STATIC_BUF_COUNT   2
+#define NXT_HTTP_STATIC_BUF_SIZE    (128 * 1024)
+
+#define NXT_HTTP_STATIC_MAX_RANGES  16
 
 
 static nxt_http_action_t *nxt_http_static(nxt_task_t *task,
@@ -49,6 +72,10 @@ static void nxt_http_static_iterate(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_static_ctx_t *ctx);
 static void nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data);
 static void nxt_http_static_send_error(nxt_task_t *task, void *obj, void *data);
+static nxt_int_t nxt_http_static_cache_key(nxt_http_request_t *r,
+    nxt_http_static_ctx_t *ctx, u_char *fname, nxt_str_t *key);
+static void nxt_http_static_file_close(nxt_task_t *task, nxt_file_t *f,
+    nxt_open_file_t *of);
 static void nxt_http_static_next(nxt_task_t *task, nxt_http_request_t *r,
     nxt_http_static_ctx_t *ctx, nxt_http_status_t status);
 #if (NXT_HAVE_OPENAT2)
@@ -56,10 +83,35 @@ static u_char *nxt_http_static_chroot_match(u_char *chr, u_char *shr);
 #endif
 static void nxt_http_static_extract_extension(nxt_str_t *path,
     nxt_str_t *exten);
+static nxt_http_field_t *nxt_http_static_field(nxt_http_request_t *r,
+    const nxt_str_t *name);
+static nxt_bool_t nxt_http_static_not_modified(nxt_task_t *task,
+    nxt_http_request_t *r, struct tm *tm, nxt_http_field_t *etag);
+static int64_t nxt_http_static_tm_order(struct tm *tm);
+static nxt_bool_t nxt_http_static_etag_match(nxt_http_field_t *field,
+    nxt_http_field_t *etag);
+static nxt_int_t nxt_http_static_date_parse(nxt_http_field_t *field,
+    struct tm *tm);
+static nxt_int_t nxt_http_static_range(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_buf_t *fb, nxt_file_info_t *fi,
+    nxt_str_t *mtype, nxt_http_field_t *content_type,
+    nxt_http_field_t *last_modified, nxt_http_field_t *etag);
+static nxt_int_t nxt_http_static_range_parse(nxt_str_t *value, nxt_off_t size,
+    nxt_http_static_range_t *ranges, nxt_uint_t *nranges);
+static nxt_int_t nxt_http_static_multipart(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_buf_t *fb, nxt_file_info_t *fi,
+    nxt_str_t *mtype, nxt_http_field_t *content_type,
+    nxt_http_static_range_t *ranges, nxt_uint_t nranges);
+static nxt_buf_t *nxt_http_static_next_part(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_buf_t *fb);
 static void nxt_http_static_body_handler(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_http_static_buf_completion(nxt_task_t *task, void *obj,
     void *data);
+static void nxt_http_static_file_completion(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_http_static_part_completion(nxt_task_t *task, void *obj,
+    void *data);
 
 static nxt_int_t nxt_http_static_mtypes_hash_test(nxt_lvlhsh_query_t *lhq,
     void *data);
@@ -162,6 +214,10 @@ nxt_http_static_init(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     }
 #endif
 
+    if (acf->precompressed != NULL) {
+        conf->precompressed = nxt_conf_get_boolean(acf->precompressed);
+    }
+
     if (acf->types != NULL) {
         conf->types = nxt_http_route_types_rule_create(task, mp, acf->types);
         if (nxt_slow_path(conf->types == NULL)) {
@@ -302,15 +358,16 @@ static void
 nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 {
     size_t                  length, encode;
-    u_char                  *p, *fname;
+    u_char                  *p, *fname, *name;
     struct tm               tm;
     nxt_buf_t               *fb;
     nxt_int_t               ret;
-    nxt_str_t               *shr, *index, exten, *mtype;
-    nxt_uint_t              level;
+    nxt_str_t               *shr, *index, exten, *mtype, key;
+    nxt_uint_t              level, encodings, i, n;
     nxt_file_t              *f, file;
+    nxt_open_file_t         *of;
     nxt_file_info_t         fi;
-    nxt_http_field_t        *field;
+    nxt_http_field_t        *field, *last_modified, *etag, *content_type;
     nxt_http_status_t       status;
     nxt_router_conf_t       *rtcf;
     nxt_http_action_t       *action;
@@ -319,6 +376,8 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
     nxt_http_static_ctx_t   *ctx;
     nxt_http_static_conf_t  *conf;
 
+    const nxt_str_t         *encoding, *encoding_exten;
+
     r = obj;
     ctx = data;
     action = ctx->action;
@@ -326,6 +385,7 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
     rtcf = r->conf->socket_conf->router_conf;
 
     f = NULL;
+    of = NULL;
     mtype = NULL;
 
     shr = &ctx->share;
@@ -369,10 +429,82 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
         fname = ctx->share.start;
     }
 
+    /*
+     * The precompressed files are tried first in the order of preference,
+     * and the file itself is opened if none of them can be served.
+     */
+
+    name = fname;
+    encodings = 0;
+
+    if (conf->precompressed) {
+        n = nxt_nitems(nxt_http_static_encodings);
+        encodings = nxt_http_accept_encoding(r, nxt_http_static_encodings, n);
+    }
+
+again:
+
+    of = NULL;
+    encoding = NULL;
+    fname = name;
+
+    for (i = 0; encodings != 0; i++) {
+
+        if ((encodings & (1 << i)) == 0) {
+            continue;
+        }
+
+        encodings &= ~(1 << i);
+        encoding = &nxt_http_static_encodings[i];
+        encoding_exten = &nxt_http_static_extens[i];
+
+        length = nxt_strlen(name);
+
+        fname = nxt_mp_nget(r->mem_pool, length + encoding_exten->length + 1);
+        if (nxt_slow_path(fname == NULL)) {
+            goto fail;
+        }
+
+        p = nxt_cpymem(fname, name, length);
+        p = nxt_cpymem(p, encoding_exten->start, encoding_exten->length);
+        *p = '\0';
+
+        break;
+    }
+
     nxt_memzero(&file, sizeof(nxt_file_t));
 
     file.name = fname;
 
+    nxt_str_null(&key);
+
+    if (rtcf->open_file_cache_max != 0) {
+        ret = nxt_http_static_cache_key(r, ctx, fname, &key);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto fail;
+        }
+
+        of = nxt_open_file_cache_find(task, &key);
+
+        if (of != NULL) {
+            if (of->file.fd == -1) {
+                nxt_open_file_release(task, of);
+
+                if (encoding != NULL) {
+                    goto again;
+                }
+
+                nxt_http_static_next(task, r, ctx, NXT_HTTP_NOT_FOUND);
+                return;
+            }
+
+            f = &of->file;
+            fi = of->info;
+
+            goto opened;
+        }
+    }
+
 #if (NXT_HAVE_OPENAT2)
     if (conf->resolve != 0 || ctx->chroot.length > 0) {
         nxt_str_t                *chr;
@@ -387,7 +519,7 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
         if (chr->length > 0) {
             resolve |= RESOLVE_IN_ROOT;
 
-            fname = share->is_const
+            fname = (share->is_const && encoding == NULL)
                     ? share->fname
                     : nxt_http_static_chroot_match(chr->start, file.name);
 
@@ -471,6 +603,23 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
             break;
         }
 
+        if (key.length != 0
+            && (file.error == NXT_ENOENT || file.error == NXT_ENOTDIR))
+        {
+            file.fd = -1;
+
+            of = nxt_open_file_cache_add(task, &key, &file, NULL,
+                                         rtcf->open_file_cache_max,
+                                         rtcf->open_file_cache_valid);
+            if (of != NULL) {
+                nxt_open_file_release(task, of);
+            }
+        }
+
+        if (encoding != NULL) {
+            goto again;
+        }
+
         if (status != NXT_HTTP_NOT_FOUND) {
 #if (NXT_HAVE_OPENAT2)
             nxt_str_t  *chr = &ctx->chroot;
@@ -497,17 +646,38 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
         goto fail;
     }
 
-    f = nxt_mp_get(r->mem_pool, sizeof(nxt_file_t));
-    if (nxt_slow_path(f == NULL)) {
+    ret = nxt_file_info(&file, &fi);
+    if (nxt_slow_path(ret != NXT_OK)) {
         nxt_file_close(task, &file);
         goto fail;
     }
 
-    *f = file;
+    if (key.length != 0) {
+        of = nxt_open_file_cache_add(task, &key, &file, &fi,
+                                     rtcf->open_file_cache_max,
+                                     rtcf->open_file_cache_valid);
+    }
+
+    if (of != NULL) {
+        f = &of->file;
 
-    ret = nxt_file_info(f, &fi);
-    if (nxt_slow_path(ret != NXT_OK)) {
-        goto fail;
+    } else {
+        f = nxt_mp_get(r->mem_pool, sizeof(nxt_file_t));
+        if (nxt_slow_path(f == NULL)) {
+            nxt_file_close(task, &file);
+            goto fail;
+        }
+
+        *f = file;
+    }
+
+opened:
+
+    if (encoding != NULL && !nxt_is_file(&fi)) {
+        nxt_http_static_file_close(task, f, of);
+        f = NULL;
+
+        goto again;
     }
 
     if (nxt_fast_path(nxt_is_file(&fi))) {
@@ -531,6 +701,8 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
         field->value = p;
         field->value_length = nxt_http_date(p, &tm) - p;
 
+        last_modified = field;
+
         field = nxt_list_zero_add(r->resp.fields);
         if (nxt_slow_path(field == NULL)) {
             goto fail;
@@ -551,6 +723,46 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
                                           nxt_file_size(&fi))
                               - p;
 
+        etag = field;
+
+        if (conf->precompressed) {
+            field = nxt_list_zero_add(r->resp.fields);
+            if (nxt_slow_path(field == NULL)) {
+                goto fail;
+            }
+
+            nxt_http_field_set(field, "Vary", "Accept-Encoding");
+        }
+
+        if (encoding != NULL) {
+            field = nxt_list_zero_add(r->resp.fields);
+            if (nxt_slow_path(field == NULL)) {
+                goto fail;
+            }
+
+            nxt_http_field_name_set(field, "Content-Encoding");
+
+            field->value = encoding->start;
+            field->value_length = encoding->length;
+        }
+
+        if (nxt_http_static_not_modified(task, r, &tm, etag)) {
+            nxt_http_static_file_close(task, f, of);
+
+            r->status = NXT_HTTP_NOT_MODIFIED;
+            r->resp.content_length_n = -1;
+
+            body_handler = NULL;
+            goto send;
+        }
+
+        field = nxt_list_zero_add(r->resp.fields);
+        if (nxt_slow_path(field == NULL)) {
+            goto fail;
+        }
+
+        nxt_http_field_set(field, "Accept-Ranges", "bytes");
+
         if (exten.start == NULL) {
             nxt_http_static_extract_extension(shr, &exten);
         }
@@ -559,6 +771,8 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
             mtype = nxt_http_static_mtype_get(&rtcf->mtypes_hash, &exten);
         }
 
+        content_type = NULL;
+
         if (mtype->length != 0) {
             field = nxt_list_zero_add(r->resp.fields);
             if (nxt_slow_path(field == NULL)) {
@@ -569,6 +783,8 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 
             field->value = mtype->start;
             field->value_length = mtype->length;
+
+            content_type = field;
         }
 
         if (ctx->need_body && nxt_file_size(&fi) > 0) {
@@ -579,19 +795,31 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 
             fb->file = f;
             fb->file_end = nxt_file_size(&fi);
+            fb->parent = of;
+
+            ret = nxt_http_static_range(task, r, fb, &fi, mtype, content_type,
+                                        last_modified, etag);
+            if (nxt_slow_path(ret == NXT_ERROR)) {
+                goto fail;
+            }
 
-            r->out = fb;
+            if (ret == NXT_DECLINED) {
+                /* Range Not Satisfiable. */
+                nxt_http_static_file_close(task, f, of);
+                body_handler = NULL;
 
-            body_handler = &nxt_http_static_body_handler;
+            } else {
+                r->out = fb;
+                body_handler = &nxt_http_static_body_handler;
+            }
 
         } else {
-            nxt_file_close(task, f);
+            nxt_http_static_file_close(task, f, of);
             body_handler = NULL;
         }
 
     } else {
         /* Not a file. */
-        nxt_file_close(task, f);
 
         if (nxt_slow_path(!nxt_is_dir(&fi)
                           || shr->start[shr->length - 1] == '/'))
@@ -599,10 +827,14 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
             nxt_log(task, NXT_LOG_ERR, "\"%FN\" is not a regular file",
                     f->name);
 
+            nxt_http_static_file_close(task, f, of);
+
             nxt_http_static_next(task, r, ctx, NXT_HTTP_NOT_FOUND);
             return;
         }
 
+        nxt_http_static_file_close(task, f, of);
+
         f = NULL;
 
         r->status = NXT_HTTP_MOVED_PERMANENTLY;
@@ -647,6 +879,8 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
         body_handler = NULL;
     }
 
+send:
+
     nxt_http_request_header_send(task, r, body_handler, NULL);
 
     r->state = &nxt_http_static_send_state;
@@ -655,13 +889,98 @@ nxt_http_static_send_ready(nxt_task_t *task, void *obj, void *data)
 fail:
 
     if (f != NULL) {
-        nxt_file_close(task, f);
+        nxt_http_static_file_close(task, f, of);
     }
 
     nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
 }
 
 
+static nxt_int_t
+nxt_http_static_cache_key(nxt_http_request_t *r, nxt_http_static_ctx_t *ctx,
+    u_char *fname, nxt_str_t *key)
+{
+    u_char  *p;
+    size_t  length;
+
+    /*
+     * The key is the null-terminated file name followed by the chroot
+     * and the resolve flags, because they can change the file opened.
+     */
+
+    length = nxt_strlen(fname) + 1;
+
+#if (NXT_HAVE_OPENAT2)
+    nxt_http_static_conf_t  *conf;
+
+    conf = ctx->action->u.conf;
+
+    length += ctx->chroot.length + 1 + NXT_INT_T_LEN;
+#endif
+
+    p = nxt_mp_nget(r->mem_pool, length);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    key->start = p;
+
+    p = nxt_cpymem(p, fname, nxt_strlen(fname) + 1);
+
+#if (NXT_HAVE_OPENAT2)
+    p = nxt_cpymem(p, ctx->chroot.start, ctx->chroot.length);
+    p = nxt_sprintf(p, key->start + length, ":%ui", conf->resolve);
+#endif
+
+    key->length = p - key->start;
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_http_static_file_close(nxt_task_t *task, nxt_file_t *f,
+    nxt_open_file_t *of)
+{
+    if (of != NULL) {
+        nxt_open_file_release(task, of);
+
+    } else {
+        nxt_file_close(task, f);
+    }
+}
+
+
+/*
+ * Sends a part of an open file as the response body.  The file is closed
+ * when the part has been sent.
+ */
+
+void
+nxt_http_static_file_send(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_file_t *f, nxt_off_t start, nxt_off_t end)
+{
+    nxt_buf_t  *fb;
+
+    fb = nxt_mp_zget(r->mem_pool, NXT_BUF_FILE_SIZE);
+    if (nxt_slow_path(fb == NULL)) {
+        nxt_file_close(task, f);
+        nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+        return;
+    }
+
+    fb->file = f;
+    fb->file_pos = start;
+    fb->file_end = end;
+
+    r->out = fb;
+
+    nxt_http_request_header_send(task, r, &nxt_http_static_body_handler, NULL);
+
+    r->state = &nxt_http_static_send_state;
+}
+
+
 static void
 nxt_http_static_send_error(nxt_task_t *task, void *obj, void *data)
 {
@@ -789,106 +1108,726 @@ nxt_http_static_extract_extension(nxt_str_t *path, nxt_str_t *exten)
 }
 
 
-static void
-nxt_http_static_body_handler(nxt_task_t *task, void *obj, void *data)
+static nxt_http_field_t *
+nxt_http_static_field(nxt_http_request_t *r, const nxt_str_t *name)
 {
-    size_t              alloc;
-    nxt_buf_t           *fb, *b, **next, *out;
-    nxt_off_t           rest;
-    nxt_int_t           n;
-    nxt_work_queue_t    *wq;
-    nxt_http_request_t  *r;
-
-    r = obj;
-    fb = r->out;
-
-    rest = fb->file_end - fb->file_pos;
-    out = NULL;
-    next = &out;
-    n = 0;
+    nxt_http_field_t  *field;
 
-    do {
-        alloc = nxt_min(rest, NXT_HTTP_STATIC_BUF_SIZE);
+    nxt_list_each(field, r->fields) {
 
-        b = nxt_buf_mem_alloc(r->mem_pool, alloc, 0);
-        if (nxt_slow_path(b == NULL)) {
-            goto fail;
+        if (field->name_length == name->length
+            && nxt_strncasecmp(field->name, name->start, name->length) == 0)
+        {
+            return field;
         }
 
-        b->completion_handler = nxt_http_static_buf_completion;
-        b->parent = r;
+    } nxt_list_loop;
 
-        nxt_mp_retain(r->mem_pool);
+    return NULL;
+}
 
-        *next = b;
-        next = &b->next;
 
-        rest -= alloc;
+/*
+ * The If-None-Match and If-Modified-Since request header fields are
+ * evaluated as described in RFC 9110, Section 13.2.2.  The date is
+ * compared in the broken-down form used for the Last-Modified field.
+ */
 
-    } while (rest > 0 && ++n < NXT_HTTP_STATIC_BUF_COUNT);
+static nxt_bool_t
+nxt_http_static_not_modified(nxt_task_t *task, nxt_http_request_t *r,
+    struct tm *tm, nxt_http_field_t *etag)
+{
+    struct tm         since;
+    nxt_http_field_t  *field;
 
-    wq = &task->thread->engine->fast_work_queue;
+    static const nxt_str_t  if_none_match = nxt_string("If-None-Match");
+    static const nxt_str_t  if_modified_since =
+                                             nxt_string("If-Modified-Since");
 
-    nxt_sendbuf_drain(task, wq, out);
-    return;
+    field = nxt_http_static_field(r, &if_none_match);
 
-fail:
+    if (field != NULL) {
+        return nxt_http_static_etag_match(field, etag);
+    }
 
-    while (out != NULL) {
-        b = out;
-        out = b->next;
+    field = nxt_http_static_field(r, &if_modified_since);
 
-        nxt_mp_free(r->mem_pool, b);
-        nxt_mp_release(r->mem_pool);
+    if (field == NULL || nxt_http_static_date_parse(field, &since) != NXT_OK) {
+        return 0;
     }
+
+    nxt_debug(task, "http static if-modified-since \"%*s\"",
+              (size_t) field->value_length, field->value);
+
+    return nxt_http_static_tm_order(tm) <= nxt_http_static_tm_order(&since);
 }
 
 
-static const nxt_http_request_state_t  nxt_http_static_send_state
-    nxt_aligned(64) =
+/*
+ * Returns a value that orders times in the same way as the broken-down
+ * times do, it is not a number of seconds.
+ */
+
+static int64_t
+nxt_http_static_tm_order(struct tm *tm)
 {
-    .error_handler = nxt_http_request_error_handler,
-};
+    return ((((((int64_t) tm->tm_year * 12 + tm->tm_mon) * 31 + tm->tm_mday)
+              * 24 + tm->tm_hour) * 60 + tm->tm_min) * 60 + tm->tm_sec);
+}
 
 
-static void
-nxt_http_static_buf_completion(nxt_task_t *task, void *obj, void *data)
+/*
+ * If-None-Match uses the weak comparison, so the "W/" prefix is ignored.
+ */
+
+static nxt_bool_t
+nxt_http_static_etag_match(nxt_http_field_t *field, nxt_http_field_t *etag)
 {
-    ssize_t             n, size;
-    nxt_buf_t           *b, *fb, *next;
-    nxt_off_t           rest;
-    nxt_http_request_t  *r;
+    u_char  *p, *end, *start;
 
-    b = obj;
-    r = data;
+    p = field->value;
+    end = p + field->value_length;
 
-complete_buf:
+    for ( ;; ) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+            p++;
+        }
 
-    fb = r->out;
+        if (p == end) {
+            return 0;
+        }
 
-    if (nxt_slow_path(fb == NULL || r->error)) {
-        goto clean;
-    }
+        if (*p == '*') {
+            return 1;
+        }
 
-    rest = fb->file_end - fb->file_pos;
-    size = nxt_buf_mem_size(&b->mem);
+        if (end - p > 2 && p[0] == 'W' && p[1] == '/') {
+            p += 2;
+        }
 
-    size = nxt_min(rest, (nxt_off_t) size);
+        if (*p != '"') {
+            return 0;
+        }
 
-    n = nxt_file_read(fb->file, b->mem.start, size, fb->file_pos);
+        start = p++;
 
-    if (nxt_slow_path(n == NXT_ERROR)) {
-        nxt_http_request_error_handler(task, r, r->proto.any);
-        goto clean;
-    }
+        while (p < end && *p != '"') {
+            p++;
+        }
 
-    next = b->next;
+        if (p == end) {
+            return 0;
+        }
 
-    if (n == rest) {
-        nxt_file_close(task, fb->file);
-        r->out = NULL;
+        p++;
+
+        if ((size_t) (p - start) == etag->value_length
+            && memcmp(start, etag->value, etag->value_length) == 0)
+        {
+            return 1;
+        }
+    }
+}
+
+
+/*
+ * Only the IMF-fixdate format is accepted, it is the format generated
+ * by this module for the Last-Modified field and returned by clients.
+ */
+
+static nxt_int_t
+nxt_http_static_date_parse(nxt_http_field_t *field, struct tm *tm)
+{
+    u_char      *p;
+    nxt_int_t   n;
+    nxt_uint_t  i;
+
+    static const char  *month[] = { "Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                    "Jul", "Aug", "Sep", "Oct", "Nov", "Dec" };
+
+    /* "Sun, 06 Nov 1994 08:49:37 GMT" */
+
+    if (field->value_length != NXT_HTTP_DATE_LEN) {
+        return NXT_ERROR;
+    }
+
+    p = field->value;
+
+    if (p[3] != ',' || p[4] != ' ' || p[7] != ' ' || p[11] != ' '
+        || p[16] != ' ' || p[19] != ':' || p[22] != ':'
+        || memcmp(&p[25], " GMT", 4) != 0)
+    {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < nxt_nitems(month); i++) {
+        if (memcmp(&p[8], month[i], 3) == 0) {
+            break;
+        }
+    }
+
+    if (i == nxt_nitems(month)) {
+        return NXT_ERROR;
+    }
+
+    tm->tm_mon = i;
+
+    n = nxt_int_parse(&p[5], 2);
+    if (n < 1 || n > 31) {
+        return NXT_ERROR;
+    }
+
+    tm->tm_mday = n;
+
+    n = nxt_int_parse(&p[12], 4);
+    if (n < 1900) {
+        return NXT_ERROR;
+    }
+
+    tm->tm_year = n - 1900;
+
+    n = nxt_int_parse(&p[17], 2);
+    if (n < 0 || n > 23) {
+        return NXT_ERROR;
+    }
+
+    tm->tm_hour = n;
+
+    n = nxt_int_parse(&p[20], 2);
+    if (n < 0 || n > 59) {
+        return NXT_ERROR;
+    }
+
+    tm->tm_min = n;
+
+    n = nxt_int_parse(&p[23], 2);
+    if (n < 0 || n > 60) {
+        return NXT_ERROR;
+    }
+
+    tm->tm_sec = n;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_http_static_range(nxt_task_t *task, nxt_http_request_t *r, nxt_buf_t *fb,
+    nxt_file_info_t *fi, nxt_str_t *mtype, nxt_http_field_t *content_type,
+    nxt_http_field_t *last_modified, nxt_http_field_t *etag)
+{
+    u_char                   *p;
+    size_t                   length;
+    nxt_int_t                ret;
+    nxt_off_t                size;
+    nxt_str_t                value;
+    nxt_uint_t               nranges;
+    nxt_http_field_t         *field;
+    nxt_http_static_range_t  ranges[NXT_HTTP_STATIC_MAX_RANGES];
+
+    static const nxt_str_t  range = nxt_string("Range");
+    static const nxt_str_t  if_range = nxt_string("If-Range");
+
+    field = nxt_http_static_field(r, &range);
+    if (field == NULL) {
+        return NXT_OK;
+    }
+
+    value.length = field->value_length;
+    value.start = field->value;
+
+    field = nxt_http_static_field(r, &if_range);
+
+    /*
+     * The If-Range validator is compared with the entity tag and
+     * the modification date as strings, since both are strong
+     * validators generated by this module and clients return them
+     * as is.
+     */
+
+    if (field != NULL
+        && (field->value_length != etag->value_length
+            || memcmp(field->value, etag->value, etag->value_length) != 0)
+        && (field->value_length != last_modified->value_length
+            || memcmp(field->value, last_modified->value,
+                          last_modified->value_length) != 0))
+    {
+        nxt_debug(task, "http static if-range does not match");
+        return NXT_OK;
+    }
+
+    size = nxt_file_size(fi);
+
+    ret = nxt_http_static_range_parse(&value, size, ranges, &nranges);
+    if (ret != NXT_OK) {
+        nxt_debug(task, "http static range \"%V\" ignored", &value);
+        return NXT_OK;
+    }
+
+    if (nranges > 1) {
+        r->status = NXT_HTTP_PARTIAL_CONTENT;
+
+        return nxt_http_static_multipart(task, r, fb, fi, mtype, content_type,
+                                         ranges, nranges);
+    }
+
+    field = nxt_list_zero_add(r->resp.fields);
+    if (nxt_slow_path(field == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_http_field_name_set(field, "Content-Range");
+
+    if (nranges == 0) {
+        length = nxt_length("bytes */") + NXT_OFF_T_LEN;
+
+        p = nxt_mp_nget(r->mem_pool, length);
+        if (nxt_slow_path(p == NULL)) {
+            return NXT_ERROR;
+        }
+
+        field->value = p;
+        field->value_length = nxt_sprintf(p, p + length, "bytes */%O", size)
+                              - p;
+
+        if (content_type != NULL) {
+            content_type->skip = 1;
+        }
+
+        r->status = NXT_HTTP_RANGE_NOT_SATISFIABLE;
+        r->resp.content_length_n = 0;
+
+        return NXT_DECLINED;
+    }
+
+    r->status = NXT_HTTP_PARTIAL_CONTENT;
+
+    length = nxt_length("bytes -/") + 3 * NXT_OFF_T_LEN;
+
+    p = nxt_mp_nget(r->mem_pool, length);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    field->value = p;
+    field->value_length = nxt_sprintf(p, p + length, "bytes %O-%O/%O",
+                                      ranges[0].start, ranges[0].end - 1,
+                                      size)
+                          - p;
+
+    fb->file_pos = ranges[0].start;
+    fb->file_end = ranges[0].end;
+
+    r->resp.content_length_n = ranges[0].end - ranges[0].start;
+
+    return NXT_OK;
+}
 
-        b->next = nxt_http_buf_last(r);
+
+/*
+ * nxt_http_static_range_parse() returns NXT_OK and satisfiable ranges
+ * which can be none, or NXT_DECLINED if the Range header field is invalid
+ * or has too many ranges and should be ignored.
+ */
+
+static nxt_int_t
+nxt_http_static_range_parse(nxt_str_t *value, nxt_off_t size,
+    nxt_http_static_range_t *ranges, nxt_uint_t *nranges)
+{
+    u_char      *p, *end, *digits;
+    nxt_off_t   start, last;
+    nxt_uint_t  n, specs;
+
+    if (value->length < nxt_length("bytes=")
+        || nxt_strncasecmp(value->start, (u_char *) "bytes=",
+                           nxt_length("bytes=")) != 0)
+    {
+        return NXT_DECLINED;
+    }
+
+    p = value->start + nxt_length("bytes=");
+    end = value->start + value->length;
+
+    n = 0;
+    specs = 0;
+
+    for ( ;; ) {
+        while (p < end && (*p == ' ' || *p == '\t' || *p == ',')) {
+            p++;
+        }
+
+        if (p == end) {
+            break;
+        }
+
+        digits = p;
+
+        while (p < end && *p >= '0' && *p <= '9') {
+            p++;
+        }
+
+        if (p != digits) {
+            start = nxt_off_t_parse(digits, p - digits);
+            if (nxt_slow_path(start < 0)) {
+                return NXT_DECLINED;
+            }
+
+        } else {
+            /* A suffix range. */
+            start = -1;
+        }
+
+        if (p == end || *p != '-') {
+            return NXT_DECLINED;
+        }
+
+        digits = ++p;
+
+        while (p < end && *p >= '0' && *p <= '9') {
+            p++;
+        }
+
+        if (p != digits) {
+            last = nxt_off_t_parse(digits, p - digits);
+            if (nxt_slow_path(last < 0)) {
+                return NXT_DECLINED;
+            }
+
+            if (start == -1) {
+                start = (last < size) ? size - last : 0;
+                last = size;
+
+            } else if (last < start) {
+                return NXT_DECLINED;
+
+            } else {
+                last = (last < size) ? last + 1 : size;
+            }
+
+        } else if (start != -1) {
+            last = size;
+
+        } else {
+            return NXT_DECLINED;
+        }
+
+        while (p < end && (*p == ' ' || *p == '\t')) {
+            p++;
+        }
+
+        if (p != end && *p != ',') {
+            return NXT_DECLINED;
+        }
+
+        specs++;
+
+        if (start >= size) {
+            /* Not satisfiable. */
+            continue;
+        }
+
+        if (n == NXT_HTTP_STATIC_MAX_RANGES) {
+            return NXT_DECLINED;
+        }
+
+        ranges[n].start = start;
+        ranges[n].end = last;
+        n++;
+    }
+
+    if (specs == 0) {
+        return NXT_DECLINED;
+    }
+
+    *nranges = n;
+
+    return NXT_OK;
+}
+
+
+#define NXT_HTTP_STATIC_BOUNDARY_LEN  20
+
+
+static nxt_int_t
+nxt_http_static_multipart(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *fb, nxt_file_info_t *fi, nxt_str_t *mtype,
+    nxt_http_field_t *content_type, nxt_http_static_range_t *ranges,
+    nxt_uint_t nranges)
+{
+    u_char        *p, *boundary;
+    size_t        length;
+    nxt_off_t     size, total;
+    nxt_buf_t     *b, **next;
+    nxt_uint_t    i;
+    nxt_random_t  *random;
+
+    static const char  multipart[] = "multipart/byteranges; boundary=";
+
+    if (content_type == NULL) {
+        content_type = nxt_list_zero_add(r->resp.fields);
+        if (nxt_slow_path(content_type == NULL)) {
+            return NXT_ERROR;
+        }
+
+        nxt_http_field_name_set(content_type, "Content-Type");
+    }
+
+    length = nxt_length(multipart) + NXT_HTTP_STATIC_BOUNDARY_LEN;
+
+    p = nxt_mp_nget(r->mem_pool, length);
+    if (nxt_slow_path(p == NULL)) {
+        return NXT_ERROR;
+    }
+
+    content_type->value = p;
+    content_type->value_length = length;
+
+    p = nxt_cpymem(p, multipart, nxt_length(multipart));
+
+    boundary = p;
+    random = &task->thread->random;
+
+    (void) nxt_sprintf(p, p + NXT_HTTP_STATIC_BOUNDARY_LEN, "%010uD%010uD",
+                       nxt_random(random), nxt_random(random));
+
+    size = nxt_file_size(fi);
+    total = 0;
+    next = &fb->next;
+
+    for (i = 0; i < nranges; i++) {
+        length = nxt_length("\r\n--") + NXT_HTTP_STATIC_BOUNDARY_LEN
+                 + nxt_length("\r\nContent-Type: ") + mtype->length
+                 + nxt_length("\r\nContent-Range: bytes -/\r\n\r\n")
+                 + 3 * NXT_OFF_T_LEN;
+
+        b = nxt_buf_mem_alloc(r->mem_pool, length, 0);
+        if (nxt_slow_path(b == NULL)) {
+            return NXT_ERROR;
+        }
+
+        p = b->mem.free;
+
+        p = nxt_cpymem(p, "\r\n--", nxt_length("\r\n--"));
+        p = nxt_cpymem(p, boundary, NXT_HTTP_STATIC_BOUNDARY_LEN);
+
+        if (mtype->length != 0) {
+            p = nxt_cpymem(p, "\r\nContent-Type: ",
+                           nxt_length("\r\nContent-Type: "));
+            p = nxt_cpymem(p, mtype->start, mtype->length);
+        }
+
+        p = nxt_sprintf(p, b->mem.end, "\r\nContent-Range: bytes %O-%O/%O"
+                        "\r\n\r\n", ranges[i].start, ranges[i].end - 1, size);
+
+        b->mem.free = p;
+        b->completion_handler = nxt_http_static_part_completion;
+        b->parent = r;
+
+        total += p - b->mem.pos;
+
+        *next = b;
+        next = &b->next;
+
+        b = nxt_buf_file_alloc(r->mem_pool, 0, 0);
+        if (nxt_slow_path(b == NULL)) {
+            return NXT_ERROR;
+        }
+
+        b->file = fb->file;
+        b->file_pos = ranges[i].start;
+        b->file_end = ranges[i].end;
+        b->completion_handler = nxt_http_static_part_completion;
+        b->parent = r;
+
+        total += ranges[i].end - ranges[i].start;
+
+        *next = b;
+        next = &b->next;
+    }
+
+    length = nxt_length("\r\n--") + NXT_HTTP_STATIC_BOUNDARY_LEN
+             + nxt_length("--\r\n");
+
+    b = nxt_buf_mem_alloc(r->mem_pool, length, 0);
+    if (nxt_slow_path(b == NULL)) {
+        return NXT_ERROR;
+    }
+
+    p = b->mem.free;
+
+    p = nxt_cpymem(p, "\r\n--", nxt_length("\r\n--"));
+    p = nxt_cpymem(p, boundary, NXT_HTTP_STATIC_BOUNDARY_LEN);
+    p = nxt_cpymem(p, "--\r\n", nxt_length("--\r\n"));
+
+    b->mem.free = p;
+    b->completion_handler = nxt_http_static_part_completion;
+    b->parent = r;
+
+    total += length;
+
+    *next = b;
+
+    /* The parts are sent starting with the first part header. */
+    fb->file_pos = 0;
+    fb->file_end = 0;
+
+    r->resp.content_length_n = total;
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_http_static_body_handler(nxt_task_t *task, void *obj, void *data)
+{
+    size_t              alloc;
+    nxt_buf_t           *fb, *b, **next, *out;
+    nxt_off_t           rest;
+    nxt_int_t           n;
+    nxt_work_queue_t    *wq;
+    nxt_http_request_t  *r;
+
+    r = obj;
+    fb = r->out;
+
+    if (r->sendfile) {
+        /*
+         * Plain and kTLS connections send the file directly with
+         * sendfile(), other TLS connections read it to memory buffers
+         * to be encrypted.
+         */
+
+        if (fb->next == NULL) {
+            b = nxt_buf_file_alloc(r->mem_pool, 0, 0);
+            if (nxt_slow_path(b == NULL)) {
+                nxt_http_request_error_handler(task, r, r->proto.any);
+                return;
+            }
+
+            b->file = fb->file;
+            b->file_pos = fb->file_pos;
+            b->file_end = fb->file_end;
+            b->parent = r;
+
+            fb->next = b;
+        }
+
+        out = fb->next;
+        fb->next = NULL;
+
+        for (b = out; /* void */; b = b->next) {
+            b->completion_handler = nxt_http_static_part_completion;
+            nxt_mp_retain(r->mem_pool);
+
+            if (b->next == NULL) {
+                break;
+            }
+        }
+
+        /* The last buffer closes the file. */
+        b->completion_handler = nxt_http_static_file_completion;
+        b->next = nxt_http_buf_last(r);
+
+        nxt_http_request_send(task, r, out);
+        return;
+    }
+
+    if (fb->file_pos == fb->file_end) {
+        /* The first part header of a multipart response. */
+        nxt_http_request_send(task, r, nxt_http_static_next_part(task, r, fb));
+    }
+
+    rest = fb->file_end - fb->file_pos;
+
+    for (b = fb->next; b != NULL; b = b->next) {
+        if (nxt_buf_is_file(b)) {
+            rest += b->file_end - b->file_pos;
+        }
+    }
+
+    out = NULL;
+    next = &out;
+    n = 0;
+
+    do {
+        alloc = nxt_min(rest, NXT_HTTP_STATIC_BUF_SIZE);
+
+        b = nxt_buf_mem_alloc(r->mem_pool, alloc, 0);
+        if (nxt_slow_path(b == NULL)) {
+            goto fail;
+        }
+
+        b->completion_handler = nxt_http_static_buf_completion;
+        b->parent = r;
+
+        nxt_mp_retain(r->mem_pool);
+
+        *next = b;
+        next = &b->next;
+
+        rest -= alloc;
+
+    } while (rest > 0 && ++n < NXT_HTTP_STATIC_BUF_COUNT);
+
+    wq = &task->thread->engine->fast_work_queue;
+
+    nxt_sendbuf_drain(task, wq, out);
+    return;
+
+fail:
+
+    while (out != NULL) {
+        b = out;
+        out = b->next;
+
+        nxt_mp_free(r->mem_pool, b);
+        nxt_mp_release(r->mem_pool);
+    }
+}
+
+
+static const nxt_http_request_state_t  nxt_http_static_send_state
+    nxt_aligned(64) =
+{
+    .error_handler = nxt_http_request_error_handler,
+};
+
+
+static void
+nxt_http_static_buf_completion(nxt_task_t *task, void *obj, void *data)
+{
+    ssize_t             n, size;
+    nxt_buf_t           *b, *fb, *next;
+    nxt_off_t           rest;
+    nxt_http_request_t  *r;
+
+    b = obj;
+    r = data;
+
+complete_buf:
+
+    fb = r->out;
+
+    if (nxt_slow_path(fb == NULL || r->error)) {
+        goto clean;
+    }
+
+    rest = fb->file_end - fb->file_pos;
+    size = nxt_buf_mem_size(&b->mem);
+
+    size = nxt_min(rest, (nxt_off_t) size);
+
+    n = nxt_file_read(fb->file, b->mem.start, size, fb->file_pos);
+
+    if (nxt_slow_path(n == NXT_ERROR)) {
+        nxt_http_request_error_handler(task, r, r->proto.any);
+        goto clean;
+    }
+
+    next = b->next;
+
+    if (n == rest) {
+        b->next = nxt_http_static_next_part(task, r, fb);
 
     } else {
         fb->file_pos += n;
@@ -919,12 +1858,96 @@ nxt_http_static_buf_completion(nxt_task_t *task, void *obj, void *data)
     } while (b != NULL);
 
     if (fb != NULL) {
-        nxt_file_close(task, fb->file);
+        nxt_http_static_file_close(task, fb->file, fb->parent);
         r->out = NULL;
     }
 }
 
 
+/*
+ * Switches the file buffer to the next range of a multipart response
+ * and returns the header of the range part, or the closing boundary
+ * followed by the last buffer when no ranges are left.
+ */
+
+static nxt_buf_t *
+nxt_http_static_next_part(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *fb)
+{
+    nxt_buf_t  *part, *range;
+
+    part = fb->next;
+
+    if (part == NULL) {
+        nxt_http_static_file_close(task, fb->file, fb->parent);
+        r->out = NULL;
+
+        return nxt_http_buf_last(r);
+    }
+
+    nxt_mp_retain(r->mem_pool);
+
+    range = part->next;
+
+    if (range == NULL) {
+        nxt_http_static_file_close(task, fb->file, fb->parent);
+        r->out = NULL;
+
+        part->next = nxt_http_buf_last(r);
+
+        return part;
+    }
+
+    fb->file_pos = range->file_pos;
+    fb->file_end = range->file_end;
+    fb->next = range->next;
+
+    nxt_mp_free(r->mem_pool, range);
+
+    part->next = NULL;
+
+    return part;
+}
+
+
+static void
+nxt_http_static_file_completion(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t           *fb;
+    nxt_http_request_t  *r;
+
+    r = data;
+    fb = r->out;
+
+    if (fb != NULL) {
+        nxt_http_static_file_close(task, fb->file, fb->parent);
+        r->out = NULL;
+    }
+
+    nxt_http_static_part_completion(task, obj, data);
+}
+
+
+static void
+nxt_http_static_part_completion(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t           *b, *next;
+    nxt_http_request_t  *r;
+
+    b = obj;
+    r = data;
+
+    do {
+        next = b->next;
+
+        nxt_mp_free(r->mem_pool, b);
+        nxt_mp_release(r->mem_pool);
+
+        b = next;
+    } while (b != NULL);
+}
+
+
 nxt_int_t
 nxt_http_static_mtypes_init(nxt_mp_t *mp, nxt_lvlhsh_t *hash)
 {
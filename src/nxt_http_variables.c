@@ -525,6 +525,12 @@ nxt_http_var_response_connection(nxt_task_t *task, nxt_str_t *str, void *ctx,
     };
 
     r = ctx;
+
+    if (r->protocol != NXT_HTTP_PROTO_H1) {
+        nxt_str_null(str);
+        return NXT_OK;
+    }
+
     h1p = r->proto.h1;
 
     conn = -1;
@@ -595,7 +601,7 @@ nxt_http_var_response_transfer_encoding(nxt_task_t *task, nxt_str_t *str,
 
     r = ctx;
 
-    if (r->proto.h1->chunked) {
+    if (r->protocol == NXT_HTTP_PROTO_H1 && r->proto.h1->chunked) {
         nxt_str_set(str, "chunked");
 
     } else {
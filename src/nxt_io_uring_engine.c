@@ -0,0 +1,1550 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+
+
+/*
+ * The io_uring engine provides the same level-triggered event semantics
+ * as the epoll level engine.  Each enabled event is a oneshot operation
+ * which is rearmed on the next poll while the event stays active, so all
+ * event changes are submitted by the same io_uring_enter() call which
+ * waits for completions.
+ *
+ * Besides poll operations the engine accepts connections and receives
+ * data of plain connections by io_uring itself:
+ *
+ *   a listen socket always has a pending accept operation which returns
+ *   a new connection along with its peer address;
+ *
+ *   a connection waiting for data has a pending receive operation with
+ *   a buffer provided by the kernel from the engine buffer ring when data
+ *   arrive, so idle connections do not hold memory; the data are copied
+ *   to the connection buffer by recvbuf() without a syscall.
+ *
+ * The kernel writes only to the engine memory, so a connection can be
+ * closed and freed while its operations are still pending.  Completions
+ * are matched to events by a file descriptor and a slot generation which
+ * is changed when an event is deleted.
+ *
+ * IORING_FEAT_NODROP, IORING_FEAT_FAST_POLL      Linux 5.7.
+ * IORING_FEAT_EXT_ARG                            Linux 5.11.
+ * IORING_REGISTER_PBUF_RING                      Linux 5.19.
+ * IORING_CQE_F_SOCK_NONEMPTY for accept          Linux 6.10.
+ */
+
+
+#define NXT_IO_URING_POLL_IN     0x01
+#define NXT_IO_URING_POLL_OUT    0x02
+#define NXT_IO_URING_ACCEPT      0x04
+#define NXT_IO_URING_RECV        0x08
+
+#define NXT_IO_URING_READ                                                     \
+    (NXT_IO_URING_POLL_IN | NXT_IO_URING_ACCEPT | NXT_IO_URING_RECV)
+
+#define NXT_IO_URING_BUFS        256
+#define NXT_IO_URING_BUF_SIZE    4096
+#define NXT_IO_URING_BUF_GROUP   0
+
+#define NXT_IO_URING_GEN_MASK    0xFFFFFF
+
+#define NXT_IO_URING_FEATURES                                                 \
+    (IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_FAST_POLL     \
+     | IORING_FEAT_EXT_ARG)
+
+
+#define nxt_io_uring_data(op, gen, fd)                                        \
+    (((uint64_t) (op) << 56)                                                  \
+     | ((uint64_t) ((gen) & NXT_IO_URING_GEN_MASK) << 32)                     \
+     | (uint32_t) (fd))
+
+#define nxt_io_uring_load(p)                                                  \
+    __atomic_load_n(p, __ATOMIC_ACQUIRE)
+
+#define nxt_io_uring_store(p, v)                                              \
+    __atomic_store_n(p, v, __ATOMIC_RELEASE)
+
+
+struct nxt_io_uring_accept_s {
+    nxt_io_uring_accept_t         *next;
+    nxt_socket_t                  fd;
+    uint8_t                       nonempty;  /* 1 bit */
+    socklen_t                     socklen;
+    struct sockaddr_storage       sockaddr;
+};
+
+
+struct nxt_io_uring_slot_s {
+    nxt_fd_event_t                *ev;
+    nxt_io_uring_accept_t         *accept;
+
+    uint32_t                      gen;
+    nxt_err_t                     error;
+
+    /* The received data left in a provided buffer. */
+    uint32_t                      offset;
+    uint32_t                      length;
+    uint16_t                      bid;
+
+    uint8_t                       pending;
+    uint8_t                       cancel;
+
+    uint8_t                       changing;  /* 1 bit */
+    uint8_t                       recv;      /* 1 bit */
+    uint8_t                       nonempty;  /* 1 bit */
+    uint8_t                       eof;       /* 1 bit */
+};
+
+
+static nxt_int_t nxt_io_uring_create(nxt_event_engine_t *engine,
+    nxt_uint_t mchanges, nxt_uint_t mevents);
+static void nxt_io_uring_buffers_create(nxt_event_engine_t *engine);
+static void nxt_io_uring_free(nxt_event_engine_t *engine);
+static void nxt_io_uring_enable(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_disable(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_delete(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static nxt_bool_t nxt_io_uring_close(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_enable_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_enable_write(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_disable_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_disable_write(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_block_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_block_write(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_oneshot_read(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_oneshot_write(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_enable_accept(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static nxt_io_uring_slot_t *nxt_io_uring_slot(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static nxt_io_uring_slot_t *nxt_io_uring_slot_find(
+    nxt_event_engine_t *engine, nxt_fd_event_t *ev);
+static void nxt_io_uring_slot_reset(nxt_event_engine_t *engine,
+    nxt_socket_t fd, nxt_io_uring_slot_t *slot);
+static void nxt_io_uring_change(nxt_event_engine_t *engine, nxt_socket_t fd,
+    nxt_io_uring_slot_t *slot);
+static nxt_bool_t nxt_io_uring_commit_changes(nxt_event_engine_t *engine);
+static nxt_bool_t nxt_io_uring_commit(nxt_event_engine_t *engine,
+    nxt_socket_t fd, nxt_io_uring_slot_t *slot);
+static void nxt_io_uring_arm(nxt_event_engine_t *engine, nxt_socket_t fd,
+    nxt_io_uring_slot_t *slot, nxt_uint_t op);
+static void nxt_io_uring_cancel(nxt_event_engine_t *engine, nxt_socket_t fd,
+    nxt_io_uring_slot_t *slot, nxt_uint_t ops);
+static struct io_uring_sqe *nxt_io_uring_sqe(nxt_event_engine_t *engine);
+static int nxt_io_uring_enter(nxt_event_engine_t *engine, nxt_bool_t wait,
+    nxt_msec_t timeout);
+static void nxt_io_uring_poll(nxt_event_engine_t *engine, nxt_msec_t timeout);
+static void nxt_io_uring_complete(nxt_event_engine_t *engine,
+    uint64_t data, int32_t res, uint32_t flags);
+static nxt_bool_t nxt_io_uring_read_ready(nxt_event_engine_t *engine,
+    nxt_fd_event_t *ev);
+static void nxt_io_uring_buffer_release(nxt_event_engine_t *engine,
+    uint16_t bid);
+static void nxt_io_uring_error_handler(nxt_task_t *task, void *obj,
+    void *data);
+
+static void nxt_io_uring_conn_io_accept(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_io_uring_conn_io_read(nxt_task_t *task, void *obj,
+    void *data);
+static ssize_t nxt_io_uring_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b);
+static ssize_t nxt_io_uring_conn_io_recv(nxt_conn_t *c, void *buf,
+    size_t size, nxt_uint_t flags);
+static ssize_t nxt_io_uring_conn_recv_buffered(nxt_conn_t *c,
+    nxt_io_uring_slot_t *slot);
+
+
+static nxt_conn_io_t  nxt_io_uring_conn_io = {
+    .connect = nxt_conn_io_connect,
+    .accept = nxt_io_uring_conn_io_accept,
+
+    .read = nxt_io_uring_conn_io_read,
+    .recvbuf = nxt_io_uring_conn_io_recvbuf,
+    .recv = nxt_io_uring_conn_io_recv,
+
+    .write = nxt_conn_io_write,
+    .sendbuf = nxt_conn_io_sendbuf,
+
+#if (NXT_HAVE_LINUX_SENDFILE)
+    .old_sendbuf = nxt_linux_event_conn_io_sendfile,
+#else
+    .old_sendbuf = nxt_event_conn_io_sendbuf,
+#endif
+
+    .writev = nxt_event_conn_io_writev,
+    .send = nxt_event_conn_io_send,
+};
+
+
+const nxt_event_interface_t  nxt_io_uring_engine = {
+    "io_uring",
+    nxt_io_uring_create,
+    nxt_io_uring_free,
+    nxt_io_uring_enable,
+    nxt_io_uring_disable,
+    nxt_io_uring_delete,
+    nxt_io_uring_close,
+    nxt_io_uring_enable_read,
+    nxt_io_uring_enable_write,
+    nxt_io_uring_disable_read,
+    nxt_io_uring_disable_write,
+    nxt_io_uring_block_read,
+    nxt_io_uring_block_write,
+    nxt_io_uring_oneshot_read,
+    nxt_io_uring_oneshot_write,
+    nxt_io_uring_enable_accept,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    nxt_io_uring_poll,
+
+    &nxt_io_uring_conn_io,
+
+    NXT_NO_FILE_EVENTS,
+    NXT_NO_SIGNAL_EVENTS,
+};
+
+
+static nxt_int_t
+nxt_io_uring_create(nxt_event_engine_t *engine, nxt_uint_t mchanges,
+    nxt_uint_t mevents)
+{
+    int                    fd;
+    u_char                 *ring;
+    size_t                 sq_size, cq_size;
+    uint32_t               i, *array;
+    nxt_io_uring_engine_t  *ur;
+    struct io_uring_params  p;
+
+    ur = &engine->u.io_uring;
+    ur->fd = -1;
+
+    nxt_memzero(&p, sizeof(struct io_uring_params));
+
+    fd = syscall(SYS_io_uring_setup, mchanges, &p);
+
+    if (fd == -1) {
+        nxt_log(&engine->task, NXT_LOG_INFO, "io_uring_setup() failed %E",
+                nxt_errno);
+        return NXT_ERROR;
+    }
+
+    ur->fd = fd;
+
+    nxt_debug(&engine->task, "io_uring_setup(): %d", fd);
+
+    if ((p.features & NXT_IO_URING_FEATURES) != NXT_IO_URING_FEATURES) {
+        nxt_log(&engine->task, NXT_LOG_INFO,
+                "io_uring features %08XD are not supported",
+                NXT_IO_URING_FEATURES & ~p.features);
+        goto fail;
+    }
+
+    sq_size = p.sq_off.array + p.sq_entries * sizeof(uint32_t);
+    cq_size = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+
+    ur->ring_size = nxt_max(sq_size, cq_size);
+
+    ring = nxt_mem_mmap(NULL, ur->ring_size, NXT_MEM_MAP_READ
+                        | NXT_MEM_MAP_WRITE, NXT_MEM_MAP_FILE, fd,
+                        IORING_OFF_SQ_RING);
+
+    if (ring == NXT_MEM_MAP_FAILED) {
+        ur->ring = NULL;
+        goto fail;
+    }
+
+    ur->ring = ring;
+
+    ur->sqes_size = p.sq_entries * sizeof(struct io_uring_sqe);
+
+    ur->sqes = nxt_mem_mmap(NULL, ur->sqes_size, NXT_MEM_MAP_READ
+                            | NXT_MEM_MAP_WRITE, NXT_MEM_MAP_FILE, fd,
+                            IORING_OFF_SQES);
+
+    if (ur->sqes == NXT_MEM_MAP_FAILED) {
+        ur->sqes = NULL;
+        goto fail;
+    }
+
+    ur->sq_khead = (uint32_t *) (ring + p.sq_off.head);
+    ur->sq_ktail = (uint32_t *) (ring + p.sq_off.tail);
+    ur->sq_mask = *(uint32_t *) (ring + p.sq_off.ring_mask);
+    ur->sq_entries = p.sq_entries;
+    ur->sq_tail = *ur->sq_ktail;
+
+    ur->cq_khead = (uint32_t *) (ring + p.cq_off.head);
+    ur->cq_ktail = (uint32_t *) (ring + p.cq_off.tail);
+    ur->cq_mask = *(uint32_t *) (ring + p.cq_off.ring_mask);
+    ur->cqes = (struct io_uring_cqe *) (ring + p.cq_off.cqes);
+
+    array = (uint32_t *) (ring + p.sq_off.array);
+
+    for (i = 0; i < p.sq_entries; i++) {
+        array[i] = i;
+    }
+
+    ur->mchanges = mchanges;
+
+    ur->changes = nxt_malloc(sizeof(nxt_socket_t) * mchanges);
+    if (ur->changes == NULL) {
+        goto fail;
+    }
+
+    nxt_io_uring_buffers_create(engine);
+
+    return NXT_OK;
+
+fail:
+
+    nxt_io_uring_free(engine);
+
+    return NXT_ERROR;
+}
+
+
+static void
+nxt_io_uring_buffers_create(nxt_event_engine_t *engine)
+{
+    size_t                   size;
+    uint16_t                 bid;
+    nxt_io_uring_engine_t    *ur;
+    struct io_uring_buf_reg  reg;
+
+    ur = &engine->u.io_uring;
+
+    size = NXT_IO_URING_BUFS * sizeof(struct io_uring_buf);
+
+    ur->buf_ring = nxt_memalign(nxt_pagesize, size);
+    if (ur->buf_ring == NULL) {
+        return;
+    }
+
+    nxt_memzero(ur->buf_ring, size);
+
+    ur->bufs = nxt_malloc(NXT_IO_URING_BUFS * NXT_IO_URING_BUF_SIZE);
+    if (ur->bufs == NULL) {
+        goto fail;
+    }
+
+    nxt_memzero(&reg, sizeof(struct io_uring_buf_reg));
+
+    reg.ring_addr = (uintptr_t) ur->buf_ring;
+    reg.ring_entries = NXT_IO_URING_BUFS;
+    reg.bgid = NXT_IO_URING_BUF_GROUP;
+
+    if (syscall(SYS_io_uring_register, ur->fd, IORING_REGISTER_PBUF_RING,
+                &reg, 1)
+        != 0)
+    {
+        nxt_log(&engine->task, NXT_LOG_INFO,
+                "io_uring_register(PBUF_RING) failed %E", nxt_errno);
+        goto fail;
+    }
+
+    for (bid = 0; bid < NXT_IO_URING_BUFS; bid++) {
+        nxt_io_uring_buffer_release(engine, bid);
+    }
+
+    return;
+
+fail:
+
+    nxt_free(ur->bufs);
+    nxt_free(ur->buf_ring);
+
+    ur->bufs = NULL;
+    ur->buf_ring = NULL;
+}
+
+
+static void
+nxt_io_uring_free(nxt_event_engine_t *engine)
+{
+    nxt_uint_t             i;
+    nxt_io_uring_slot_t    *slot;
+    nxt_io_uring_accept_t  *accept;
+    nxt_io_uring_engine_t  *ur;
+
+    ur = &engine->u.io_uring;
+
+    nxt_debug(&engine->task, "io_uring %d free", ur->fd);
+
+    /* Closing the ring cancels all pending operations. */
+
+    if (ur->fd != -1 && close(ur->fd) != 0) {
+        nxt_alert(&engine->task, "io_uring close(%d) failed %E",
+                  ur->fd, nxt_errno);
+    }
+
+    if (ur->sqes != NULL) {
+        nxt_mem_munmap(ur->sqes, ur->sqes_size);
+    }
+
+    if (ur->ring != NULL) {
+        nxt_mem_munmap(ur->ring, ur->ring_size);
+    }
+
+    for (i = 0; i < ur->nslots; i++) {
+        slot = &ur->slots[i];
+        accept = slot->accept;
+
+        if (accept != NULL) {
+            if (accept->fd != -1) {
+                nxt_socket_close(&engine->task, accept->fd);
+            }
+
+            nxt_free(accept);
+        }
+    }
+
+    while (ur->zombies != NULL) {
+        accept = ur->zombies;
+        ur->zombies = accept->next;
+
+        nxt_free(accept);
+    }
+
+    nxt_free(ur->slots);
+    nxt_free(ur->changes);
+    nxt_free(ur->bufs);
+    nxt_free(ur->buf_ring);
+
+    nxt_memzero(ur, sizeof(nxt_io_uring_engine_t));
+}
+
+
+static void
+nxt_io_uring_enable(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t  *slot;
+
+    slot = nxt_io_uring_slot(engine, ev);
+
+    if (slot != NULL) {
+        ev->read = NXT_EVENT_ACTIVE;
+        ev->write = NXT_EVENT_ACTIVE;
+
+        slot->recv = 0;
+
+        nxt_io_uring_change(engine, ev->fd, slot);
+    }
+}
+
+
+static void
+nxt_io_uring_disable(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t  *slot;
+
+    ev->read = NXT_EVENT_INACTIVE;
+    ev->write = NXT_EVENT_INACTIVE;
+
+    slot = nxt_io_uring_slot_find(engine, ev);
+
+    if (slot != NULL) {
+        nxt_io_uring_change(engine, ev->fd, slot);
+    }
+}
+
+
+static void
+nxt_io_uring_delete(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t  *slot;
+
+    ev->read = NXT_EVENT_INACTIVE;
+    ev->write = NXT_EVENT_INACTIVE;
+
+    slot = nxt_io_uring_slot_find(engine, ev);
+
+    if (slot != NULL) {
+        nxt_io_uring_slot_reset(engine, ev->fd, slot);
+    }
+}
+
+
+/*
+ * Pending operations hold a file reference, so the file is released
+ * only after the operations are cancelled on the next poll.  The close()
+ * may be called right away since the kernel does not use the event memory.
+ */
+
+static nxt_bool_t
+nxt_io_uring_close(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_delete(engine, ev);
+
+    return 0;
+}
+
+
+static void
+nxt_io_uring_enable_read(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t  *slot;
+
+    slot = nxt_io_uring_slot(engine, ev);
+
+    if (slot != NULL) {
+        ev->read = NXT_EVENT_ACTIVE;
+
+        slot->recv = 0;
+
+        nxt_io_uring_change(engine, ev->fd, slot);
+    }
+}
+
+
+static void
+nxt_io_uring_enable_write(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t  *slot;
+
+    slot = nxt_io_uring_slot(engine, ev);
+
+    if (slot != NULL) {
+        ev->write = NXT_EVENT_ACTIVE;
+
+        nxt_io_uring_change(engine, ev->fd, slot);
+    }
+}
+
+
+static void
+nxt_io_uring_disable_read(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t  *slot;
+
+    ev->read = NXT_EVENT_INACTIVE;
+
+    slot = nxt_io_uring_slot_find(engine, ev);
+
+    if (slot != NULL) {
+        nxt_io_uring_change(engine, ev->fd, slot);
+    }
+}
+
+
+static void
+nxt_io_uring_disable_write(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t  *slot;
+
+    ev->write = NXT_EVENT_INACTIVE;
+
+    slot = nxt_io_uring_slot_find(engine, ev);
+
+    if (slot != NULL) {
+        nxt_io_uring_change(engine, ev->fd, slot);
+    }
+}
+
+
+/*
+ * A blocked event keeps its pending operation, the operation completion
+ * disables the event as in the epoll level-triggered mode.
+ */
+
+static void
+nxt_io_uring_block_read(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    if (ev->read != NXT_EVENT_INACTIVE) {
+        ev->read = NXT_EVENT_BLOCKED;
+    }
+}
+
+
+static void
+nxt_io_uring_block_write(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    if (ev->write != NXT_EVENT_INACTIVE) {
+        ev->write = NXT_EVENT_BLOCKED;
+    }
+}
+
+
+static void
+nxt_io_uring_oneshot_read(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t  *slot;
+
+    slot = nxt_io_uring_slot(engine, ev);
+
+    if (slot != NULL) {
+        ev->read = NXT_EVENT_ONESHOT;
+        ev->write = NXT_EVENT_INACTIVE;
+
+        slot->recv = 0;
+
+        nxt_io_uring_change(engine, ev->fd, slot);
+    }
+}
+
+
+static void
+nxt_io_uring_oneshot_write(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t  *slot;
+
+    slot = nxt_io_uring_slot(engine, ev);
+
+    if (slot != NULL) {
+        ev->read = NXT_EVENT_INACTIVE;
+        ev->write = NXT_EVENT_ONESHOT;
+
+        nxt_io_uring_change(engine, ev->fd, slot);
+    }
+}
+
+
+static void
+nxt_io_uring_enable_accept(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t    *slot;
+    nxt_io_uring_accept_t  *accept;
+
+    slot = nxt_io_uring_slot(engine, ev);
+
+    if (slot == NULL) {
+        return;
+    }
+
+    if (slot->accept == NULL) {
+        accept = nxt_zalloc(sizeof(nxt_io_uring_accept_t));
+
+        if (nxt_slow_path(accept == NULL)) {
+            nxt_work_queue_add(&engine->fast_work_queue,
+                               nxt_io_uring_error_handler,
+                               ev->task, ev, ev->data);
+            return;
+        }
+
+        accept->fd = -1;
+        slot->accept = accept;
+    }
+
+    ev->read = NXT_EVENT_ACTIVE;
+
+    nxt_io_uring_change(engine, ev->fd, slot);
+}
+
+
+static nxt_io_uring_slot_t *
+nxt_io_uring_slot(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_uint_t             n;
+    nxt_io_uring_slot_t    *slot, *slots;
+    nxt_io_uring_engine_t  *ur;
+
+    ur = &engine->u.io_uring;
+
+    if ((nxt_uint_t) ev->fd >= ur->nslots) {
+        n = nxt_max(ur->nslots * 2, (nxt_uint_t) ev->fd + 1);
+        n = nxt_max(n, 64);
+
+        slots = nxt_realloc(ur->slots, n * sizeof(nxt_io_uring_slot_t));
+
+        if (nxt_slow_path(slots == NULL)) {
+            nxt_work_queue_add(&engine->fast_work_queue,
+                               nxt_io_uring_error_handler,
+                               ev->task, ev, ev->data);
+            return NULL;
+        }
+
+        nxt_memzero(&slots[ur->nslots],
+                    (n - ur->nslots) * sizeof(nxt_io_uring_slot_t));
+
+        ur->slots = slots;
+        ur->nslots = n;
+    }
+
+    slot = &ur->slots[ev->fd];
+
+    if (slot->ev != ev) {
+
+        if (slot->ev != NULL) {
+            /* The descriptor has been closed without the event deletion. */
+            nxt_io_uring_slot_reset(engine, ev->fd, slot);
+        }
+
+        slot->ev = ev;
+    }
+
+    return slot;
+}
+
+
+static nxt_io_uring_slot_t *
+nxt_io_uring_slot_find(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    nxt_io_uring_slot_t    *slot;
+    nxt_io_uring_engine_t  *ur;
+
+    ur = &engine->u.io_uring;
+
+    if (ev->fd < 0 || (nxt_uint_t) ev->fd >= ur->nslots) {
+        return NULL;
+    }
+
+    slot = &ur->slots[ev->fd];
+
+    return (slot->ev == ev) ? slot : NULL;
+}
+
+
+static void
+nxt_io_uring_slot_reset(nxt_event_engine_t *engine, nxt_socket_t fd,
+    nxt_io_uring_slot_t *slot)
+{
+    nxt_io_uring_accept_t  *accept;
+
+    nxt_debug(&engine->task, "io_uring %d reset fd:%d pending:%02Xd",
+              engine->u.io_uring.fd, fd, slot->pending);
+
+    nxt_io_uring_cancel(engine, fd, slot, slot->pending);
+
+    if (slot->length != 0) {
+        nxt_io_uring_buffer_release(engine, slot->bid);
+    }
+
+    accept = slot->accept;
+
+    if (accept != NULL) {
+        if (accept->fd != -1) {
+            nxt_socket_close(&engine->task, accept->fd);
+        }
+
+        if ((slot->pending & NXT_IO_URING_ACCEPT) != 0) {
+            /* The kernel may still write the peer address. */
+            accept->next = engine->u.io_uring.zombies;
+            engine->u.io_uring.zombies = accept;
+
+        } else {
+            nxt_free(accept);
+        }
+    }
+
+    slot->ev = NULL;
+    slot->accept = NULL;
+    slot->gen++;
+    slot->error = 0;
+    slot->offset = 0;
+    slot->length = 0;
+    slot->pending = 0;
+    slot->cancel = 0;
+    slot->recv = 0;
+    slot->nonempty = 0;
+    slot->eof = 0;
+}
+
+
+static void
+nxt_io_uring_change(nxt_event_engine_t *engine, nxt_socket_t fd,
+    nxt_io_uring_slot_t *slot)
+{
+    nxt_uint_t             n;
+    nxt_socket_t           *changes;
+    nxt_io_uring_engine_t  *ur;
+
+    if (slot->changing) {
+        return;
+    }
+
+    ur = &engine->u.io_uring;
+
+    /*
+     * The changes are not committed before the poll, because a descriptor
+     * may be closed and reused before a prepared operation is submitted.
+     */
+
+    if (ur->nchanges == ur->mchanges) {
+        n = ur->mchanges * 2;
+
+        changes = nxt_realloc(ur->changes, n * sizeof(nxt_socket_t));
+
+        if (nxt_slow_path(changes == NULL)) {
+            nxt_work_queue_add(&engine->fast_work_queue,
+                               nxt_io_uring_error_handler,
+                               slot->ev->task, slot->ev, slot->ev->data);
+            return;
+        }
+
+        ur->changes = changes;
+        ur->mchanges = n;
+    }
+
+    slot->changing = 1;
+
+    ur->changes[ur->nchanges++] = fd;
+}
+
+
+static nxt_bool_t
+nxt_io_uring_commit_changes(nxt_event_engine_t *engine)
+{
+    nxt_uint_t             i;
+    nxt_bool_t             posted;
+    nxt_socket_t           fd;
+    nxt_io_uring_slot_t    *slot;
+    nxt_io_uring_engine_t  *ur;
+
+    ur = &engine->u.io_uring;
+
+    nxt_debug(&engine->task, "io_uring %d changes:%ui",
+              ur->fd, ur->nchanges);
+
+    posted = 0;
+
+    for (i = 0; i < ur->nchanges; i++) {
+        fd = ur->changes[i];
+        slot = &ur->slots[fd];
+
+        slot->changing = 0;
+
+        if (slot->ev != NULL) {
+            posted |= nxt_io_uring_commit(engine, fd, slot);
+        }
+    }
+
+    ur->nchanges = 0;
+
+    return posted;
+}
+
+
+static nxt_bool_t
+nxt_io_uring_commit(nxt_event_engine_t *engine, nxt_socket_t fd,
+    nxt_io_uring_slot_t *slot)
+{
+    nxt_uint_t      op;
+    nxt_bool_t      posted;
+    nxt_fd_event_t  *ev;
+
+    ev = slot->ev;
+    posted = 0;
+
+    if (slot->accept != NULL) {
+        op = NXT_IO_URING_ACCEPT;
+
+    } else if (slot->recv) {
+        op = NXT_IO_URING_RECV;
+
+    } else {
+        op = NXT_IO_URING_POLL_IN;
+    }
+
+    if (nxt_fd_event_is_active(ev->read)) {
+        nxt_io_uring_cancel(engine, fd, slot, NXT_IO_URING_READ & ~op);
+
+        if (slot->length != 0
+            || slot->eof
+            || slot->error != 0
+            || (slot->accept != NULL && slot->accept->fd != -1))
+        {
+            /* The data have already been received. */
+            posted = nxt_io_uring_read_ready(engine, ev);
+
+        } else if ((slot->pending & op) == 0) {
+            nxt_io_uring_arm(engine, fd, slot, op);
+        }
+
+    } else if (ev->read != NXT_EVENT_BLOCKED) {
+        nxt_io_uring_cancel(engine, fd, slot, NXT_IO_URING_READ);
+    }
+
+    if (nxt_fd_event_is_active(ev->write)) {
+
+        if ((slot->pending & NXT_IO_URING_POLL_OUT) == 0) {
+            nxt_io_uring_arm(engine, fd, slot, NXT_IO_URING_POLL_OUT);
+        }
+
+    } else if (ev->write != NXT_EVENT_BLOCKED) {
+        nxt_io_uring_cancel(engine, fd, slot, NXT_IO_URING_POLL_OUT);
+    }
+
+    return posted;
+}
+
+
+static void
+nxt_io_uring_arm(nxt_event_engine_t *engine, nxt_socket_t fd,
+    nxt_io_uring_slot_t *slot, nxt_uint_t op)
+{
+    uint32_t               events;
+    struct io_uring_sqe    *sqe;
+    nxt_io_uring_accept_t  *accept;
+
+    sqe = nxt_io_uring_sqe(engine);
+    if (nxt_slow_path(sqe == NULL)) {
+        return;
+    }
+
+    nxt_debug(slot->ev->task, "io_uring %d arm fd:%d op:%ui",
+              engine->u.io_uring.fd, fd, op);
+
+    sqe->fd = fd;
+    sqe->user_data = nxt_io_uring_data(op, slot->gen, fd);
+
+    switch (op) {
+
+    case NXT_IO_URING_ACCEPT:
+        accept = slot->accept;
+
+        nxt_memzero(&accept->sockaddr, sizeof(struct sockaddr_storage));
+        accept->socklen = sizeof(struct sockaddr_storage);
+
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->addr = (uintptr_t) &accept->sockaddr;
+        sqe->addr2 = (uintptr_t) &accept->socklen;
+        sqe->accept_flags = SOCK_NONBLOCK;
+        break;
+
+    case NXT_IO_URING_RECV:
+        sqe->opcode = IORING_OP_RECV;
+        sqe->len = NXT_IO_URING_BUF_SIZE;
+        sqe->flags = IOSQE_BUFFER_SELECT;
+        sqe->buf_group = NXT_IO_URING_BUF_GROUP;
+        /* The socket has been drained, so wait for data at first. */
+        sqe->ioprio = IORING_RECVSEND_POLL_FIRST;
+        break;
+
+    default:
+        events = (op == NXT_IO_URING_POLL_IN) ? POLLIN : POLLOUT;
+
+#if (NXT_HAVE_BIG_ENDIAN)
+        events = (events << 16) | (events >> 16);
+#endif
+
+        sqe->opcode = IORING_OP_POLL_ADD;
+        sqe->poll32_events = events;
+        break;
+    }
+
+    slot->pending |= op;
+}
+
+
+static void
+nxt_io_uring_cancel(nxt_event_engine_t *engine, nxt_socket_t fd,
+    nxt_io_uring_slot_t *slot, nxt_uint_t ops)
+{
+    nxt_uint_t           op;
+    struct io_uring_sqe  *sqe;
+
+    ops &= slot->pending & ~slot->cancel;
+
+    for (op = 1; ops != 0; op <<= 1) {
+
+        if ((ops & op) == 0) {
+            continue;
+        }
+
+        ops &= ~op;
+
+        sqe = nxt_io_uring_sqe(engine);
+        if (nxt_slow_path(sqe == NULL)) {
+            return;
+        }
+
+        nxt_debug(&engine->task, "io_uring %d cancel fd:%d op:%ui",
+                  engine->u.io_uring.fd, fd, op);
+
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->fd = -1;
+        sqe->addr = nxt_io_uring_data(op, slot->gen, fd);
+        sqe->user_data = 0;
+
+        slot->cancel |= op;
+    }
+}
+
+
+static struct io_uring_sqe *
+nxt_io_uring_sqe(nxt_event_engine_t *engine)
+{
+    struct io_uring_sqe    *sqe;
+    nxt_io_uring_engine_t  *ur;
+
+    ur = &engine->u.io_uring;
+
+    if (ur->sq_tail - nxt_io_uring_load(ur->sq_khead) >= ur->sq_entries) {
+
+        if (nxt_io_uring_enter(engine, 0, 0) == -1) {
+            nxt_alert(&engine->task, "io_uring_enter(%d) failed %E",
+                      ur->fd, nxt_errno);
+        }
+
+        if (ur->sq_tail - nxt_io_uring_load(ur->sq_khead) >= ur->sq_entries) {
+            nxt_alert(&engine->task, "io_uring %d submission queue is full",
+                      ur->fd);
+            return NULL;
+        }
+    }
+
+    sqe = &ur->sqes[ur->sq_tail & ur->sq_mask];
+    ur->sq_tail++;
+
+    nxt_memzero(sqe, sizeof(struct io_uring_sqe));
+
+    return sqe;
+}
+
+
+static int
+nxt_io_uring_enter(nxt_event_engine_t *engine, nxt_bool_t wait,
+    nxt_msec_t timeout)
+{
+    uint32_t                       submit, flags;
+    nxt_io_uring_engine_t          *ur;
+    struct __kernel_timespec       ts;
+    struct io_uring_getevents_arg  arg;
+
+    ur = &engine->u.io_uring;
+
+    nxt_io_uring_store(ur->sq_ktail, ur->sq_tail);
+
+    submit = ur->sq_tail - nxt_io_uring_load(ur->sq_khead);
+    flags = 0;
+
+    if (wait) {
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+
+        nxt_memzero(&arg, sizeof(struct io_uring_getevents_arg));
+
+        if (timeout != NXT_INFINITE_MSEC) {
+            ts.tv_sec = timeout / 1000;
+            ts.tv_nsec = (timeout % 1000) * 1000000;
+
+            arg.ts = (uintptr_t) &ts;
+        }
+    }
+
+    nxt_debug(&engine->task, "io_uring_enter(%d) submit:%uD wait:%d",
+              ur->fd, submit, wait);
+
+    return syscall(SYS_io_uring_enter, ur->fd, submit, wait, flags,
+                   &arg, sizeof(struct io_uring_getevents_arg));
+}
+
+
+static void
+nxt_io_uring_poll(nxt_event_engine_t *engine, nxt_msec_t timeout)
+{
+    int                    n;
+    uint32_t               head, tail;
+    nxt_err_t              err;
+    nxt_uint_t             level;
+    nxt_io_uring_engine_t  *ur;
+    struct io_uring_cqe    *cqe;
+
+    ur = &engine->u.io_uring;
+
+    if (ur->nchanges != 0 && nxt_io_uring_commit_changes(engine)) {
+        /* Handlers have been enqueued for already received data. */
+        timeout = 0;
+    }
+
+    if (*ur->cq_khead != nxt_io_uring_load(ur->cq_ktail)) {
+        timeout = 0;
+    }
+
+    n = nxt_io_uring_enter(engine, timeout != 0, timeout);
+
+    err = (n == -1) ? nxt_errno : 0;
+
+    nxt_thread_time_update(engine->task.thread);
+
+    nxt_debug(&engine->task, "io_uring_enter(%d): %d", ur->fd, n);
+
+    if (n == -1 && err != NXT_ETIME) {
+        level = (err == NXT_EINTR) ? NXT_LOG_INFO : NXT_LOG_ALERT;
+
+        nxt_log(&engine->task, level, "io_uring_enter(%d) failed %E",
+                ur->fd, err);
+    }
+
+    head = *ur->cq_khead;
+    tail = nxt_io_uring_load(ur->cq_ktail);
+
+    while (head != tail) {
+        cqe = &ur->cqes[head & ur->cq_mask];
+
+        nxt_io_uring_complete(engine, cqe->user_data, cqe->res, cqe->flags);
+
+        head++;
+    }
+
+    nxt_io_uring_store(ur->cq_khead, head);
+}
+
+
+static void
+nxt_io_uring_complete(nxt_event_engine_t *engine, uint64_t data, int32_t res,
+    uint32_t flags)
+{
+    uint32_t               gen;
+    uint16_t               bid;
+    nxt_uint_t             op;
+    nxt_socket_t           fd;
+    nxt_fd_event_t         *ev;
+    nxt_io_uring_slot_t    *slot;
+    nxt_io_uring_engine_t  *ur;
+
+    op = data >> 56;
+
+    if (op == 0) {
+        /* A cancel operation. */
+        return;
+    }
+
+    ur = &engine->u.io_uring;
+
+    fd = (uint32_t) data;
+    gen = (data >> 32) & NXT_IO_URING_GEN_MASK;
+
+    slot = ((nxt_uint_t) fd < ur->nslots) ? &ur->slots[fd] : NULL;
+
+    if (slot == NULL
+        || slot->ev == NULL
+        || (slot->gen & NXT_IO_URING_GEN_MASK) != gen)
+    {
+        nxt_debug(&engine->task, "io_uring stale fd:%d op:%ui res:%d",
+                  fd, op, res);
+
+        if ((flags & IORING_CQE_F_BUFFER) != 0) {
+            nxt_io_uring_buffer_release(engine,
+                                        flags >> IORING_CQE_BUFFER_SHIFT);
+        }
+
+        if (op == NXT_IO_URING_ACCEPT && res >= 0) {
+            nxt_socket_close(&engine->task, res);
+        }
+
+        return;
+    }
+
+    ev = slot->ev;
+
+    nxt_debug(ev->task, "io_uring: fd:%d op:%ui res:%d f:%04XD rd:%d wr:%d",
+              fd, op, res, flags, ev->read, ev->write);
+
+    slot->pending &= ~op;
+    slot->cancel &= ~op;
+
+    nxt_io_uring_change(engine, fd, slot);
+
+    if (res == -ECANCELED) {
+        return;
+    }
+
+    switch (op) {
+
+    case NXT_IO_URING_RECV:
+        if ((flags & IORING_CQE_F_BUFFER) != 0) {
+            bid = flags >> IORING_CQE_BUFFER_SHIFT;
+
+            if (res > 0) {
+                slot->bid = bid;
+                slot->offset = 0;
+                slot->length = res;
+
+            } else {
+                nxt_io_uring_buffer_release(engine, bid);
+            }
+        }
+
+        slot->nonempty = ((flags & IORING_CQE_F_SOCK_NONEMPTY) != 0);
+
+        if (res == 0) {
+            slot->eof = 1;
+
+        } else if (res < 0 && res != -ENOBUFS) {
+            /* On -ENOBUFS the data will be read by recv(). */
+            slot->error = -res;
+        }
+
+        (void) nxt_io_uring_read_ready(engine, ev);
+        return;
+
+    case NXT_IO_URING_ACCEPT:
+        if (res >= 0) {
+            slot->accept->fd = res;
+            slot->accept->nonempty =
+                           ((flags & IORING_CQE_F_SOCK_NONEMPTY) != 0);
+        }
+
+        /* An accept() error will be reported by accept4(). */
+
+        (void) nxt_io_uring_read_ready(engine, ev);
+        return;
+
+    case NXT_IO_URING_POLL_IN:
+        if (res < 0) {
+            break;
+        }
+
+        (void) nxt_io_uring_read_ready(engine, ev);
+        return;
+
+    default: /* NXT_IO_URING_POLL_OUT */
+        if (res < 0) {
+            break;
+        }
+
+        ev->write_ready = 1;
+
+        if (nxt_fd_event_is_active(ev->write)) {
+
+            if (ev->write == NXT_EVENT_ONESHOT) {
+                ev->write = NXT_EVENT_DISABLED;
+            }
+
+            nxt_work_queue_add(ev->write_work_queue, ev->write_handler,
+                               ev->task, ev, ev->data);
+
+        } else if (ev->write == NXT_EVENT_BLOCKED) {
+            ev->write = NXT_EVENT_INACTIVE;
+        }
+
+        return;
+    }
+
+    ev->error = -res;
+
+    nxt_alert(ev->task, "io_uring poll(%d) failed %E", fd, ev->error);
+
+    ev->read_ready = 1;
+    ev->write_ready = 1;
+
+    if (nxt_fd_event_is_active(ev->read) || nxt_fd_event_is_active(ev->write))
+    {
+        nxt_work_queue_add(&engine->fast_work_queue,
+                           nxt_io_uring_error_handler, ev->task, ev, ev->data);
+    }
+}
+
+
+static nxt_bool_t
+nxt_io_uring_read_ready(nxt_event_engine_t *engine, nxt_fd_event_t *ev)
+{
+    ev->read_ready = 1;
+
+    if (nxt_fd_event_is_active(ev->read)) {
+
+        if (ev->read == NXT_EVENT_ONESHOT) {
+            ev->read = NXT_EVENT_DISABLED;
+        }
+
+        nxt_work_queue_add(ev->read_work_queue, ev->read_handler,
+                           ev->task, ev, ev->data);
+        return 1;
+    }
+
+    if (ev->read == NXT_EVENT_BLOCKED) {
+        ev->read = NXT_EVENT_INACTIVE;
+    }
+
+    return 0;
+}
+
+
+static void
+nxt_io_uring_buffer_release(nxt_event_engine_t *engine, uint16_t bid)
+{
+    struct io_uring_buf    *buf;
+    nxt_io_uring_engine_t  *ur;
+
+    ur = &engine->u.io_uring;
+
+    buf = &ur->buf_ring->bufs[ur->buf_tail & (NXT_IO_URING_BUFS - 1)];
+
+    buf->addr = (uintptr_t) (ur->bufs + bid * NXT_IO_URING_BUF_SIZE);
+    buf->len = NXT_IO_URING_BUF_SIZE;
+    buf->bid = bid;
+
+    ur->buf_tail++;
+
+    nxt_io_uring_store(&ur->buf_ring->tail, ur->buf_tail);
+}
+
+
+static void
+nxt_io_uring_error_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_fd_event_t  *ev;
+
+    ev = obj;
+
+    ev->read = NXT_EVENT_INACTIVE;
+    ev->write = NXT_EVENT_INACTIVE;
+
+    ev->error_handler(ev->task, ev, data);
+}
+
+
+static void
+nxt_io_uring_conn_io_accept(nxt_task_t *task, void *obj, void *data)
+{
+    socklen_t              socklen;
+    nxt_conn_t             *c;
+    nxt_bool_t             nonempty;
+    nxt_socket_t           s;
+    struct sockaddr        *sa;
+    nxt_listen_event_t     *lev;
+    nxt_io_uring_slot_t    *slot;
+    nxt_io_uring_accept_t  *accept;
+
+    lev = obj;
+    c = lev->next;
+
+    lev->ready--;
+
+    slot = nxt_io_uring_slot_find(task->thread->engine, &lev->socket);
+    accept = (slot != NULL) ? slot->accept : NULL;
+
+    if (accept != NULL && accept->fd != -1) {
+        s = accept->fd;
+        accept->fd = -1;
+
+        nonempty = accept->nonempty;
+
+        lev->socket.read_ready = (lev->ready != 0 && nonempty);
+
+        nxt_memcpy(&c->remote->u.sockaddr, &accept->sockaddr,
+                   nxt_min(c->remote->socklen, accept->socklen));
+
+        c->socket.fd = s;
+
+        nxt_debug(task, "io_uring accept(%d): %d", lev->socket.fd, s);
+
+        nxt_conn_accept(task, lev, c);
+
+        if (!nonempty) {
+            /* The backlog is drained. */
+            lev->pending = 0;
+        }
+
+        return;
+    }
+
+    lev->socket.read_ready = (lev->ready != 0);
+
+    sa = &c->remote->u.sockaddr;
+    socklen = c->remote->socklen;
+    /*
+     * The returned socklen is ignored here,
+     * see comment in nxt_conn_io_accept().
+     */
+    s = accept4(lev->socket.fd, sa, &socklen, SOCK_NONBLOCK);
+
+    if (s != -1) {
+        c->socket.fd = s;
+
+        nxt_debug(task, "accept4(%d): %d", lev->socket.fd, s);
+
+        nxt_conn_accept(task, lev, c);
+        return;
+    }
+
+    nxt_conn_accept_error(task, lev, "accept4", nxt_errno);
+}
+
+
+/*
+ * A plain connection without data waits for them with a receive operation
+ * instead of a poll operation.  TLS libraries read sockets directly, so
+ * connections which may be handed over to them do not set read_ahead.
+ */
+
+static void
+nxt_io_uring_conn_io_read(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t              *c;
+    nxt_event_engine_t      *engine;
+    nxt_io_uring_slot_t     *slot;
+    const nxt_conn_state_t  *state;
+
+    c = obj;
+
+    engine = task->thread->engine;
+
+    if (!c->read_ahead
+        || c->socket.read_ready
+        || c->socket.error != 0
+        || c->block_read
+        || engine->u.io_uring.buf_ring == NULL)
+    {
+        nxt_conn_io_read(task, c, data);
+        return;
+    }
+
+    nxt_debug(task, "io_uring conn read fd:%d", c->socket.fd);
+
+    slot = nxt_io_uring_slot(engine, &c->socket);
+    if (nxt_slow_path(slot == NULL)) {
+        return;
+    }
+
+    state = c->read_state;
+
+    c->socket.read_handler = c->io->read;
+    c->socket.error_handler = state->error_handler;
+    c->socket.read = NXT_EVENT_ACTIVE;
+
+    slot->recv = 1;
+
+    nxt_io_uring_change(engine, c->socket.fd, slot);
+
+    if (state->timer_autoreset || !c->read_timer.enabled) {
+        nxt_conn_timer(engine, c, state, &c->read_timer);
+    }
+}
+
+
+static ssize_t
+nxt_io_uring_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b)
+{
+    u_char               *p;
+    size_t               size;
+    ssize_t              n;
+    nxt_io_uring_slot_t  *slot;
+
+    slot = nxt_io_uring_slot_find(c->socket.task->thread->engine, &c->socket);
+
+    if (slot == NULL) {
+        return nxt_conn_io_recvbuf(c, b);
+    }
+
+    if (slot->length == 0) {
+        n = nxt_io_uring_conn_recv_buffered(c, slot);
+
+        return (n != NXT_DECLINED) ? n : nxt_conn_io_recvbuf(c, b);
+    }
+
+    p = c->socket.task->thread->engine->u.io_uring.bufs
+        + slot->bid * NXT_IO_URING_BUF_SIZE + slot->offset;
+
+    n = 0;
+
+    while (b != NULL && slot->length != 0) {
+
+        if (!nxt_buf_is_sync(b)) {
+            size = nxt_min((size_t) (b->mem.end - b->mem.free), slot->length);
+
+            nxt_memcpy(b->mem.free, p, size);
+
+            p += size;
+
+            slot->offset += size;
+            slot->length -= size;
+            n += size;
+        }
+
+        b = b->next;
+    }
+
+    nxt_debug(c->socket.task, "io_uring recvbuf(%d): %z left:%uD",
+              c->socket.fd, n, slot->length);
+
+    if (slot->length == 0) {
+        nxt_io_uring_buffer_release(c->socket.task->thread->engine,
+                                    slot->bid);
+
+        c->socket.read_ready = slot->nonempty;
+    }
+
+    return n;
+}
+
+
+static ssize_t
+nxt_io_uring_conn_io_recv(nxt_conn_t *c, void *buf, size_t size,
+    nxt_uint_t flags)
+{
+    u_char               *p;
+    ssize_t              n;
+    nxt_io_uring_slot_t  *slot;
+
+    slot = nxt_io_uring_slot_find(c->socket.task->thread->engine, &c->socket);
+
+    if (slot == NULL) {
+        return nxt_conn_io_recv(c, buf, size, flags);
+    }
+
+    if (slot->length == 0) {
+        n = nxt_io_uring_conn_recv_buffered(c, slot);
+
+        return (n != NXT_DECLINED) ? n : nxt_conn_io_recv(c, buf, size, flags);
+    }
+
+    p = c->socket.task->thread->engine->u.io_uring.bufs
+        + slot->bid * NXT_IO_URING_BUF_SIZE + slot->offset;
+
+    size = nxt_min(size, slot->length);
+
+    nxt_memcpy(buf, p, size);
+
+    if ((flags & MSG_PEEK) == 0) {
+        slot->offset += size;
+        slot->length -= size;
+
+        if (slot->length == 0) {
+            nxt_io_uring_buffer_release(c->socket.task->thread->engine,
+                                        slot->bid);
+
+            c->socket.read_ready = slot->nonempty;
+        }
+    }
+
+    return size;
+}
+
+
+static ssize_t
+nxt_io_uring_conn_recv_buffered(nxt_conn_t *c, nxt_io_uring_slot_t *slot)
+{
+    nxt_err_t  err;
+
+    if (slot->error != 0) {
+        err = slot->error;
+        slot->error = 0;
+
+        c->socket.error = err;
+
+        nxt_log(c->socket.task, nxt_socket_error_level(err),
+                "io_uring recv(%d) failed %E", c->socket.fd, err);
+
+        return NXT_ERROR;
+    }
+
+    if (slot->eof) {
+        c->socket.closed = 1;
+        c->socket.read_ready = 0;
+
+        return 0;
+    }
+
+    if ((slot->pending & NXT_IO_URING_RECV) != 0) {
+        /* The data must not be read before the pending operation data. */
+        c->socket.read_ready = 0;
+
+        return NXT_AGAIN;
+    }
+
+    return NXT_DECLINED;
+}
@@ -18,10 +18,15 @@ typedef struct {
 
     nxt_sockaddr_t            *sockaddr;
 
+    /* SO_REUSEPORT group, sockets[0] is the socket itself. */
+    nxt_socket_t              *sockets;
+    uint32_t                  nsockets;
+
     uint32_t                  count;
 
     uint8_t                   flags;
     uint8_t                   read_after_accept;   /* 1 bit */
+    uint8_t                   reuseport;           /* 1 bit */
 
 #if (NXT_TLS)
     uint8_t                   tls;                 /* 1 bit */
@@ -48,6 +48,7 @@ typedef uint16_t                     nxt_port_id_t;
 #include <nxt_random.h>
 #include <nxt_string.h>
 #include <nxt_lvlhsh.h>
+#include <nxt_radix.h>
 #include <nxt_atomic.h>
 #include <nxt_spinlock.h>
 #include <nxt_work_queue.h>
@@ -26,6 +26,7 @@ typedef struct {
     nxt_socket_error_t  error;
     u_char              *start;
     u_char              *end;
+    uint8_t             reuseport;  /* 1 bit */
 } nxt_listening_socket_t;
 
 
@@ -230,6 +231,12 @@ static nxt_conf_map_t  nxt_python_app_conf[] = {
         NXT_CONF_MAP_INT32,
         offsetof(nxt_common_app_conf_t, u.python.thread_stack_size),
     },
+
+    {
+        nxt_string("preload"),
+        NXT_CONF_MAP_INT8,
+        offsetof(nxt_common_app_conf_t, u.python.preload),
+    },
 };
 
 
@@ -1136,6 +1143,12 @@ nxt_main_port_socket_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 
     /* TODO check b size and make plain */
 
+    /* An optional flags byte follows the sockaddr. */
+    size = nxt_sockaddr_size(sa);
+
+    ls.reuseport = ((size_t) nxt_buf_used_size(b) > size
+                    && b->mem.pos[size] != 0);
+
     ls.socket = -1;
     ls.error = NXT_SOCKET_ERROR_SYSTEM;
     ls.start = message;
@@ -1212,6 +1225,20 @@ nxt_main_listening_socket(nxt_sockaddr_t *sa, nxt_listening_socket_t *ls)
         goto fail;
     }
 
+#if (NXT_HAVE_REUSEPORT)
+
+    if (ls->reuseport
+        && setsockopt(s, SOL_SOCKET, SO_REUSEPORT, &enable, length) != 0)
+    {
+        ls->end = nxt_sprintf(ls->start, ls->end,
+                              "setsockopt(\\\"%*s\\\", SO_REUSEPORT) failed %E",
+                              (size_t) sa->length, nxt_sockaddr_start(sa),
+                              nxt_errno);
+        goto fail;
+    }
+
+#endif
+
 #if (NXT_INET6)
 
     if (sa->u.sockaddr.sa_family == AF_INET6) {
@@ -0,0 +1,236 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <nxt_open_file_cache.h>
+
+
+/*
+ * The cache is local to an event engine, so it is not locked.  Entries
+ * are kept in the least recently used order and are closed when they
+ * are evicted, expire, or the cache is flushed and the last request
+ * using them has finished.
+ */
+
+typedef struct {
+    nxt_lvlhsh_t                hash;
+    nxt_queue_t                 lru;     /* of nxt_open_file_t */
+    size_t                      entries;
+} nxt_open_file_cache_t;
+
+
+static void nxt_open_file_cache_delete(nxt_task_t *task,
+    nxt_open_file_cache_t *cache, nxt_open_file_t *of);
+static nxt_int_t nxt_open_file_cache_test(nxt_lvlhsh_query_t *lhq,
+    void *data);
+
+
+static const nxt_lvlhsh_proto_t  nxt_open_file_cache_proto  nxt_aligned(64) = {
+    NXT_LVLHSH_DEFAULT,
+    nxt_open_file_cache_test,
+    nxt_lvlhsh_alloc,
+    nxt_lvlhsh_free,
+};
+
+
+nxt_open_file_t *
+nxt_open_file_cache_find(nxt_task_t *task, nxt_str_t *key)
+{
+    nxt_open_file_t        *of;
+    nxt_event_engine_t     *engine;
+    nxt_lvlhsh_query_t     lhq;
+    nxt_open_file_cache_t  *cache;
+
+    engine = task->thread->engine;
+    cache = engine->open_file_cache;
+
+    if (cache == NULL) {
+        return NULL;
+    }
+
+    lhq.key = *key;
+    lhq.key_hash = nxt_djb_hash(key->start, key->length);
+    lhq.proto = &nxt_open_file_cache_proto;
+
+    if (nxt_lvlhsh_find(&cache->hash, &lhq) != NXT_OK) {
+        return NULL;
+    }
+
+    of = lhq.value;
+
+    if (nxt_msec_diff(of->expires, engine->timers.now) <= 0) {
+        nxt_debug(task, "open file cache expired: \"%FN\"", of->file.name);
+
+        nxt_open_file_cache_delete(task, cache, of);
+
+        return NULL;
+    }
+
+    nxt_debug(task, "open file cache hit: \"%FN\"", of->file.name);
+
+    nxt_queue_remove(&of->link);
+    nxt_queue_insert_head(&cache->lru, &of->link);
+
+    of->count++;
+
+    return of;
+}
+
+
+nxt_open_file_t *
+nxt_open_file_cache_add(nxt_task_t *task, nxt_str_t *key, nxt_file_t *file,
+    nxt_file_info_t *fi, size_t max, nxt_msec_t valid)
+{
+    nxt_open_file_t        *of;
+    nxt_queue_link_t       *link;
+    nxt_event_engine_t     *engine;
+    nxt_lvlhsh_query_t     lhq;
+    nxt_open_file_cache_t  *cache;
+
+    engine = task->thread->engine;
+    cache = engine->open_file_cache;
+
+    if (cache == NULL) {
+        cache = nxt_zalloc(sizeof(nxt_open_file_cache_t));
+        if (nxt_slow_path(cache == NULL)) {
+            return NULL;
+        }
+
+        nxt_queue_init(&cache->lru);
+
+        engine->open_file_cache = cache;
+    }
+
+    of = nxt_malloc(sizeof(nxt_open_file_t) + key->length);
+    if (nxt_slow_path(of == NULL)) {
+        return NULL;
+    }
+
+    of->file = *file;
+
+    if (fi != NULL) {
+        of->info = *fi;
+
+    } else {
+        nxt_memzero(&of->info, sizeof(nxt_file_info_t));
+    }
+
+    of->key.length = key->length;
+    of->key.start = nxt_pointer_to(of, sizeof(nxt_open_file_t));
+    nxt_memcpy(of->key.start, key->start, key->length);
+
+    of->key_hash = nxt_djb_hash(key->start, key->length);
+    of->file.name = of->key.start;
+
+    of->expires = engine->timers.now + valid;
+
+    lhq.key = of->key;
+    lhq.key_hash = of->key_hash;
+    lhq.replace = 0;
+    lhq.value = of;
+    lhq.proto = &nxt_open_file_cache_proto;
+    lhq.pool = NULL;
+
+    if (nxt_slow_path(nxt_lvlhsh_insert(&cache->hash, &lhq) != NXT_OK)) {
+        /* The entry is used by the caller only. */
+        of->count = 1;
+
+        return of;
+    }
+
+    nxt_debug(task, "open file cache add: \"%FN\"", of->file.name);
+
+    /* The cache and the caller. */
+    of->count = 2;
+
+    nxt_queue_insert_head(&cache->lru, &of->link);
+    cache->entries++;
+
+    while (cache->entries > max) {
+        link = nxt_queue_last(&cache->lru);
+
+        nxt_open_file_cache_delete(task, cache,
+                                   nxt_queue_link_data(link, nxt_open_file_t,
+                                                       link));
+    }
+
+    return of;
+}
+
+
+void
+nxt_open_file_release(nxt_task_t *task, nxt_open_file_t *of)
+{
+    if (--of->count != 0) {
+        return;
+    }
+
+    if (of->file.fd != -1) {
+        nxt_file_close(task, &of->file);
+    }
+
+    nxt_free(of);
+}
+
+
+void
+nxt_open_file_cache_flush(nxt_task_t *task)
+{
+    nxt_queue_link_t       *link;
+    nxt_event_engine_t     *engine;
+    nxt_open_file_cache_t  *cache;
+
+    engine = task->thread->engine;
+    cache = engine->open_file_cache;
+
+    if (cache == NULL) {
+        return;
+    }
+
+    nxt_debug(task, "open file cache flush: %z", cache->entries);
+
+    while (!nxt_queue_is_empty(&cache->lru)) {
+        link = nxt_queue_first(&cache->lru);
+
+        nxt_open_file_cache_delete(task, cache,
+                                   nxt_queue_link_data(link, nxt_open_file_t,
+                                                       link));
+    }
+
+    nxt_free(cache);
+
+    engine->open_file_cache = NULL;
+}
+
+
+static void
+nxt_open_file_cache_delete(nxt_task_t *task, nxt_open_file_cache_t *cache,
+    nxt_open_file_t *of)
+{
+    nxt_lvlhsh_query_t  lhq;
+
+    lhq.key = of->key;
+    lhq.key_hash = of->key_hash;
+    lhq.proto = &nxt_open_file_cache_proto;
+    lhq.pool = NULL;
+
+    (void) nxt_lvlhsh_delete(&cache->hash, &lhq);
+
+    nxt_queue_remove(&of->link);
+    cache->entries--;
+
+    nxt_open_file_release(task, of);
+}
+
+
+static nxt_int_t
+nxt_open_file_cache_test(nxt_lvlhsh_query_t *lhq, void *data)
+{
+    nxt_open_file_t  *of;
+
+    of = data;
+
+    return nxt_strstr_eq(&lhq->key, &of->key) ? NXT_OK : NXT_DECLINED;
+}
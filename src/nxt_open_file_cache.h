@@ -0,0 +1,40 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_OPEN_FILE_CACHE_H_INCLUDED_
+#define _NXT_OPEN_FILE_CACHE_H_INCLUDED_
+
+
+/*
+ * An open file cache entry.  The file descriptor is shared by all
+ * requests that use the entry, so it must be read only with pread()
+ * or sendfile().  Negative entries have the descriptor set to -1 and
+ * keep the open() error.  The key starts with the null-terminated file
+ * name that is also used as the file name of the entry.
+ */
+
+typedef struct {
+    nxt_file_t                  file;
+    nxt_file_info_t             info;
+
+    nxt_queue_link_t            link;
+    nxt_str_t                   key;
+    uint32_t                    key_hash;
+
+    nxt_msec_t                  expires;
+
+    /* The cache itself and the requests using the entry. */
+    uint32_t                    count;
+} nxt_open_file_t;
+
+
+nxt_open_file_t *nxt_open_file_cache_find(nxt_task_t *task, nxt_str_t *key);
+nxt_open_file_t *nxt_open_file_cache_add(nxt_task_t *task, nxt_str_t *key,
+    nxt_file_t *file, nxt_file_info_t *fi, size_t max, nxt_msec_t valid);
+void nxt_open_file_release(nxt_task_t *task, nxt_open_file_t *of);
+void nxt_open_file_cache_flush(nxt_task_t *task);
+
+
+#endif  /* _NXT_OPEN_FILE_CACHE_H_INCLUDED_ */
@@ -25,9 +25,18 @@ typedef struct {
     int               ssl_error;
     uint8_t           times;      /* 2 bits */
     uint8_t           handshake;  /* 1 bit  */
+    uint8_t           offload;    /* 2 bits */
+    uint8_t           shutdown;   /* 1 bit  */
 
     nxt_tls_conf_t    *conf;
     nxt_buf_mem_t     buffer;
+
+#if (NXT_HAVE_OPENSSL_CLIENT_HELLO_CB)
+    nxt_int_t         offload_status;
+    nxt_err_t         offload_error;
+    nxt_task_t        task;
+    nxt_work_t        work;
+#endif
 } nxt_openssl_conn_t;
 
 
@@ -45,6 +54,19 @@ struct nxt_tls_tickets_s {
 };
 
 
+/*
+ * A handshake is moved to a thread pool after a ClientHello has been
+ * received, so private key operations do not block an event engine.
+ */
+
+typedef enum {
+    NXT_OPENSSL_OFFLOAD_NONE = 0,
+    NXT_OPENSSL_OFFLOAD_PENDING,
+    NXT_OPENSSL_OFFLOAD_RUNNING,
+    NXT_OPENSSL_OFFLOAD_DONE,
+} nxt_openssl_offload_t;
+
+
 typedef enum {
     NXT_OPENSSL_HANDSHAKE = 0,
     NXT_OPENSSL_READ,
@@ -84,14 +106,37 @@ static nxt_int_t nxt_openssl_bundle_hash_test(nxt_lvlhsh_query_t *lhq,
 static nxt_int_t nxt_openssl_bundle_hash_insert(nxt_task_t *task,
     nxt_lvlhsh_t *lvlhsh, nxt_tls_bundle_hash_item_t *item, nxt_mp_t * mp);
 static nxt_int_t nxt_openssl_servername(SSL *s, int *ad, void *arg);
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+static int nxt_openssl_alpn_select(SSL *s, const unsigned char **out,
+    unsigned char *outlen, const unsigned char *in, unsigned int inlen,
+    void *arg);
+#endif
 static nxt_tls_bundle_conf_t *nxt_openssl_find_ctx(nxt_tls_conf_t *conf,
     nxt_str_t *sn);
 static void nxt_openssl_server_free(nxt_task_t *task, nxt_tls_conf_t *conf);
 static void nxt_openssl_conn_init(nxt_task_t *task, nxt_tls_conf_t *conf,
     nxt_conn_t *c);
 static void nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data);
+static nxt_task_t *nxt_openssl_conn_task(nxt_conn_t *c);
+#if (NXT_HAVE_OPENSSL_CLIENT_HELLO_CB)
+static nxt_int_t nxt_openssl_thread_pool_init(nxt_task_t *task);
+static int nxt_openssl_client_hello(SSL *s, int *al, void *arg);
+static nxt_bool_t nxt_openssl_client_hello_resumption(SSL *s);
+static void nxt_openssl_conn_handshake_offload(nxt_task_t *task,
+    nxt_conn_t *c);
+static void nxt_openssl_conn_handshake_wait(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_openssl_conn_handshake_thread(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_openssl_conn_handshake_resume(nxt_task_t *task, void *obj,
+    void *data);
+#endif
 static ssize_t nxt_openssl_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b);
 static ssize_t nxt_openssl_conn_io_sendbuf(nxt_task_t *task, nxt_sendbuf_t *sb);
+#if (NXT_HAVE_OPENSSL_KTLS)
+static ssize_t nxt_openssl_conn_io_sendfile(nxt_task_t *task,
+    nxt_sendbuf_t *sb);
+#endif
 static ssize_t nxt_openssl_conn_io_send(nxt_task_t *task, nxt_sendbuf_t *sb,
     void *buf, size_t size);
 static void nxt_openssl_conn_io_shutdown(nxt_task_t *task, void *obj,
@@ -128,6 +173,10 @@ static nxt_conn_io_t  nxt_openssl_conn_io = {
 static long  nxt_openssl_version;
 static int   nxt_openssl_connection_index;
 
+#if (NXT_HAVE_OPENSSL_CLIENT_HELLO_CB)
+static nxt_thread_pool_t  *nxt_openssl_thread_pool;
+#endif
+
 
 static nxt_int_t
 nxt_openssl_library_init(nxt_task_t *task)
@@ -331,6 +380,23 @@ nxt_openssl_server_init(nxt_task_t *task, nxt_mp_t *mp,
     SSL_CTX_set_options(ctx, SSL_OP_IGNORE_UNEXPECTED_EOF);
 #endif
 
+#if (NXT_HAVE_OPENSSL_KTLS)
+    if (tls_init->ktls) {
+        /*
+         * Record encryption is moved into the kernel if it supports
+         * the negotiated cipher, otherwise OpenSSL silently falls back
+         * to the userspace.
+         */
+        SSL_CTX_set_options(ctx, SSL_OP_ENABLE_KTLS);
+    }
+#endif
+
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+    if (tls_init->http2) {
+        SSL_CTX_set_alpn_select_cb(ctx, nxt_openssl_alpn_select, NULL);
+    }
+#endif
+
 #ifdef SSL_MODE_RELEASE_BUFFERS
 
     if (nxt_openssl_version >= 10001078) {
@@ -423,6 +489,14 @@ nxt_openssl_server_init(nxt_task_t *task, nxt_mp_t *mp,
         SSL_CTX_set_client_CA_list(ctx, list);
     }
 
+#if (NXT_HAVE_OPENSSL_CLIENT_HELLO_CB)
+    if (tls_init->handshake_offload
+        && nxt_openssl_thread_pool_init(task) == NXT_OK)
+    {
+        SSL_CTX_set_client_hello_cb(ctx, nxt_openssl_client_hello, NULL);
+    }
+#endif
+
     if (last) {
         conf->conn_init = nxt_openssl_conn_init;
 
@@ -737,6 +811,7 @@ nxt_tls_ticket_key_callback(SSL *s, unsigned char *name, unsigned char *iv,
 {
     nxt_uint_t          i;
     nxt_conn_t          *c;
+    nxt_task_t          *task;
     const EVP_MD        *digest;
     const EVP_CIPHER    *cipher;
     nxt_tls_ticket_t    *ticket;
@@ -751,18 +826,19 @@ nxt_tls_ticket_key_callback(SSL *s, unsigned char *name, unsigned char *iv,
 
     tls = c->u.tls;
     ticket = tls->conf->tickets->tickets;
+    task = nxt_openssl_conn_task(c);
 
     i = 0;
 
     if (enc == 1) {
         /* encrypt session ticket */
 
-        nxt_debug(c->socket.task, "TLS session ticket encrypt");
+        nxt_debug(task, "TLS session ticket encrypt");
 
         cipher = (ticket[0].size == 16) ? EVP_aes_128_cbc() : EVP_aes_256_cbc();
 
         if (RAND_bytes(iv, EVP_CIPHER_iv_length(cipher)) != 1) {
-            nxt_openssl_log_error(c->socket.task, NXT_LOG_ALERT,
+            nxt_openssl_log_error(task, NXT_LOG_ALERT,
                                   "RAND_bytes() failed");
             return -1;
         }
@@ -771,7 +847,7 @@ nxt_tls_ticket_key_callback(SSL *s, unsigned char *name, unsigned char *iv,
 
         if (EVP_EncryptInit_ex(ectx, cipher, NULL, ticket[0].aes_key, iv) != 1)
         {
-            nxt_openssl_log_error(c->socket.task, NXT_LOG_ALERT,
+            nxt_openssl_log_error(task, NXT_LOG_ALERT,
                                   "EVP_EncryptInit_ex() failed");
             return -1;
         }
@@ -786,14 +862,13 @@ nxt_tls_ticket_key_callback(SSL *s, unsigned char *name, unsigned char *iv,
 
         } while (++i < tls->conf->tickets->count);
 
-        nxt_debug(c->socket.task, "TLS session ticket decrypt, key not found");
+        nxt_debug(task, "TLS session ticket decrypt, key not found");
 
         return 0;
 
     found:
 
-        nxt_debug(c->socket.task,
-                  "TLS session ticket decrypt, key number: \"%d\"", i);
+        nxt_debug(task, "TLS session ticket decrypt, key number: \"%d\"", i);
 
         enc = (i == 0) ? 1 : 2 /* renew */;
 
@@ -801,7 +876,7 @@ nxt_tls_ticket_key_callback(SSL *s, unsigned char *name, unsigned char *iv,
 
         if (EVP_DecryptInit_ex(ectx, cipher, NULL, ticket[i].aes_key, iv) != 1)
         {
-            nxt_openssl_log_error(c->socket.task, NXT_LOG_ALERT,
+            nxt_openssl_log_error(task, NXT_LOG_ALERT,
                                   "EVP_DecryptInit_ex() failed");
             return -1;
         }
@@ -816,7 +891,7 @@ nxt_tls_ticket_key_callback(SSL *s, unsigned char *name, unsigned char *iv,
     if (HMAC_Init_ex(hctx, ticket[i].hmac_key, ticket[i].size, digest, NULL)
         != 1)
     {
-        nxt_openssl_log_error(c->socket.task, NXT_LOG_ALERT,
+        nxt_openssl_log_error(task, NXT_LOG_ALERT,
                               "HMAC_Init_ex() failed");
         return -1;
     }
@@ -1032,10 +1107,12 @@ nxt_openssl_servername(SSL *s, int *ad, void *arg)
     nxt_str_t              str;
     nxt_uint_t             i;
     nxt_conn_t             *c;
+    nxt_task_t             *task;
     const char             *servername;
     nxt_tls_conf_t         *conf;
     nxt_openssl_conn_t     *tls;
     nxt_tls_bundle_conf_t  *bundle;
+    u_char                 name[256];
 
     c = SSL_get_ex_data(s, nxt_openssl_connection_index);
 
@@ -1044,32 +1121,42 @@ nxt_openssl_servername(SSL *s, int *ad, void *arg)
         return SSL_TLSEXT_ERR_ALERT_FATAL;
     }
 
+    task = nxt_openssl_conn_task(c);
+
     servername = SSL_get_servername(s, TLSEXT_NAMETYPE_host_name);
 
     if (servername == NULL) {
-        nxt_debug(c->socket.task, "SSL_get_servername(): NULL");
+        nxt_debug(task, "SSL_get_servername(): NULL");
         goto done;
     }
 
     str.length = nxt_strlen(servername);
     if (str.length == 0) {
-        nxt_debug(c->socket.task, "SSL_get_servername(): \"\" is empty");
+        nxt_debug(task, "SSL_get_servername(): \"\" is empty");
         goto done;
     }
 
     if (servername[0] == '.') {
-        nxt_debug(c->socket.task, "ignored the server name \"%s\": "
-                                  "leading \".\"", servername);
+        nxt_debug(task, "ignored the server name \"%s\": "
+                        "leading \".\"", servername);
         goto done;
     }
 
-    nxt_debug(c->socket.task, "tls with servername \"%s\"", servername);
+    /*
+     * The callback may run in a thread pool during the handshake,
+     * so the connection memory pool is not used.
+     */
 
-    str.start = nxt_mp_nget(c->mem_pool, str.length);
-    if (nxt_slow_path(str.start == NULL)) {
-        return SSL_TLSEXT_ERR_ALERT_FATAL;
+    if (str.length > sizeof(name)) {
+        nxt_debug(task, "ignored the server name \"%s\": "
+                        "too long", servername);
+        goto done;
     }
 
+    nxt_debug(task, "tls with servername \"%s\"", servername);
+
+    str.start = name;
+
     nxt_memcpy_lowcase(str.start, (const u_char *) servername, str.length);
 
     tls = c->u.tls;
@@ -1090,13 +1177,13 @@ nxt_openssl_servername(SSL *s, int *ad, void *arg)
     }
 
     if (bundle != NULL) {
-        nxt_debug(c->socket.task, "new tls context found for \"%V\": \"%V\" "
-                                  "(old: \"%V\")", &str, &bundle->name,
-                                  &conf->bundle->name);
+        nxt_debug(task, "new tls context found for \"%V\": \"%V\" "
+                        "(old: \"%V\")", &str, &bundle->name,
+                        &conf->bundle->name);
 
         if (bundle != conf->bundle) {
             if (SSL_set_SSL_CTX(s, bundle->ctx) == NULL) {
-                nxt_openssl_log_error(c->socket.task, NXT_LOG_ALERT,
+                nxt_openssl_log_error(task, NXT_LOG_ALERT,
                                       "SSL_set_SSL_CTX() failed");
 
                 return SSL_TLSEXT_ERR_ALERT_FATAL;
@@ -1110,6 +1197,32 @@ nxt_openssl_servername(SSL *s, int *ad, void *arg)
 }
 
 
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+
+static int
+nxt_openssl_alpn_select(SSL *s, const unsigned char **out,
+    unsigned char *outlen, const unsigned char *in, unsigned int inlen,
+    void *arg)
+{
+    int  ret;
+
+    static const u_char  protocols[] = "\x02h2\x08http/1.1";
+
+    ret = SSL_select_next_proto((unsigned char **) out, outlen, protocols,
+                                sizeof(protocols) - 1, in, inlen);
+
+    if (ret != OPENSSL_NPN_NEGOTIATED) {
+        return SSL_TLSEXT_ERR_NOACK;
+    }
+
+    nxt_thread_log_debug("ALPN: %*s", (size_t) *outlen, *out);
+
+    return SSL_TLSEXT_ERR_OK;
+}
+
+#endif
+
+
 static nxt_tls_bundle_conf_t *
 nxt_openssl_find_ctx(nxt_tls_conf_t *conf, nxt_str_t *sn)
 {
@@ -1245,6 +1358,10 @@ nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data)
     nxt_work_handler_t      handler;
     nxt_openssl_conn_t      *tls;
     const nxt_conn_state_t  *state;
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+    unsigned int            len;
+    const unsigned char     *protocol;
+#endif
 
     c = obj;
 
@@ -1278,6 +1395,21 @@ nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data)
         /* ret == 1, the handshake was successfully completed. */
         tls->handshake = 1;
 
+#ifdef TLSEXT_TYPE_application_layer_protocol_negotiation
+        SSL_get0_alpn_selected(tls->session, &protocol, &len);
+
+        c->http2 = (len == 2 && protocol[0] == 'h' && protocol[1] == '2');
+#endif
+
+#if (NXT_HAVE_OPENSSL_KTLS)
+        if (BIO_get_ktls_send(SSL_get_wbio(tls->session))) {
+            nxt_debug(task, "openssl kTLS send fd:%d", c->socket.fd);
+
+            /* Files can be sent with SSL_sendfile(). */
+            c->sendfile = NXT_CONN_SENDFILE_ON;
+        }
+#endif
+
         if (c->read_state != NULL) {
             if (state->io_read_handler != NULL || c->read != NULL) {
                 nxt_conn_read(task->thread->engine, c);
@@ -1294,6 +1426,13 @@ nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data)
         handler = state->ready_handler;
 
     } else {
+#if (NXT_HAVE_OPENSSL_CLIENT_HELLO_CB)
+        if (tls->offload == NXT_OPENSSL_OFFLOAD_PENDING) {
+            nxt_openssl_conn_handshake_offload(task, c);
+            return;
+        }
+#endif
+
         c->socket.read_handler = nxt_openssl_conn_handshake;
         c->socket.write_handler = nxt_openssl_conn_handshake;
 
@@ -1328,6 +1467,288 @@ nxt_openssl_conn_handshake(nxt_task_t *task, void *obj, void *data)
 }
 
 
+#if (NXT_HAVE_OPENSSL_CLIENT_HELLO_CB)
+
+static nxt_int_t
+nxt_openssl_thread_pool_init(nxt_task_t *task)
+{
+    nxt_int_t          ret;
+    nxt_runtime_t      *rt;
+    nxt_thread_pool_t  **tp;
+
+    if (nxt_openssl_thread_pool != NULL) {
+        return NXT_OK;
+    }
+
+    rt = task->thread->runtime;
+
+    ret = nxt_runtime_thread_pool_create(task->thread, rt, nxt_ncpu,
+                                         60000 * 1000000LL);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return NXT_ERROR;
+    }
+
+    tp = rt->thread_pools->elts;
+    nxt_openssl_thread_pool = tp[rt->thread_pools->nelts - 1];
+
+    return NXT_OK;
+}
+
+
+static int
+nxt_openssl_client_hello(SSL *s, int *al, void *arg)
+{
+    nxt_conn_t          *c;
+    nxt_openssl_conn_t  *tls;
+
+    c = SSL_get_ex_data(s, nxt_openssl_connection_index);
+
+    if (nxt_slow_path(c == NULL)) {
+        return SSL_CLIENT_HELLO_SUCCESS;
+    }
+
+    tls = c->u.tls;
+
+    if (tls->offload != NXT_OPENSSL_OFFLOAD_NONE) {
+        return SSL_CLIENT_HELLO_SUCCESS;
+    }
+
+    if (nxt_openssl_client_hello_resumption(s)) {
+        tls->offload = NXT_OPENSSL_OFFLOAD_DONE;
+        return SSL_CLIENT_HELLO_SUCCESS;
+    }
+
+    /* Suspend SSL_do_handshake() to continue it in a thread pool. */
+
+    tls->offload = NXT_OPENSSL_OFFLOAD_PENDING;
+
+    return SSL_CLIENT_HELLO_RETRY;
+}
+
+
+/*
+ * A resumed session needs no private key operations, so its handshake
+ * is not worth offloading.  The session is not looked up yet, so the
+ * ClientHello is only tested for a session ticket, a TLS 1.3 PSK, or,
+ * if the session cache is enabled, a TLS 1.2 session id.  TLS 1.3
+ * clients send a random session id for middlebox compatibility.
+ */
+
+static nxt_bool_t
+nxt_openssl_client_hello_resumption(SSL *s)
+{
+    int                  ret;
+    size_t               len;
+    const unsigned char  *p;
+
+    if (SSL_client_hello_get0_ext(s, TLSEXT_TYPE_psk, &p, &len) == 1) {
+        return 1;
+    }
+
+    ret = SSL_client_hello_get0_ext(s, TLSEXT_TYPE_session_ticket, &p, &len);
+
+    if (ret == 1 && len != 0) {
+        return 1;
+    }
+
+    if (!(SSL_CTX_get_session_cache_mode(SSL_get_SSL_CTX(s))
+          & SSL_SESS_CACHE_SERVER))
+    {
+        return 0;
+    }
+
+    ret = SSL_client_hello_get0_ext(s, TLSEXT_TYPE_supported_versions,
+                                    &p, &len);
+
+    return (ret != 1 && SSL_client_hello_get0_session_id(s, &p) != 0);
+}
+
+
+static void
+nxt_openssl_conn_handshake_offload(nxt_task_t *task, nxt_conn_t *c)
+{
+    nxt_int_t           ret;
+    nxt_openssl_conn_t  *tls;
+
+    tls = c->u.tls;
+
+    nxt_debug(task, "openssl conn handshake offload fd:%d", c->socket.fd);
+
+    tls->offload = NXT_OPENSSL_OFFLOAD_RUNNING;
+
+    /*
+     * The connection is not touched by the engine until the thread
+     * returns, the handshake is retried then to catch up with events.
+     */
+    c->socket.read_handler = nxt_openssl_conn_handshake_wait;
+    c->socket.write_handler = nxt_openssl_conn_handshake_wait;
+
+    /* The thread is set by the thread pool. */
+    tls->task.thread = NULL;
+    tls->task.log = task->log;
+    tls->task.ident = task->ident;
+
+    nxt_work_set(&tls->work, nxt_openssl_conn_handshake_thread, &tls->task,
+                 c, task->thread->engine);
+    tls->work.next = NULL;
+
+    ret = nxt_thread_pool_post(nxt_openssl_thread_pool, &tls->work);
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        tls->offload = NXT_OPENSSL_OFFLOAD_DONE;
+
+        nxt_openssl_conn_handshake(task, c, c->socket.data);
+    }
+}
+
+
+static void
+nxt_openssl_conn_handshake_wait(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_debug(task, "openssl conn handshake wait");
+}
+
+
+static void
+nxt_openssl_conn_handshake_thread(nxt_task_t *task, void *obj, void *data)
+{
+    int                 ret;
+    nxt_int_t           n;
+    nxt_err_t           err;
+    nxt_conn_t          *c;
+    nxt_event_engine_t  *engine;
+    nxt_openssl_conn_t  *tls;
+
+    c = obj;
+    engine = data;
+
+    tls = c->u.tls;
+
+    ret = SSL_do_handshake(tls->session);
+
+    err = (ret <= 0) ? nxt_socket_errno : 0;
+
+    nxt_debug(task, "SSL_do_handshake(%d) in thread: %d err:%d",
+              c->socket.fd, ret, err);
+
+    /* NXT_AGAIN means that SSL_do_handshake() is retried by the engine. */
+
+    if (ret > 0) {
+        n = NXT_AGAIN;
+
+    } else {
+        /* The error queue is per thread, so it is examined here. */
+
+        switch (SSL_get_error(tls->session, ret)) {
+
+        case SSL_ERROR_WANT_READ:
+        case SSL_ERROR_WANT_WRITE:
+            n = NXT_AGAIN;
+            break;
+
+        case SSL_ERROR_ZERO_RETURN:
+            n = 0;
+            break;
+
+        case SSL_ERROR_SYSCALL:
+            if (err == 0 && ERR_peek_error() == 0) {
+                n = 0;
+                break;
+            }
+
+            /* Fall through. */
+
+        default:
+            n = NXT_ERROR;
+
+            nxt_openssl_conn_error(task, err, "SSL_do_handshake(%d) failed",
+                                   c->socket.fd);
+            break;
+        }
+
+        ERR_clear_error();
+    }
+
+    tls->offload_status = n;
+    tls->offload_error = err;
+
+    nxt_work_set(&tls->work, nxt_openssl_conn_handshake_resume,
+                 c->socket.task, c, NULL);
+    tls->work.next = NULL;
+
+    nxt_event_engine_post(engine, &tls->work);
+}
+
+
+static void
+nxt_openssl_conn_handshake_resume(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t              *c;
+    nxt_work_queue_t        *wq;
+    nxt_work_handler_t      handler;
+    nxt_openssl_conn_t      *tls;
+    const nxt_conn_state_t  *state;
+
+    c = obj;
+    tls = c->u.tls;
+
+    nxt_debug(task, "openssl conn handshake resume fd:%d status:%i",
+              c->socket.fd, tls->offload_status);
+
+    tls->offload = NXT_OPENSSL_OFFLOAD_DONE;
+
+    if (tls->shutdown) {
+        nxt_openssl_conn_io_shutdown(task, c, NULL);
+        return;
+    }
+
+    if (tls->offload_status == NXT_AGAIN) {
+        /* SSL_do_handshake() is retried to test readiness or to finish. */
+        nxt_openssl_conn_handshake(task, c, c->socket.data);
+        return;
+    }
+
+    state = (c->read_state != NULL) ? c->read_state : c->write_state;
+
+    if (tls->offload_status == 0) {
+        handler = state->close_handler;
+
+    } else {
+        c->socket.error = (tls->offload_error != 0) ? tls->offload_error
+                                                    : 1000;
+        handler = state->error_handler;
+    }
+
+    wq = (c->read_state != NULL) ? c->read_work_queue : c->write_work_queue;
+
+    nxt_work_queue_add(wq, handler, task, c, c->socket.data);
+}
+
+#endif
+
+
+/*
+ * The callbacks called by SSL_do_handshake() use the task of the thread
+ * pool thread while the handshake is offloaded.
+ */
+
+static nxt_task_t *
+nxt_openssl_conn_task(nxt_conn_t *c)
+{
+#if (NXT_HAVE_OPENSSL_CLIENT_HELLO_CB)
+    nxt_openssl_conn_t  *tls;
+
+    tls = c->u.tls;
+
+    if (tls->offload == NXT_OPENSSL_OFFLOAD_RUNNING) {
+        return &tls->task;
+    }
+#endif
+
+    return c->socket.task;
+}
+
+
 static ssize_t
 nxt_openssl_conn_io_recvbuf(nxt_conn_t *c, nxt_buf_t *b)
 {
@@ -1375,10 +1796,76 @@ nxt_openssl_conn_io_sendbuf(nxt_task_t *task, nxt_sendbuf_t *sb)
         return 0;
     }
 
+#if (NXT_HAVE_OPENSSL_KTLS)
+    if (niov == 0 && sb->buf != NULL && nxt_buf_is_file(sb->buf)) {
+        return nxt_openssl_conn_io_sendfile(task, sb);
+    }
+#endif
+
     return nxt_openssl_conn_io_send(task, sb, iov.iov_base, iov.iov_len);
 }
 
 
+#if (NXT_HAVE_OPENSSL_KTLS)
+
+static ssize_t
+nxt_openssl_conn_io_sendfile(nxt_task_t *task, nxt_sendbuf_t *sb)
+{
+    size_t              size;
+    ossl_ssize_t        ret;
+    nxt_err_t           err;
+    nxt_int_t           n;
+    nxt_buf_t           *b;
+    nxt_conn_t          *c;
+    nxt_openssl_conn_t  *tls;
+
+    tls = sb->tls;
+    b = sb->buf;
+
+    size = nxt_min(b->file_end - b->file_pos, (nxt_off_t) sb->limit);
+
+    ret = SSL_sendfile(tls->session, b->file->fd, b->file_pos, size, 0);
+
+    err = (ret <= 0) ? nxt_socket_errno : 0;
+
+    nxt_debug(task, "SSL_sendfile(%d, %FD, @%O, %uz): %z err:%d",
+              sb->socket, b->file->fd, b->file_pos, size, ret, err);
+
+    if (ret > 0) {
+        if (ret < (ossl_ssize_t) size) {
+            sb->ready = 0;
+        }
+
+        return ret;
+    }
+
+    if (nxt_slow_path(ret == 0)) {
+        nxt_alert(task, "SSL_sendfile() reported that file was truncated "
+                  "at %O", b->file_pos);
+
+        return NXT_ERROR;
+    }
+
+    c = tls->conn;
+    c->socket.write_ready = sb->ready;
+
+    n = nxt_openssl_conn_test_error(task, c, ret, err, NXT_OPENSSL_WRITE);
+
+    sb->ready = c->socket.write_ready;
+
+    if (n == NXT_ERROR) {
+        sb->error = c->socket.error;
+        nxt_openssl_conn_error(task, err, "SSL_sendfile(%d, %FD, @%O, %uz) "
+                               "failed", sb->socket, b->file->fd,
+                               b->file_pos, size);
+    }
+
+    return n;
+}
+
+#endif
+
+
 static ssize_t
 nxt_openssl_conn_io_send(nxt_task_t *task, nxt_sendbuf_t *sb, void *buf,
     size_t size)
@@ -1442,6 +1929,14 @@ nxt_openssl_conn_io_shutdown(nxt_task_t *task, void *obj, void *data)
         return;
     }
 
+#if (NXT_HAVE_OPENSSL_CLIENT_HELLO_CB)
+    if (tls->offload == NXT_OPENSSL_OFFLOAD_RUNNING) {
+        /* The shutdown continues when the handshake thread returns. */
+        tls->shutdown = 1;
+        return;
+    }
+#endif
+
     s = tls->session;
 
     if (s == NULL || !tls->handshake) {
@@ -356,6 +356,7 @@ NXT_EXPORT nxt_app_module_t  nxt_app_module = {
     0,
     nxt_php_setup,
     nxt_php_start,
+    NULL,
 };
 
 
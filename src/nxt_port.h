@@ -63,6 +63,9 @@ struct nxt_port_handlers_s {
     nxt_port_handler_t  shm_ack;
     nxt_port_handler_t  read_queue;
     nxt_port_handler_t  read_socket;
+
+    /* Streamed request body acknowledgment. */
+    nxt_port_handler_t  req_body_ack;
 };
 
 
@@ -119,6 +122,7 @@ typedef enum {
     _NXT_PORT_MSG_SHM_ACK         = nxt_port_handler_idx(shm_ack),
     _NXT_PORT_MSG_READ_QUEUE      = nxt_port_handler_idx(read_queue),
     _NXT_PORT_MSG_READ_SOCKET     = nxt_port_handler_idx(read_socket),
+    _NXT_PORT_MSG_REQ_BODY_ACK    = nxt_port_handler_idx(req_body_ack),
 
     NXT_PORT_MSG_MAX              = sizeof(nxt_port_handlers_t)
                                     / sizeof(nxt_port_handler_t),
@@ -152,6 +156,7 @@ typedef enum {
 
     NXT_PORT_MSG_REQ_HEADERS      = _NXT_PORT_MSG_REQ_HEADERS,
     NXT_PORT_MSG_REQ_BODY         = _NXT_PORT_MSG_REQ_BODY,
+    NXT_PORT_MSG_REQ_BODY_LAST    = nxt_msg_last(_NXT_PORT_MSG_REQ_BODY),
     NXT_PORT_MSG_WEBSOCKET        = _NXT_PORT_MSG_WEBSOCKET,
     NXT_PORT_MSG_WEBSOCKET_LAST   = nxt_msg_last(_NXT_PORT_MSG_WEBSOCKET),
 
@@ -164,6 +169,7 @@ typedef enum {
     NXT_PORT_MSG_SHM_ACK          = nxt_msg_last(_NXT_PORT_MSG_SHM_ACK),
     NXT_PORT_MSG_READ_QUEUE       = _NXT_PORT_MSG_READ_QUEUE,
     NXT_PORT_MSG_READ_SOCKET      = _NXT_PORT_MSG_READ_SOCKET,
+    NXT_PORT_MSG_REQ_BODY_ACK     = _NXT_PORT_MSG_REQ_BODY_ACK,
 } nxt_port_msg_type_t;
 
 
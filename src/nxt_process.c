@@ -640,6 +640,7 @@ nxt_process_setup(nxt_task_t *task, nxt_process_t *process)
     nxt_int_t                    ret;
     nxt_thread_t                 *thread;
     nxt_runtime_t                *rt;
+    nxt_thread_pool_t            **tp;
     nxt_process_init_t           *init;
     nxt_event_engine_t           *engine;
     const nxt_event_interface_t  *interface;
@@ -681,6 +682,9 @@ nxt_process_setup(nxt_task_t *task, nxt_process_t *process)
         return NXT_ERROR;
     }
 
+    tp = rt->thread_pools->elts;
+    rt->auxiliary_pool = tp[rt->thread_pools->nelts - 1];
+
     nxt_port_read_close(process->parent_port);
     nxt_port_write_enable(task, process->parent_port);
 
@@ -0,0 +1,314 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+
+
+static nxt_radix_node_t *nxt_radix_node_create(nxt_radix_t *tree,
+    const u_char *key, size_t length);
+static nxt_radix_node_t **nxt_radix_child(nxt_radix_node_t *node, u_char c);
+static nxt_int_t nxt_radix_child_add(nxt_radix_t *tree, nxt_radix_node_t *node,
+    nxt_radix_node_t *child);
+static nxt_int_t nxt_radix_node_walk(nxt_radix_node_t *node,
+    nxt_radix_walk_t handler, void *data, void *parent);
+
+
+nxt_radix_t *
+nxt_radix_create(nxt_mp_t *mp, nxt_bool_t nocase)
+{
+    nxt_radix_t  *tree;
+
+    tree = nxt_mp_get(mp, sizeof(nxt_radix_t));
+    if (nxt_slow_path(tree == NULL)) {
+        return NULL;
+    }
+
+    tree->mem_pool = mp;
+    tree->nocase = nocase;
+
+    tree->root = nxt_radix_node_create(tree, NULL, 0);
+    if (nxt_slow_path(tree->root == NULL)) {
+        return NULL;
+    }
+
+    return tree;
+}
+
+
+void **
+nxt_radix_insert(nxt_radix_t *tree, const u_char *key, size_t length,
+    nxt_radix_match_t match)
+{
+    u_char            c;
+    size_t            n, rest;
+    const u_char      *p, *end;
+    nxt_radix_node_t  *node, *child, *split, **pchild;
+
+    node = tree->root;
+
+    p = key;
+    end = key + length;
+
+    for ( ;; ) {
+        if (p == end) {
+            return &node->value[match];
+        }
+
+        c = tree->nocase ? nxt_lowcase(*p) : *p;
+
+        pchild = nxt_radix_child(node, c);
+
+        if (pchild == NULL) {
+            child = nxt_radix_node_create(tree, p, end - p);
+            if (nxt_slow_path(child == NULL)) {
+                return NULL;
+            }
+
+            if (nxt_slow_path(nxt_radix_child_add(tree, node, child)
+                              != NXT_OK))
+            {
+                return NULL;
+            }
+
+            return &child->value[match];
+        }
+
+        child = *pchild;
+        rest = end - p;
+
+        for (n = 1; n < child->length && n < rest; n++) {
+            c = tree->nocase ? nxt_lowcase(p[n]) : p[n];
+
+            if (child->key[n] != c) {
+                break;
+            }
+        }
+
+        if (n < child->length) {
+            /* The child key diverges from the inserted key, split it. */
+
+            split = nxt_radix_node_create(tree, NULL, 0);
+            if (nxt_slow_path(split == NULL)) {
+                return NULL;
+            }
+
+            split->key = child->key;
+            split->length = n;
+
+            child->key += n;
+            child->length -= n;
+
+            *pchild = split;
+
+            if (nxt_slow_path(nxt_radix_child_add(tree, split, child)
+                              != NXT_OK))
+            {
+                return NULL;
+            }
+
+            child = split;
+        }
+
+        p += n;
+        node = child;
+    }
+}
+
+
+void *
+nxt_radix_find(nxt_radix_t *tree, const u_char *key, size_t length)
+{
+    u_char            c;
+    size_t            n;
+    void              *value;
+    const u_char      *p, *end;
+    nxt_radix_node_t  *node, **pchild;
+
+    node = tree->root;
+    value = NULL;
+
+    p = key;
+    end = key + length;
+
+    for ( ;; ) {
+        if (p == end) {
+            if (node->value[NXT_RADIX_EXACT] != NULL) {
+                return node->value[NXT_RADIX_EXACT];
+            }
+
+            if (node->value[NXT_RADIX_PREFIX] != NULL) {
+                return node->value[NXT_RADIX_PREFIX];
+            }
+
+            return value;
+        }
+
+        if (node->value[NXT_RADIX_PREFIX] != NULL) {
+            value = node->value[NXT_RADIX_PREFIX];
+        }
+
+        c = tree->nocase ? nxt_lowcase(*p) : *p;
+
+        pchild = nxt_radix_child(node, c);
+        if (pchild == NULL) {
+            return value;
+        }
+
+        node = *pchild;
+
+        if (node->length > (size_t) (end - p)) {
+            return value;
+        }
+
+        if (tree->nocase) {
+            for (n = 1; n < node->length; n++) {
+                if (node->key[n] != nxt_lowcase(p[n])) {
+                    return value;
+                }
+            }
+
+        } else if (memcmp(node->key + 1, p + 1, node->length - 1) != 0) {
+            return value;
+        }
+
+        p += node->length;
+    }
+}
+
+
+nxt_int_t
+nxt_radix_walk(nxt_radix_t *tree, nxt_radix_walk_t handler, void *data)
+{
+    return nxt_radix_node_walk(tree->root, handler, data, NULL);
+}
+
+
+static nxt_radix_node_t *
+nxt_radix_node_create(nxt_radix_t *tree, const u_char *key, size_t length)
+{
+    u_char            *p;
+    nxt_radix_node_t  *node;
+
+    node = nxt_mp_zget(tree->mem_pool, sizeof(nxt_radix_node_t));
+    if (nxt_slow_path(node == NULL)) {
+        return NULL;
+    }
+
+    if (length != 0) {
+        p = nxt_mp_nget(tree->mem_pool, length);
+        if (nxt_slow_path(p == NULL)) {
+            return NULL;
+        }
+
+        if (tree->nocase) {
+            nxt_memcpy_lowcase(p, key, length);
+
+        } else {
+            nxt_memcpy(p, key, length);
+        }
+
+        node->key = p;
+        node->length = length;
+    }
+
+    return node;
+}
+
+
+static nxt_radix_node_t **
+nxt_radix_child(nxt_radix_node_t *node, u_char c)
+{
+    u_char            k;
+    nxt_uint_t        lo, hi, mid;
+    nxt_radix_node_t  **children;
+
+    children = node->children;
+
+    lo = 0;
+    hi = node->nchildren;
+
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        k = children[mid]->key[0];
+
+        if (k == c) {
+            return &children[mid];
+        }
+
+        if (k < c) {
+            lo = mid + 1;
+
+        } else {
+            hi = mid;
+        }
+    }
+
+    return NULL;
+}
+
+
+static nxt_int_t
+nxt_radix_child_add(nxt_radix_t *tree, nxt_radix_node_t *node,
+    nxt_radix_node_t *child)
+{
+    u_char            c;
+    nxt_uint_t        i, n;
+    nxt_radix_node_t  **children;
+
+    n = node->nchildren;
+
+    children = nxt_mp_alloc(tree->mem_pool,
+                            (n + 1) * sizeof(nxt_radix_node_t *));
+    if (nxt_slow_path(children == NULL)) {
+        return NXT_ERROR;
+    }
+
+    c = child->key[0];
+
+    for (i = 0; i < n && node->children[i]->key[0] < c; i++) {
+        children[i] = node->children[i];
+    }
+
+    children[i] = child;
+
+    nxt_memcpy(&children[i + 1], &node->children[i],
+               (n - i) * sizeof(nxt_radix_node_t *));
+
+    if (node->children != NULL) {
+        nxt_mp_free(tree->mem_pool, node->children);
+    }
+
+    node->children = children;
+    node->nchildren = n + 1;
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_radix_node_walk(nxt_radix_node_t *node, nxt_radix_walk_t handler,
+    void *data, void *parent)
+{
+    nxt_int_t   ret;
+    nxt_uint_t  i;
+
+    ret = handler(data, node->value, parent);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        return ret;
+    }
+
+    if (node->value[NXT_RADIX_PREFIX] != NULL) {
+        parent = node->value[NXT_RADIX_PREFIX];
+    }
+
+    for (i = 0; i < node->nchildren; i++) {
+        ret = nxt_radix_node_walk(node->children[i], handler, data, parent);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return ret;
+        }
+    }
+
+    return NXT_OK;
+}
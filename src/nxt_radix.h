@@ -0,0 +1,60 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#ifndef _NXT_RADIX_H_INCLUDED_
+#define _NXT_RADIX_H_INCLUDED_
+
+
+/*
+ * A byte-level radix tree which maps strings to values.  A key is stored
+ * either as an exact string or as a prefix which matches any string that
+ * starts with it.  A lookup returns the value of the longest matching key,
+ * so its cost depends on the string length only, but not on the number
+ * of keys.  The tree is intended to be built once and then only looked up.
+ */
+
+
+typedef enum {
+    NXT_RADIX_EXACT = 0,
+    NXT_RADIX_PREFIX,
+} nxt_radix_match_t;
+
+
+typedef struct nxt_radix_node_s  nxt_radix_node_t;
+
+struct nxt_radix_node_s {
+    u_char                   *key;
+    uint32_t                 length;
+    uint32_t                 nchildren;
+    nxt_radix_node_t         **children;
+    void                     *value[2];
+};
+
+
+typedef struct {
+    nxt_radix_node_t         *root;
+    nxt_mp_t                 *mem_pool;
+    uint8_t                  nocase;    /* 1 bit */
+} nxt_radix_t;
+
+
+/*
+ * The handler is called for each node, the parent nodes go first, with
+ * the node values and with the value of the longest prefix key which is
+ * a proper prefix of the node key.
+ */
+typedef nxt_int_t (*nxt_radix_walk_t)(void *data, void **value, void *parent);
+
+
+NXT_EXPORT nxt_radix_t *nxt_radix_create(nxt_mp_t *mp, nxt_bool_t nocase);
+NXT_EXPORT void **nxt_radix_insert(nxt_radix_t *tree, const u_char *key,
+    size_t length, nxt_radix_match_t match);
+NXT_EXPORT void *nxt_radix_find(nxt_radix_t *tree, const u_char *key,
+    size_t length);
+NXT_EXPORT nxt_int_t nxt_radix_walk(nxt_radix_t *tree,
+    nxt_radix_walk_t handler, void *data);
+
+
+#endif /* _NXT_RADIX_H_INCLUDED_ */
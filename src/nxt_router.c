@@ -15,6 +15,8 @@
 #include <nxt_script.h>
 #endif
 #include <nxt_http.h>
+#include <nxt_upstream.h>
+#include <nxt_open_file_cache.h>
 #include <nxt_port_memory_int.h>
 #include <nxt_unit_request.h>
 #include <nxt_unit_response.h>
@@ -24,6 +26,9 @@
 
 #define NXT_SHARED_PORT_ID  0xFFFFu
 
+/* The interval between retirements of idle processes scaled by latency. */
+#define NXT_ROUTER_APP_RETIRE_INTERVAL  1000
+
 typedef struct {
     nxt_str_t         type;
     uint32_t          processes;
@@ -31,6 +36,7 @@ typedef struct {
     uint32_t          spare_processes;
     nxt_msec_t        timeout;
     nxt_msec_t        idle_timeout;
+    nxt_msec_t        queue_time;
     nxt_conf_value_t  *limits_value;
     nxt_conf_value_t  *processes_value;
     nxt_conf_value_t  *targets_value;
@@ -40,6 +46,8 @@ typedef struct {
 typedef struct {
     nxt_str_t         pass;
     nxt_str_t         application;
+    uint32_t          accept_batch;
+    uint8_t           reuseport;
 } nxt_router_listener_conf_t;
 
 
@@ -84,8 +92,27 @@ typedef struct {
 } nxt_app_rpc_t;
 
 
+/*
+ * A process start error cancels one request waiting for the application,
+ * or all of them if no other processes are being started.  The requests
+ * are linked in the queues of their engines, so the error is posted to
+ * each engine, and the engines share the budget of one cancellation.
+ * The context is allocated along with the process start request, so
+ * the error itself does not depend on memory allocation.
+ */
+
+typedef struct {
+    nxt_app_t               *app;
+    nxt_atomic_t            budget;
+    nxt_atomic_t            count;
+    nxt_uint_t              nworks;
+    nxt_work_t              works[];
+} nxt_app_cancel_t;
+
+
 typedef struct {
     nxt_app_joint_t         *app_joint;
+    nxt_app_cancel_t        *app_cancel;
     uint32_t                generation;
     uint8_t                 proto;  /* 1 bit */
 } nxt_app_joint_rpc_t;
@@ -105,6 +132,9 @@ static void nxt_router_conf_data_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
 static void nxt_router_app_restart_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
+static void nxt_router_port_grace_release(nxt_task_t *task, nxt_port_t *port);
+static void nxt_router_port_grace_handler(nxt_task_t *task, nxt_port_t *port,
+    void *data);
 static void nxt_router_status_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
 static void nxt_router_remove_pid_handler(nxt_task_t *task,
@@ -146,6 +176,8 @@ static void nxt_router_listen_socket_ready(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
 static void nxt_router_listen_socket_error(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
+static void nxt_router_listen_socket_group_free(nxt_task_t *task,
+    nxt_listen_socket_t *ls);
 #if (NXT_TLS)
 static void nxt_router_tls_rpc_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
@@ -173,6 +205,8 @@ static nxt_int_t nxt_router_listen_socket_find(nxt_router_temp_conf_t *tmcf,
 static nxt_int_t nxt_router_engines_create(nxt_task_t *task,
     nxt_router_t *router, nxt_router_temp_conf_t *tmcf,
     const nxt_event_interface_t *interface);
+static nxt_event_engine_t *nxt_router_engine_create(nxt_task_t *task,
+    const nxt_event_interface_t *interface);
 static nxt_int_t nxt_router_engine_conf_create(nxt_router_temp_conf_t *tmcf,
     nxt_router_engine_conf_t *recf);
 static nxt_int_t nxt_router_engine_conf_update(nxt_router_temp_conf_t *tmcf,
@@ -214,8 +248,13 @@ static void nxt_router_listen_socket_close(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_router_thread_exit_handler(nxt_task_t *task, void *obj,
     void *data);
+static void nxt_router_response_discard(nxt_task_t *task,
+    nxt_http_request_t *r, nxt_buf_t *b);
 static void nxt_router_req_headers_ack_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, nxt_request_rpc_data_t *req_rpc_data);
+static void nxt_router_req_body_send(nxt_task_t *task, void *obj, void *data);
+static void nxt_router_req_body_ack_handler(nxt_task_t *task,
+    nxt_port_recv_msg_t *msg, nxt_request_rpc_data_t *req_rpc_data);
 static void nxt_router_listen_socket_release(nxt_task_t *task,
     nxt_socket_conf_t *skcf);
 
@@ -223,6 +262,13 @@ static void nxt_router_app_port_ready(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
 static void nxt_router_app_port_error(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
+static nxt_app_cancel_t *nxt_router_app_cancel_create(void);
+static void nxt_router_app_cancel_release(nxt_task_t *task,
+    nxt_app_cancel_t *app_cancel);
+static void nxt_router_app_cancel_handler(nxt_task_t *task, nxt_port_t *port,
+    void *data);
+static void nxt_router_app_requests_cancel(nxt_task_t *task, void *obj,
+    void *data);
 
 static void nxt_router_app_use(nxt_task_t *task, nxt_app_t *app, int i);
 static void nxt_router_app_unlink(nxt_task_t *task, nxt_app_t *app);
@@ -286,7 +332,7 @@ static const nxt_str_t  *nxt_app_msg_prefix[] = {
 
 
 static const nxt_port_handlers_t  nxt_router_process_port_handlers = {
-    .quit         = nxt_signal_quit_handler,
+    .quit         = nxt_router_access_log_quit_handler,
     .new_port     = nxt_router_new_port_handler,
     .get_port     = nxt_router_get_port_handler,
     .change_file  = nxt_port_change_log_file_handler,
@@ -369,6 +415,7 @@ nxt_router_start(nxt_task_t *task, nxt_process_data_t *data)
     nxt_queue_init(&router->engines);
     nxt_queue_init(&router->sockets);
     nxt_queue_init(&router->apps);
+    nxt_queue_init(&router->upstream_checks);
 
     nxt_router = router;
 
@@ -401,9 +448,11 @@ nxt_router_start_app_process_handler(nxt_task_t *task, nxt_port_t *port,
     nxt_buf_t            *b;
     nxt_port_t           *dport;
     nxt_runtime_t        *rt;
+    nxt_app_cancel_t     *app_cancel;
     nxt_app_joint_rpc_t  *app_joint_rpc;
 
     app = data;
+    app_cancel = NULL;
 
     nxt_thread_mutex_lock(&app->mutex);
 
@@ -448,6 +497,11 @@ nxt_router_start_app_process_handler(nxt_task_t *task, nxt_port_t *port,
         queue_fd = app->shared_port->queue_fd;
     }
 
+    app_cancel = nxt_router_app_cancel_create();
+    if (nxt_slow_path(app_cancel == NULL)) {
+        goto failed;
+    }
+
     app_joint_rpc = nxt_port_rpc_register_handler_ex(task, port,
                                                      nxt_router_app_port_ready,
                                                      nxt_router_app_port_error,
@@ -467,9 +521,12 @@ nxt_router_start_app_process_handler(nxt_task_t *task, nxt_port_t *port,
     }
 
     app_joint_rpc->app_joint = app->joint;
+    app_joint_rpc->app_cancel = app_cancel;
     app_joint_rpc->generation = app->generation;
     app_joint_rpc->proto = (b != NULL);
 
+    app_cancel = NULL;
+
     if (b != NULL) {
         app->proto_port_requests++;
 
@@ -480,6 +537,10 @@ nxt_router_start_app_process_handler(nxt_task_t *task, nxt_port_t *port,
 
 failed:
 
+    if (app_cancel != NULL) {
+        nxt_free(app_cancel);
+    }
+
     if (b != NULL) {
         nxt_mp_free(b->data, b);
     }
@@ -603,7 +664,6 @@ nxt_request_rpc_data_unlink(nxt_task_t *task,
     nxt_request_rpc_data_t *req_rpc_data)
 {
     nxt_app_t           *app;
-    nxt_bool_t          unlinked;
     nxt_http_request_t  *r;
 
     nxt_router_msg_cancel(task, req_rpc_data);
@@ -627,23 +687,11 @@ nxt_request_rpc_data_unlink(nxt_task_t *task,
         r->req_rpc_data = NULL;
         req_rpc_data->request = NULL;
 
-        if (app != NULL) {
-            unlinked = 0;
-
-            nxt_thread_mutex_lock(&app->mutex);
-
-            if (r->app_link.next != NULL) {
-                nxt_queue_remove(&r->app_link);
-                r->app_link.next = NULL;
-
-                unlinked = 1;
-            }
-
-            nxt_thread_mutex_unlock(&app->mutex);
+        if (r->app_link.next != NULL) {
+            nxt_queue_remove(&r->app_link);
+            r->app_link.next = NULL;
 
-            if (unlinked) {
-                nxt_mp_release(r->mem_pool);
-            }
+            nxt_mp_release(r->mem_pool);
         }
     }
 
@@ -919,7 +967,7 @@ nxt_router_app_restart_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         nxt_thread_mutex_unlock(&app->mutex);
 
         nxt_port_close(task, old_shared_port);
-        nxt_port_use(task, old_shared_port, -1);
+        nxt_router_port_grace_release(task, old_shared_port);
 
         if (proto_port != NULL) {
             (void) nxt_port_socket_write(task, proto_port, NXT_PORT_MSG_QUIT,
@@ -944,18 +992,87 @@ nxt_router_app_restart_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 }
 
 
+/*
+ * The shared port is obtained by the request path without the application
+ * lock, so the reference to a replaced port is released only after a work
+ * has been run by each router engine.
+ */
+
+typedef struct {
+    nxt_port_t          *port;
+    nxt_atomic_t        count;
+} nxt_router_port_grace_t;
+
+
+static void
+nxt_router_port_grace_release(nxt_task_t *task, nxt_port_t *port)
+{
+    nxt_int_t                ret;
+    nxt_event_engine_t       *engine;
+    nxt_router_port_grace_t  *grace;
+
+    grace = nxt_malloc(sizeof(nxt_router_port_grace_t));
+    if (nxt_slow_path(grace == NULL)) {
+        nxt_port_use(task, port, -1);
+        return;
+    }
+
+    grace->port = port;
+    grace->count = 1;
+
+    nxt_queue_each(engine, &nxt_router->engines, nxt_event_engine_t, link0)
+    {
+        if (nxt_fast_path(engine->port != NULL)) {
+            nxt_atomic_fetch_add(&grace->count, 1);
+
+            ret = nxt_port_post(task, engine->port,
+                                nxt_router_port_grace_handler, grace);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                nxt_atomic_fetch_add(&grace->count, -1);
+            }
+        }
+    }
+    nxt_queue_loop;
+
+    nxt_router_port_grace_handler(task, NULL, grace);
+}
+
+
+static void
+nxt_router_port_grace_handler(nxt_task_t *task, nxt_port_t *port, void *data)
+{
+    nxt_router_port_grace_t  *grace;
+
+    grace = data;
+
+    if (nxt_atomic_fetch_add(&grace->count, -1) == 1) {
+        nxt_port_use(task, grace->port, -1);
+        nxt_free(grace);
+    }
+}
+
+
 static void
 nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 {
-    u_char               *p;
-    size_t               alloc;
-    nxt_app_t            *app;
-    nxt_buf_t            *b;
-    nxt_uint_t           type;
-    nxt_port_t           *port;
-    nxt_status_app_t     *app_stat;
-    nxt_event_engine_t   *engine;
-    nxt_status_report_t  *report;
+    u_char                        *p;
+    size_t                        alloc;
+    uint32_t                      i, j;
+    nxt_app_t                     *app;
+    nxt_buf_t                     *b;
+    nxt_msec_t                    now;
+    nxt_uint_t                    type;
+    nxt_port_t                    *port;
+    nxt_upstream_t                *upstream;
+    nxt_upstreams_t               *upstreams;
+    nxt_sockaddr_t                *sa;
+    nxt_status_app_t              *app_stat;
+    nxt_event_engine_t            *engine;
+    nxt_status_thread_t           *thread_stat;
+    nxt_status_report_t           *report;
+    nxt_upstream_health_t         *health;
+    nxt_status_upstream_t         *upstream_stat;
+    nxt_status_upstream_server_t  *server_stat;
 
     port = nxt_runtime_port_find(task->thread->runtime,
                                  msg->port_msg.pid,
@@ -973,6 +1090,27 @@ nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 
     } nxt_queue_loop;
 
+    nxt_queue_each(engine, &nxt_router->engines, nxt_event_engine_t, link0) {
+
+        alloc += sizeof(nxt_status_thread_t);
+
+    } nxt_queue_loop;
+
+    upstreams = nxt_router->upstreams;
+
+    if (upstreams != NULL) {
+        for (i = 0; i < upstreams->items; i++) {
+            upstream = &upstreams->upstream[i];
+
+            alloc += sizeof(nxt_status_upstream_t) + upstream->name.length;
+
+            for (j = 0; j < upstream->servers; j++) {
+                alloc += sizeof(nxt_status_upstream_server_t)
+                         + upstream->health[j].sockaddr->length;
+            }
+        }
+    }
+
     b = nxt_buf_mem_alloc(port->mem_pool, alloc, 0);
     if (nxt_slow_path(b == NULL)) {
         type = NXT_PORT_MSG_RPC_ERROR;
@@ -993,6 +1131,7 @@ nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
 
     } nxt_queue_loop;
 
+    report->threads_count = 0;
     report->apps_count = 0;
     app_stat = report->apps;
     p = b->mem.end;
@@ -1014,6 +1153,82 @@ nxt_router_status_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
         app_stat++;
     } nxt_queue_loop;
 
+    report->upstreams_count = 0;
+    upstream_stat = (nxt_status_upstream_t *) app_stat;
+    report->upstreams = (nxt_status_upstream_t *)
+                            ((u_char *) upstream_stat - b->mem.pos);
+
+    if (upstreams != NULL) {
+        server_stat = (nxt_status_upstream_server_t *)
+                          (upstream_stat + upstreams->items);
+
+        now = task->thread->engine->timers.now;
+
+        for (i = 0; i < upstreams->items; i++) {
+            upstream = &upstreams->upstream[i];
+
+            p -= upstream->name.length;
+
+            nxt_memcpy(p, upstream->name.start, upstream->name.length);
+
+            upstream_stat->name.length = upstream->name.length;
+            upstream_stat->name.start = (u_char *) (p - b->mem.pos);
+
+            upstream_stat->servers_count = upstream->servers;
+            upstream_stat->servers = (nxt_status_upstream_server_t *)
+                                  ((u_char *) server_stat - b->mem.pos);
+
+            for (j = 0; j < upstream->servers; j++) {
+                health = &upstream->health[j];
+                sa = health->sockaddr;
+
+                p -= sa->length;
+
+                nxt_memcpy(p, nxt_sockaddr_start(sa), sa->length);
+
+                server_stat->address.length = sa->length;
+                server_stat->address.start = (u_char *) (p - b->mem.pos);
+
+                server_stat->fails = health->fails;
+
+                if (health->unhealthy) {
+                    server_stat->state = NXT_STATUS_SERVER_UNHEALTHY;
+
+                } else if (nxt_upstream_health_down(health, now)) {
+                    server_stat->state = NXT_STATUS_SERVER_DOWN;
+
+                } else {
+                    server_stat->state = NXT_STATUS_SERVER_UP;
+                }
+
+                server_stat++;
+            }
+
+            report->upstreams_count++;
+            upstream_stat++;
+        }
+
+        thread_stat = (nxt_status_thread_t *) server_stat;
+
+    } else {
+        thread_stat = (nxt_status_thread_t *) upstream_stat;
+    }
+
+    report->threads = (nxt_status_thread_t *)
+                          ((u_char *) thread_stat - b->mem.pos);
+
+    nxt_queue_each(engine, &nxt_router->engines, nxt_event_engine_t, link0) {
+
+        thread_stat->accepted_conns = engine->accepted_conns_cnt;
+        thread_stat->accept_events = engine->accept_events_cnt;
+        thread_stat->accept_latency = engine->accept_latency / 1000;
+        thread_stat->accept_latency_max = engine->accept_latency_max / 1000;
+
+        report->threads_count++;
+        thread_stat++;
+
+    } nxt_queue_loop;
+
     type = NXT_PORT_MSG_RPC_READY_LAST;
 
 fail:
@@ -1149,11 +1364,57 @@ nxt_router_temp_conf(nxt_task_t *task)
 }
 
 
+/*
+ * The averages are exponentially weighted with the 1/8 factor.  They are
+ * updated by several engines, so a lost race just drops the sample.
+ */
+
+nxt_inline void
+nxt_router_app_time_update(nxt_atomic_t *avg, nxt_msec_t time)
+{
+    nxt_atomic_uint_t  old;
+
+    old = *avg;
+
+    (void) nxt_atomic_cmp_set(avg, old, old - (old >> 3) + time);
+}
+
+
+/*
+ * The number of processes required to bring the average queue time down to
+ * the "queue_time" target at the current request rate: the queue time and
+ * the service time together are proportional to the load per process.
+ */
+
+nxt_inline uint32_t
+nxt_router_app_scale(nxt_app_t *app)
+{
+    nxt_msec_t  queue, service;
+
+    if (app->queue_time == 0 || app->idle_processes != 0) {
+        return 0;
+    }
+
+    queue = app->queue_time_avg >> 3;
+
+    if (queue <= app->queue_time) {
+        return 0;
+    }
+
+    service = app->service_time_avg >> 3;
+
+    return (app->processes * (queue + service) + app->queue_time + service - 1)
+           / (app->queue_time + service);
+}
+
+
 nxt_inline nxt_bool_t
 nxt_router_app_can_start(nxt_app_t *app)
 {
     return app->processes + app->pending_processes < app->max_processes
-            && app->pending_processes < app->max_pending_processes;
+            && (app->pending_processes < app->max_pending_processes
+                || app->processes + app->pending_processes
+                   < nxt_router_app_scale(app));
 }
 
 
@@ -1163,7 +1424,9 @@ nxt_router_app_need_start(nxt_app_t *app)
     return (app->active_requests
               > app->port_hash_count + app->pending_processes)
            || (app->spare_processes
-                > app->idle_processes + app->pending_processes);
+                > app->idle_processes + app->pending_processes)
+           || (nxt_router_app_scale(app)
+                > app->processes + app->pending_processes);
 }
 
 
@@ -1270,12 +1533,31 @@ nxt_router_conf_apply(nxt_task_t *task, void *obj, void *data)
 
     nxt_router_apps_hash_use(task, rtcf, 1);
 
+    /*
+     * The previous configuration can be destroyed by the engines
+     * as soon as the new one is posted.
+     */
+    nxt_upstream_checks_stop(task, &router->upstream_checks);
+
+    router->upstreams = NULL;
+
+    if (rtcf->count != 0) {
+        router->upstreams = rtcf->upstreams;
+
+        nxt_upstream_checks_start(task, rtcf->upstreams,
+                                  &router->upstream_checks);
+    }
+
     nxt_router_engines_post(router, tmcf);
 
     nxt_queue_add(&router->sockets, &updating_sockets);
     nxt_queue_add(&router->sockets, &creating_sockets);
 
     if (router->access_log != rtcf->access_log) {
+        if (router->access_log != NULL) {
+            nxt_router_access_log_flush(task, NULL);
+        }
+
         nxt_router_access_log_use(&router->lock, rtcf->access_log);
 
         nxt_router_access_log_release(task, &router->lock, router->access_log);
@@ -1368,6 +1650,8 @@ nxt_router_conf_error(nxt_task_t *task, nxt_router_temp_conf_t *tmcf)
             nxt_socket_close(task, s);
         }
 
+        nxt_router_listen_socket_group_free(task, skcf->listen);
+
         nxt_free(skcf->listen);
     }
 
@@ -1419,6 +1703,21 @@ static nxt_conf_map_t  nxt_router_conf[] = {
 };
 
 
+static nxt_conf_map_t  nxt_router_open_file_cache_conf[] = {
+    {
+        nxt_string("max"),
+        NXT_CONF_MAP_SIZE,
+        offsetof(nxt_router_conf_t, open_file_cache_max),
+    },
+
+    {
+        nxt_string("valid"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_router_conf_t, open_file_cache_valid),
+    },
+};
+
+
 static nxt_conf_map_t  nxt_router_app_conf[] = {
     {
         nxt_string("type"),
@@ -1479,6 +1778,12 @@ static nxt_conf_map_t  nxt_router_app_processes_conf[] = {
         NXT_CONF_MAP_MSEC,
         offsetof(nxt_router_app_conf_t, idle_timeout),
     },
+
+    {
+        nxt_string("queue_time"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_router_app_conf_t, queue_time),
+    },
 };
 
 
@@ -1494,6 +1799,18 @@ static nxt_conf_map_t  nxt_router_listener_conf[] = {
         NXT_CONF_MAP_STR_COPY,
         offsetof(nxt_router_listener_conf_t, application),
     },
+
+    {
+        nxt_string("accept_batch"),
+        NXT_CONF_MAP_INT32,
+        offsetof(nxt_router_listener_conf_t, accept_batch),
+    },
+
+    {
+        nxt_string("reuseport"),
+        NXT_CONF_MAP_INT8,
+        offsetof(nxt_router_listener_conf_t, reuseport),
+    },
 };
 
 
@@ -1552,6 +1869,24 @@ static nxt_conf_map_t  nxt_router_http_conf[] = {
         offsetof(nxt_socket_conf_t, send_timeout),
     },
 
+    {
+        nxt_string("proxy_keepalive"),
+        NXT_CONF_MAP_SIZE,
+        offsetof(nxt_socket_conf_t, proxy_keepalive),
+    },
+
+    {
+        nxt_string("proxy_keepalive_requests"),
+        NXT_CONF_MAP_SIZE,
+        offsetof(nxt_socket_conf_t, proxy_keepalive_requests),
+    },
+
+    {
+        nxt_string("proxy_keepalive_timeout"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_socket_conf_t, proxy_keepalive_timeout),
+    },
+
     {
         nxt_string("body_temp_path"),
         NXT_CONF_MAP_STR,
@@ -1564,6 +1899,18 @@ static nxt_conf_map_t  nxt_router_http_conf[] = {
         offsetof(nxt_socket_conf_t, discard_unsafe_fields),
     },
 
+    {
+        nxt_string("body_streaming"),
+        NXT_CONF_MAP_INT8,
+        offsetof(nxt_socket_conf_t, body_streaming),
+    },
+
+    {
+        nxt_string("http2"),
+        NXT_CONF_MAP_INT8,
+        offsetof(nxt_socket_conf_t, http2),
+    },
+
     {
         nxt_string("log_route"),
         NXT_CONF_MAP_INT8,
@@ -1633,6 +1980,9 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     nxt_app_lang_module_t       *lang;
     nxt_router_app_conf_t       apcf;
     nxt_router_listener_conf_t  lscf;
+#if (NXT_HAVE_REUSEPORT)
+    nxt_listen_socket_t         *ls;
+#endif
 
     static nxt_str_t  http_path = nxt_string("/settings/http");
     static nxt_str_t  applications_path = nxt_string("/applications");
@@ -1645,11 +1995,17 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     static nxt_str_t  conf_cache_path = nxt_string("/tls/session/cache_size");
     static nxt_str_t  conf_timeout_path = nxt_string("/tls/session/timeout");
     static nxt_str_t  conf_tickets = nxt_string("/tls/session/tickets");
+    static nxt_str_t  conf_ktls_path = nxt_string("/tls/ktls");
+    static nxt_str_t  conf_offload = nxt_string("/tls/handshake_offload");
 #endif
 #if (NXT_HAVE_NJS)
     static nxt_str_t  js_module_path = nxt_string("/settings/js_module");
 #endif
     static nxt_str_t  static_path = nxt_string("/settings/http/static");
+    static nxt_str_t  cache_path = nxt_string("/settings/http/cache");
+#if (NXT_HAVE_COMPRESSION)
+    static nxt_str_t  compress_path = nxt_string("/settings/http/compression");
+#endif
     static nxt_str_t  websocket_path = nxt_string("/settings/http/websocket");
     static nxt_str_t  forwarded_path = nxt_string("/forwarded");
     static nxt_str_t  client_ip_path = nxt_string("/client_ip");
@@ -1681,6 +2037,26 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         return NXT_ERROR;
     }
 
+    conf = nxt_conf_get_path(root, &cache_path);
+
+    if (conf != NULL) {
+        ret = nxt_http_cache_create(task, rtcf, conf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+    }
+
+#if (NXT_HAVE_COMPRESSION)
+    conf = nxt_conf_get_path(root, &compress_path);
+
+    if (conf != NULL) {
+        ret = nxt_http_compress_conf_create(task, rtcf, conf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+    }
+#endif
+
     router = rtcf->router;
 
     applications = nxt_conf_get_path(root, &applications_path);
@@ -1745,6 +2121,7 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
             apcf.spare_processes = 0;
             apcf.timeout = 0;
             apcf.idle_timeout = 15000;
+            apcf.queue_time = 0;
             apcf.limits_value = NULL;
             apcf.processes_value = NULL;
             apcf.targets_value = NULL;
@@ -1842,7 +2219,6 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
             nxt_queue_init(&app->ports);
             nxt_queue_init(&app->spare_ports);
             nxt_queue_init(&app->idle_ports);
-            nxt_queue_init(&app->ack_waiting_req);
 
             app->name.length = name.length;
             nxt_memcpy(app->name.start, name.start, name.length);
@@ -1854,6 +2230,7 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
                                          ? apcf.spare_processes : 1;
             app->timeout = apcf.timeout;
             app->idle_timeout = apcf.idle_timeout;
+            app->queue_time = apcf.queue_time;
 
             app->targets = targets;
 
@@ -1971,6 +2348,25 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 
             nxt_debug(task, "application: %V", &lscf.application);
 
+            skcf->accept_batch = lscf.accept_batch;
+
+#if (NXT_HAVE_REUSEPORT)
+            ls = skcf->listen;
+
+            if (ls->sockaddr->u.sockaddr.sa_family == AF_UNIX) {
+                lscf.reuseport = 0;
+            }
+
+            if (ls->socket == -1) {
+                ls->reuseport = lscf.reuseport;
+
+            } else if (ls->reuseport != lscf.reuseport) {
+                nxt_log(task, NXT_LOG_WARN, "listener \"%V\" keeps "
+                        "\"reuseport\" %s until it is recreated", &name,
+                        ls->reuseport ? "enabled" : "disabled");
+            }
+#endif
+
             // STUB, default values if http block is not defined.
             skcf->header_buffer_size = 2048;
             skcf->large_header_buffer_size = 8192;
@@ -1981,6 +2377,8 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
             skcf->proxy_header_buffer_size = 64 * 1024;
             skcf->proxy_buffer_size = 4096;
             skcf->proxy_buffers = 256;
+            skcf->proxy_keepalive = 0;
+            skcf->proxy_keepalive_requests = 1000;
             skcf->idle_timeout = 180 * 1000;
             skcf->header_read_timeout = 30 * 1000;
             skcf->body_read_timeout = 30 * 1000;
@@ -1988,6 +2386,7 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
             skcf->proxy_timeout = 60 * 1000;
             skcf->proxy_send_timeout = 30 * 1000;
             skcf->proxy_read_timeout = 30 * 1000;
+            skcf->proxy_keepalive_timeout = 60 * 1000;
 
             skcf->server_version = 1;
 
@@ -2071,6 +2470,16 @@ nxt_router_conf_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
                 tls_init->tickets_conf = nxt_conf_get_path(listener,
                                                            &conf_tickets);
 
+                value = nxt_conf_get_path(listener, &conf_ktls_path);
+                tls_init->ktls = (value != NULL
+                                  && nxt_conf_get_boolean(value));
+
+                value = nxt_conf_get_path(listener, &conf_offload);
+                tls_init->handshake_offload = (value != NULL
+                                              && nxt_conf_get_boolean(value));
+
+                tls_init->http2 = skcf->http2;
+
                 n = nxt_conf_array_elements_count_or_1(certificate);
 
                 for (i = 0; i < n; i++) {
@@ -2281,9 +2690,10 @@ nxt_router_conf_process_static(nxt_task_t *task, nxt_router_conf_t *rtcf,
     nxt_str_t         *type, exten, str, *s;
     nxt_int_t         ret;
     nxt_uint_t        exts;
-    nxt_conf_value_t  *mtypes_conf, *ext_conf, *value;
+    nxt_conf_value_t  *mtypes_conf, *ext_conf, *value, *cache_conf;
 
     static nxt_str_t  mtypes_path = nxt_string("/mime_types");
+    static nxt_str_t  cache_path = nxt_string("/open_file_cache");
 
     mp = rtcf->mem_pool;
 
@@ -2296,6 +2706,21 @@ nxt_router_conf_process_static(nxt_task_t *task, nxt_router_conf_t *rtcf,
         return NXT_OK;
     }
 
+    cache_conf = nxt_conf_get_path(conf, &cache_path);
+
+    if (cache_conf != NULL) {
+        rtcf->open_file_cache_max = 1000;
+        rtcf->open_file_cache_valid = 60 * 1000;
+
+        ret = nxt_conf_map_object(mp, cache_conf,
+                                  nxt_router_open_file_cache_conf,
+                                  nxt_nitems(nxt_router_open_file_cache_conf),
+                                  rtcf);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+    }
+
     mtypes_conf = nxt_conf_get_path(conf, &mtypes_path);
 
     if (mtypes_conf != NULL) {
@@ -2808,7 +3233,7 @@ nxt_router_listen_socket_rpc_create(nxt_task_t *task,
 
     size = nxt_sockaddr_size(skcf->listen->sockaddr);
 
-    b = nxt_buf_mem_alloc(tmcf->mem_pool, size, 0);
+    b = nxt_buf_mem_alloc(tmcf->mem_pool, size + 1, 0);
     if (b == NULL) {
         goto fail;
     }
@@ -2816,6 +3241,7 @@ nxt_router_listen_socket_rpc_create(nxt_task_t *task,
     b->completion_handler = nxt_buf_dummy_completion;
 
     b->mem.free = nxt_cpymem(b->mem.free, skcf->listen->sockaddr, size);
+    *b->mem.free++ = skcf->listen->reuseport;
 
     rt = task->thread->runtime;
     main_port = rt->port_by_type[NXT_PROCESS_MAIN];
@@ -2849,11 +3275,14 @@ static void
 nxt_router_listen_socket_ready(nxt_task_t *task, nxt_port_recv_msg_t *msg,
     void *data)
 {
-    nxt_int_t         ret;
-    nxt_socket_t      s;
-    nxt_socket_rpc_t  *rpc;
+    uint32_t             threads;
+    nxt_int_t            ret;
+    nxt_socket_t         s;
+    nxt_socket_rpc_t     *rpc;
+    nxt_listen_socket_t  *ls;
 
     rpc = data;
+    ls = rpc->socket_conf->listen;
 
     s = msg->fd[0];
 
@@ -2862,14 +3291,40 @@ nxt_router_listen_socket_ready(nxt_task_t *task, nxt_port_recv_msg_t *msg,
         goto fail;
     }
 
-    nxt_socket_defer_accept(task, s, rpc->socket_conf->listen->sockaddr);
+    nxt_socket_defer_accept(task, s, ls->sockaddr);
 
     ret = nxt_listen_socket(task, s, NXT_LISTEN_BACKLOG);
     if (nxt_slow_path(ret != NXT_OK)) {
         goto fail;
     }
 
-    rpc->socket_conf->listen->socket = s;
+    threads = rpc->temp_conf->router_conf->threads;
+
+    if (ls->socket == -1) {
+        ls->socket = s;
+
+        if (ls->reuseport && threads > 1) {
+            ls->sockets = nxt_malloc(threads * sizeof(nxt_socket_t));
+            if (nxt_slow_path(ls->sockets == NULL)) {
+                nxt_router_conf_error(task, rpc->temp_conf);
+                return;
+            }
+
+            ls->sockets[0] = s;
+            ls->nsockets = 1;
+        }
+
+    } else {
+        ls->sockets[ls->nsockets++] = s;
+    }
+
+    /* Each engine thread listens on its own socket of the group. */
+
+    if (ls->nsockets != 0 && ls->nsockets < threads) {
+        nxt_router_listen_socket_rpc_create(task, rpc->temp_conf,
+                                            rpc->socket_conf);
+        return;
+    }
 
     nxt_work_queue_add(&task->thread->engine->fast_work_queue,
                        nxt_router_conf_apply, task, rpc->temp_conf, NULL);
@@ -2945,6 +3400,23 @@ nxt_router_listen_socket_error(nxt_task_t *task, nxt_port_recv_msg_t *msg,
 }
 
 
+static void
+nxt_router_listen_socket_group_free(nxt_task_t *task, nxt_listen_socket_t *ls)
+{
+    uint32_t  i;
+
+    /* sockets[0] is ls->socket and is closed by the caller. */
+
+    for (i = 1; i < ls->nsockets; i++) {
+        nxt_socket_close(task, ls->sockets[i]);
+    }
+
+    if (ls->sockets != NULL) {
+        nxt_free(ls->sockets);
+    }
+}
+
+
 #if (NXT_TLS)
 
 static void
@@ -3243,7 +3715,7 @@ nxt_router_engines_create(nxt_task_t *task, nxt_router_t *router,
 
         recf->action = NXT_ROUTER_ENGINE_ADD;
 
-        recf->engine = nxt_event_engine_create(task, interface, NULL, 0, 0);
+        recf->engine = nxt_router_engine_create(task, interface);
         if (nxt_slow_path(recf->engine == NULL)) {
             return NXT_ERROR;
         }
@@ -3260,9 +3732,31 @@ nxt_router_engines_create(nxt_task_t *task, nxt_router_t *router,
 }
 
 
-static nxt_int_t
-nxt_router_engine_conf_create(nxt_router_temp_conf_t *tmcf,
-    nxt_router_engine_conf_t *recf)
+/*
+ * Worker threads prefer the io_uring engine which falls back to
+ * the default engine if io_uring is not available or is restricted.
+ */
+
+static nxt_event_engine_t *
+nxt_router_engine_create(nxt_task_t *task,
+    const nxt_event_interface_t *interface)
+{
+#if (NXT_HAVE_IO_URING)
+    nxt_event_engine_t  *engine;
+
+    engine = nxt_event_engine_create(task, &nxt_io_uring_engine, NULL, 0, 0);
+    if (engine != NULL) {
+        return engine;
+    }
+#endif
+
+    return nxt_event_engine_create(task, interface, NULL, 0, 0);
+}
+
+
+static nxt_int_t
+nxt_router_engine_conf_create(nxt_router_temp_conf_t *tmcf,
+    nxt_router_engine_conf_t *recf)
 {
     nxt_int_t  ret;
 
@@ -3335,11 +3829,15 @@ nxt_router_engine_joints_create(nxt_router_temp_conf_t *tmcf,
     nxt_work_handler_t handler)
 {
     nxt_int_t                ret;
+    nxt_uint_t               n;
     nxt_joint_job_t          *job;
     nxt_queue_link_t         *qlk;
     nxt_socket_conf_t        *skcf;
+    nxt_listen_socket_t      *ls;
     nxt_socket_conf_joint_t  *joint;
 
+    n = recf - (nxt_router_engine_conf_t *) tmcf->engines->elts;
+
     for (qlk = nxt_queue_first(sockets);
          qlk != nxt_queue_tail(sockets);
          qlk = nxt_queue_next(qlk))
@@ -3380,6 +3878,11 @@ nxt_router_engine_joints_create(nxt_router_temp_conf_t *tmcf,
         joint->socket_conf = skcf;
 
         joint->engine = recf->engine;
+
+        ls = skcf->listen;
+
+        job->socket = (ls->nsockets != 0) ? ls->sockets[n % ls->nsockets]
+                                          : ls->socket;
     }
 
     return NXT_OK;
@@ -3568,6 +4071,7 @@ static nxt_port_handlers_t  nxt_router_app_port_handlers = {
     .data            = nxt_port_rpc_handler,
     .oosm            = nxt_router_oosm_handler,
     .req_headers_ack = nxt_port_rpc_handler,
+    .req_body_ack    = nxt_port_rpc_handler,
 };
 
 
@@ -3682,7 +4186,7 @@ nxt_router_listen_socket_create(nxt_task_t *task, void *obj, void *data)
     skcf = joint->socket_conf;
     ls = skcf->listen;
 
-    lev = nxt_listen_event(task, ls);
+    lev = nxt_listen_event_socket(task, ls, job->socket);
     if (nxt_slow_path(lev == NULL)) {
         nxt_router_listen_socket_release(task, skcf);
         return;
@@ -3690,6 +4194,10 @@ nxt_router_listen_socket_create(nxt_task_t *task, void *obj, void *data)
 
     lev->socket.data = joint;
 
+    if (skcf->accept_batch != 0) {
+        lev->batch = skcf->accept_batch;
+    }
+
     lock = &skcf->router_conf->router->lock;
 
     nxt_thread_spin_lock(lock);
@@ -3707,11 +4215,11 @@ nxt_inline nxt_listen_event_t *
 nxt_router_listen_event(nxt_queue_t *listen_connections,
     nxt_socket_conf_t *skcf)
 {
-    nxt_socket_t        fd;
-    nxt_queue_link_t    *qlk;
-    nxt_listen_event_t  *lev;
+    nxt_queue_link_t     *qlk;
+    nxt_listen_event_t   *lev;
+    nxt_listen_socket_t  *ls;
 
-    fd = skcf->listen->socket;
+    ls = skcf->listen;
 
     for (qlk = nxt_queue_first(listen_connections);
          qlk != nxt_queue_tail(listen_connections);
@@ -3719,7 +4227,7 @@ nxt_router_listen_event(nxt_queue_t *listen_connections,
     {
         lev = nxt_queue_link_data(qlk, nxt_listen_event_t, link);
 
-        if (fd == lev->socket.fd) {
+        if (ls == lev->listen) {
             return lev;
         }
     }
@@ -3750,6 +4258,9 @@ nxt_router_listen_socket_update(nxt_task_t *task, void *obj, void *data)
     lev->socket.data = joint;
     lev->listen = joint->socket_conf->listen;
 
+    lev->batch = (joint->socket_conf->accept_batch != 0)
+                 ? joint->socket_conf->accept_batch : engine->batch;
+
     job->work.next = NULL;
     job->work.handler = nxt_router_conf_wait;
 
@@ -3877,6 +4388,8 @@ nxt_router_listen_socket_release(nxt_task_t *task, nxt_socket_conf_t *skcf)
 
     nxt_socket_close(task, ls->socket);
 
+    nxt_router_listen_socket_group_free(task, ls);
+
 #if (NXT_HAVE_UNIX_DOMAIN)
     sa = ls->sockaddr;
     if (sa->u.sockaddr.sa_family != AF_UNIX
@@ -3951,6 +4464,9 @@ nxt_router_conf_release(nxt_task_t *task, nxt_socket_conf_joint_t *joint)
 
     nxt_queue_remove(&joint->link);
 
+    /* The cached files must not outlive the configuration. */
+    nxt_open_file_cache_flush(task);
+
     /*
      * The joint content can not be safely used after the critical
      * section protected by the spinlock because its memory pool may
@@ -4028,6 +4544,12 @@ nxt_router_thread_exit_handler(nxt_task_t *task, void *obj, void *data)
     nxt_mp_thread_adopt(port->mem_pool);
     nxt_port_use(task, port, -1);
 
+    nxt_router_access_log_engine_free(task, engine);
+
+#if (NXT_HAVE_COMPRESSION)
+    nxt_http_compress_engine_free(task, engine);
+#endif
+
     nxt_mp_thread_adopt(engine->mem_pool);
     nxt_mp_destroy(engine->mem_pool);
 
@@ -4073,6 +4595,12 @@ nxt_router_response_ready_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
         return;
     }
 
+    if (msg->port_msg.type == _NXT_PORT_MSG_REQ_BODY_ACK) {
+        nxt_router_req_body_ack_handler(task, msg, req_rpc_data);
+
+        return;
+    }
+
     b = (msg->size == 0) ? NULL : msg->buf;
 
     if (msg->port_msg.last != 0) {
@@ -4084,6 +4612,12 @@ nxt_router_response_ready_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
 
         if (req_rpc_data->apr_action == NXT_APR_REQUEST_FAILED) {
             req_rpc_data->apr_action = NXT_APR_GOT_RESPONSE;
+
+            if (req_rpc_data->acked != 0) {
+                nxt_router_app_time_update(&app->service_time_avg,
+                                           task->thread->engine->timers.now
+                                           - req_rpc_data->acked);
+            }
         }
 
         nxt_request_rpc_data_unlink(task, req_rpc_data);
@@ -4166,6 +4700,29 @@ nxt_router_response_ready_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
 
         r->status = resp->status;
 
+        if (r->action != NULL && r->action->sendfile != NULL) {
+            ret = nxt_http_sendfile_init(task, r);
+
+            if (ret == NXT_OK) {
+                nxt_router_response_discard(task, r, b);
+
+                if (req_rpc_data->apr_action == NXT_APR_REQUEST_FAILED) {
+                    req_rpc_data->apr_action = NXT_APR_GOT_RESPONSE;
+                }
+
+                nxt_request_rpc_data_unlink(task, req_rpc_data);
+
+                nxt_http_sendfile(task, r);
+
+                return;
+            }
+
+            if (nxt_slow_path(ret == NXT_ERROR)) {
+                nxt_router_response_discard(task, r, b);
+                goto fail;
+            }
+        }
+
         if (resp->piggyback_content_length != 0) {
             b->mem.pos = nxt_unit_sptr_get(&resp->piggyback_content);
             b->mem.free = b->mem.pos + resp->piggyback_content_length;
@@ -4188,6 +4745,18 @@ nxt_router_response_ready_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
             nxt_buf_chain_add(&r->out, b);
         }
 
+        ret = nxt_http_cache_init(task, r);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto fail;
+        }
+
+#if (NXT_HAVE_COMPRESSION)
+        ret = nxt_http_compress_init(task, r);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto fail;
+        }
+#endif
+
         nxt_http_request_header_send(task, r, nxt_http_request_send_body, NULL);
 
         if (r->websocket_handshake
@@ -4226,6 +4795,30 @@ nxt_router_response_ready_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
 }
 
 
+static void
+nxt_router_response_discard(nxt_task_t *task, nxt_http_request_t *r,
+    nxt_buf_t *b)
+{
+    nxt_buf_t  *next;
+
+    while (b != NULL) {
+        next = b->next;
+        b->next = NULL;
+
+        if (nxt_buf_is_sync(b) && nxt_buf_is_last(b)) {
+            /* The last buffer is kept for the response that replaces it. */
+            r->last = b;
+
+        } else {
+            nxt_work_queue_add(&task->thread->engine->fast_work_queue,
+                               b->completion_handler, task, b, b->parent);
+        }
+
+        b = next;
+    }
+}
+
+
 static void
 nxt_router_req_headers_ack_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, nxt_request_rpc_data_t *req_rpc_data)
@@ -4251,8 +4844,6 @@ nxt_router_req_headers_ack_handler(nxt_task_t *task,
     start_process = 0;
     unlinked = 0;
 
-    nxt_thread_mutex_lock(&app->mutex);
-
     if (r->app_link.next != NULL) {
         nxt_queue_remove(&r->app_link);
         r->app_link.next = NULL;
@@ -4260,6 +4851,8 @@ nxt_router_req_headers_ack_handler(nxt_task_t *task,
         unlinked = 1;
     }
 
+    nxt_thread_mutex_lock(&app->mutex);
+
     app_port = nxt_port_hash_find(&app->port_hash, msg->port_msg.pid,
                                   msg->port_msg.reply_port);
     if (nxt_slow_path(app_port == NULL)) {
@@ -4318,6 +4911,11 @@ nxt_router_req_headers_ack_handler(nxt_task_t *task,
 
     nxt_thread_mutex_unlock(&app->mutex);
 
+    req_rpc_data->acked = task->thread->engine->timers.now;
+
+    nxt_router_app_time_update(&app->queue_time_avg,
+                               req_rpc_data->acked - req_rpc_data->queued);
+
     if (unlinked) {
         nxt_mp_release(r->mem_pool);
     }
@@ -4362,6 +4960,182 @@ nxt_router_req_headers_ack_handler(nxt_task_t *task,
         r->timer_data = req_rpc_data;
         nxt_timer_add(task->thread->engine, &r->timer, app->timeout);
     }
+
+    if (r->body_rest != 0) {
+        nxt_debug(task, "stream #%uD: stream body rest %O",
+                  req_rpc_data->stream, r->body_rest);
+
+        req_rpc_data->body_sent = r->content_length_n - r->body_rest;
+        r->body_handler = nxt_router_req_body_send;
+
+        nxt_http_request_read_body(task, r);
+    }
+}
+
+
+/*
+ * The application acknowledges the streamed body offset it has consumed,
+ * so the router keeps at most the window of the body in the application
+ * shared memory and suspends the client connection reading otherwise.
+ */
+
+nxt_inline nxt_bool_t
+nxt_router_req_body_window_full(nxt_http_request_t *r,
+    nxt_request_rpc_data_t *req_rpc_data)
+{
+    return req_rpc_data->body_sent - req_rpc_data->body_acked
+           >= (nxt_off_t) (4 * r->conf->socket_conf->body_buffer_size);
+}
+
+
+static void
+nxt_router_req_body_send(nxt_task_t *task, void *obj, void *data)
+{
+    u_char                  *pos;
+    size_t                  size, copy_size;
+    nxt_int_t               res;
+    nxt_buf_t               *b, *buf, *out, **tail;
+    nxt_port_t              *app_port;
+    nxt_http_request_t      *r;
+    nxt_request_rpc_data_t  *req_rpc_data;
+
+    r = obj;
+    b = data;
+
+    req_rpc_data = r->req_rpc_data;
+
+    if (req_rpc_data == NULL || req_rpc_data->app_port == NULL) {
+        nxt_debug(task, "router request body is not required");
+
+        r->body_handler = NULL;
+        return;
+    }
+
+    app_port = req_rpc_data->app_port;
+
+    if (b == NULL) {
+        nxt_debug(task, "stream #%uD: request body aborted",
+                  req_rpc_data->stream);
+
+        goto abort;
+    }
+
+    size = nxt_buf_mem_used_size(&b->mem);
+    pos = b->mem.pos;
+
+    out = NULL;
+    tail = &out;
+
+    while (size > 0) {
+        copy_size = nxt_min(size, PORT_MMAP_DATA_SIZE);
+
+        buf = nxt_port_mmap_get_buf(task, &req_rpc_data->app->outgoing,
+                                    copy_size);
+        if (nxt_slow_path(buf == NULL)) {
+            while (out != NULL) {
+                buf = out->next;
+                out->next = NULL;
+                out->completion_handler(task, out, out->parent);
+                out = buf;
+            }
+
+            goto fail;
+        }
+
+        buf->mem.free = nxt_cpymem(buf->mem.free, pos, copy_size);
+
+        pos += copy_size;
+        size -= copy_size;
+
+        *tail = buf;
+        tail = &buf->next;
+    }
+
+    b->mem.pos = b->mem.free;
+
+    if (out != NULL) {
+        res = nxt_port_socket_write(task, app_port, NXT_PORT_MSG_REQ_BODY, -1,
+                                    req_rpc_data->stream,
+                                    task->thread->engine->port->id, out);
+        if (nxt_slow_path(res != NXT_OK)) {
+            goto fail;
+        }
+    }
+
+    req_rpc_data->body_sent = r->content_length_n - r->body_rest;
+
+    if (r->body_rest == 0) {
+        r->body_handler = NULL;
+        return;
+    }
+
+    if (nxt_router_req_body_window_full(r, req_rpc_data)) {
+        nxt_debug(task, "stream #%uD: request body window is full",
+                  req_rpc_data->stream);
+
+        req_rpc_data->body_wait = 1;
+        return;
+    }
+
+    nxt_http_request_read_body(task, r);
+
+    return;
+
+fail:
+
+    nxt_http_request_error(task, r, NXT_HTTP_INTERNAL_SERVER_ERROR);
+
+abort:
+
+    (void) nxt_port_socket_write(task, app_port, NXT_PORT_MSG_REQ_BODY_LAST,
+                                 -1, req_rpc_data->stream,
+                                 task->thread->engine->port->id, NULL);
+
+    r->body_handler = NULL;
+
+    nxt_request_rpc_data_unlink(task, req_rpc_data);
+}
+
+
+static void
+nxt_router_req_body_ack_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg,
+    nxt_request_rpc_data_t *req_rpc_data)
+{
+    uint64_t            offset;
+    nxt_app_t           *app;
+    nxt_http_request_t  *r;
+
+    if (nxt_slow_path(msg->size != sizeof(uint64_t))) {
+        nxt_alert(task, "stream #%uD: invalid body ack size %uz",
+                  req_rpc_data->stream, msg->size);
+        return;
+    }
+
+    memcpy(&offset, msg->buf->mem.pos, sizeof(uint64_t));
+
+    nxt_debug(task, "stream #%uD: body ack %uL", req_rpc_data->stream,
+              offset);
+
+    if ((nxt_off_t) offset > req_rpc_data->body_acked) {
+        req_rpc_data->body_acked = offset;
+    }
+
+    r = req_rpc_data->request;
+    app = req_rpc_data->app;
+
+    if (app->timeout != 0) {
+        r->timer.handler = nxt_router_app_timeout;
+        r->timer_data = req_rpc_data;
+        nxt_timer_add(task->thread->engine, &r->timer, app->timeout);
+    }
+
+    if (req_rpc_data->body_wait
+        && !nxt_router_req_body_window_full(r, req_rpc_data))
+    {
+        req_rpc_data->body_wait = 0;
+
+        nxt_http_request_read_body(task, r);
+    }
 }
 
 
@@ -4432,6 +5206,8 @@ nxt_router_app_port_ready(nxt_task_t *task, nxt_port_recv_msg_t *msg,
     nxt_assert(port != NULL);
     nxt_assert(port->id == 0);
 
+    nxt_free(app_joint_rpc->app_cancel);
+
     app = app_joint->app;
 
     nxt_router_app_joint_use(task, app_joint, -1);
@@ -4534,18 +5310,23 @@ static void
 nxt_router_app_port_error(nxt_task_t *task, nxt_port_recv_msg_t *msg,
     void *data)
 {
+    nxt_int_t            ret;
+    nxt_uint_t           i;
     nxt_app_t            *app;
+    nxt_bool_t           cancel;
+    nxt_app_cancel_t     *app_cancel;
     nxt_app_joint_t      *app_joint;
-    nxt_queue_link_t     *link;
-    nxt_http_request_t   *r;
+    nxt_event_engine_t   *engine;
     nxt_app_joint_rpc_t  *app_joint_rpc;
 
     nxt_assert(data != NULL);
 
     app_joint_rpc = data;
     app_joint = app_joint_rpc->app_joint;
+    app_cancel = app_joint_rpc->app_cancel;
 
     nxt_assert(app_joint != NULL);
+    nxt_assert(app_cancel != NULL);
 
     app = app_joint->app;
 
@@ -4554,48 +5335,172 @@ nxt_router_app_port_error(nxt_task_t *task, nxt_port_recv_msg_t *msg,
     if (nxt_slow_path(app == NULL)) {
         nxt_debug(task, "start error for released app");
 
+        nxt_free(app_cancel);
+
         return;
     }
 
     nxt_debug(task, "app '%V' %p start error", &app->name, app);
 
-    link = NULL;
-
     nxt_thread_mutex_lock(&app->mutex);
 
     nxt_assert(app->pending_processes != 0);
 
     app->pending_processes--;
 
-    if (app->processes == 0 && !nxt_queue_is_empty(&app->ack_waiting_req)) {
-        link = nxt_queue_first(&app->ack_waiting_req);
+    cancel = (app->processes == 0);
 
-        nxt_queue_remove(link);
-        link->next = NULL;
+    nxt_thread_mutex_unlock(&app->mutex);
+
+    if (!cancel) {
+        nxt_free(app_cancel);
+
+        return;
+    }
+
+    app_cancel->app = app;
+    app_cancel->budget = 1;
+    app_cancel->count = 1;
+
+    nxt_router_app_use(task, app, 1);
+
+    i = 0;
+
+    nxt_queue_each(engine, &nxt_router->engines, nxt_event_engine_t, link0)
+    {
+        if (nxt_slow_path(engine->port == NULL)) {
+            continue;
+        }
+
+        nxt_atomic_fetch_add(&app_cancel->count, 1);
+
+        if (nxt_fast_path(i < app_cancel->nworks)) {
+            nxt_work_set(&app_cancel->works[i],
+                         nxt_router_app_requests_cancel, &engine->task,
+                         app_cancel, NULL);
+
+            nxt_event_engine_post(engine, &app_cancel->works[i]);
+
+            i++;
+
+            continue;
+        }
+
+        /* The engine has been added after the process start request. */
+
+        ret = nxt_port_post(task, engine->port, nxt_router_app_cancel_handler,
+                            app_cancel);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            nxt_atomic_fetch_add(&app_cancel->count, -1);
+        }
+    }
+    nxt_queue_loop;
+
+    nxt_router_app_cancel_release(task, app_cancel);
+}
+
+
+static nxt_app_cancel_t *
+nxt_router_app_cancel_create(void)
+{
+    nxt_uint_t        n;
+    nxt_app_cancel_t  *app_cancel;
+    nxt_queue_link_t  *link;
+
+    n = 0;
+
+    for (link = nxt_queue_first(&nxt_router->engines);
+         link != nxt_queue_tail(&nxt_router->engines);
+         link = nxt_queue_next(link))
+    {
+        n++;
+    }
+
+    app_cancel = nxt_zalloc(sizeof(nxt_app_cancel_t) + n * sizeof(nxt_work_t));
+    if (nxt_slow_path(app_cancel == NULL)) {
+        return NULL;
+    }
+
+    app_cancel->nworks = n;
+
+    return app_cancel;
+}
+
+
+static void
+nxt_router_app_cancel_release(nxt_task_t *task, nxt_app_cancel_t *app_cancel)
+{
+    if (nxt_atomic_fetch_add(&app_cancel->count, -1) != 1) {
+        return;
     }
 
+    nxt_router_app_use(task, app_cancel->app, -1);
+
+    nxt_free(app_cancel);
+}
+
+
+static void
+nxt_router_app_cancel_handler(nxt_task_t *task, nxt_port_t *port, void *data)
+{
+    nxt_router_app_requests_cancel(task, data, NULL);
+}
+
+
+static void
+nxt_router_app_requests_cancel(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_app_t               *app;
+    nxt_bool_t              all, cancel;
+    nxt_queue_t             *requests;
+    nxt_app_cancel_t        *app_cancel;
+    nxt_queue_link_t        *link, *next;
+    nxt_http_request_t      *r;
+    nxt_request_rpc_data_t  *req_rpc_data;
+
+    app_cancel = obj;
+    app = app_cancel->app;
+
+    nxt_thread_mutex_lock(&app->mutex);
+
+    cancel = (app->processes == 0);
+    all = (app->pending_processes == 0);
+
     nxt_thread_mutex_unlock(&app->mutex);
 
-    while (link != NULL) {
-        r = nxt_container_of(link, nxt_http_request_t, app_link);
+    requests = &task->thread->engine->app_requests;
 
-        nxt_event_engine_post(r->engine, &r->err_work);
+    /*
+     * One request is cancelled on each start error, the rest wait
+     * while there are other processes being started.
+     */
 
-        link = NULL;
+    for (link = nxt_queue_first(requests);
+         cancel && link != nxt_queue_tail(requests);
+         link = next)
+    {
+        next = nxt_queue_next(link);
 
-        nxt_thread_mutex_lock(&app->mutex);
+        r = nxt_container_of(link, nxt_http_request_t, app_link);
+        req_rpc_data = r->req_rpc_data;
 
-        if (app->processes == 0 && app->pending_processes == 0
-            && !nxt_queue_is_empty(&app->ack_waiting_req))
-        {
-            link = nxt_queue_first(&app->ack_waiting_req);
+        if (req_rpc_data == NULL || req_rpc_data->app != app) {
+            continue;
+        }
 
-            nxt_queue_remove(link);
-            link->next = NULL;
+        if (!all && !nxt_atomic_cmp_set(&app_cancel->budget, 1, 0)) {
+            break;
         }
 
-        nxt_thread_mutex_unlock(&app->mutex);
+        nxt_queue_remove(link);
+        link->next = NULL;
+
+        nxt_event_engine_post(r->engine, &r->err_work);
+
+        cancel = all;
     }
+
+    nxt_router_app_cancel_release(task, app_cancel);
 }
 
 
@@ -4705,13 +5610,10 @@ nxt_router_app_port_release(nxt_task_t *task, nxt_app_t *app, nxt_port_t *port,
               port->pid, port->id,
               (int) inc_use, (int) got_response);
 
-    if (port->id == NXT_SHARED_PORT_ID) {
-        nxt_thread_mutex_lock(&app->mutex);
-
-        app->active_requests -= got_response + dec_requests;
-
-        nxt_thread_mutex_unlock(&app->mutex);
+    nxt_atomic_fetch_add(&app->active_requests,
+                         -(int) (got_response + dec_requests));
 
+    if (port->id == NXT_SHARED_PORT_ID) {
         goto adjust_use;
     }
 
@@ -4720,7 +5622,6 @@ nxt_router_app_port_release(nxt_task_t *task, nxt_app_t *app, nxt_port_t *port,
     nxt_thread_mutex_lock(&app->mutex);
 
     main_app_port->active_requests -= got_response + dec_requests;
-    app->active_requests -= got_response + dec_requests;
 
     if (main_app_port->pair[1] != -1 && main_app_port->app_link.next == NULL) {
         nxt_queue_insert_tail(&app->ports, &main_app_port->app_link);
@@ -4876,6 +5777,14 @@ nxt_router_app_port_close(nxt_task_t *task, nxt_port_t *port)
 }
 
 
+/*
+ * If the "queue_time" target is set, idle processes are retired one per
+ * NXT_ROUTER_APP_RETIRE_INTERVAL and only while the average queue time
+ * stays below half of the target.  There are idle processes, so nothing
+ * is queued and the average is not updated; a copy of it is decayed
+ * instead until it drops below, the average itself is left to scaling.
+ */
+
 static void
 nxt_router_adjust_idle_timer(nxt_task_t *task, void *obj, void *data)
 {
@@ -4884,6 +5793,7 @@ nxt_router_adjust_idle_timer(nxt_task_t *task, void *obj, void *data)
     nxt_port_t          *port;
     nxt_msec_t          timeout, threshold;
     nxt_queue_link_t    *lnk;
+    nxt_atomic_uint_t   avg;
     nxt_event_engine_t  *engine;
 
     app = obj;
@@ -4926,6 +5836,31 @@ nxt_router_adjust_idle_timer(nxt_task_t *task, void *obj, void *data)
             break;
         }
 
+        if (app->queue_time != 0) {
+            avg = app->queue_time_avg;
+
+            if (avg != app->retire_queue_last) {
+                /* Requests have been queued since the last check. */
+                app->retire_queue_last = avg;
+                app->retire_queue_avg = avg;
+            }
+
+            if ((app->retire_queue_avg >> 3) > app->queue_time / 2) {
+                app->retire_queue_avg /= 2;
+
+                timeout = threshold + NXT_ROUTER_APP_RETIRE_INTERVAL;
+                break;
+            }
+
+            timeout = app->retire_time + NXT_ROUTER_APP_RETIRE_INTERVAL;
+
+            if (app->retire_time != 0 && timeout > threshold) {
+                break;
+            }
+
+            app->retire_time = engine->timers.now;
+        }
+
         nxt_queue_remove(lnk);
         lnk->next = NULL;
 
@@ -5089,49 +6024,72 @@ nxt_router_free_app(nxt_task_t *task, void *obj, void *data)
 }
 
 
+/*
+ * The request path does not lock the application.  The active requests
+ * counter is atomic, the requests waiting for an application process are
+ * linked in the engine queue, and a replaced shared port is released only
+ * after all engines have run past it.  The mutex is taken only if a new
+ * process is likely to be started; the decision is checked again under it.
+ */
+
 static void
 nxt_router_app_port_get(nxt_task_t *task, nxt_app_t *app,
     nxt_request_rpc_data_t *req_rpc_data)
 {
-    nxt_bool_t          start_process;
+    nxt_uint_t          start_process;
     nxt_port_t          *port;
     nxt_http_request_t  *r;
 
     start_process = 0;
 
-    nxt_thread_mutex_lock(&app->mutex);
-
     port = app->shared_port;
     nxt_port_inc_use(port);
 
-    app->active_requests++;
+    nxt_atomic_fetch_add(&app->active_requests, 1);
 
     if (nxt_router_app_can_start(app) && nxt_router_app_need_start(app)) {
-        app->pending_processes++;
-        start_process = 1;
+        nxt_thread_mutex_lock(&app->mutex);
+
+        /*
+         * The processes required to meet the queue time target
+         * are started at once rather than one per request.
+         */
+
+        while (nxt_router_app_can_start(app)
+               && nxt_router_app_need_start(app))
+        {
+            app->pending_processes++;
+            start_process++;
+
+            if (app->queue_time == 0) {
+                break;
+            }
+        }
+
+        nxt_thread_mutex_unlock(&app->mutex);
     }
 
     r = req_rpc_data->request;
 
     /*
-     * Put request into application-wide list to be able to cancel request
+     * Put request into engine-wide list to be able to cancel request
      * if something goes wrong with application processes.
      */
-    nxt_queue_insert_tail(&app->ack_waiting_req, &r->app_link);
-
-    nxt_thread_mutex_unlock(&app->mutex);
+    nxt_queue_insert_tail(&r->engine->app_requests, &r->app_link);
 
     /*
-     * Retain request memory pool while request is linked in ack_waiting_req
+     * Retain request memory pool while request is linked in app_requests
      * to guarantee request structure memory is accessble.
      */
     nxt_mp_retain(r->mem_pool);
 
     req_rpc_data->app_port = port;
     req_rpc_data->apr_action = NXT_APR_REQUEST_FAILED;
+    req_rpc_data->queued = task->thread->engine->timers.now;
 
-    if (start_process) {
+    while (start_process != 0) {
         nxt_router_start_app_process(task, app);
+        start_process--;
     }
 }
 
@@ -5147,6 +6105,12 @@ nxt_router_process_http_request(nxt_task_t *task, nxt_http_request_t *r,
     conf = action->u.conf;
     engine = task->thread->engine;
 
+    if (r->body_rest != 0 && conf->app->type == NXT_APP_EXTERNAL) {
+        /* External applications expect the whole request body. */
+        nxt_http_request_body_complete(task, r, action);
+        return;
+    }
+
     r->app_target = conf->target;
 
     req_rpc_data = nxt_port_rpc_register_handler_ex(task, engine->port,
@@ -5438,6 +6402,7 @@ nxt_router_prepare_msg(nxt_task_t *task, nxt_http_request_t *r,
     out->mem.free += req_size;
 
     req->app_target = r->app_target;
+    req->content_stream = (r->body_rest != 0);
 
     req->content_length = content_length;
 
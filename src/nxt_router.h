@@ -16,12 +16,14 @@ typedef struct nxt_http_request_s  nxt_http_request_t;
 #include <nxt_application.h>
 
 
-typedef struct nxt_http_action_s        nxt_http_action_t;
-typedef struct nxt_http_routes_s        nxt_http_routes_t;
-typedef struct nxt_http_forward_s       nxt_http_forward_t;
-typedef struct nxt_upstream_s           nxt_upstream_t;
-typedef struct nxt_upstreams_s          nxt_upstreams_t;
-typedef struct nxt_router_access_log_s  nxt_router_access_log_t;
+typedef struct nxt_http_action_s         nxt_http_action_t;
+typedef struct nxt_http_routes_s         nxt_http_routes_t;
+typedef struct nxt_http_forward_s        nxt_http_forward_t;
+typedef struct nxt_upstream_s            nxt_upstream_t;
+typedef struct nxt_upstreams_s           nxt_upstreams_t;
+typedef struct nxt_router_access_log_s   nxt_router_access_log_t;
+typedef struct nxt_http_compress_conf_s  nxt_http_compress_conf_t;
+typedef struct nxt_http_cache_s          nxt_http_cache_t;
 
 
 #define NXT_HTTP_ACTION_ERROR  ((nxt_http_action_t *) -1)
@@ -35,6 +37,9 @@ typedef struct {
     nxt_queue_t              apps;     /* of nxt_app_t */
 
     nxt_router_access_log_t  *access_log;
+
+    nxt_upstreams_t          *upstreams;
+    nxt_queue_t              upstream_checks;
 } nxt_router_t;
 
 
@@ -52,9 +57,17 @@ typedef struct {
     nxt_lvlhsh_t             mtypes_hash;
     nxt_lvlhsh_t             apps_hash;
 
+    size_t                   open_file_cache_max;
+    nxt_msec_t               open_file_cache_valid;
+
+    nxt_http_compress_conf_t *compress;
+    nxt_http_cache_t         *cache;
+
     nxt_router_access_log_t  *access_log;
     nxt_tstr_t               *log_format;
     nxt_tstr_t               *log_expr;
+    size_t                   log_buffer;
+    nxt_msec_t               log_flush;
     uint8_t                  log_negate;  /* 1 bit */
 } nxt_router_conf_t;
 
@@ -99,6 +112,7 @@ typedef struct {
     nxt_task_t              task;
     nxt_work_t              work;
     nxt_router_temp_conf_t  *tmcf;
+    nxt_socket_t            socket;
 } nxt_joint_job_t;
 
 
@@ -124,7 +138,7 @@ struct nxt_app_s {
 
     uint32_t               port_hash_count;
 
-    uint32_t               active_requests;
+    nxt_atomic_t           active_requests;
     uint32_t               pending_processes;
     uint32_t               processes;
     uint32_t               idle_processes;
@@ -139,6 +153,15 @@ struct nxt_app_s {
     nxt_msec_t             timeout;
     nxt_msec_t             idle_timeout;
 
+    /* The target and the averages are in milliseconds, the averages * 8. */
+    nxt_msec_t             queue_time;
+    nxt_atomic_t           queue_time_avg;
+    nxt_atomic_t           service_time_avg;
+    nxt_msec_t             retire_time;
+    /* A copy of queue_time_avg decayed while processes are retired. */
+    nxt_atomic_uint_t      retire_queue_avg;
+    nxt_atomic_uint_t      retire_queue_last;
+
     nxt_str_t              *targets;
 
     nxt_app_type_t         type:8;
@@ -149,7 +172,6 @@ struct nxt_app_s {
     nxt_str_t              conf;
 
     nxt_atomic_t           use_count;
-    nxt_queue_t            ack_waiting_req; /* of nxt_http_request_t.app_link */
 
     nxt_app_joint_t        *joint;
     nxt_port_t             *shared_port;
@@ -182,6 +204,8 @@ typedef struct {
 
     nxt_listen_socket_t    *listen;
 
+    uint32_t               accept_batch;
+
     size_t                 header_buffer_size;
     size_t                 large_header_buffer_size;
     size_t                 large_header_buffers;
@@ -190,6 +214,8 @@ typedef struct {
     size_t                 proxy_header_buffer_size;
     size_t                 proxy_buffer_size;
     size_t                 proxy_buffers;
+    size_t                 proxy_keepalive;
+    size_t                 proxy_keepalive_requests;
 
     nxt_msec_t             idle_timeout;
     nxt_msec_t             header_read_timeout;
@@ -198,6 +224,7 @@ typedef struct {
     nxt_msec_t             proxy_timeout;
     nxt_msec_t             proxy_send_timeout;
     nxt_msec_t             proxy_read_timeout;
+    nxt_msec_t             proxy_keepalive_timeout;
 
     nxt_websocket_conf_t   websocket_conf;
 
@@ -207,6 +234,10 @@ typedef struct {
 
     uint8_t                discard_unsafe_fields;  /* 1 bit */
 
+    uint8_t                body_streaming;         /* 1 bit */
+
+    uint8_t                http2;                  /* 1 bit */
+
     uint8_t                server_version;         /* 1 bit */
 
     nxt_http_forward_t     *forwarded;
@@ -261,8 +292,14 @@ void nxt_router_access_log_use(nxt_thread_spinlock_t *lock,
     nxt_router_access_log_t *access_log);
 void nxt_router_access_log_release(nxt_task_t *task,
     nxt_thread_spinlock_t *lock, nxt_router_access_log_t *access_log);
+void nxt_router_access_log_flush(nxt_task_t *task,
+    nxt_port_post_handler_t handler);
 void nxt_router_access_log_reopen_handler(nxt_task_t *task,
     nxt_port_recv_msg_t *msg);
+void nxt_router_access_log_quit_handler(nxt_task_t *task,
+    nxt_port_recv_msg_t *msg);
+void nxt_router_access_log_engine_free(nxt_task_t *task,
+    nxt_event_engine_t *engine);
 
 
 extern nxt_router_t  *nxt_router;
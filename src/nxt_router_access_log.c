@@ -14,6 +14,8 @@ typedef struct {
     nxt_str_t                 path;
     nxt_str_t                 format;
     nxt_conf_value_t          *expr;
+    size_t                    buffer;
+    nxt_msec_t                flush;
 } nxt_router_access_log_conf_t;
 
 
@@ -23,6 +25,59 @@ typedef struct {
 } nxt_router_access_log_ctx_t;
 
 
+/*
+ * If the "buffer" option is set, log lines are accumulated in per-engine
+ * chunks.  A chunk is passed to the writer when it is full, when the
+ * "flush" timeout expires, or when the log is reopened.  Each engine
+ * has at most one writer job in the thread pool at a time, and the job
+ * writes all the chunks passed to it so far with writev(), retrying short
+ * writes.  The lock protects the list of passed chunks and is shared only
+ * between the engine and its writer.  The mutex is held while the chunks taken
+ * from the list are written, so the engine may write them itself without
+ * reordering the lines if the writer cannot keep up or the log is flushed.
+ */
+
+typedef struct nxt_router_access_log_chunk_s  nxt_router_access_log_chunk_t;
+
+struct nxt_router_access_log_chunk_s {
+    nxt_router_access_log_chunk_t   *next;
+    nxt_router_access_log_t         *access_log;
+    u_char                          *free;
+    u_char                          *end;
+    u_char                          start[0];
+};
+
+
+typedef struct {
+    nxt_router_access_log_chunk_t   *current;
+    nxt_event_engine_t              *engine;
+    nxt_timer_t                     timer;
+
+    nxt_thread_mutex_t              mutex;
+
+    nxt_thread_spinlock_t           lock;
+    nxt_router_access_log_chunk_t   *first;
+    nxt_router_access_log_chunk_t   **last;
+    nxt_uint_t                      chunks;
+    uint8_t                         writing;  /* 1 bit */
+    uint8_t                         orphan;   /* 1 bit */
+
+    nxt_work_t                      work;
+    nxt_task_t                      task;
+} nxt_router_access_log_buffer_t;
+
+
+typedef struct {
+    nxt_atomic_t                    count;
+    nxt_port_post_handler_t         handler;
+} nxt_router_access_log_flush_t;
+
+
+#define NXT_ROUTER_ACCESS_LOG_FLUSH   1000
+#define NXT_ROUTER_ACCESS_LOG_CHUNKS  64
+#define NXT_ROUTER_ACCESS_LOG_IOVS    64
+
+
 static void nxt_router_access_log_writer(nxt_task_t *task,
     nxt_http_request_t *r, nxt_router_access_log_t *access_log,
     nxt_tstr_t *format);
@@ -30,10 +85,33 @@ static void nxt_router_access_log_write_ready(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_router_access_log_write_error(nxt_task_t *task, void *obj,
     void *data);
+static void nxt_router_access_log_buffer_write(nxt_task_t *task,
+    nxt_router_conf_t *rtcf, nxt_router_access_log_t *access_log,
+    nxt_str_t *text);
+static nxt_router_access_log_buffer_t *nxt_router_access_log_buffer(
+    nxt_event_engine_t *engine);
+static void nxt_router_access_log_buffer_flush(nxt_task_t *task,
+    nxt_router_access_log_buffer_t *buffer);
+static void nxt_router_access_log_timer_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_router_access_log_writer_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_router_access_log_queue_write(nxt_task_t *task,
+    nxt_router_access_log_buffer_t *buffer);
+static void nxt_router_access_log_chunks_write(nxt_task_t *task,
+    nxt_router_access_log_chunk_t *chunk);
+static void nxt_router_access_log_flush_handler(nxt_task_t *task,
+    nxt_port_t *port, void *data);
+static void nxt_router_access_log_buffer_drain(nxt_task_t *task,
+    nxt_router_access_log_buffer_t *buffer);
+static void nxt_router_access_log_quit(nxt_task_t *task, nxt_port_t *port,
+    void *data);
 static void nxt_router_access_log_ready(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
 static void nxt_router_access_log_error(nxt_task_t *task,
     nxt_port_recv_msg_t *msg, void *data);
+static void nxt_router_access_log_reopen(nxt_task_t *task, nxt_port_t *port,
+    void *data);
 static void nxt_router_access_log_reopen_completion(nxt_task_t *task, void *obj,
     void *data);
 static void nxt_router_access_log_reopen_ready(nxt_task_t *task,
@@ -60,9 +138,25 @@ static nxt_conf_map_t  nxt_router_access_log_conf[] = {
         NXT_CONF_MAP_PTR,
         offsetof(nxt_router_access_log_conf_t, expr),
     },
+
+    {
+        nxt_string("buffer"),
+        NXT_CONF_MAP_SIZE,
+        offsetof(nxt_router_access_log_conf_t, buffer),
+    },
+
+    {
+        nxt_string("flush"),
+        NXT_CONF_MAP_MSEC,
+        offsetof(nxt_router_access_log_conf_t, flush),
+    },
 };
 
 
+/* Lines are written synchronously after the router has started to exit. */
+static nxt_bool_t  nxt_router_access_log_exiting;
+
+
 nxt_int_t
 nxt_router_access_log_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
     nxt_conf_value_t *value)
@@ -82,6 +176,7 @@ nxt_router_access_log_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
     nxt_memzero(&alcf, sizeof(nxt_router_access_log_conf_t));
 
     alcf.format = log_format_str;
+    alcf.flush = NXT_ROUTER_ACCESS_LOG_FLUSH;
 
     if (nxt_conf_type(value) == NXT_CONF_STRING) {
         nxt_conf_get_string(value, &alcf.path);
@@ -141,6 +236,8 @@ nxt_router_access_log_create(nxt_task_t *task, nxt_router_conf_t *rtcf,
 
     rtcf->access_log = access_log;
     rtcf->log_format = format;
+    rtcf->log_buffer = alcf.buffer;
+    rtcf->log_flush = alcf.flush;
 
     if (alcf.expr != NULL) {
         nxt_conf_get_string(alcf.expr, &str);
@@ -202,13 +299,22 @@ nxt_router_access_log_writer(nxt_task_t *task, nxt_http_request_t *r,
 static void
 nxt_router_access_log_write_ready(nxt_task_t *task, void *obj, void *data)
 {
+    nxt_router_conf_t            *rtcf;
     nxt_http_request_t           *r;
     nxt_router_access_log_ctx_t  *ctx;
 
     r = obj;
     ctx = data;
 
-    nxt_fd_write(ctx->access_log->fd, ctx->text.start, ctx->text.length);
+    rtcf = r->conf->socket_conf->router_conf;
+
+    if (rtcf->log_buffer != 0 && !nxt_router_access_log_exiting) {
+        nxt_router_access_log_buffer_write(task, rtcf, ctx->access_log,
+                                           &ctx->text);
+
+    } else {
+        nxt_fd_write(ctx->access_log->fd, ctx->text.start, ctx->text.length);
+    }
 
     nxt_http_request_close_handler(task, r, r->proto.any);
 }
@@ -221,6 +327,466 @@ nxt_router_access_log_write_error(nxt_task_t *task, void *obj, void *data)
 }
 
 
+static void
+nxt_router_access_log_buffer_write(nxt_task_t *task, nxt_router_conf_t *rtcf,
+    nxt_router_access_log_t *access_log, nxt_str_t *text)
+{
+    size_t                          size;
+    nxt_event_engine_t              *engine;
+    nxt_router_access_log_chunk_t   *chunk;
+    nxt_router_access_log_buffer_t  *buffer;
+
+    engine = task->thread->engine;
+
+    buffer = nxt_router_access_log_buffer(engine);
+    if (nxt_slow_path(buffer == NULL)) {
+        nxt_fd_write(access_log->fd, text->start, text->length);
+        return;
+    }
+
+    chunk = buffer->current;
+
+    if (chunk != NULL
+        && (chunk->access_log != access_log
+            || (size_t) (chunk->end - chunk->free) < text->length))
+    {
+        nxt_router_access_log_buffer_flush(task, buffer);
+        chunk = NULL;
+    }
+
+    if (chunk == NULL) {
+        size = nxt_max(rtcf->log_buffer, text->length);
+
+        chunk = nxt_malloc(sizeof(nxt_router_access_log_chunk_t) + size);
+        if (nxt_slow_path(chunk == NULL)) {
+            /* The line is written after the lines passed to the writer. */
+            nxt_router_access_log_queue_write(task, buffer);
+
+            nxt_fd_write(access_log->fd, text->start, text->length);
+            return;
+        }
+
+        nxt_router_access_log_use(&nxt_router->lock, access_log);
+
+        chunk->next = NULL;
+        chunk->access_log = access_log;
+        chunk->free = chunk->start;
+        chunk->end = chunk->start + size;
+
+        buffer->current = chunk;
+
+        if (rtcf->log_flush != 0) {
+            nxt_timer_add(engine, &buffer->timer, rtcf->log_flush);
+        }
+    }
+
+    chunk->free = nxt_cpymem(chunk->free, text->start, text->length);
+
+    if (chunk->free == chunk->end) {
+        nxt_router_access_log_buffer_flush(task, buffer);
+    }
+}
+
+
+static nxt_router_access_log_buffer_t *
+nxt_router_access_log_buffer(nxt_event_engine_t *engine)
+{
+    nxt_router_access_log_buffer_t  *buffer;
+
+    buffer = engine->access_log;
+
+    if (nxt_fast_path(buffer != NULL)) {
+        return buffer;
+    }
+
+    buffer = nxt_zalloc(sizeof(nxt_router_access_log_buffer_t));
+    if (nxt_slow_path(buffer == NULL)) {
+        return NULL;
+    }
+
+    if (nxt_slow_path(nxt_thread_mutex_create(&buffer->mutex) != NXT_OK)) {
+        nxt_free(buffer);
+        return NULL;
+    }
+
+    buffer->engine = engine;
+    buffer->last = &buffer->first;
+
+    buffer->timer.handler = nxt_router_access_log_timer_handler;
+    buffer->timer.work_queue = &engine->fast_work_queue;
+    buffer->timer.task = &engine->task;
+    buffer->timer.log = engine->task.log;
+    buffer->timer.bias = NXT_TIMER_DEFAULT_BIAS;
+
+    buffer->task.log = engine->task.log;
+
+    engine->access_log = buffer;
+
+    return buffer;
+}
+
+
+static void
+nxt_router_access_log_buffer_flush(nxt_task_t *task,
+    nxt_router_access_log_buffer_t *buffer)
+{
+    nxt_int_t                      ret;
+    nxt_bool_t                     start;
+    nxt_thread_pool_t              *tp;
+    nxt_router_access_log_chunk_t  *chunk;
+
+    chunk = buffer->current;
+
+    if (chunk == NULL) {
+        return;
+    }
+
+    buffer->current = NULL;
+
+    nxt_timer_delete(buffer->engine, &buffer->timer);
+
+    start = 0;
+
+    nxt_thread_spin_lock(&buffer->lock);
+
+    *buffer->last = chunk;
+    buffer->last = &chunk->next;
+    buffer->chunks++;
+
+    if (buffer->chunks >= NXT_ROUTER_ACCESS_LOG_CHUNKS) {
+        nxt_thread_spin_unlock(&buffer->lock);
+
+        /* The writer cannot keep up. */
+
+        nxt_router_access_log_queue_write(task, buffer);
+        return;
+    }
+
+    if (!buffer->writing) {
+        buffer->writing = 1;
+        start = 1;
+    }
+
+    nxt_thread_spin_unlock(&buffer->lock);
+
+    if (!start) {
+        return;
+    }
+
+    tp = task->thread->runtime->auxiliary_pool;
+
+    nxt_work_set(&buffer->work, nxt_router_access_log_writer_handler,
+                 &buffer->task, buffer, NULL);
+
+    ret = (tp != NULL) ? nxt_thread_pool_post(tp, &buffer->work) : NXT_ERROR;
+
+    if (nxt_slow_path(ret != NXT_OK)) {
+        buffer->task.thread = task->thread;
+
+        nxt_router_access_log_writer_handler(&buffer->task, buffer, NULL);
+    }
+}
+
+
+static void
+nxt_router_access_log_timer_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_timer_t                     *timer;
+    nxt_router_access_log_buffer_t  *buffer;
+
+    timer = obj;
+
+    buffer = nxt_timer_data(timer, nxt_router_access_log_buffer_t, timer);
+
+    nxt_router_access_log_buffer_flush(task, buffer);
+}
+
+
+static void
+nxt_router_access_log_writer_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_bool_t                      orphan;
+    nxt_router_access_log_buffer_t  *buffer;
+
+    buffer = obj;
+
+    for ( ;; ) {
+        nxt_router_access_log_queue_write(task, buffer);
+
+        /*
+         * The writing flag is cleared only after the mutex has been
+         * unlocked, because the engine may free the buffer then.
+         */
+
+        nxt_thread_spin_lock(&buffer->lock);
+
+        if (buffer->first == NULL) {
+            buffer->writing = 0;
+            orphan = buffer->orphan;
+
+            nxt_thread_spin_unlock(&buffer->lock);
+
+            if (orphan) {
+                nxt_thread_mutex_destroy(&buffer->mutex);
+                nxt_free(buffer);
+            }
+
+            return;
+        }
+
+        nxt_thread_spin_unlock(&buffer->lock);
+    }
+}
+
+
+static void
+nxt_router_access_log_queue_write(nxt_task_t *task,
+    nxt_router_access_log_buffer_t *buffer)
+{
+    nxt_router_access_log_chunk_t  *chunk;
+
+    nxt_thread_mutex_lock(&buffer->mutex);
+
+    nxt_thread_spin_lock(&buffer->lock);
+
+    chunk = buffer->first;
+
+    buffer->first = NULL;
+    buffer->last = &buffer->first;
+    buffer->chunks = 0;
+
+    nxt_thread_spin_unlock(&buffer->lock);
+
+    nxt_router_access_log_chunks_write(task, chunk);
+
+    nxt_thread_mutex_unlock(&buffer->mutex);
+}
+
+
+static void
+nxt_router_access_log_chunks_write(nxt_task_t *task,
+    nxt_router_access_log_chunk_t *chunk)
+{
+    ssize_t                        n;
+    nxt_err_t                      err;
+    nxt_uint_t                     niov;
+    struct iovec                   *v, iov[NXT_ROUTER_ACCESS_LOG_IOVS];
+    nxt_router_access_log_t        *access_log;
+    nxt_router_access_log_chunk_t  *next, *first;
+
+    while (chunk != NULL) {
+        first = chunk;
+        access_log = chunk->access_log;
+        niov = 0;
+
+        do {
+            iov[niov].iov_base = chunk->start;
+            iov[niov].iov_len = chunk->free - chunk->start;
+            niov++;
+
+            chunk = chunk->next;
+
+        } while (chunk != NULL
+                 && chunk->access_log == access_log
+                 && niov < NXT_ROUTER_ACCESS_LOG_IOVS);
+
+        v = iov;
+
+        for ( ;; ) {
+            n = writev(access_log->fd, v, niov);
+
+            if (nxt_slow_path(n == -1)) {
+                err = nxt_errno;
+
+                if (err == NXT_EINTR) {
+                    continue;
+                }
+
+                nxt_alert(task, "writev(%FD, %ui) failed %E",
+                          access_log->fd, niov, err);
+                break;
+            }
+
+            /* The tail of a short write is written again. */
+
+            while (niov != 0 && (size_t) n >= v->iov_len) {
+                n -= v->iov_len;
+                v++;
+                niov--;
+            }
+
+            if (niov == 0) {
+                break;
+            }
+
+            v->iov_base = (u_char *) v->iov_base + n;
+            v->iov_len -= n;
+        }
+
+        while (first != chunk) {
+            next = first->next;
+
+            nxt_free(first);
+            nxt_router_access_log_release(task, &nxt_router->lock,
+                                          access_log);
+
+            first = next;
+        }
+    }
+}
+
+
+/*
+ * The buffered lines are flushed on log reopening, on reconfiguration,
+ * and on exit.  Each engine writes its chunks itself after the chunks
+ * being written by its writer, so the handler runs on the router thread
+ * only after all the lines logged so far have been written, e.g. before
+ * the log is reopened or the process quits.
+ */
+
+void
+nxt_router_access_log_flush(nxt_task_t *task, nxt_port_post_handler_t handler)
+{
+    nxt_int_t                      ret;
+    nxt_event_engine_t             *engine;
+    nxt_router_access_log_flush_t  *flush;
+
+    flush = nxt_malloc(sizeof(nxt_router_access_log_flush_t));
+    if (nxt_slow_path(flush == NULL)) {
+        if (handler != NULL) {
+            handler(task, NULL, NULL);
+        }
+
+        return;
+    }
+
+    flush->count = 1;
+    flush->handler = handler;
+
+    nxt_queue_each(engine, &nxt_router->engines, nxt_event_engine_t, link0)
+    {
+        if (nxt_fast_path(engine->port != NULL)) {
+            nxt_atomic_fetch_add(&flush->count, 1);
+
+            ret = nxt_port_post(task, engine->port,
+                                nxt_router_access_log_flush_handler, flush);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                nxt_atomic_fetch_add(&flush->count, -1);
+            }
+        }
+    }
+    nxt_queue_loop;
+
+    nxt_router_access_log_flush_handler(task, NULL, flush);
+}
+
+
+static void
+nxt_router_access_log_flush_handler(nxt_task_t *task, nxt_port_t *port,
+    void *data)
+{
+    nxt_port_t                      *router_port;
+    nxt_router_access_log_flush_t   *flush;
+    nxt_router_access_log_buffer_t  *buffer;
+
+    flush = data;
+
+    buffer = task->thread->engine->access_log;
+
+    if (buffer != NULL) {
+        nxt_router_access_log_buffer_drain(task, buffer);
+    }
+
+    if (nxt_atomic_fetch_add(&flush->count, -1) != 1) {
+        return;
+    }
+
+    if (flush->handler != NULL) {
+        router_port = task->thread->runtime->port_by_type[NXT_PROCESS_ROUTER];
+
+        if (nxt_slow_path(nxt_port_post(task, router_port, flush->handler,
+                                        NULL)
+                          != NXT_OK))
+        {
+            nxt_alert(task, "failed to post access log flush handler");
+        }
+    }
+
+    nxt_free(flush);
+}
+
+
+static void
+nxt_router_access_log_buffer_drain(nxt_task_t *task,
+    nxt_router_access_log_buffer_t *buffer)
+{
+    nxt_router_access_log_chunk_t  *chunk;
+
+    chunk = buffer->current;
+
+    if (chunk != NULL) {
+        buffer->current = NULL;
+
+        nxt_timer_delete(buffer->engine, &buffer->timer);
+
+        nxt_thread_spin_lock(&buffer->lock);
+
+        *buffer->last = chunk;
+        buffer->last = &chunk->next;
+
+        nxt_thread_spin_unlock(&buffer->lock);
+    }
+
+    nxt_router_access_log_queue_write(task, buffer);
+}
+
+
+void
+nxt_router_access_log_quit_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
+{
+    nxt_router_access_log_exiting = 1;
+
+    nxt_router_access_log_flush(task, nxt_router_access_log_quit);
+}
+
+
+static void
+nxt_router_access_log_quit(nxt_task_t *task, nxt_port_t *port, void *data)
+{
+    nxt_process_quit(task, 0);
+}
+
+
+void
+nxt_router_access_log_engine_free(nxt_task_t *task, nxt_event_engine_t *engine)
+{
+    nxt_bool_t                      writing;
+    nxt_router_access_log_buffer_t  *buffer;
+
+    buffer = engine->access_log;
+
+    if (buffer == NULL) {
+        return;
+    }
+
+    engine->access_log = NULL;
+
+    nxt_router_access_log_buffer_drain(task, buffer);
+
+    nxt_thread_spin_lock(&buffer->lock);
+
+    writing = buffer->writing;
+    buffer->orphan = 1;
+
+    nxt_thread_spin_unlock(&buffer->lock);
+
+    if (!writing) {
+        nxt_thread_mutex_destroy(&buffer->mutex);
+        nxt_free(buffer);
+    }
+}
+
+
 void
 nxt_router_access_log_open(nxt_task_t *task, nxt_router_temp_conf_t *tmcf)
 {
@@ -352,6 +918,15 @@ typedef struct {
 
 void
 nxt_router_access_log_reopen_handler(nxt_task_t *task, nxt_port_recv_msg_t *msg)
+{
+    if (nxt_router->access_log != NULL) {
+        nxt_router_access_log_flush(task, nxt_router_access_log_reopen);
+    }
+}
+
+
+static void
+nxt_router_access_log_reopen(nxt_task_t *task, nxt_port_t *port, void *data)
 {
     nxt_mp_t                        *mp;
     uint32_t                        stream;
@@ -33,7 +33,16 @@ typedef struct {
     nxt_http_request_t      *request;
     nxt_msg_info_t          msg_info;
 
+    /* A streamed request body offsets sent and acknowledged. */
+    nxt_off_t               body_sent;
+    nxt_off_t               body_acked;
+
+    /* The times the request was queued and taken by a process. */
+    nxt_msec_t              queued;
+    nxt_msec_t              acked;
+
     nxt_bool_t              rpc_cancel;
+    nxt_bool_t              body_wait;
 } nxt_request_rpc_data_t;
 
 
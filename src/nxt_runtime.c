@@ -488,6 +488,21 @@ nxt_runtime_close_idle_connections(nxt_event_engine_t *engine)
             nxt_conn_close(engine, c);
         }
     }
+
+    idle = &engine->idle_peers;
+
+    for (link = nxt_queue_first(idle);
+         link != nxt_queue_tail(idle);
+         link = next)
+    {
+        next = nxt_queue_next(link);
+        c = nxt_queue_link_data(link, nxt_conn_t, link);
+
+        nxt_queue_remove(link);
+        nxt_conn_close(engine, c);
+    }
+
+    engine->idle_peers_n = 0;
 }
 
 
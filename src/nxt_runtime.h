@@ -33,6 +33,7 @@ struct nxt_runtime_s {
 #endif
 
     nxt_array_t            *thread_pools;       /* of nxt_thread_pool_t */
+    nxt_thread_pool_t      *auxiliary_pool;
     nxt_runtime_cont_t     continuation;
 
     nxt_process_t          *mprocess;
@@ -11,11 +11,17 @@
 nxt_conf_value_t *
 nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
 {
-    size_t            i;
-    nxt_str_t         name;
-    nxt_int_t         ret;
-    nxt_status_app_t  *app;
-    nxt_conf_value_t  *status, *obj, *apps, *app_obj;
+    size_t                        i;
+    uint32_t                      j;
+    nxt_str_t                     name;
+    nxt_int_t                     ret;
+    nxt_status_app_t              *app;
+    nxt_conf_value_t              *status, *obj, *apps, *app_obj;
+    nxt_conf_value_t              *upstreams, *servers, *server_obj;
+    nxt_conf_value_t              *threads, *thread_obj;
+    nxt_status_thread_t           *thread;
+    nxt_status_upstream_t         *upstream;
+    nxt_status_upstream_server_t  *server;
 
     static nxt_str_t conns_str = nxt_string("connections");
     static nxt_str_t acc_str = nxt_string("accepted");
@@ -28,8 +34,23 @@ nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
     static nxt_str_t procs_str = nxt_string("processes");
     static nxt_str_t run_str = nxt_string("running");
     static nxt_str_t start_str = nxt_string("starting");
-
-    status = nxt_conf_create_object(mp, 3);
+    static nxt_str_t upstreams_str = nxt_string("upstreams");
+    static nxt_str_t servers_str = nxt_string("servers");
+    static nxt_str_t state_str = nxt_string("state");
+    static nxt_str_t fails_str = nxt_string("fails");
+    static nxt_str_t threads_str = nxt_string("threads");
+    static nxt_str_t events_str = nxt_string("accept_events");
+    static nxt_str_t latency_str = nxt_string("accept_latency");
+    static nxt_str_t max_str = nxt_string("max");
+
+    static nxt_str_t states[] = {
+        nxt_string("up"),
+        nxt_string("down"),
+        nxt_string("unhealthy"),
+    };
+
+    status = nxt_conf_create_object(mp, (report->upstreams_count != 0) ? 5
+                                                                       : 4);
     if (nxt_slow_path(status == NULL)) {
         return NULL;
     }
@@ -101,5 +122,98 @@ nxt_status_get(nxt_status_report_t *report, nxt_mp_t *mp)
         nxt_conf_set_member_integer(obj, &active_str, app->active_requests, 0);
     }
 
+    threads = nxt_conf_create_array(mp, report->threads_count);
+    if (nxt_slow_path(threads == NULL)) {
+        return NULL;
+    }
+
+    nxt_conf_set_member(status, &threads_str, threads, 3);
+
+    thread = nxt_pointer_to(report, (uintptr_t) report->threads);
+
+    for (i = 0; i < report->threads_count; i++) {
+        thread_obj = nxt_conf_create_object(mp, 3);
+        if (nxt_slow_path(thread_obj == NULL)) {
+            return NULL;
+        }
+
+        nxt_conf_set_element(threads, i, thread_obj);
+
+        nxt_conf_set_member_integer(thread_obj, &acc_str,
+                                    thread[i].accepted_conns, 0);
+        nxt_conf_set_member_integer(thread_obj, &events_str,
+                                    thread[i].accept_events, 1);
+
+        obj = nxt_conf_create_object(mp, 2);
+        if (nxt_slow_path(obj == NULL)) {
+            return NULL;
+        }
+
+        nxt_conf_set_member(thread_obj, &latency_str, obj, 2);
+
+        nxt_conf_set_member_integer(obj, &total_str,
+                                    thread[i].accept_latency, 0);
+        nxt_conf_set_member_integer(obj, &max_str,
+                                    thread[i].accept_latency_max, 1);
+    }
+
+    if (report->upstreams_count == 0) {
+        return status;
+    }
+
+    upstreams = nxt_conf_create_object(mp, report->upstreams_count);
+    if (nxt_slow_path(upstreams == NULL)) {
+        return NULL;
+    }
+
+    nxt_conf_set_member(status, &upstreams_str, upstreams, 4);
+
+    upstream = nxt_pointer_to(report, (uintptr_t) report->upstreams);
+
+    for (i = 0; i < report->upstreams_count; i++) {
+        obj = nxt_conf_create_object(mp, 1);
+        if (nxt_slow_path(obj == NULL)) {
+            return NULL;
+        }
+
+        name.length = upstream[i].name.length;
+        name.start = nxt_pointer_to(report, (uintptr_t) upstream[i].name.start);
+
+        ret = nxt_conf_set_member_dup(upstreams, mp, &name, obj, i);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NULL;
+        }
+
+        servers = nxt_conf_create_object(mp, upstream[i].servers_count);
+        if (nxt_slow_path(servers == NULL)) {
+            return NULL;
+        }
+
+        nxt_conf_set_member(obj, &servers_str, servers, 0);
+
+        server = nxt_pointer_to(report, (uintptr_t) upstream[i].servers);
+
+        for (j = 0; j < upstream[i].servers_count; j++) {
+            server_obj = nxt_conf_create_object(mp, 2);
+            if (nxt_slow_path(server_obj == NULL)) {
+                return NULL;
+            }
+
+            name.length = server[j].address.length;
+            name.start = nxt_pointer_to(report,
+                                        (uintptr_t) server[j].address.start);
+
+            ret = nxt_conf_set_member_dup(servers, mp, &name, server_obj, j);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NULL;
+            }
+
+            nxt_conf_set_member_string(server_obj, &state_str,
+                                       &states[server[j].state], 0);
+            nxt_conf_set_member_integer(server_obj, &fails_str,
+                                        server[j].fails, 1);
+        }
+    }
+
     return status;
 }
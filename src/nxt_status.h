@@ -16,14 +16,49 @@ typedef struct {
 } nxt_status_app_t;
 
 
+typedef enum {
+    NXT_STATUS_SERVER_UP = 0,
+    NXT_STATUS_SERVER_DOWN,
+    NXT_STATUS_SERVER_UNHEALTHY,
+} nxt_status_server_state_t;
+
+
 typedef struct {
-    uint64_t          accepted_conns;
-    uint64_t          idle_conns;
-    uint64_t          closed_conns;
-    uint64_t          requests;
+    nxt_str_t                  address;
+    uint32_t                   fails;
+    nxt_status_server_state_t  state;
+} nxt_status_upstream_server_t;
+
+
+typedef struct {
+    nxt_str_t                     name;
+    uint32_t                      servers_count;
+    nxt_status_upstream_server_t  *servers;
+} nxt_status_upstream_t;
+
+
+typedef struct {
+    uint64_t               accepted_conns;
+    uint64_t               accept_events;
+    uint64_t               accept_latency;      /* usec */
+    uint64_t               accept_latency_max;  /* usec */
+} nxt_status_thread_t;
+
+
+typedef struct {
+    uint64_t               accepted_conns;
+    uint64_t               idle_conns;
+    uint64_t               closed_conns;
+    uint64_t               requests;
+
+    size_t                 threads_count;
+    nxt_status_thread_t    *threads;
+
+    size_t                 upstreams_count;
+    nxt_status_upstream_t  *upstreams;
 
-    size_t            apps_count;
-    nxt_status_app_t  apps[];
+    size_t                 apps_count;
+    nxt_status_app_t       apps[];
 } nxt_status_report_t;
 
 
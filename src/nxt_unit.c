@@ -99,6 +99,16 @@ static nxt_unit_mmap_buf_t *nxt_unit_request_preread(
     nxt_unit_request_info_t *req, size_t size);
 static ssize_t nxt_unit_buf_read(nxt_unit_buf_t **b, uint64_t *len, void *dst,
     size_t size);
+static ssize_t nxt_unit_request_stream_read(nxt_unit_request_info_t *req,
+    void *dst, size_t size, ssize_t res);
+static void nxt_unit_request_content_release(nxt_unit_request_info_t *req);
+static uint64_t nxt_unit_request_content_received(
+    nxt_unit_request_info_t *req);
+static int nxt_unit_request_content_wait(nxt_unit_request_info_t *req);
+static nxt_unit_read_buf_t *nxt_unit_request_content_pending(
+    nxt_unit_request_info_t *req);
+static int nxt_unit_send_req_body_ack(nxt_unit_request_info_t *req,
+    uint64_t offset);
 static nxt_port_mmap_header_t *nxt_unit_mmap_get(nxt_unit_ctx_t *ctx,
     nxt_unit_port_t *port, nxt_chunk_id_t *c, int *n, int min_n);
 static int nxt_unit_send_oosm(nxt_unit_ctx_t *ctx, nxt_unit_port_t *port);
@@ -254,6 +264,10 @@ struct nxt_unit_request_info_impl_s {
     nxt_unit_req_state_t     state;
     uint8_t                  websocket;
     uint8_t                  in_hash;
+    uint8_t                  content_aborted;
+
+    /*  the streamed content offset acknowledged to router */
+    uint64_t                 content_acked;
 
     /*  for nxt_unit_ctx_impl_t.free_req or active_req */
     nxt_queue_link_t         link;
@@ -1352,6 +1366,8 @@ nxt_unit_process_req_headers(nxt_unit_ctx_t *ctx, nxt_unit_recv_msg_t *recv_msg,
     req_impl->state = NXT_UNIT_RS_START;
     req_impl->websocket = 0;
     req_impl->in_hash = 0;
+    req_impl->content_aborted = 0;
+    req_impl->content_acked = 0;
 
     nxt_unit_debug(ctx, "#%"PRIu32": %.*s %.*s (%d)", recv_msg->stream,
                    (int) r->method_length,
@@ -1392,8 +1408,9 @@ nxt_unit_process_req_headers(nxt_unit_ctx_t *ctx, nxt_unit_recv_msg_t *recv_msg,
             /*
              * If application have separate data handler, we may start
              * request processing and process data when it is arrived.
+             * A streamed content is read by request handler on demand.
              */
-            if (lib->callbacks.data_handler == NULL) {
+            if (lib->callbacks.data_handler == NULL && !r->content_stream) {
                 return NXT_UNIT_OK;
             }
         }
@@ -1413,10 +1430,11 @@ nxt_unit_process_req_headers(nxt_unit_ctx_t *ctx, nxt_unit_recv_msg_t *recv_msg,
 static int
 nxt_unit_process_req_body(nxt_unit_ctx_t *ctx, nxt_unit_recv_msg_t *recv_msg)
 {
-    uint64_t                 l;
-    nxt_unit_impl_t          *lib;
-    nxt_unit_mmap_buf_t      *b;
-    nxt_unit_request_info_t  *req;
+    uint64_t                      l;
+    nxt_unit_impl_t               *lib;
+    nxt_unit_mmap_buf_t           *b;
+    nxt_unit_request_info_t       *req;
+    nxt_unit_request_info_impl_t  *req_impl;
 
     req = nxt_unit_request_hash_find(ctx, recv_msg->stream, recv_msg->last);
     if (req == NULL) {
@@ -1449,6 +1467,23 @@ nxt_unit_process_req_body(nxt_unit_ctx_t *ctx, nxt_unit_recv_msg_t *recv_msg)
 
     lib = nxt_container_of(ctx->unit, nxt_unit_impl_t, unit);
 
+    if (req->request->content_stream) {
+        if (recv_msg->last) {
+            nxt_unit_req_debug(req, "content stream aborted");
+
+            req_impl = nxt_container_of(req, nxt_unit_request_info_impl_t,
+                                        req);
+            req_impl->content_aborted = 1;
+        }
+
+        /* Request handler is already started and reads content itself. */
+        if (lib->callbacks.data_handler != NULL) {
+            lib->callbacks.data_handler(req);
+        }
+
+        return NXT_UNIT_OK;
+    }
+
     if (lib->callbacks.data_handler != NULL) {
         lib->callbacks.data_handler(req);
 
@@ -3075,6 +3110,10 @@ nxt_unit_request_read(nxt_unit_request_info_t *req, void *dst, size_t size)
     buf_res = nxt_unit_buf_read(&req->content_buf, &req->content_length,
                                 dst, size);
 
+    if (req->request->content_stream) {
+        return nxt_unit_request_stream_read(req, dst, size, buf_res);
+    }
+
     if (buf_res < (ssize_t) size && req->content_fd != -1) {
         res = read(req->content_fd, dst, size);
         if (nxt_slow_path(res < 0)) {
@@ -3102,6 +3141,299 @@ nxt_unit_request_read(nxt_unit_request_info_t *req, void *dst, size_t size)
 }
 
 
+/*
+ * A streamed content arrives in REQ_BODY messages while request handler
+ * reads it.  The consumed content is released and its offset is sent
+ * back to router which limits the content in flight by this offset.
+ */
+
+static ssize_t
+nxt_unit_request_stream_read(nxt_unit_request_info_t *req, void *dst,
+    size_t size, ssize_t res)
+{
+    nxt_unit_request_info_impl_t  *req_impl;
+
+    req_impl = nxt_container_of(req, nxt_unit_request_info_impl_t, req);
+
+    for ( ;; ) {
+        nxt_unit_request_content_release(req);
+
+        if ((size_t) res == size || req->content_length == 0) {
+            return res;
+        }
+
+        if (nxt_unit_request_content_wait(req) != NXT_UNIT_OK) {
+            break;
+        }
+
+        res += nxt_unit_buf_read(&req->content_buf, &req->content_length,
+                                 nxt_pointer_to(dst, res), size - res);
+    }
+
+    if (res == 0 && req_impl->content_aborted) {
+        nxt_unit_req_warn(req, "content stream is aborted");
+
+        return -1;
+    }
+
+    return res;
+}
+
+
+static void
+nxt_unit_request_content_release(nxt_unit_request_info_t *req)
+{
+    int                           released;
+    uint64_t                      offset;
+    nxt_unit_mmap_buf_t           *b, *request_buf;
+    nxt_unit_request_info_impl_t  *req_impl;
+
+    request_buf = nxt_container_of(req->request_buf, nxt_unit_mmap_buf_t, buf);
+
+    if (req->content_buf == req->request_buf) {
+        if (request_buf->buf.free != request_buf->buf.end
+            || request_buf->next == NULL)
+        {
+            return;
+        }
+
+        req->content_buf = &request_buf->next->buf;
+    }
+
+    released = 0;
+
+    for (b = request_buf->next; b != NULL; b = request_buf->next) {
+
+        if (&b->buf == req->content_buf) {
+            if (b->buf.free != b->buf.end || b->next == NULL) {
+                break;
+            }
+
+            req->content_buf = &b->next->buf;
+        }
+
+        nxt_unit_mmap_buf_free(b);
+
+        released = 1;
+    }
+
+    if (!released) {
+        return;
+    }
+
+    req_impl = nxt_container_of(req, nxt_unit_request_info_impl_t, req);
+
+    offset = req->request->content_length - req->content_length;
+
+    if (offset > req_impl->content_acked) {
+        (void) nxt_unit_send_req_body_ack(req, offset);
+    }
+}
+
+
+static uint64_t
+nxt_unit_request_content_received(nxt_unit_request_info_t *req)
+{
+    uint64_t        received;
+    nxt_unit_buf_t  *b;
+
+    received = req->request->content_length - req->content_length;
+
+    for (b = req->content_buf; b != NULL; b = nxt_unit_buf_next(b)) {
+        received += b->end - b->free;
+    }
+
+    return received;
+}
+
+
+static int
+nxt_unit_request_content_wait(nxt_unit_request_info_t *req)
+{
+    int                           rc, nevents;
+    uint64_t                      received;
+    struct pollfd                 pfd;
+    nxt_unit_ctx_t                *ctx;
+    nxt_port_msg_t                *port_msg;
+    nxt_unit_impl_t               *lib;
+    nxt_unit_ctx_impl_t           *ctx_impl;
+    nxt_unit_read_buf_t           *rbuf;
+    nxt_unit_request_info_impl_t  *req_impl;
+
+    ctx = req->ctx;
+    lib = nxt_container_of(ctx->unit, nxt_unit_impl_t, unit);
+    ctx_impl = nxt_container_of(ctx, nxt_unit_ctx_impl_t, ctx);
+    req_impl = nxt_container_of(req, nxt_unit_request_info_impl_t, req);
+
+    /* Data handler is called when the content arrives. */
+    if (lib->callbacks.data_handler != NULL || req_impl->content_aborted) {
+        return NXT_UNIT_AGAIN;
+    }
+
+    received = nxt_unit_request_content_received(req);
+
+    /*
+     * All the received content is acknowledged including not consumed one,
+     * otherwise a long line can stall the stream.
+     */
+    if (received > req_impl->content_acked) {
+        rc = nxt_unit_send_req_body_ack(req, received);
+        if (nxt_slow_path(rc != NXT_UNIT_OK)) {
+            return NXT_UNIT_ERROR;
+        }
+    }
+
+    nxt_unit_req_debug(req, "content wait: received %"PRIu64, received);
+
+    while (!req_impl->content_aborted) {
+        rbuf = nxt_unit_request_content_pending(req);
+
+        if (rbuf == NULL) {
+            rbuf = nxt_unit_read_buf_get(ctx);
+            if (nxt_slow_path(rbuf == NULL)) {
+                return NXT_UNIT_ERROR;
+            }
+
+            for ( ;; ) {
+                rc = nxt_unit_ctx_port_recv(ctx, ctx_impl->read_port, rbuf);
+                if (rc != NXT_UNIT_AGAIN) {
+                    break;
+                }
+
+                pfd.fd = ctx_impl->read_port->in_fd;
+                pfd.events = POLLIN;
+                pfd.revents = 0;
+
+                nevents = poll(&pfd, 1, -1);
+                if (nxt_slow_path(nevents == -1 && errno != EINTR)) {
+                    nxt_unit_alert(ctx, "poll(%d) failed: %s (%d)",
+                                   pfd.fd, strerror(errno), errno);
+
+                    rc = NXT_UNIT_ERROR;
+                    break;
+                }
+            }
+
+            if (nxt_slow_path(rc == NXT_UNIT_ERROR)) {
+                nxt_unit_read_buf_release(ctx, rbuf);
+
+                return NXT_UNIT_ERROR;
+            }
+
+            port_msg = (nxt_port_msg_t *) rbuf->buf;
+
+            if (rbuf->size < (ssize_t) sizeof(nxt_port_msg_t)
+                || (port_msg->type != _NXT_PORT_MSG_MMAP
+                    && (port_msg->type != _NXT_PORT_MSG_REQ_BODY
+                        || port_msg->stream != req_impl->stream)))
+            {
+                pthread_mutex_lock(&ctx_impl->mutex);
+
+                nxt_queue_insert_tail(&ctx_impl->pending_rbuf, &rbuf->link);
+
+                pthread_mutex_unlock(&ctx_impl->mutex);
+
+                if (rbuf->size < (ssize_t) sizeof(nxt_port_msg_t)
+                    || nxt_unit_is_quit(rbuf))
+                {
+                    nxt_unit_req_debug(req, "content wait: quit received");
+
+                    return NXT_UNIT_ERROR;
+                }
+
+                continue;
+            }
+        }
+
+        rc = nxt_unit_process_msg(ctx, rbuf, NULL);
+        if (nxt_slow_path(rc == NXT_UNIT_ERROR)) {
+            return NXT_UNIT_ERROR;
+        }
+
+        if (nxt_unit_request_content_received(req) > received) {
+            return NXT_UNIT_OK;
+        }
+    }
+
+    return NXT_UNIT_ERROR;
+}
+
+
+static nxt_unit_read_buf_t *
+nxt_unit_request_content_pending(nxt_unit_request_info_t *req)
+{
+    nxt_port_msg_t                *port_msg;
+    nxt_unit_ctx_impl_t           *ctx_impl;
+    nxt_unit_read_buf_t           *rbuf, *res;
+    nxt_unit_request_info_impl_t  *req_impl;
+
+    ctx_impl = nxt_container_of(req->ctx, nxt_unit_ctx_impl_t, ctx);
+    req_impl = nxt_container_of(req, nxt_unit_request_info_impl_t, req);
+
+    res = NULL;
+
+    pthread_mutex_lock(&ctx_impl->mutex);
+
+    nxt_queue_each(rbuf, &ctx_impl->pending_rbuf, nxt_unit_read_buf_t, link) {
+
+        port_msg = (nxt_port_msg_t *) rbuf->buf;
+
+        if (rbuf->size >= (ssize_t) sizeof(nxt_port_msg_t)
+            && port_msg->type == _NXT_PORT_MSG_REQ_BODY
+            && port_msg->stream == req_impl->stream)
+        {
+            nxt_queue_remove(&rbuf->link);
+
+            res = rbuf;
+            break;
+        }
+
+    } nxt_queue_loop;
+
+    pthread_mutex_unlock(&ctx_impl->mutex);
+
+    return res;
+}
+
+
+static int
+nxt_unit_send_req_body_ack(nxt_unit_request_info_t *req, uint64_t offset)
+{
+    ssize_t                       res;
+    nxt_unit_impl_t               *lib;
+    nxt_unit_ctx_impl_t           *ctx_impl;
+    nxt_unit_request_info_impl_t  *req_impl;
+
+    struct {
+        nxt_port_msg_t            msg;
+        uint64_t                  offset;
+    } m;
+
+    lib = nxt_container_of(req->ctx->unit, nxt_unit_impl_t, unit);
+    ctx_impl = nxt_container_of(req->ctx, nxt_unit_ctx_impl_t, ctx);
+    req_impl = nxt_container_of(req, nxt_unit_request_info_impl_t, req);
+
+    memset(&m.msg, 0, sizeof(nxt_port_msg_t));
+
+    m.msg.stream = req_impl->stream;
+    m.msg.pid = lib->pid;
+    m.msg.reply_port = ctx_impl->read_port->id.id;
+    m.msg.type = _NXT_PORT_MSG_REQ_BODY_ACK;
+
+    m.offset = offset;
+
+    res = nxt_unit_port_send(req->ctx, req->response_port,
+                             &m, sizeof(m), NULL);
+    if (nxt_slow_path(res != sizeof(m))) {
+        return NXT_UNIT_ERROR;
+    }
+
+    req_impl->content_acked = offset;
+
+    return NXT_UNIT_OK;
+}
+
+
 ssize_t
 nxt_unit_request_readline_size(nxt_unit_request_info_t *req, size_t max_size)
 {
@@ -3135,6 +3467,16 @@ nxt_unit_request_readline_size(nxt_unit_request_info_t *req, size_t max_size)
         }
 
         mmap_buf = nxt_container_of(b, nxt_unit_mmap_buf_t, buf);
+
+        if (mmap_buf->next == NULL
+            && req->request->content_stream
+            && l_size < req->content_length)
+        {
+            if (nxt_unit_request_content_wait(req) != NXT_UNIT_OK) {
+                break;
+            }
+        }
+
         if (mmap_buf->next == NULL
             && req->content_fd != -1
             && l_size < req->content_length)
@@ -4841,8 +5183,11 @@ nxt_unit_process_ready_req(nxt_unit_ctx_t *ctx)
             /*
              * If application have separate data handler, we may start
              * request processing and process data when it is arrived.
+             * A streamed content is read by request handler on demand.
              */
-            if (lib->callbacks.data_handler == NULL) {
+            if (lib->callbacks.data_handler == NULL
+                && !req->request->content_stream)
+            {
                 continue;
             }
         }
@@ -196,6 +196,10 @@
 
 #endif
 
+#if (NXT_HAVE_IO_URING)
+#include <linux/io_uring.h>
+#endif
+
 #if (NXT_HAVE_SIGNALFD)
 #include <sys/signalfd.h>
 #endif
@@ -63,6 +63,11 @@ nxt_upstreams_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         if (nxt_slow_path(ret != NXT_OK)) {
             return NXT_ERROR;
         }
+
+        ret = nxt_upstream_check_create(mp, upcf, &upstreams->upstream[i]);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
     }
 
     tmcf->router_conf->upstreams = upstreams;
@@ -143,6 +148,11 @@ nxt_upstream_handler(nxt_task_t *task, nxt_http_request_t *r,
 {
     nxt_upstream_t  *u;
 
+    if (r->body_rest != 0) {
+        nxt_http_request_body_complete(task, r, action);
+        return NULL;
+    }
+
     u = r->conf->upstreams[action->u.upstream_number];
 
     nxt_debug(task, "upstream handler: \"%V\"", &u->name);
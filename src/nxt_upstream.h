@@ -12,6 +12,7 @@ typedef struct nxt_upstream_proxy_s            nxt_upstream_proxy_t;
 typedef struct nxt_upstream_round_robin_s      nxt_upstream_round_robin_t;
 typedef struct nxt_upstream_round_robin_server_s
     nxt_upstream_round_robin_server_t;
+typedef struct nxt_upstream_check_s            nxt_upstream_check_t;
 
 
 typedef void (*nxt_upstream_peer_ready_t)(nxt_task_t *task,
@@ -30,14 +31,40 @@ typedef nxt_upstream_t *(*nxt_upstream_joint_create_t)(
     nxt_router_temp_conf_t *tmcf, nxt_upstream_t *upstream);
 typedef void (*nxt_upstream_server_get_t)(nxt_task_t *task,
     nxt_upstream_server_t *us);
+typedef void (*nxt_upstream_server_free_t)(nxt_task_t *task,
+    nxt_upstream_server_t *us, nxt_bool_t failed);
 
 
 typedef struct {
     nxt_upstream_joint_create_t                joint_create;
     nxt_upstream_server_get_t                  get;
+    nxt_upstream_server_free_t                 free;
 } nxt_upstream_server_proto_t;
 
 
+/*
+ * The server health state is shared by all engines.  The failures are
+ * counted by requests to the server if "max_fails" is set, and the
+ * "unhealthy" flag is set by active health checks.  The time of the
+ * last failure or retry is a word-sized atomic as well, so engines
+ * updating it concurrently just leave the latest time.
+ */
+
+typedef struct {
+    nxt_sockaddr_t                             *sockaddr;
+
+    nxt_atomic_t                               fails;
+    nxt_atomic_t                               checked;
+
+    uint32_t                                   max_fails;
+    nxt_msec_t                                 fail_timeout;
+
+    uint32_t                                   check_passes;
+    uint32_t                                   check_fails;
+    uint8_t                                    unhealthy;  /* 1 bit */
+} nxt_upstream_health_t;
+
+
 struct nxt_upstream_s {
     const nxt_upstream_server_proto_t          *proto;
 
@@ -46,6 +73,10 @@ struct nxt_upstream_s {
         nxt_upstream_round_robin_t             *round_robin;
     } type;
 
+    uint32_t                                   servers;
+    nxt_upstream_health_t                      *health;
+    nxt_upstream_check_t                       *check;
+
     nxt_str_t                                  name;
 };
 
@@ -77,5 +108,25 @@ nxt_int_t nxt_upstream_round_robin_create(nxt_task_t *task,
     nxt_router_temp_conf_t *tmcf, nxt_conf_value_t *upstream_conf,
     nxt_upstream_t *upstream);
 
+nxt_int_t nxt_upstream_check_create(nxt_mp_t *mp,
+    nxt_conf_value_t *upstream_conf, nxt_upstream_t *upstream);
+void nxt_upstream_checks_start(nxt_task_t *task, nxt_upstreams_t *upstreams,
+    nxt_queue_t *checks);
+void nxt_upstream_checks_stop(nxt_task_t *task, nxt_queue_t *checks);
+
+
+nxt_inline nxt_bool_t
+nxt_upstream_health_down(nxt_upstream_health_t *health, nxt_msec_t now)
+{
+    if (health->unhealthy) {
+        return 1;
+    }
+
+    return (health->max_fails != 0
+            && health->fails >= health->max_fails
+            && nxt_msec_diff(now, (nxt_msec_t) health->checked)
+               < (nxt_msec_int_t) health->fail_timeout);
+}
+
 
 #endif /* _NXT_UPSTREAM_H_INCLUDED_ */
@@ -0,0 +1,698 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include <nxt_upstream.h>
+
+
+struct nxt_upstream_check_s {
+    nxt_str_t                 uri;
+    nxt_msec_t                interval;
+    nxt_msec_t                timeout;
+    uint32_t                  passes;
+    uint32_t                  fails;
+};
+
+
+typedef struct nxt_upstream_checker_s  nxt_upstream_checker_t;
+
+
+typedef struct {
+    nxt_upstream_checker_t    *checker;
+    nxt_upstream_health_t     *health;
+    nxt_sockaddr_t            *sockaddr;
+    nxt_str_t                 request;
+    nxt_conn_t                *conn;
+} nxt_upstream_probe_t;
+
+
+/*
+ * The checkers run in the router main engine.  A checker is allocated
+ * from its own memory pool because probes still in progress can outlive
+ * the configuration, so the health state is updated only while the
+ * checker is not stopped.
+ */
+
+struct nxt_upstream_checker_s {
+    nxt_queue_link_t          link;
+    nxt_timer_t               timer;
+    nxt_mp_t                  *mem_pool;
+
+    nxt_str_t                 name;
+
+    nxt_msec_t                interval;
+    nxt_msec_t                timeout;
+    uint32_t                  passes;
+    uint32_t                  fails;
+
+    /* The checker itself and the probes in progress. */
+    uint32_t                  count;
+    uint8_t                   stopped;  /* 1 bit */
+
+    uint32_t                  probes;
+    nxt_upstream_probe_t      probe[0];
+};
+
+
+#define NXT_UPSTREAM_PROBE_BUFFER  256
+
+
+static nxt_upstream_checker_t *nxt_upstream_checker_create(nxt_task_t *task,
+    nxt_upstream_t *upstream);
+static void nxt_upstream_checker_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_checker_release_handler(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_checker_release(nxt_upstream_checker_t *checker);
+static void nxt_upstream_probe_start(nxt_task_t *task,
+    nxt_upstream_probe_t *probe);
+static void nxt_upstream_probe_send(nxt_task_t *task, void *obj, void *data);
+static void nxt_upstream_probe_sent(nxt_task_t *task, void *obj, void *data);
+static void nxt_upstream_probe_read(nxt_task_t *task, void *obj, void *data);
+static void nxt_upstream_probe_error(nxt_task_t *task, void *obj, void *data);
+static void nxt_upstream_probe_send_timeout(nxt_task_t *task, void *obj,
+    void *data);
+static void nxt_upstream_probe_read_timeout(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_msec_t nxt_upstream_probe_timer_value(nxt_conn_t *c,
+    uintptr_t data);
+static nxt_int_t nxt_upstream_probe_status(nxt_buf_t *b);
+static void nxt_upstream_probe_done(nxt_task_t *task, nxt_conn_t *c,
+    nxt_bool_t passed);
+static void nxt_upstream_probe_free(nxt_task_t *task, void *obj, void *data);
+
+
+static const nxt_conn_state_t  nxt_upstream_probe_connect_state;
+static const nxt_conn_state_t  nxt_upstream_probe_send_state;
+static const nxt_conn_state_t  nxt_upstream_probe_read_state;
+static const nxt_conn_state_t  nxt_upstream_probe_close_state;
+
+
+nxt_int_t
+nxt_upstream_check_create(nxt_mp_t *mp, nxt_conf_value_t *upstream_conf,
+    nxt_upstream_t *upstream)
+{
+    nxt_str_t             str;
+    nxt_conf_value_t      *conf, *value;
+    nxt_upstream_check_t  *check;
+
+    static nxt_str_t  health_check = nxt_string("health_check");
+    static nxt_str_t  uri = nxt_string("uri");
+    static nxt_str_t  interval = nxt_string("interval");
+    static nxt_str_t  timeout = nxt_string("timeout");
+    static nxt_str_t  passes = nxt_string("passes");
+    static nxt_str_t  fails = nxt_string("fails");
+
+    conf = nxt_conf_get_object_member(upstream_conf, &health_check, NULL);
+    if (conf == NULL) {
+        return NXT_OK;
+    }
+
+    check = nxt_mp_zget(mp, sizeof(nxt_upstream_check_t));
+    if (nxt_slow_path(check == NULL)) {
+        return NXT_ERROR;
+    }
+
+    nxt_str_set(&check->uri, "/");
+    check->interval = 5000;
+    check->timeout = 1000;
+    check->passes = 1;
+    check->fails = 1;
+
+    value = nxt_conf_get_object_member(conf, &uri, NULL);
+    if (value != NULL) {
+        nxt_conf_get_string(value, &str);
+
+        if (nxt_slow_path(nxt_str_dup(mp, &check->uri, &str) == NULL)) {
+            return NXT_ERROR;
+        }
+    }
+
+    value = nxt_conf_get_object_member(conf, &interval, NULL);
+    if (value != NULL) {
+        check->interval = nxt_conf_get_number(value) * 1000;
+    }
+
+    value = nxt_conf_get_object_member(conf, &timeout, NULL);
+    if (value != NULL) {
+        check->timeout = nxt_conf_get_number(value) * 1000;
+    }
+
+    value = nxt_conf_get_object_member(conf, &passes, NULL);
+    if (value != NULL) {
+        check->passes = nxt_conf_get_number(value);
+    }
+
+    value = nxt_conf_get_object_member(conf, &fails, NULL);
+    if (value != NULL) {
+        check->fails = nxt_conf_get_number(value);
+    }
+
+    upstream->check = check;
+
+    return NXT_OK;
+}
+
+
+void
+nxt_upstream_checks_start(nxt_task_t *task, nxt_upstreams_t *upstreams,
+    nxt_queue_t *checks)
+{
+    uint32_t                i;
+    nxt_upstream_t          *upstream;
+    nxt_event_engine_t      *engine;
+    nxt_upstream_checker_t  *checker;
+
+    if (upstreams == NULL) {
+        return;
+    }
+
+    engine = task->thread->engine;
+
+    for (i = 0; i < upstreams->items; i++) {
+        upstream = &upstreams->upstream[i];
+
+        if (upstream->check == NULL || upstream->servers == 0) {
+            continue;
+        }
+
+        checker = nxt_upstream_checker_create(task, upstream);
+        if (nxt_slow_path(checker == NULL)) {
+            nxt_alert(task, "failed to start health checks of "
+                      "upstream \"%V\"", &upstream->name);
+            continue;
+        }
+
+        nxt_queue_insert_tail(checks, &checker->link);
+
+        nxt_timer_add(engine, &checker->timer, 0);
+    }
+}
+
+
+void
+nxt_upstream_checks_stop(nxt_task_t *task, nxt_queue_t *checks)
+{
+    nxt_queue_link_t        *link;
+    nxt_event_engine_t      *engine;
+    nxt_upstream_checker_t  *checker;
+
+    engine = task->thread->engine;
+
+    while (!nxt_queue_is_empty(checks)) {
+        link = nxt_queue_first(checks);
+        nxt_queue_remove(link);
+
+        checker = nxt_queue_link_data(link, nxt_upstream_checker_t, link);
+
+        nxt_debug(task, "upstream \"%V\" health checks stop", &checker->name);
+
+        checker->stopped = 1;
+
+        if (nxt_timer_delete(engine, &checker->timer)) {
+            checker->timer.handler = nxt_upstream_checker_release_handler;
+            nxt_timer_add(engine, &checker->timer, 0);
+
+        } else {
+            nxt_upstream_checker_release(checker);
+        }
+    }
+}
+
+
+static nxt_upstream_checker_t *
+nxt_upstream_checker_create(nxt_task_t *task, nxt_upstream_t *upstream)
+{
+    u_char                  *p;
+    size_t                  size;
+    uint32_t                i;
+    nxt_mp_t                *mp;
+    nxt_str_t               host;
+    nxt_sockaddr_t          *sa;
+    nxt_event_engine_t      *engine;
+    nxt_upstream_probe_t    *probe;
+    nxt_upstream_check_t    *check;
+    nxt_upstream_checker_t  *checker;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return NULL;
+    }
+
+    size = sizeof(nxt_upstream_checker_t)
+           + upstream->servers * sizeof(nxt_upstream_probe_t);
+
+    checker = nxt_mp_zalloc(mp, size);
+    if (nxt_slow_path(checker == NULL)) {
+        goto fail;
+    }
+
+    checker->mem_pool = mp;
+
+    if (nxt_slow_path(nxt_str_dup(mp, &checker->name, &upstream->name)
+                      == NULL))
+    {
+        goto fail;
+    }
+
+    check = upstream->check;
+
+    checker->interval = check->interval;
+    checker->timeout = check->timeout;
+    checker->passes = check->passes;
+    checker->fails = check->fails;
+    checker->count = 1;
+    checker->probes = upstream->servers;
+
+    for (i = 0; i < upstream->servers; i++) {
+        probe = &checker->probe[i];
+
+        probe->checker = checker;
+        probe->health = &upstream->health[i];
+
+        /* The copy includes the textual representation. */
+
+        size = upstream->health[i].sockaddr->start
+               + upstream->health[i].sockaddr->length;
+
+        sa = nxt_mp_alloc(mp, size);
+        if (nxt_slow_path(sa == NULL)) {
+            goto fail;
+        }
+
+        nxt_memcpy(sa, upstream->health[i].sockaddr, size);
+
+        probe->sockaddr = sa;
+
+#if (NXT_HAVE_UNIX_DOMAIN)
+        if (sa->u.sockaddr.sa_family == AF_UNIX) {
+            nxt_str_set(&host, "localhost");
+
+        } else
+#endif
+        {
+            host.length = sa->length;
+            host.start = nxt_sockaddr_start(sa);
+        }
+
+        size = nxt_length("GET  HTTP/1.1\r\n")
+               + check->uri.length
+               + nxt_length("Host: \r\n") + host.length
+               + nxt_length("Connection: close\r\n\r\n");
+
+        p = nxt_mp_nget(mp, size);
+        if (nxt_slow_path(p == NULL)) {
+            goto fail;
+        }
+
+        probe->request.start = p;
+
+        p = nxt_sprintf(p, p + size, "GET %V HTTP/1.1\r\n"
+                                     "Host: %V\r\n"
+                                     "Connection: close\r\n\r\n",
+                        &check->uri, &host);
+
+        probe->request.length = p - probe->request.start;
+    }
+
+    engine = task->thread->engine;
+
+    checker->timer.bias = NXT_TIMER_DEFAULT_BIAS;
+    checker->timer.work_queue = &engine->fast_work_queue;
+    checker->timer.handler = nxt_upstream_checker_handler;
+    checker->timer.task = &engine->task;
+    checker->timer.log = engine->task.log;
+
+    return checker;
+
+fail:
+
+    nxt_mp_destroy(mp);
+
+    return NULL;
+}
+
+
+static void
+nxt_upstream_checker_handler(nxt_task_t *task, void *obj, void *data)
+{
+    uint32_t                i;
+    nxt_timer_t             *timer;
+    nxt_upstream_probe_t    *probe;
+    nxt_upstream_checker_t  *checker;
+
+    timer = obj;
+
+    checker = nxt_timer_data(timer, nxt_upstream_checker_t, timer);
+
+    nxt_debug(task, "upstream \"%V\" health checks", &checker->name);
+
+    for (i = 0; i < checker->probes; i++) {
+        probe = &checker->probe[i];
+
+        /* A probe still in progress is limited by the timeout. */
+
+        if (probe->conn == NULL) {
+            nxt_upstream_probe_start(task, probe);
+        }
+    }
+
+    nxt_timer_add(task->thread->engine, &checker->timer, checker->interval);
+}
+
+
+static void
+nxt_upstream_checker_release_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_timer_t             *timer;
+    nxt_upstream_checker_t  *checker;
+
+    timer = obj;
+
+    checker = nxt_timer_data(timer, nxt_upstream_checker_t, timer);
+
+    nxt_upstream_checker_release(checker);
+}
+
+
+static void
+nxt_upstream_checker_release(nxt_upstream_checker_t *checker)
+{
+    if (--checker->count == 0) {
+        nxt_mp_destroy(checker->mem_pool);
+    }
+}
+
+
+static void
+nxt_upstream_probe_start(nxt_task_t *task, nxt_upstream_probe_t *probe)
+{
+    nxt_mp_t    *mp;
+    nxt_conn_t  *c;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (nxt_slow_path(mp == NULL)) {
+        return;
+    }
+
+    c = nxt_conn_create(mp, task);
+    if (nxt_slow_path(c == NULL)) {
+        nxt_mp_destroy(mp);
+        return;
+    }
+
+    c->remote = probe->sockaddr;
+    c->socket.data = probe;
+    c->read_work_queue = c->socket.read_work_queue;
+    c->write_work_queue = c->socket.write_work_queue;
+    c->socket.write_ready = 1;
+    c->write_state = &nxt_upstream_probe_connect_state;
+
+    probe->conn = c;
+    probe->checker->count++;
+
+    nxt_conn_connect(task->thread->engine, c);
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_probe_connect_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_probe_send,
+    .close_handler = nxt_upstream_probe_error,
+    .error_handler = nxt_upstream_probe_error,
+
+    .timer_handler = nxt_upstream_probe_send_timeout,
+    .timer_value = nxt_upstream_probe_timer_value,
+};
+
+
+static void
+nxt_upstream_probe_send(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t             *b;
+    nxt_conn_t            *c;
+    nxt_upstream_probe_t  *probe;
+
+    c = obj;
+    probe = data;
+
+    b = nxt_buf_mem_alloc(c->mem_pool, probe->request.length, 0);
+    if (nxt_slow_path(b == NULL)) {
+        nxt_upstream_probe_done(task, c, 0);
+        return;
+    }
+
+    b->mem.free = nxt_cpymem(b->mem.free, probe->request.start,
+                             probe->request.length);
+
+    c->write = b;
+    c->write_state = &nxt_upstream_probe_send_state;
+
+    nxt_conn_write(task->thread->engine, c);
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_probe_send_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_probe_sent,
+    .close_handler = nxt_upstream_probe_error,
+    .error_handler = nxt_upstream_probe_error,
+
+    .timer_handler = nxt_upstream_probe_send_timeout,
+    .timer_value = nxt_upstream_probe_timer_value,
+};
+
+
+static void
+nxt_upstream_probe_sent(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_buf_t   *b;
+    nxt_conn_t  *c;
+
+    c = obj;
+
+    b = nxt_buf_mem_alloc(c->mem_pool, NXT_UPSTREAM_PROBE_BUFFER, 0);
+    if (nxt_slow_path(b == NULL)) {
+        nxt_upstream_probe_done(task, c, 0);
+        return;
+    }
+
+    c->read = b;
+    c->read_state = &nxt_upstream_probe_read_state;
+
+    nxt_conn_read(task->thread->engine, c);
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_probe_read_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_probe_read,
+    .close_handler = nxt_upstream_probe_read,
+    .error_handler = nxt_upstream_probe_error,
+
+    .timer_handler = nxt_upstream_probe_read_timeout,
+    .timer_value = nxt_upstream_probe_timer_value,
+};
+
+
+static void
+nxt_upstream_probe_read(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_int_t   status;
+    nxt_buf_t   *b;
+    nxt_conn_t  *c;
+
+    c = obj;
+    b = c->read;
+
+    status = nxt_upstream_probe_status(b);
+
+    if (status == NXT_AGAIN
+        && !c->socket.closed
+        && b->mem.free < b->mem.end)
+    {
+        nxt_conn_read(task->thread->engine, c);
+        return;
+    }
+
+    nxt_debug(task, "upstream probe status: %i", status);
+
+    nxt_upstream_probe_done(task, c, status >= 200 && status < 400);
+}
+
+
+static nxt_int_t
+nxt_upstream_probe_status(nxt_buf_t *b)
+{
+    u_char     *p;
+    nxt_int_t  status;
+
+    /* "HTTP/1.x 200 " */
+
+    if (b->mem.free - b->mem.pos < 13) {
+        return NXT_AGAIN;
+    }
+
+    p = b->mem.pos;
+
+    if (nxt_slow_path(memcmp(p, "HTTP/1.", 7) != 0 || p[8] != ' ')) {
+        return NXT_ERROR;
+    }
+
+    status = nxt_int_parse(&p[9], 3);
+
+    if (nxt_slow_path(status < 100 || p[12] != ' ')) {
+        return NXT_ERROR;
+    }
+
+    return status;
+}
+
+
+static void
+nxt_upstream_probe_error(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t  *c;
+
+    c = obj;
+
+    nxt_debug(task, "upstream probe error");
+
+    nxt_upstream_probe_done(task, c, 0);
+}
+
+
+static void
+nxt_upstream_probe_send_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    nxt_debug(task, "upstream probe send timeout");
+
+    c = nxt_write_timer_conn(timer);
+    c->block_write = 1;
+    c->block_read = 1;
+
+    nxt_upstream_probe_done(task, c, 0);
+}
+
+
+static void
+nxt_upstream_probe_read_timeout(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t   *c;
+    nxt_timer_t  *timer;
+
+    timer = obj;
+
+    nxt_debug(task, "upstream probe read timeout");
+
+    c = nxt_read_timer_conn(timer);
+    c->block_write = 1;
+    c->block_read = 1;
+
+    nxt_upstream_probe_done(task, c, 0);
+}
+
+
+static nxt_msec_t
+nxt_upstream_probe_timer_value(nxt_conn_t *c, uintptr_t data)
+{
+    nxt_upstream_probe_t  *probe;
+
+    probe = c->socket.data;
+
+    return probe->checker->timeout;
+}
+
+
+static void
+nxt_upstream_probe_done(nxt_task_t *task, nxt_conn_t *c, nxt_bool_t passed)
+{
+    nxt_upstream_probe_t    *probe;
+    nxt_upstream_health_t   *health;
+    nxt_upstream_checker_t  *checker;
+
+    probe = c->socket.data;
+    checker = probe->checker;
+
+    probe->conn = NULL;
+
+    if (!checker->stopped) {
+        health = probe->health;
+
+        if (passed) {
+            health->check_fails = 0;
+            health->check_passes++;
+
+            if (health->unhealthy
+                && health->check_passes >= checker->passes)
+            {
+                health->unhealthy = 0;
+
+                nxt_log(task, NXT_LOG_NOTICE, "upstream \"%V\" server %*s "
+                        "is healthy", &checker->name,
+                        (size_t) probe->sockaddr->length,
+                        nxt_sockaddr_start(probe->sockaddr));
+            }
+
+        } else {
+            health->check_passes = 0;
+            health->check_fails++;
+
+            if (!health->unhealthy
+                && health->check_fails >= checker->fails)
+            {
+                health->unhealthy = 1;
+
+                nxt_log(task, NXT_LOG_WARN, "upstream \"%V\" server %*s "
+                        "is unhealthy", &checker->name,
+                        (size_t) probe->sockaddr->length,
+                        nxt_sockaddr_start(probe->sockaddr));
+            }
+        }
+    }
+
+    c->read_state = &nxt_upstream_probe_close_state;
+    c->write_state = &nxt_upstream_probe_close_state;
+
+    if (c->socket.fd != -1) {
+        nxt_conn_close(task->thread->engine, c);
+
+    } else {
+        nxt_upstream_probe_free(task, c, probe);
+    }
+}
+
+
+static const nxt_conn_state_t  nxt_upstream_probe_close_state
+    nxt_aligned(64) =
+{
+    .ready_handler = nxt_upstream_probe_free,
+};
+
+
+static void
+nxt_upstream_probe_free(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t            *c;
+    nxt_upstream_probe_t  *probe;
+
+    c = obj;
+    probe = data;
+
+    nxt_debug(task, "upstream probe free");
+
+    nxt_conn_free(task, c);
+
+    nxt_upstream_checker_release(probe->checker);
+}
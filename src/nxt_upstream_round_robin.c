@@ -17,25 +17,83 @@ struct nxt_upstream_round_robin_server_s {
     int32_t                            effective_weight;
     int32_t                            weight;
 
+    /* Active connections shared by all engines, least_connections only. */
+    nxt_atomic_t                       *conns;
+    nxt_upstream_health_t              *health;
+
     uint8_t                            protocol;
 };
 
 
+typedef struct {
+    uint32_t                           hash;
+    uint32_t                           server;
+} nxt_upstream_hash_point_t;
+
+
 struct nxt_upstream_round_robin_s {
     uint32_t                           items;
+
+    nxt_tstr_t                         *hash;
+    nxt_upstream_hash_point_t          *points;
+    uint32_t                           points_n;
+
     nxt_upstream_round_robin_server_t  server[0];
 };
 
 
+typedef struct {
+    nxt_upstream_server_t              *us;
+    nxt_str_t                          key;
+} nxt_upstream_hash_ctx_t;
+
+
+#define NXT_UPSTREAM_HASH_POINTS      160
+#define NXT_UPSTREAM_HASH_POINTS_MAX  (NXT_UPSTREAM_HASH_POINTS * 100)
+
+
 static nxt_upstream_t *nxt_upstream_round_robin_joint_create(
     nxt_router_temp_conf_t *tmcf, nxt_upstream_t *upstream);
 static void nxt_upstream_round_robin_server_get(nxt_task_t *task,
     nxt_upstream_server_t *us);
+static void nxt_upstream_round_robin_server_use(nxt_task_t *task,
+    nxt_upstream_server_t *us, nxt_upstream_round_robin_server_t *s);
+static void nxt_upstream_round_robin_server_free(nxt_task_t *task,
+    nxt_upstream_server_t *us, nxt_bool_t failed);
+static nxt_int_t nxt_upstream_least_conn_create(nxt_mp_t *mp,
+    nxt_upstream_round_robin_t *urr);
+static void nxt_upstream_least_conn_server_get(nxt_task_t *task,
+    nxt_upstream_server_t *us);
+static nxt_int_t nxt_upstream_hash_create(nxt_mp_t *mp,
+    nxt_upstream_round_robin_t *urr, nxt_conf_value_t *servers_conf,
+    double total);
+static uint32_t nxt_upstream_hash_points(double weight);
+static int nxt_cdecl nxt_upstream_hash_point_cmp(const void *one,
+    const void *two);
+static void nxt_upstream_hash_server_get(nxt_task_t *task,
+    nxt_upstream_server_t *us);
+static void nxt_upstream_hash_ready(nxt_task_t *task, void *obj, void *data);
+static void nxt_upstream_hash_error(nxt_task_t *task, void *obj, void *data);
 
 
 static const nxt_upstream_server_proto_t  nxt_upstream_round_robin_proto = {
     .joint_create = nxt_upstream_round_robin_joint_create,
     .get          = nxt_upstream_round_robin_server_get,
+    .free         = nxt_upstream_round_robin_server_free,
+};
+
+
+static const nxt_upstream_server_proto_t  nxt_upstream_least_conn_proto = {
+    .joint_create = nxt_upstream_round_robin_joint_create,
+    .get          = nxt_upstream_least_conn_server_get,
+    .free         = nxt_upstream_round_robin_server_free,
+};
+
+
+static const nxt_upstream_server_proto_t  nxt_upstream_hash_proto = {
+    .joint_create = nxt_upstream_round_robin_joint_create,
+    .get          = nxt_upstream_hash_server_get,
+    .free         = nxt_upstream_round_robin_server_free,
 };
 
 
@@ -47,15 +105,23 @@ nxt_upstream_round_robin_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
     size_t                      size;
     uint32_t                    i, n, next, wt;
     nxt_mp_t                    *mp;
-    nxt_str_t                   name;
+    nxt_int_t                   ret;
+    nxt_str_t                   name, str;
     nxt_sockaddr_t              *sa;
-    nxt_conf_value_t            *servers_conf, *srvcf, *wtcf;
+    nxt_conf_value_t            *servers_conf, *srvcf, *wtcf, *value;
+    nxt_router_conf_t           *rtcf;
+    nxt_upstream_health_t       *health;
     nxt_upstream_round_robin_t  *urr;
 
     static nxt_str_t  servers = nxt_string("servers");
     static nxt_str_t  weight = nxt_string("weight");
+    static nxt_str_t  max_fails = nxt_string("max_fails");
+    static nxt_str_t  fail_timeout = nxt_string("fail_timeout");
+    static nxt_str_t  balancing = nxt_string("balancing");
+    static nxt_str_t  hash = nxt_string("hash");
 
-    mp = tmcf->router_conf->mem_pool;
+    rtcf = tmcf->router_conf;
+    mp = rtcf->mem_pool;
 
     servers_conf = nxt_conf_get_object_member(upstream_conf, &servers, NULL);
     n = nxt_conf_object_members_count(servers_conf);
@@ -88,6 +154,11 @@ nxt_upstream_round_robin_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
         return NXT_ERROR;
     }
 
+    health = nxt_mp_zget(mp, n * sizeof(nxt_upstream_health_t));
+    if (nxt_slow_path(health == NULL && n != 0)) {
+        return NXT_ERROR;
+    }
+
     urr->items = n;
     next = 0;
 
@@ -103,6 +174,20 @@ nxt_upstream_round_robin_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 
         urr->server[i].sockaddr = sa;
         urr->server[i].protocol = NXT_HTTP_PROTO_H1;
+        urr->server[i].health = &health[i];
+
+        health[i].sockaddr = sa;
+        health[i].fail_timeout = 10000;
+
+        value = nxt_conf_get_object_member(srvcf, &max_fails, NULL);
+        if (value != NULL) {
+            health[i].max_fails = nxt_conf_get_number(value);
+        }
+
+        value = nxt_conf_get_object_member(srvcf, &fail_timeout, NULL);
+        if (value != NULL) {
+            health[i].fail_timeout = nxt_conf_get_number(value) * 1000;
+        }
 
         wtcf = nxt_conf_get_object_member(srvcf, &weight, NULL);
         w = (wtcf != NULL) ? k * nxt_conf_get_number(wtcf) : k;
@@ -114,6 +199,43 @@ nxt_upstream_round_robin_create(nxt_task_t *task, nxt_router_temp_conf_t *tmcf,
 
     upstream->proto = &nxt_upstream_round_robin_proto;
     upstream->type.round_robin = urr;
+    upstream->servers = n;
+    upstream->health = health;
+
+    value = nxt_conf_get_object_member(upstream_conf, &hash, NULL);
+
+    if (value != NULL) {
+        nxt_conf_get_string(value, &str);
+
+        urr->hash = nxt_tstr_compile(rtcf->tstr_state, &str, 0);
+        if (nxt_slow_path(urr->hash == NULL)) {
+            return NXT_ERROR;
+        }
+
+        ret = nxt_upstream_hash_create(mp, urr, servers_conf, total);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            return NXT_ERROR;
+        }
+
+        upstream->proto = &nxt_upstream_hash_proto;
+
+        return NXT_OK;
+    }
+
+    value = nxt_conf_get_object_member(upstream_conf, &balancing, NULL);
+
+    if (value != NULL) {
+        nxt_conf_get_string(value, &str);
+
+        if (nxt_str_eq(&str, "least_connections", 17)) {
+            ret = nxt_upstream_least_conn_create(mp, urr);
+            if (nxt_slow_path(ret != NXT_OK)) {
+                return NXT_ERROR;
+            }
+
+            upstream->proto = &nxt_upstream_least_conn_proto;
+        }
+    }
 
     return NXT_OK;
 }
@@ -153,6 +275,10 @@ nxt_upstream_round_robin_joint_create(nxt_router_temp_conf_t *tmcf,
     n = urrcf->items;
     urr->items = n;
 
+    urr->hash = urrcf->hash;
+    urr->points = urrcf->points;
+    urr->points_n = urrcf->points_n;
+
     for (i = 0; i < n; i++) {
         urr->server[i] = urrcf->server[i];
     }
@@ -166,6 +292,7 @@ nxt_upstream_round_robin_server_get(nxt_task_t *task, nxt_upstream_server_t *us)
 {
     int32_t                            total;
     uint32_t                           i, n;
+    nxt_msec_t                         now;
     nxt_upstream_round_robin_t         *round_robin;
     nxt_upstream_round_robin_server_t  *s, *best;
 
@@ -177,8 +304,14 @@ nxt_upstream_round_robin_server_get(nxt_task_t *task, nxt_upstream_server_t *us)
     s = round_robin->server;
     n = round_robin->items;
 
+    now = task->thread->engine->timers.now;
+
     for (i = 0; i < n; i++) {
 
+        if (nxt_upstream_health_down(s[i].health, now)) {
+            continue;
+        }
+
         s[i].current_weight += s[i].effective_weight;
         total += s[i].effective_weight;
 
@@ -197,9 +330,413 @@ nxt_upstream_round_robin_server_get(nxt_task_t *task, nxt_upstream_server_t *us)
     }
 
     best->current_weight -= total;
-    us->sockaddr = best->sockaddr;
-    us->protocol = best->protocol;
-    us->server.round_robin = best;
+
+    nxt_upstream_round_robin_server_use(task, us, best);
+}
+
+
+static void
+nxt_upstream_round_robin_server_use(nxt_task_t *task, nxt_upstream_server_t *us,
+    nxt_upstream_round_robin_server_t *s)
+{
+    nxt_upstream_health_t  *health;
+
+    health = s->health;
+
+    /*
+     * A failed server is given a single request after the "fail_timeout"
+     * period, the next one is allowed only after another period.
+     */
+
+    if (health->max_fails != 0 && health->fails >= health->max_fails) {
+        health->checked = task->thread->engine->timers.now;
+    }
+
+    if (s->conns != NULL) {
+        (void) nxt_atomic_fetch_add(s->conns, 1);
+    }
+
+    us->sockaddr = s->sockaddr;
+    us->protocol = s->protocol;
+    us->server.round_robin = s;
 
     us->state->ready(task, us);
 }
+
+
+static void
+nxt_upstream_round_robin_server_free(nxt_task_t *task,
+    nxt_upstream_server_t *us, nxt_bool_t failed)
+{
+    nxt_atomic_uint_t                  fails;
+    nxt_upstream_health_t              *health;
+    nxt_upstream_round_robin_server_t  *s;
+
+    s = us->server.round_robin;
+
+    if (s == NULL) {
+        return;
+    }
+
+    us->server.round_robin = NULL;
+
+    if (s->conns != NULL) {
+        (void) nxt_atomic_fetch_add(s->conns, -1);
+    }
+
+    health = s->health;
+
+    if (health->max_fails == 0) {
+        return;
+    }
+
+    if (!failed) {
+        if (health->fails != 0) {
+            health->fails = 0;
+        }
+
+        return;
+    }
+
+    health->checked = task->thread->engine->timers.now;
+
+    fails = nxt_atomic_fetch_add(&health->fails, 1) + 1;
+
+    if (fails == health->max_fails) {
+        nxt_log(task, NXT_LOG_WARN, "upstream \"%V\" server %*s is "
+                "temporarily disabled", &us->upstream->name,
+                (size_t) s->sockaddr->length, nxt_sockaddr_start(s->sockaddr));
+    }
+}
+
+
+/*
+ * Each server keeps a single connection counter shared by all engines,
+ * so the choice takes into account the whole router load, while the
+ * smooth weighted round robin state stays per engine and is used to
+ * spread requests between servers with equal load.
+ */
+
+static nxt_int_t
+nxt_upstream_least_conn_create(nxt_mp_t *mp, nxt_upstream_round_robin_t *urr)
+{
+    uint32_t      i;
+    nxt_atomic_t  *conns;
+
+    conns = nxt_mp_zget(mp, urr->items * sizeof(nxt_atomic_t));
+    if (nxt_slow_path(conns == NULL && urr->items != 0)) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < urr->items; i++) {
+        urr->server[i].conns = &conns[i];
+    }
+
+    return NXT_OK;
+}
+
+
+static void
+nxt_upstream_least_conn_server_get(nxt_task_t *task, nxt_upstream_server_t *us)
+{
+    int32_t                            total;
+    uint32_t                           i, n;
+    nxt_msec_t                         now;
+    nxt_atomic_int_t                   conns, best_conns;
+    nxt_upstream_round_robin_t         *round_robin;
+    nxt_upstream_round_robin_server_t  *s, *best, *least;
+
+    least = NULL;
+    best_conns = 0;
+
+    round_robin = us->upstream->type.round_robin;
+
+    s = round_robin->server;
+    n = round_robin->items;
+
+    now = task->thread->engine->timers.now;
+
+    for (i = 0; i < n; i++) {
+
+        if (s[i].weight == 0 || nxt_upstream_health_down(s[i].health, now)) {
+            continue;
+        }
+
+        conns = *s[i].conns;
+
+        /* conns / weight < best_conns / least->weight */
+
+        if (least == NULL
+            || (int64_t) conns * least->weight
+               < (int64_t) best_conns * s[i].weight)
+        {
+            least = &s[i];
+            best_conns = conns;
+        }
+    }
+
+    if (least == NULL) {
+        us->state->error(task, us);
+        return;
+    }
+
+    best = NULL;
+    total = 0;
+
+    for (i = 0; i < n; i++) {
+
+        if (s[i].weight == 0
+            || (int64_t) *s[i].conns * least->weight
+               != (int64_t) best_conns * s[i].weight
+            || nxt_upstream_health_down(s[i].health, now))
+        {
+            continue;
+        }
+
+        s[i].current_weight += s[i].effective_weight;
+        total += s[i].effective_weight;
+
+        if (s[i].effective_weight < s[i].weight) {
+            s[i].effective_weight++;
+        }
+
+        if (best == NULL || s[i].current_weight > best->current_weight) {
+            best = &s[i];
+        }
+    }
+
+    if (best == NULL) {
+        best = least;
+
+    } else {
+        best->current_weight -= total;
+    }
+
+    nxt_upstream_round_robin_server_use(task, us, best);
+}
+
+
+/*
+ * The consistent hash ring contains NXT_UPSTREAM_HASH_POINTS points
+ * per unit of server weight.  The number of points of a server depends
+ * only on its own weight, so adding or removing a server remaps only
+ * the keys of its own ring segments.
+ */
+
+static nxt_int_t
+nxt_upstream_hash_create(nxt_mp_t *mp, nxt_upstream_round_robin_t *urr,
+    nxt_conf_value_t *servers_conf, double total)
+{
+    double                     w;
+    uint32_t                   i, j, n, next, points, key[2];
+    nxt_str_t                  name;
+    nxt_conf_value_t           *srvcf, *wtcf;
+    nxt_upstream_hash_point_t  *point;
+
+    static nxt_str_t  weight = nxt_string("weight");
+
+    n = urr->items;
+
+    if (n == 0 || total == 0) {
+        return NXT_OK;
+    }
+
+    points = 0;
+    next = 0;
+
+    for (i = 0; i < n; i++) {
+        srvcf = nxt_conf_next_object_member(servers_conf, &name, &next);
+        wtcf = nxt_conf_get_object_member(srvcf, &weight, NULL);
+        w = (wtcf != NULL) ? nxt_conf_get_number(wtcf) : 1;
+
+        if (w != 0) {
+            points += nxt_upstream_hash_points(w);
+        }
+    }
+
+    urr->points = nxt_mp_alloc(mp, points * sizeof(nxt_upstream_hash_point_t));
+    if (nxt_slow_path(urr->points == NULL)) {
+        return NXT_ERROR;
+    }
+
+    point = urr->points;
+    next = 0;
+
+    for (i = 0; i < n; i++) {
+        srvcf = nxt_conf_next_object_member(servers_conf, &name, &next);
+        wtcf = nxt_conf_get_object_member(srvcf, &weight, NULL);
+        w = (wtcf != NULL) ? nxt_conf_get_number(wtcf) : 1;
+
+        if (w == 0) {
+            continue;
+        }
+
+        key[0] = nxt_murmur_hash2(name.start, name.length);
+
+        points = nxt_upstream_hash_points(w);
+
+        for (j = 0; j < points; j++) {
+            key[1] = j;
+
+            point->hash = nxt_murmur_hash2(key, sizeof(key));
+            point->server = i;
+            point++;
+        }
+    }
+
+    urr->points_n = point - urr->points;
+
+    nxt_qsort(urr->points, urr->points_n, sizeof(nxt_upstream_hash_point_t),
+              nxt_upstream_hash_point_cmp);
+
+    return NXT_OK;
+}
+
+
+static uint32_t
+nxt_upstream_hash_points(double weight)
+{
+    double  points;
+
+    /* The ring size is limited, so weights above 100 get equal shares. */
+
+    points = round(NXT_UPSTREAM_HASH_POINTS * weight);
+
+    return nxt_max(1, nxt_min(points, NXT_UPSTREAM_HASH_POINTS_MAX));
+}
+
+
+static int nxt_cdecl
+nxt_upstream_hash_point_cmp(const void *one, const void *two)
+{
+    const nxt_upstream_hash_point_t  *first, *second;
+
+    first = one;
+    second = two;
+
+    if (first->hash != second->hash) {
+        return (first->hash < second->hash) ? -1 : 1;
+    }
+
+    return (first->server < second->server) ? -1
+                                              : (first->server > second->server);
+}
+
+
+static void
+nxt_upstream_hash_server_get(nxt_task_t *task, nxt_upstream_server_t *us)
+{
+    nxt_int_t                   ret;
+    nxt_router_conf_t           *rtcf;
+    nxt_http_request_t          *r;
+    nxt_upstream_hash_ctx_t     *ctx;
+    nxt_upstream_round_robin_t  *round_robin;
+
+    r = us->peer.http->request;
+    round_robin = us->upstream->type.round_robin;
+
+    ctx = nxt_mp_get(r->mem_pool, sizeof(nxt_upstream_hash_ctx_t));
+    if (nxt_slow_path(ctx == NULL)) {
+        us->state->error(task, us);
+        return;
+    }
+
+    ctx->us = us;
+
+    if (nxt_tstr_is_const(round_robin->hash)) {
+        nxt_tstr_str(round_robin->hash, &ctx->key);
+        nxt_upstream_hash_ready(task, r, ctx);
+        return;
+    }
+
+    rtcf = r->conf->socket_conf->router_conf;
+
+    ret = nxt_tstr_query_init(&r->tstr_query, rtcf->tstr_state,
+                              &r->tstr_cache, r, r->mem_pool);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        us->state->error(task, us);
+        return;
+    }
+
+    nxt_tstr_query(task, r->tstr_query, round_robin->hash, &ctx->key);
+
+    nxt_tstr_query_resolve(task, r->tstr_query, ctx, nxt_upstream_hash_ready,
+                           nxt_upstream_hash_error);
+}
+
+
+static void
+nxt_upstream_hash_ready(nxt_task_t *task, void *obj, void *data)
+{
+    uint32_t                           i, hash, left, right, middle;
+    nxt_msec_t                         now;
+    nxt_upstream_server_t              *us;
+    nxt_upstream_hash_ctx_t            *ctx;
+    nxt_upstream_hash_point_t          *points;
+    nxt_upstream_round_robin_t         *round_robin;
+    nxt_upstream_round_robin_server_t  *s;
+
+    ctx = data;
+    us = ctx->us;
+
+    round_robin = us->upstream->type.round_robin;
+
+    if (round_robin->points_n == 0) {
+        us->state->error(task, us);
+        return;
+    }
+
+    hash = nxt_murmur_hash2(ctx->key.start, ctx->key.length);
+
+    nxt_debug(task, "upstream hash key: \"%V\" %08xD", &ctx->key, hash);
+
+    /* Find the first point not less than the hash. */
+
+    points = round_robin->points;
+    left = 0;
+    right = round_robin->points_n;
+
+    while (left < right) {
+        middle = left + (right - left) / 2;
+
+        if (points[middle].hash < hash) {
+            left = middle + 1;
+
+        } else {
+            right = middle;
+        }
+    }
+
+    now = task->thread->engine->timers.now;
+
+    /* Unavailable servers pass their keys to the next points of the ring. */
+
+    for (i = 0; i < round_robin->points_n; i++) {
+
+        if (left == round_robin->points_n) {
+            left = 0;
+        }
+
+        s = &round_robin->server[points[left].server];
+
+        if (!nxt_upstream_health_down(s->health, now)) {
+            nxt_upstream_round_robin_server_use(task, us, s);
+            return;
+        }
+
+        left++;
+    }
+
+    us->state->error(task, us);
+}
+
+
+static void
+nxt_upstream_hash_error(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_upstream_hash_ctx_t  *ctx;
+
+    ctx = data;
+
+    ctx->us->state->error(task, ctx->us);
+}
@@ -26,6 +26,10 @@ typedef struct {
 static nxt_int_t nxt_python3_init_config(nxt_int_t pep405);
 #endif
 
+static nxt_int_t nxt_python_init(nxt_task_t *task,
+    nxt_common_app_conf_t *app_conf);
+static nxt_int_t nxt_python_preload(nxt_task_t *task,
+    nxt_process_data_t *data);
 static nxt_int_t nxt_python_start(nxt_task_t *task,
     nxt_process_data_t *data);
 static nxt_int_t nxt_python_set_target(nxt_task_t *task,
@@ -54,6 +58,7 @@ NXT_EXPORT nxt_app_module_t  nxt_app_module = {
     nxt_nitems(nxt_python_mounts),
     NULL,
     nxt_python_start,
+    nxt_python_preload,
 };
 
 static PyObject           *nxt_py_stderr_flush;
@@ -68,6 +73,7 @@ static char               *nxt_py_home;
 static pthread_attr_t        *nxt_py_thread_attr;
 static nxt_py_thread_info_t  *nxt_py_threads;
 static nxt_python_proto_t    nxt_py_proto;
+static nxt_bool_t            nxt_py_preloaded;
 
 
 #if PY_VERSION_HEX >= NXT_PYTHON_VER(3, 8)
@@ -144,19 +150,15 @@ nxt_python3_init_config(nxt_int_t pep405)
 
 
 static nxt_int_t
-nxt_python_start(nxt_task_t *task, nxt_process_data_t *data)
+nxt_python_init(nxt_task_t *task, nxt_common_app_conf_t *app_conf)
 {
-    int                    rc;
     size_t                 len, size;
     uint32_t               next;
     PyObject               *obj;
-    nxt_str_t              proto, probe_proto, name;
+    nxt_str_t              name;
     nxt_int_t              ret, n, i;
-    nxt_unit_ctx_t         *unit_ctx;
-    nxt_unit_init_t        python_init;
     nxt_conf_value_t       *cv;
     nxt_python_targets_t   *targets;
-    nxt_common_app_conf_t  *app_conf;
     nxt_python_app_conf_t  *c;
 #if PY_MAJOR_VERSION == 3
     char                   *path;
@@ -166,10 +168,6 @@ nxt_python_start(nxt_task_t *task, nxt_process_data_t *data)
     static const char bin_python[] = "/bin/python";
 #endif
 
-    static const nxt_str_t  wsgi = nxt_string("wsgi");
-    static const nxt_str_t  asgi = nxt_string("asgi");
-
-    app_conf = data->app;
     c = &app_conf->u.python;
 
     if (c->home != NULL) {
@@ -237,10 +235,6 @@ nxt_python_start(nxt_task_t *task, nxt_process_data_t *data)
     }
 #endif
 
-    obj = NULL;
-
-    python_init.ctx_data = NULL;
-
     obj = PySys_GetObject((char *) "stderr");
     if (nxt_slow_path(obj == NULL)) {
         nxt_alert(task, "Python failed to get \"sys.stderr\" object");
@@ -312,6 +306,73 @@ nxt_python_start(nxt_task_t *task, nxt_process_data_t *data)
         }
     }
 
+    return NXT_OK;
+
+fail:
+
+    Py_XDECREF(obj);
+
+    return NXT_ERROR;
+}
+
+
+static nxt_int_t
+nxt_python_preload(nxt_task_t *task, nxt_process_data_t *data)
+{
+    nxt_int_t  ret;
+
+    if (!data->app->u.python.preload) {
+        return NXT_OK;
+    }
+
+    ret = nxt_python_init(task, data->app);
+    if (nxt_slow_path(ret != NXT_OK)) {
+        nxt_python_atexit();
+        return NXT_ERROR;
+    }
+
+    nxt_py_preloaded = 1;
+
+    nxt_debug(task, "python application preloaded");
+
+    return NXT_OK;
+}
+
+
+static nxt_int_t
+nxt_python_start(nxt_task_t *task, nxt_process_data_t *data)
+{
+    int                    rc;
+    nxt_str_t              proto, probe_proto;
+    nxt_int_t              ret, i;
+    nxt_unit_ctx_t         *unit_ctx;
+    nxt_unit_init_t        python_init;
+    nxt_python_targets_t   *targets;
+    nxt_python_app_conf_t  *c;
+
+    static const nxt_str_t  wsgi = nxt_string("wsgi");
+    static const nxt_str_t  asgi = nxt_string("asgi");
+
+    c = &data->app->u.python;
+
+    python_init.ctx_data = NULL;
+
+    if (nxt_py_preloaded) {
+#if PY_VERSION_HEX >= NXT_PYTHON_VER(3, 7)
+        PyOS_AfterFork_Child();
+#else
+        PyOS_AfterFork();
+#endif
+
+    } else {
+        ret = nxt_python_init(task, data->app);
+        if (nxt_slow_path(ret != NXT_OK)) {
+            goto fail;
+        }
+    }
+
+    targets = nxt_py_targets;
+
     nxt_unit_default_init(task, &python_init, data->app);
 
     python_init.data = c;
@@ -388,8 +449,6 @@ nxt_python_start(nxt_task_t *task, nxt_process_data_t *data)
         nxt_py_proto.ctx_data_free(python_init.ctx_data);
     }
 
-    Py_XDECREF(obj);
-
     nxt_python_atexit();
 
     return NXT_ERROR;
@@ -198,6 +198,25 @@ nxt_py_asgi_http_read_msg(nxt_py_asgi_http_t *http)
 
         read_res = nxt_unit_request_read(req, body_buf, size);
 
+        if (nxt_slow_path(read_res < 0)) {
+            Py_DECREF(body);
+
+            http->closed = 1;
+
+            return nxt_py_asgi_new_msg(req, nxt_py_http_disconnect_str);
+        }
+
+        /* A streamed request body arrives by parts. */
+        if (read_res > 0 && read_res < size) {
+            if (nxt_slow_path(_PyBytes_Resize(&body, read_res) != 0)) {
+                nxt_unit_req_alert(req, "Python failed to resize body");
+                nxt_python_print_exception();
+
+                return PyErr_Format(PyExc_RuntimeError,
+                                    "failed to resize Bytes object");
+            }
+        }
+
     } else {
         body = NULL;
         read_res = 0;
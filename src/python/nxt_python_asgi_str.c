@@ -14,6 +14,7 @@
 
 PyObject  *nxt_py_1_0_str;
 PyObject  *nxt_py_1_1_str;
+PyObject  *nxt_py_2_str;
 PyObject  *nxt_py_2_0_str;
 PyObject  *nxt_py_2_1_str;
 PyObject  *nxt_py_3_0_str;
@@ -70,6 +71,7 @@ PyObject  *nxt_py_wss_str;
 static nxt_python_string_t nxt_py_asgi_strings[] = {
     { nxt_string("1.0"), &nxt_py_1_0_str },
     { nxt_string("1.1"), &nxt_py_1_1_str },
+    { nxt_string("2"), &nxt_py_2_str },
     { nxt_string("2.0"), &nxt_py_2_0_str },
     { nxt_string("2.1"), &nxt_py_2_1_str },
     { nxt_string("3.0"), &nxt_py_3_0_str },
@@ -9,6 +9,7 @@
 
 extern PyObject  *nxt_py_1_0_str;
 extern PyObject  *nxt_py_1_1_str;
+extern PyObject  *nxt_py_2_str;
 extern PyObject  *nxt_py_2_0_str;
 extern PyObject  *nxt_py_2_1_str;
 extern PyObject  *nxt_py_3_0_str;
@@ -88,6 +88,8 @@ static PyObject *nxt_py_input_read(nxt_python_ctx_t *pctx, PyObject *args);
 static PyObject *nxt_py_input_readline(nxt_python_ctx_t *pctx,
     PyObject *args);
 static PyObject *nxt_py_input_getline(nxt_python_ctx_t *pctx, size_t size);
+static PyObject *nxt_py_input_content(PyObject *content, ssize_t res,
+    ssize_t size);
 static PyObject *nxt_py_input_readlines(nxt_python_ctx_t *self,
     PyObject *args);
 
@@ -1223,9 +1225,9 @@ nxt_py_input_read(nxt_python_ctx_t *pctx, PyObject *args)
 
     buf = PyBytes_AS_STRING(content);
 
-    size = nxt_unit_request_read(pctx->req, buf, size);
+    n = nxt_unit_request_read(pctx->req, buf, size);
 
-    return content;
+    return nxt_py_input_content(content, n, size);
 }
 
 
@@ -1298,7 +1300,27 @@ nxt_py_input_getline(nxt_python_ctx_t *pctx, size_t size)
 
     buf = PyBytes_AS_STRING(content);
 
-    res = nxt_unit_request_read(pctx->req, buf, res);
+    return nxt_py_input_content(content,
+                                nxt_unit_request_read(pctx->req, buf, res),
+                                res);
+}
+
+
+static PyObject *
+nxt_py_input_content(PyObject *content, ssize_t res, ssize_t size)
+{
+    if (nxt_slow_path(res < 0)) {
+        Py_DECREF(content);
+
+        return PyErr_Format(PyExc_IOError, "failed to read request body");
+    }
+
+    /* A streamed request body can be interrupted by client. */
+    if (nxt_slow_path(res < size)) {
+        if (_PyBytes_Resize(&content, res) != 0) {
+            return NULL;
+        }
+    }
 
     return content;
 }
@@ -0,0 +1,298 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include "nxt_tests.h"
+
+
+/*
+ * The test drives the listen event accept path of an event engine with
+ * loopback connections.  Each poll round processes the engine work queues
+ * the same way as nxt_event_engine_start() does, so the number of rounds,
+ * the longest round, and the engine accept latency counters show how an
+ * accept batch trades new connection latency for other work latency.
+ */
+
+
+static void nxt_conn_accept_test_handler(nxt_task_t *task, void *obj,
+    void *data);
+static nxt_uint_t nxt_conn_accept_test_run(nxt_event_engine_t *engine);
+
+
+static nxt_uint_t  nxt_conn_accept_test_accepted;
+
+
+nxt_int_t
+nxt_conn_accept_test(nxt_thread_t *thr, nxt_uint_t runs, nxt_uint_t n,
+    nxt_uint_t batch)
+{
+    int                          ret;
+    nxt_mp_t                     *mp;
+    nxt_int_t                    rc;
+    nxt_nsec_t                   start, round, round_max, elapsed;
+    nxt_uint_t                   i, run, rounds, accepted, accepted_max;
+    socklen_t                    socklen;
+    nxt_task_t                   task;
+    nxt_socket_t                 s, *clients;
+    nxt_sockaddr_t               *sa;
+    nxt_listen_event_t           *lev;
+    nxt_event_engine_t           *engine, *prev;
+    nxt_listen_socket_t          ls;
+    struct sockaddr_in           sin;
+    const nxt_event_interface_t  *interface;
+
+#if (NXT_HAVE_EPOLL_EDGE)
+    interface = &nxt_epoll_edge_engine;
+#elif (NXT_HAVE_KQUEUE)
+    interface = &nxt_kqueue_engine;
+#else
+    interface = &nxt_poll_engine;
+#endif
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "conn accept test started: %ui x %ui, batch %ui",
+                  runs, n, batch);
+
+    rc = NXT_ERROR;
+    clients = NULL;
+    lev = NULL;
+    s = -1;
+
+    task.thread = thr;
+    task.log = thr->log;
+    task.ident = nxt_task_next_ident();
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (mp == NULL) {
+        return NXT_ERROR;
+    }
+
+    engine = nxt_event_engine_create(&task, interface, NULL, 0, 0);
+    if (engine == NULL) {
+        nxt_mp_destroy(mp);
+        return NXT_ERROR;
+    }
+
+    engine->mem_pool = mp;
+
+    prev = thr->engine;
+    thr->engine = engine;
+
+    s = nxt_socket_create(&task, AF_INET, SOCK_STREAM, 0, NXT_NONBLOCK);
+    if (s == -1) {
+        goto fail;
+    }
+
+    nxt_memzero(&sin, sizeof(struct sockaddr_in));
+
+    sin.sin_family = AF_INET;
+    sin.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    socklen = sizeof(struct sockaddr_in);
+
+    if (bind(s, (struct sockaddr *) &sin, socklen) != 0
+        || getsockname(s, (struct sockaddr *) &sin, &socklen) != 0)
+    {
+        nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                      "conn accept test: bind() failed %E", nxt_errno);
+        goto fail;
+    }
+
+    sa = nxt_sockaddr_create(mp, (struct sockaddr *) &sin, socklen,
+                             NXT_INET_ADDR_STR_LEN);
+    if (sa == NULL) {
+        goto fail;
+    }
+
+    sa->type = SOCK_STREAM;
+
+    if (nxt_listen_socket(&task, s, NXT_LISTEN_BACKLOG) != NXT_OK) {
+        goto fail;
+    }
+
+    nxt_memzero(&ls, sizeof(nxt_listen_socket_t));
+
+    ls.socket = s;
+    ls.sockaddr = sa;
+    ls.handler = nxt_conn_accept_test_handler;
+    ls.read_after_accept = 1;
+
+    nxt_listen_socket_remote_size(&ls);
+
+    lev = nxt_listen_event(&task, &ls);
+    if (lev == NULL) {
+        goto fail;
+    }
+
+    lev->batch = batch;
+
+    clients = nxt_malloc(n * sizeof(nxt_socket_t));
+    if (clients == NULL) {
+        goto fail;
+    }
+
+    rounds = 0;
+    round_max = 0;
+    accepted_max = 0;
+    nxt_conn_accept_test_accepted = 0;
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    for (run = 0; run < runs; run++) {
+
+        for (i = 0; i < n; i++) {
+            clients[i] = nxt_socket_create(&task, AF_INET, SOCK_STREAM, 0,
+                                           NXT_NONBLOCK);
+            if (clients[i] == -1) {
+                n = i;
+                goto fail;
+            }
+
+            ret = connect(clients[i], (struct sockaddr *) &sin,
+                          sizeof(struct sockaddr_in));
+
+            if (ret != 0 && nxt_socket_errno != NXT_EINPROGRESS) {
+                nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                              "conn accept test: connect() failed %E",
+                              nxt_socket_errno);
+                n = i + 1;
+                goto fail;
+            }
+        }
+
+        while (nxt_conn_accept_test_accepted < (run + 1) * n) {
+
+            if (rounds++ == (runs + 1) * n) {
+                nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                              "conn accept test failed: %ui of %ui "
+                              "connections accepted in %ui rounds",
+                              nxt_conn_accept_test_accepted,
+                              (run + 1) * n, rounds);
+                goto fail;
+            }
+
+            engine->event.poll(engine, 1000);
+
+            round = nxt_thread_monotonic_time(thr);
+
+            accepted = nxt_conn_accept_test_run(engine);
+
+            nxt_thread_time_update(thr);
+            round = nxt_thread_monotonic_time(thr) - round;
+
+            round_max = nxt_max(round_max, round);
+            accepted_max = nxt_max(accepted_max, accepted);
+        }
+
+        for (i = 0; i < n; i++) {
+            nxt_socket_close(&task, clients[i]);
+        }
+    }
+
+    nxt_thread_time_update(thr);
+    elapsed = nxt_thread_monotonic_time(thr) - start;
+
+    n = 0;
+
+    if (batch != 0 && accepted_max > batch) {
+        nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                      "conn accept test failed: %ui connections accepted "
+                      "in a round, batch %ui", accepted_max, batch);
+        goto fail;
+    }
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "conn accept test passed: %ui rounds, %uA events, "
+                  "latency avg %uL max %uL ns, round max %N ns, %N ns",
+                  rounds, engine->accept_events_cnt,
+                  engine->accept_latency / engine->accepted_conns_cnt,
+                  engine->accept_latency_max, round_max, elapsed);
+
+    rc = NXT_OK;
+
+fail:
+
+    if (clients != NULL) {
+        for (i = 0; i < n; i++) {
+            nxt_socket_close(&task, clients[i]);
+        }
+
+        nxt_free(clients);
+    }
+
+    if (lev != NULL) {
+        nxt_fd_event_delete(engine, &lev->socket);
+
+        if (lev->next != NULL) {
+            nxt_sockaddr_cache_free(engine, lev->next);
+            nxt_conn_free(&task, lev->next);
+        }
+
+        nxt_free(lev);
+    }
+
+    if (s != -1) {
+        nxt_socket_close(&task, s);
+    }
+
+    nxt_event_engine_free(engine);
+    thr->engine = prev;
+
+    nxt_mp_destroy(mp);
+
+    return rc;
+}
+
+
+static nxt_uint_t
+nxt_conn_accept_test_run(nxt_event_engine_t *engine)
+{
+    void                *obj, *data;
+    nxt_uint_t          accepted;
+    nxt_task_t          *task;
+    nxt_work_queue_t    *wq;
+    nxt_work_handler_t  handler;
+
+    accepted = nxt_conn_accept_test_accepted;
+
+    for (wq = &engine->fast_work_queue;
+         wq <= &engine->close_work_queue;
+         wq++)
+    {
+        for ( ;; ) {
+            if (wq->head == NULL) {
+                break;
+            }
+
+            handler = nxt_work_queue_pop(wq, &task, &obj, &data);
+
+            handler(task, obj, data);
+        }
+    }
+
+    return nxt_conn_accept_test_accepted - accepted;
+}
+
+
+static void
+nxt_conn_accept_test_handler(nxt_task_t *task, void *obj, void *data)
+{
+    nxt_conn_t          *c;
+    nxt_event_engine_t  *engine;
+
+    c = obj;
+
+    engine = task->thread->engine;
+
+    nxt_conn_active(engine, c);
+
+    nxt_socket_close(task, c->socket.fd);
+
+    nxt_sockaddr_cache_free(engine, c);
+    nxt_conn_free(task, c);
+
+    nxt_conn_accept_test_accepted++;
+}
@@ -0,0 +1,346 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <nxt_hpack.h>
+#include "nxt_tests.h"
+
+
+typedef struct {
+    nxt_str_t  block;
+    nxt_str_t  fields;
+} nxt_hpack_test_t;
+
+
+static nxt_int_t nxt_hpack_test_decode(nxt_thread_t *thr, nxt_hpack_t *hpack,
+    nxt_mp_t *mp, nxt_hpack_test_t *test);
+static nxt_int_t nxt_hpack_test_oversized(nxt_thread_t *thr, nxt_mp_t *mp);
+
+
+/* The examples from RFC 7541, Appendix C.4 and C.6. */
+
+static nxt_hpack_test_t  nxt_hpack_requests[] = {
+    {
+        nxt_string("\x82\x86\x84\x41\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab"
+                   "\x90\xf4\xff"),
+        nxt_string(":method: GET\n"
+                   ":scheme: http\n"
+                   ":path: /\n"
+                   ":authority: www.example.com\n")
+    },
+    {
+        nxt_string("\x82\x86\x84\xbe\x58\x86\xa8\xeb\x10\x64\x9c\xbf"),
+        nxt_string(":method: GET\n"
+                   ":scheme: http\n"
+                   ":path: /\n"
+                   ":authority: www.example.com\n"
+                   "cache-control: no-cache\n")
+    },
+    {
+        nxt_string("\x82\x87\x85\xbf\x40\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f"
+                   "\x89\x25\xa8\x49\xe9\x5b\xb8\xe8\xb4\xbf"),
+        nxt_string(":method: GET\n"
+                   ":scheme: https\n"
+                   ":path: /index.html\n"
+                   ":authority: www.example.com\n"
+                   "custom-key: custom-value\n")
+    },
+};
+
+
+static nxt_hpack_test_t  nxt_hpack_responses[] = {
+    {
+        nxt_string("\x48\x82\x64\x02\x58\x85\xae\xc3\x77\x1a\x4b\x61\x96\xd0"
+                   "\x7a\xbe\x94\x10\x54\xd4\x44\xa8\x20\x05\x95\x04\x0b\x81"
+                   "\x66\xe0\x82\xa6\x2d\x1b\xff\x6e\x91\x9d\x29\xad\x17\x18"
+                   "\x63\xc7\x8f\x0b\x97\xc8\xe9\xae\x82\xae\x43\xd3"),
+        nxt_string(":status: 302\n"
+                   "cache-control: private\n"
+                   "date: Mon, 21 Oct 2013 20:13:21 GMT\n"
+                   "location: https://www.example.com\n")
+    },
+    {
+        nxt_string("\x48\x83\x64\x0e\xff\xc1\xc0\xbf"),
+        nxt_string(":status: 307\n"
+                   "cache-control: private\n"
+                   "date: Mon, 21 Oct 2013 20:13:21 GMT\n"
+                   "location: https://www.example.com\n")
+    },
+    {
+        nxt_string("\x88\xc1\x61\x96\xd0\x7a\xbe\x94\x10\x54\xd4\x44\xa8\x20"
+                   "\x05\x95\x04\x0b\x81\x66\xe0\x84\xa6\x2d\x1b\xff\xc0\x5a"
+                   "\x83\x9b\xd9\xab\x77\xad\x94\xe7\x82\x1d\xd7\xf2\xe6\xc7"
+                   "\xb3\x35\xdf\xdf\xcd\x5b\x39\x60\xd5\xaf\x27\x08\x7f\x36"
+                   "\x72\xc1\xab\x27\x0f\xb5\x29\x1f\x95\x87\x31\x60\x65\xc0"
+                   "\x03\xed\x4e\xe5\xb1\x06\x3d\x50\x07"),
+        nxt_string(":status: 200\n"
+                   "cache-control: private\n"
+                   "date: Mon, 21 Oct 2013 20:13:22 GMT\n"
+                   "location: https://www.example.com\n"
+                   "content-encoding: gzip\n"
+                   "set-cookie: foo=ASDJKHQKBZXOQWEOPIUAXQWEOIU; "
+                   "max-age=3600; version=1\n")
+    },
+};
+
+
+static nxt_hpack_test_t  nxt_hpack_invalid[] = {
+    /* Index 0. */
+    { nxt_string("\x80"), nxt_null_string },
+    /* Absent dynamic table entry. */
+    { nxt_string("\xbe"), nxt_null_string },
+    /* Truncated string. */
+    { nxt_string("\x04\x05/ind"), nxt_null_string },
+    /* EOS in a Huffman string. */
+    { nxt_string("\x04\x84\xff\xff\xff\xff"), nxt_null_string },
+    /* Padding longer than 7 bits. */
+    { nxt_string("\x04\x82\x1f\xff"), nxt_null_string },
+    /* Table size update above the limit. */
+    { nxt_string("\x3f\xe2\x1f"), nxt_null_string },
+    /* Integer overflow. */
+    { nxt_string("\xff\xff\xff\xff\xff\xff\xff\x7f"), nxt_null_string },
+};
+
+
+nxt_int_t
+nxt_hpack_test(nxt_thread_t *thr)
+{
+    u_char            *p, buf[256];
+    nxt_mp_t          *mp;
+    nxt_int_t         ret;
+    nxt_uint_t        i;
+    nxt_hpack_t       hpack;
+    nxt_hpack_test_t  test;
+
+    nxt_thread_time_update(thr);
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (mp == NULL) {
+        return NXT_ERROR;
+    }
+
+    ret = NXT_ERROR;
+
+    if (nxt_hpack_init(&hpack, mp, NXT_HPACK_TABLE_SIZE) != NXT_OK) {
+        goto fail;
+    }
+
+    for (i = 0; i < nxt_nitems(nxt_hpack_requests); i++) {
+        if (nxt_hpack_test_decode(thr, &hpack, mp, &nxt_hpack_requests[i])
+            != NXT_OK)
+        {
+            goto fail;
+        }
+    }
+
+    if (hpack.count != 3 || hpack.size != 164) {
+        nxt_log_alert(thr->log, "hpack test failed: dynamic table %uD %uz",
+                      hpack.count, hpack.size);
+        goto fail;
+    }
+
+    nxt_hpack_free(&hpack);
+
+    if (nxt_hpack_init(&hpack, mp, 256) != NXT_OK) {
+        goto fail;
+    }
+
+    for (i = 0; i < nxt_nitems(nxt_hpack_responses); i++) {
+        if (nxt_hpack_test_decode(thr, &hpack, mp, &nxt_hpack_responses[i])
+            != NXT_OK)
+        {
+            goto fail;
+        }
+    }
+
+    if (hpack.count != 3 || hpack.size != 215) {
+        nxt_log_alert(thr->log, "hpack test failed: dynamic table %uD %uz",
+                      hpack.count, hpack.size);
+        goto fail;
+    }
+
+    nxt_hpack_free(&hpack);
+
+    for (i = 0; i < nxt_nitems(nxt_hpack_invalid); i++) {
+        if (nxt_hpack_init(&hpack, mp, NXT_HPACK_TABLE_SIZE) != NXT_OK) {
+            goto fail;
+        }
+
+        if (nxt_hpack_test_decode(thr, &hpack, mp, &nxt_hpack_invalid[i])
+            != NXT_OK)
+        {
+            goto fail;
+        }
+
+        nxt_hpack_free(&hpack);
+    }
+
+    p = nxt_hpack_encode_status(buf, 200);
+    p = nxt_hpack_encode_status(p, 302);
+    p = nxt_hpack_encode_field(p, (u_char *) "Content-Type", 12,
+                               (u_char *) "text/html", 9);
+    p = nxt_hpack_encode_field(p, (u_char *) "X-Powered-By", 12,
+                               (u_char *) "Unit", 4);
+
+    test.block.start = buf;
+    test.block.length = p - buf;
+    nxt_str_set(&test.fields, ":status: 200\n"
+                              ":status: 302\n"
+                              "content-type: text/html\n"
+                              "x-powered-by: Unit\n");
+
+    if (nxt_hpack_init(&hpack, mp, NXT_HPACK_TABLE_SIZE) != NXT_OK) {
+        goto fail;
+    }
+
+    if (nxt_hpack_test_decode(thr, &hpack, mp, &test) != NXT_OK) {
+        goto fail;
+    }
+
+    nxt_hpack_free(&hpack);
+
+    if (nxt_hpack_test_oversized(thr, mp) != NXT_OK) {
+        goto fail;
+    }
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "hpack test passed");
+
+    ret = NXT_OK;
+
+fail:
+
+    nxt_mp_destroy(mp);
+
+    return ret;
+}
+
+
+static nxt_int_t
+nxt_hpack_test_decode(nxt_thread_t *thr, nxt_hpack_t *hpack, nxt_mp_t *mp,
+    nxt_hpack_test_t *test)
+{
+    u_char             *pos, *end, *p, buf[512];
+    nxt_int_t          ret;
+    nxt_hpack_field_t  field;
+
+    pos = test->block.start;
+    end = pos + test->block.length;
+    p = buf;
+
+    for ( ;; ) {
+        ret = nxt_hpack_decode(hpack, mp, &pos, end, &field);
+
+        if (ret != NXT_OK) {
+            break;
+        }
+
+        p = nxt_sprintf(p, buf + sizeof(buf), "%V: %V\n",
+                        &field.name, &field.value);
+    }
+
+    if (test->fields.start == NULL) {
+        if (ret == NXT_ERROR) {
+            return NXT_OK;
+        }
+
+        nxt_log_alert(thr->log, "hpack test failed: invalid block decoded");
+
+        return NXT_ERROR;
+    }
+
+    if (ret != NXT_DONE
+        || !nxt_str_eq(&test->fields, buf, (size_t) (p - buf)))
+    {
+        nxt_log_alert(thr->log, "hpack test failed: \"%*s\"",
+                      p - buf, buf);
+
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * A literal with incremental indexing larger than the table empties it,
+ * while its name refers to an evicted entry.  The field is checked after
+ * the next entry has been added in place of the evicted one.
+ */
+
+static nxt_int_t
+nxt_hpack_test_oversized(nxt_thread_t *thr, nxt_mp_t *mp)
+{
+    u_char             *pos, *end, *p, buf[256];
+    nxt_mp_t           *table_mp;
+    nxt_int_t          ret;
+    nxt_hpack_t        hpack;
+    nxt_hpack_field_t  field, oversized;
+
+    static nxt_str_t  block = nxt_string(
+        "\x40\x0a" "custom-key" "\x01" "v"
+        "\x7e\x1e" "xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"
+        "\x40\x0a" "zzzzzzzzzz" "\x01" "w");
+
+    static nxt_str_t  expected = nxt_string(
+        "custom-key: v\n"
+        "zzzzzzzzzz: w\n"
+        "custom-key: xxxxxxxxxxxxxxxxxxxxxxxxxxxxxx\n");
+
+    table_mp = nxt_mp_create(1024, 128, 256, 32);
+    if (table_mp == NULL) {
+        return NXT_ERROR;
+    }
+
+    ret = NXT_ERROR;
+
+    if (nxt_hpack_init(&hpack, table_mp, 64) != NXT_OK) {
+        goto fail;
+    }
+
+    pos = block.start;
+    end = pos + block.length;
+    p = buf;
+
+    if (nxt_hpack_decode(&hpack, mp, &pos, end, &field) != NXT_OK) {
+        goto error;
+    }
+
+    p = nxt_sprintf(p, buf + sizeof(buf), "%V: %V\n",
+                    &field.name, &field.value);
+
+    if (nxt_hpack_decode(&hpack, mp, &pos, end, &oversized) != NXT_OK
+        || hpack.count != 0)
+    {
+        goto error;
+    }
+
+    if (nxt_hpack_decode(&hpack, mp, &pos, end, &field) != NXT_OK) {
+        goto error;
+    }
+
+    p = nxt_sprintf(p, buf + sizeof(buf), "%V: %V\n%V: %V\n",
+                    &field.name, &field.value,
+                    &oversized.name, &oversized.value);
+
+    if (pos == end && nxt_str_eq(&expected, buf, (size_t) (p - buf))) {
+        ret = NXT_OK;
+        goto done;
+    }
+
+error:
+
+    nxt_log_alert(thr->log, "hpack test failed: oversized field \"%*s\"",
+                  p - buf, buf);
+
+done:
+
+    nxt_hpack_free(&hpack);
+
+fail:
+
+    nxt_mp_destroy(table_mp);
+
+    return ret;
+}
@@ -0,0 +1,275 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_main.h>
+#include <nxt_conf.h>
+#include <nxt_http_route_addr.h>
+#include "nxt_tests.h"
+
+
+typedef struct {
+    nxt_str_t   addr;
+    nxt_bool_t  match;
+} nxt_http_route_addr_test_case_t;
+
+
+static nxt_int_t nxt_http_route_addr_test_bench(nxt_thread_t *thr,
+    nxt_uint_t n, nxt_uint_t runs);
+
+
+static nxt_str_t  nxt_http_route_addr_test_patterns = nxt_string(
+    "[\"10.0.0.0/8\", \"192.168.1.1\", \"172.16.0.10-172.16.1.20\","
+    " \"203.0.113.0/24:8000-8080\", \"198.51.100.7:443\","
+    " \"2001:db8::/32\", \"[fe80::1]:22\","
+    " \"fd00::5-fd00::1:2\", \"*:9999\"]");
+
+
+static nxt_http_route_addr_test_case_t  nxt_http_route_addr_test_cases[] = {
+    { nxt_string("10.1.2.3:80"), 1 },
+    { nxt_string("10.255.255.255:1"), 1 },
+    { nxt_string("11.0.0.0:80"), 0 },
+    { nxt_string("9.255.255.255:80"), 0 },
+    { nxt_string("192.168.1.1:80"), 1 },
+    { nxt_string("192.168.1.2:80"), 0 },
+    { nxt_string("172.16.0.9:80"), 0 },
+    { nxt_string("172.16.0.10:80"), 1 },
+    { nxt_string("172.16.0.255:80"), 1 },
+    { nxt_string("172.16.1.20:80"), 1 },
+    { nxt_string("172.16.1.21:80"), 0 },
+    { nxt_string("203.0.113.5:8000"), 1 },
+    { nxt_string("203.0.113.5:8080"), 1 },
+    { nxt_string("203.0.113.5:8081"), 0 },
+    { nxt_string("198.51.100.7:443"), 1 },
+    { nxt_string("198.51.100.7:80"), 0 },
+    { nxt_string("1.2.3.4:9999"), 1 },
+    { nxt_string("[2001:db8:1::1]:80"), 1 },
+    { nxt_string("[2001:db9::1]:80"), 0 },
+    { nxt_string("[fe80::1]:22"), 1 },
+    { nxt_string("[fe80::1]:23"), 0 },
+    { nxt_string("[fd00::4]:80"), 0 },
+    { nxt_string("[fd00::5]:80"), 1 },
+    { nxt_string("[fd00::ffff]:80"), 1 },
+    { nxt_string("[fd00::1:2]:80"), 1 },
+    { nxt_string("[fd00::1:3]:80"), 0 },
+    { nxt_string("[::1]:9999"), 1 },
+};
+
+
+nxt_int_t
+nxt_http_route_addr_test(nxt_thread_t *thr)
+{
+    nxt_mp_t                       *mp;
+    nxt_int_t                      ret;
+    nxt_bool_t                     match;
+    nxt_uint_t                     i, n;
+    nxt_sockaddr_t                 *sa;
+    nxt_conf_value_t               *patterns, *value;
+    nxt_http_route_addr_tree_t     tree;
+    nxt_http_route_addr_pattern_t  pattern;
+
+    nxt_thread_time_update(thr);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "http route addr test started");
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (mp == NULL) {
+        return NXT_ERROR;
+    }
+
+    patterns = nxt_conf_json_parse_str(mp, &nxt_http_route_addr_test_patterns);
+    if (patterns == NULL) {
+        return NXT_ERROR;
+    }
+
+    nxt_memzero(&tree, sizeof(nxt_http_route_addr_tree_t));
+
+    n = nxt_conf_array_elements_count(patterns);
+
+    for (i = 0; i < n; i++) {
+        value = nxt_conf_get_array_element(patterns, i);
+
+        ret = nxt_http_route_addr_pattern_parse(mp, &pattern, value);
+        if (ret != NXT_OK) {
+            nxt_log_alert(thr->log, "http route addr test: pattern %ui "
+                          "parse failed", i);
+            return NXT_ERROR;
+        }
+
+        ret = nxt_http_route_addr_tree_add(mp, &tree, &pattern);
+        if (ret != NXT_OK) {
+            return NXT_ERROR;
+        }
+    }
+
+    for (i = 0; i < nxt_nitems(nxt_http_route_addr_test_cases); i++) {
+        sa = nxt_sockaddr_parse(mp, &nxt_http_route_addr_test_cases[i].addr);
+        if (sa == NULL) {
+            return NXT_ERROR;
+        }
+
+        match = nxt_http_route_addr_tree_find(&tree, sa);
+
+        if (match != nxt_http_route_addr_test_cases[i].match) {
+            nxt_log_alert(thr->log, "http route addr test failed: "
+                          "\"%V\" match %d",
+                          &nxt_http_route_addr_test_cases[i].addr, match);
+            return NXT_ERROR;
+        }
+    }
+
+    nxt_mp_destroy(mp);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "http route addr test passed");
+
+    if (nxt_http_route_addr_test_bench(thr, 10 * 1000, 10 * 1000) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    if (nxt_http_route_addr_test_bench(thr, 100 * 1000, 1000) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * The benchmark compares the sequential test of random IPv4 CIDR
+ * patterns, as it is done for small rules, with the prefix tree.
+ */
+
+#define NXT_HTTP_ROUTE_ADDR_TEST_RUNS  (1000 * 1000)
+
+
+static nxt_int_t
+nxt_http_route_addr_test_bench(nxt_thread_t *thr, nxt_uint_t n,
+    nxt_uint_t runs)
+{
+    uint32_t                       mask, *addrs;
+    nxt_mp_t                       *mp;
+    nxt_str_t                      str;
+    nxt_uint_t                     i, j, bits, found, found_tree;
+    nxt_nsec_t                     start, end;
+    nxt_sockaddr_t                 *sa;
+    struct sockaddr_in             *sin;
+    nxt_http_route_addr_tree_t     tree;
+    nxt_http_route_addr_pattern_t  *patterns, *p;
+
+    static const nxt_uint_t  naddrs = 1024;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (mp == NULL) {
+        return NXT_ERROR;
+    }
+
+    patterns = nxt_mp_zalloc(mp, n * sizeof(nxt_http_route_addr_pattern_t));
+    addrs = nxt_mp_alloc(mp, naddrs * sizeof(uint32_t));
+
+    nxt_str_set(&str, "127.0.0.1:80");
+    sa = nxt_sockaddr_parse(mp, &str);
+
+    if (patterns == NULL || addrs == NULL || sa == NULL) {
+        return NXT_ERROR;
+    }
+
+    sin = &sa->u.sockaddr_in;
+
+    nxt_memzero(&tree, sizeof(nxt_http_route_addr_tree_t));
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    for (i = 0; i < n; i++) {
+        p = &patterns[i];
+
+        bits = 16 + nxt_random(&thr->random) % 17;
+        mask = (bits == 32) ? 0xFFFFFFFF : ~(0xFFFFFFFF >> bits);
+
+        p->base.addr_family = AF_INET;
+        p->base.match_type = NXT_HTTP_ROUTE_ADDR_CIDR;
+        p->base.port.start = 0;
+        p->base.port.end = 65535;
+        p->addr.v4.end = htonl(mask);
+        p->addr.v4.start = htonl(nxt_random(&thr->random) & mask);
+
+        if (nxt_http_route_addr_tree_add(mp, &tree, p) != NXT_OK) {
+            return NXT_ERROR;
+        }
+    }
+
+    nxt_thread_time_update(thr);
+    end = nxt_thread_monotonic_time(thr);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "http route addr bench %ui prefixes: tree built in %0.3fs",
+                  n, (end - start) / 1000000000.0);
+
+    for (i = 0; i < naddrs; i++) {
+        if (i % 2 == 0) {
+            /* An address within a random prefix. */
+            p = &patterns[nxt_random(&thr->random) % n];
+            addrs[i] = p->addr.v4.start
+                       | (htonl(nxt_random(&thr->random)) & ~p->addr.v4.end);
+
+        } else {
+            addrs[i] = htonl(nxt_random(&thr->random));
+        }
+    }
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    found = 0;
+
+    for (i = 0; nxt_fast_path(i < runs); i++) {
+        for (j = 0; j < n; j++) {
+            if ((addrs[i % naddrs] & patterns[j].addr.v4.end)
+                == patterns[j].addr.v4.start)
+            {
+                found++;
+                break;
+            }
+        }
+    }
+
+    nxt_thread_time_update(thr);
+    end = nxt_thread_monotonic_time(thr);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "http route addr bench %ui prefixes: linear %uins "
+                  "per match", n, (nxt_uint_t) ((end - start) / runs));
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    found_tree = 0;
+
+    for (i = 0; nxt_fast_path(i < NXT_HTTP_ROUTE_ADDR_TEST_RUNS); i++) {
+        sin->sin_addr.s_addr = addrs[i % naddrs];
+
+        if (nxt_http_route_addr_tree_find(&tree, sa)) {
+            found_tree += (i < runs);
+        }
+    }
+
+    nxt_thread_time_update(thr);
+    end = nxt_thread_monotonic_time(thr);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "http route addr bench %ui prefixes: tree %uins per match",
+                  n, (nxt_uint_t) ((end - start)
+                                   / NXT_HTTP_ROUTE_ADDR_TEST_RUNS));
+
+    if (found != found_tree) {
+        nxt_log_alert(thr->log, "http route addr bench failed: "
+                      "%ui linear matches, %ui tree matches",
+                      found, found_tree);
+        return NXT_ERROR;
+    }
+
+    nxt_mp_destroy(mp);
+
+    return NXT_OK;
+}
@@ -0,0 +1,315 @@
+
+/*
+ * Copyright (C) NGINX, Inc.
+ */
+
+#include <nxt_router.h>
+#include <nxt_http.h>
+#include "nxt_tests.h"
+
+
+typedef struct {
+    nxt_str_t          key;
+    nxt_radix_match_t  match;
+} nxt_radix_test_key_t;
+
+
+typedef struct {
+    nxt_str_t          string;
+    nxt_int_t          key;
+} nxt_radix_test_case_t;
+
+
+static nxt_int_t nxt_radix_test_bench(nxt_thread_t *thr, nxt_uint_t n,
+    nxt_uint_t runs);
+
+
+static nxt_radix_test_key_t  nxt_radix_test_keys[] = {
+    { nxt_string("/"), NXT_RADIX_EXACT },
+    { nxt_string("/static/"), NXT_RADIX_PREFIX },
+    { nxt_string("/static/img/"), NXT_RADIX_PREFIX },
+    { nxt_string("/static/index.html"), NXT_RADIX_EXACT },
+    { nxt_string("/stats"), NXT_RADIX_EXACT },
+    { nxt_string("/api/v1/"), NXT_RADIX_PREFIX },
+    { nxt_string("/api/v2"), NXT_RADIX_EXACT },
+    { nxt_string("/api/v2"), NXT_RADIX_PREFIX },
+    { nxt_string("/API/V3/"), NXT_RADIX_PREFIX },
+};
+
+
+static nxt_radix_test_case_t  nxt_radix_test_cases[] = {
+    { nxt_string("/"), 0 },
+    { nxt_string(""), -1 },
+    { nxt_string("/index.html"), -1 },
+    { nxt_string("/static/"), 1 },
+    { nxt_string("/static"), -1 },
+    { nxt_string("/static/app.js"), 1 },
+    { nxt_string("/static/img/logo.png"), 2 },
+    { nxt_string("/static/img"), 1 },
+    { nxt_string("/static/index.html"), 3 },
+    { nxt_string("/static/index.htm"), 1 },
+    { nxt_string("/static/index.html.bak"), 1 },
+    { nxt_string("/stats"), 4 },
+    { nxt_string("/stat"), -1 },
+    { nxt_string("/stats/"), -1 },
+    { nxt_string("/api/v1/users"), 5 },
+    { nxt_string("/api/v1"), -1 },
+    { nxt_string("/api/v2"), 6 },
+    { nxt_string("/api/v2/users"), 7 },
+    { nxt_string("/api/v3/users"), -1 },
+    { nxt_string("/API/V3/users"), 8 },
+};
+
+
+static nxt_radix_test_case_t  nxt_radix_test_nocase_cases[] = {
+    { nxt_string("/Static/App.js"), 1 },
+    { nxt_string("/STATIC/IMG/LOGO.PNG"), 2 },
+    { nxt_string("/Stats"), 4 },
+    { nxt_string("/api/v3/users"), 8 },
+    { nxt_string("/Api/V3/Users"), 8 },
+    { nxt_string("/api/v4/users"), -1 },
+};
+
+
+static nxt_int_t
+nxt_radix_test_run(nxt_thread_t *thr, nxt_mp_t *mp, nxt_bool_t nocase,
+    nxt_radix_test_case_t *cases, nxt_uint_t n)
+{
+    void                  **value, *found, *expected;
+    nxt_uint_t            i;
+    nxt_radix_t           *tree;
+    nxt_radix_test_key_t  *key;
+
+    tree = nxt_radix_create(mp, nocase);
+    if (tree == NULL) {
+        return NXT_ERROR;
+    }
+
+    for (i = 0; i < nxt_nitems(nxt_radix_test_keys); i++) {
+        key = &nxt_radix_test_keys[i];
+
+        value = nxt_radix_insert(tree, key->key.start, key->key.length,
+                                 key->match);
+        if (value == NULL) {
+            return NXT_ERROR;
+        }
+
+        *value = key;
+    }
+
+    for (i = 0; i < n; i++) {
+        found = nxt_radix_find(tree, cases[i].string.start,
+                               cases[i].string.length);
+
+        expected = (cases[i].key < 0) ? NULL
+                                      : &nxt_radix_test_keys[cases[i].key];
+
+        if (found != expected) {
+            nxt_log_alert(thr->log, "radix test failed: \"%V\" matched %p, "
+                          "expected %p", &cases[i].string, found, expected);
+            return NXT_ERROR;
+        }
+    }
+
+    return NXT_OK;
+}
+
+
+nxt_int_t
+nxt_radix_test(nxt_thread_t *thr)
+{
+    nxt_mp_t   *mp;
+    nxt_int_t  ret;
+
+    nxt_thread_time_update(thr);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "radix test started");
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (mp == NULL) {
+        return NXT_ERROR;
+    }
+
+    ret = nxt_radix_test_run(thr, mp, 0, nxt_radix_test_cases,
+                             nxt_nitems(nxt_radix_test_cases));
+    if (ret != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    ret = nxt_radix_test_run(thr, mp, 1, nxt_radix_test_nocase_cases,
+                             nxt_nitems(nxt_radix_test_nocase_cases));
+    if (ret != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    nxt_mp_destroy(mp);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log, "radix test passed");
+
+    if (nxt_radix_test_bench(thr, 10, 1000 * 1000) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    if (nxt_radix_test_bench(thr, 100, 1000 * 1000) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    if (nxt_radix_test_bench(thr, 1000, 100 * 1000) != NXT_OK) {
+        return NXT_ERROR;
+    }
+
+    return NXT_OK;
+}
+
+
+/*
+ * The benchmark compares route rules with the same prefix patterns.
+ * The patterns of a rule with a single pattern are not compiled, so a list
+ * of such rules is tested sequentially, as it is done for each pattern of
+ * a small route rule, while a rule with all the patterns uses the radix tree.
+ * The number of runs is reduced for large numbers of prefixes.
+ */
+
+static nxt_int_t
+nxt_radix_test_bench(nxt_thread_t *thr, nxt_uint_t n, nxt_uint_t runs)
+{
+    u_char                 *p, *end, *uris, *json;
+    nxt_mp_t               *mp;
+    nxt_str_t              *uri, str;
+    nxt_int_t              ret;
+    nxt_uint_t             i, j, found, found_tree;
+    nxt_nsec_t             start, stop;
+    nxt_conf_value_t       *cv;
+    nxt_http_request_t     r;
+    nxt_http_route_rule_t  **rules, *rule;
+
+    static const nxt_uint_t  nuris = 64;
+
+    mp = nxt_mp_create(1024, 128, 256, 32);
+    if (mp == NULL) {
+        return NXT_ERROR;
+    }
+
+    rules = nxt_mp_alloc(mp, n * sizeof(nxt_http_route_rule_t *));
+    json = nxt_mp_alloc(mp, n * 32 + 2);
+    uri = nxt_mp_alloc(mp, nuris * sizeof(nxt_str_t));
+    uris = nxt_mp_alloc(mp, nuris * 64);
+
+    if (rules == NULL || json == NULL || uri == NULL || uris == NULL) {
+        goto fail;
+    }
+
+    for (i = 0; i < n; i++) {
+        str.start = json;
+        str.length = nxt_sprintf(json, json + 32, "\"/tenant%05ui/*\"", i)
+                     - json;
+
+        cv = nxt_conf_json_parse_str(mp, &str);
+        if (cv == NULL) {
+            goto fail;
+        }
+
+        rules[i] = nxt_http_route_types_rule_create(thr->task, mp, cv);
+        if (rules[i] == NULL) {
+            goto fail;
+        }
+    }
+
+    p = json;
+    end = json + n * 32 + 2;
+
+    *p++ = '[';
+
+    for (i = 0; i < n; i++) {
+        p = nxt_sprintf(p, end, "%s\"/tenant%05ui/*\"", (i == 0) ? "" : ",",
+                        i);
+    }
+
+    *p++ = ']';
+
+    str.start = json;
+    str.length = p - json;
+
+    cv = nxt_conf_json_parse_str(mp, &str);
+    if (cv == NULL) {
+        goto fail;
+    }
+
+    rule = nxt_http_route_types_rule_create(thr->task, mp, cv);
+    if (rule == NULL) {
+        goto fail;
+    }
+
+    for (i = 0; i < nuris; i++) {
+        p = uris + i * 64;
+        uri[i].start = p;
+        uri[i].length = nxt_sprintf(p, p + 64, "/tenant%05ui/static/app.js",
+                                    nxt_random(&thr->random) % (n + n / 8))
+                        - p;
+    }
+
+    /* Prefix patterns do not use the request. */
+    nxt_memzero(&r, sizeof(nxt_http_request_t));
+    r.mem_pool = mp;
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "radix bench started: %ui prefixes, %ui runs", n, runs);
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    found = 0;
+
+    for (i = 0; nxt_fast_path(i < runs); i++) {
+        for (j = 0; j < n; j++) {
+            ret = nxt_http_route_test_rule(&r, rules[j], uri[i % nuris].start,
+                                           uri[i % nuris].length);
+            if (ret != 0) {
+                found += (ret == 1);
+                break;
+            }
+        }
+    }
+
+    nxt_thread_time_update(thr);
+    stop = nxt_thread_monotonic_time(thr);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "radix bench %ui prefixes: linear %uins per match",
+                  n, (nxt_uint_t) ((stop - start) / runs));
+
+    nxt_thread_time_update(thr);
+    start = nxt_thread_monotonic_time(thr);
+
+    found_tree = 0;
+
+    for (i = 0; nxt_fast_path(i < runs); i++) {
+        ret = nxt_http_route_test_rule(&r, rule, uri[i % nuris].start,
+                                       uri[i % nuris].length);
+        found_tree += (ret == 1);
+    }
+
+    nxt_thread_time_update(thr);
+    stop = nxt_thread_monotonic_time(thr);
+
+    nxt_log_error(NXT_LOG_NOTICE, thr->log,
+                  "radix bench %ui prefixes: radix %uins per match",
+                  n, (nxt_uint_t) ((stop - start) / runs));
+
+    if (found != found_tree) {
+        nxt_log_alert(thr->log, "radix bench failed: "
+                      "%ui linear matches, %ui radix matches",
+                      found, found_tree);
+        goto fail;
+    }
+
+    nxt_mp_destroy(mp);
+
+    return NXT_OK;
+
+fail:
+
+    nxt_mp_destroy(mp);
+
+    return NXT_ERROR;
+}
@@ -70,6 +70,28 @@ main(int argc, char **argv)
 
 #endif
 
+    if (nxt_process_argv[1] != NULL
+        && nxt_strcmp(nxt_process_argv[1], "accept") == 0)
+    {
+        if (nxt_conn_accept_test(thr, 100, 256, 1) != NXT_OK) {
+            return 1;
+        }
+
+        if (nxt_conn_accept_test(thr, 100, 256, 16) != NXT_OK) {
+            return 1;
+        }
+
+        if (nxt_conn_accept_test(thr, 100, 256, 64) != NXT_OK) {
+            return 1;
+        }
+
+        if (nxt_conn_accept_test(thr, 100, 256, 0) != NXT_OK) {
+            return 1;
+        }
+
+        return 0;
+    }
+
     if (nxt_random_test(thr) != NXT_OK) {
         return 1;
     }
@@ -158,6 +180,14 @@ main(int argc, char **argv)
         return 1;
     }
 
+    if (nxt_radix_test(thr) != NXT_OK) {
+        return 1;
+    }
+
+    if (nxt_http_route_addr_test(thr) != NXT_OK) {
+        return 1;
+    }
+
     if (nxt_strverscmp_test(thr) != NXT_OK) {
         return 1;
     }
@@ -166,6 +196,14 @@ main(int argc, char **argv)
         return 1;
     }
 
+    if (nxt_hpack_test(thr) != NXT_OK) {
+        return 1;
+    }
+
+    if (nxt_conn_accept_test(thr, 2, 64, 8) != NXT_OK) {
+        return 1;
+    }
+
 #if (NXT_HAVE_CLONE_NEWUSER)
     if (nxt_clone_creds_test(thr) != NXT_OK) {
         return 1;
@@ -63,9 +63,14 @@ nxt_int_t nxt_sprintf_test(nxt_thread_t *thr);
 nxt_int_t nxt_malloc_test(nxt_thread_t *thr);
 nxt_int_t nxt_utf8_test(nxt_thread_t *thr);
 nxt_int_t nxt_http_parse_test(nxt_thread_t *thr);
+nxt_int_t nxt_radix_test(nxt_thread_t *thr);
+nxt_int_t nxt_http_route_addr_test(nxt_thread_t *thr);
 nxt_int_t nxt_strverscmp_test(nxt_thread_t *thr);
 nxt_int_t nxt_base64_test(nxt_thread_t *thr);
+nxt_int_t nxt_hpack_test(nxt_thread_t *thr);
 nxt_int_t nxt_clone_creds_test(nxt_thread_t *thr);
+nxt_int_t nxt_conn_accept_test(nxt_thread_t *thr, nxt_uint_t runs,
+    nxt_uint_t n, nxt_uint_t batch);
 
 
 #endif /* _NXT_TESTS_H_INCLUDED_ */
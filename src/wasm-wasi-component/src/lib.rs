@@ -51,6 +51,7 @@ pub static mut nxt_app_module: bindings::nxt_app_module_t = {
         version: version.as_ptr().cast(),
         setup: Some(setup),
         start: Some(start),
+        preload: None,
     }
 };
 
@@ -0,0 +1,24 @@
+import threading
+import time
+
+lock = threading.Lock()
+count = 0
+
+
+def application(environ, start_response):
+    global count
+
+    with lock:
+        count += 1
+        body = str(count).encode()
+
+    time.sleep(int(environ.get('HTTP_X_DELAY', 0)))
+
+    headers = [('Content-Length', str(len(body)))]
+
+    cache_control = environ.get('HTTP_X_CACHE_CONTROL')
+    if cache_control is not None:
+        headers.append(('Cache-Control', cache_control))
+
+    start_response('200', headers)
+    return [body]
@@ -0,0 +1,18 @@
+def application(environ, start_response):
+    length = int(environ.get('HTTP_X_LENGTH', '4096'))
+    body = (b'0123456789abcdef' * (length // 16 + 1))[:length]
+
+    headers = [('Content-Type', environ.get('HTTP_X_TYPE', 'text/plain'))]
+
+    for name in ['Content-Encoding', 'ETag', 'Cache-Control']:
+        value = environ.get('HTTP_X_' + name.upper().replace('-', '_'))
+
+        if value is not None:
+            headers.append((name, value))
+
+    if environ.get('HTTP_X_CHUNKED') is None:
+        headers.append(('Content-Length', str(length)))
+
+    start_response(environ.get('HTTP_X_STATUS', '200'), headers)
+
+    return [body[i : i + 1000] for i in range(0, length, 1000)]
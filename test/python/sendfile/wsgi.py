@@ -0,0 +1,13 @@
+def application(environ, start_response):
+    headers = [
+        ('Content-Type', 'text/html'),
+        ('Content-Length', '4'),
+        ('Content-Disposition', 'attachment'),
+    ]
+
+    redirect = environ.get('HTTP_X_REDIRECT')
+    if redirect is not None:
+        headers.append(('X-Accel-Redirect', redirect))
+
+    start_response('200', headers)
+    return [b'body']
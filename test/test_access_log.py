@@ -285,6 +285,75 @@ def test_access_log_change(temp_dir, wait_for_record):
     ), 'change'
 
 
+def test_access_log_buffer(search_in_file, temp_dir, wait_for_record):
+    load('empty')
+
+    assert 'success' in client.conf(
+        {
+            'path': f'{temp_dir}/access.log',
+            'format': '$uri',
+            'buffer': 4096,
+            'flush': 1,
+        },
+        'access_log',
+    ), 'access_log buffer'
+
+    assert client.get(url='/buffered')['status'] == 200
+    assert search_in_file(r'^/buffered$', 'access.log') is None, 'buffered'
+    assert (
+        wait_for_record(r'^/buffered$', 'access.log') is not None
+    ), 'flushed'
+
+    assert 'success' in client.conf('0', 'access_log/flush')
+    assert 'success' in client.conf('64', 'access_log/buffer')
+
+    for i in range(10):
+        assert client.get(url=f'/full_{i}')['status'] == 200
+
+    assert wait_for_record(r'^/full_0$', 'access.log') is not None, 'full'
+    assert search_in_file(r'^/full_9$', 'access.log') is None, 'full last'
+
+    assert 'success' in client.conf('2048', 'access_log/buffer')
+
+    assert client.get(url='/long' + 'X' * 4096)['status'] == 200
+    assert client.get(url='/long_last')['status'] == 200
+
+    assert wait_for_record(r'^/longX{4096}$', 'access.log') is not None
+    assert search_in_file(r'^/long_last$', 'access.log') is None
+
+
+def test_access_log_buffer_order(temp_dir, wait_for_record):
+    load('empty')
+
+    assert 'success' in client.conf(
+        {
+            'path': f'{temp_dir}/access.log',
+            'format': '$uri',
+            'buffer': 1,
+        },
+        'access_log',
+    ), 'access_log buffer'
+
+    requests = ''.join(
+        f'GET /order_{i} HTTP/1.1\r\nHost: localhost\r\n\r\n'
+        for i in range(199)
+    )
+
+    client.http(
+        f'{requests}GET /order_199 HTTP/1.1\r\nHost: localhost\r\n'
+        'Connection: close\r\n\r\n'.encode(),
+        raw_resp=True,
+        raw=True,
+    )
+
+    assert wait_for_record(r'^/order_199$', 'access.log') is not None
+
+    with open(f'{temp_dir}/access.log', encoding='utf-8') as f:
+        lines = f.read().splitlines()
+
+    assert lines == [f'/order_{i}' for i in range(200)], 'order'
+
+
 def test_access_log_format(wait_for_record):
     load('empty')
 
@@ -385,3 +454,12 @@ def test_access_log_incorrect(temp_dir, skip_alert):
     ), 'access_log format incorrect'
 
     assert 'error' in client.conf('$arg_', 'access_log/if')
+
+    for option_name in ['buffer', 'flush']:
+        assert 'error' in client.conf(
+            {
+                'path': f'{temp_dir}/access.log',
+                option_name: -1,
+            },
+            'access_log',
+        ), f'access_log {option_name} negative'
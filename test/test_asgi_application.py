@@ -218,6 +218,26 @@ def test_asgi_application_shm_ack_handle():
     assert resp['body'] == body, 'keep-alive 1'
 
 
+def test_asgi_application_body_streaming():
+    client.load('mirror')
+
+    assert 'success' in client.conf(
+        {
+            'http': {
+                'max_body_size': 16 * 1024 * 1024,
+                'body_buffer_size': 8 * 1024,
+                'body_streaming': True,
+            }
+        },
+        'settings',
+    )
+
+    body = '0123456789abcdef' * 1024 * 1024
+    resp = client.post(body=body, read_buffer_size=1024 * 1024)
+    assert resp['status'] == 200, 'status'
+    assert resp['body'] == body, 'body'
+
+
 def test_asgi_application_body_bytearray():
     client.load('body_bytearray')
 
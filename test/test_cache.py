@@ -0,0 +1,200 @@
+import threading
+import time
+from pathlib import Path
+
+import pytest
+
+from unit.applications.lang.python import ApplicationPython
+from unit.option import option
+
+prerequisites = {'modules': {'python': 'any'}}
+
+client = ApplicationPython()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    client.load('cache', threads=4)
+
+    path = f'{option.temp_dir}/cache'
+    Path(path).mkdir()
+    Path(path).chmod(0o777)
+
+    assert 'success' in client.conf(
+        {
+            "settings": {"http": {"cache": {"path": path}}},
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [
+                {
+                    "action": {
+                        "pass": "applications/cache",
+                        "cache": {"valid": 60},
+                    }
+                }
+            ],
+            "applications": client.conf_get('applications'),
+        }
+    )
+
+
+def get(url='/', **kwargs):
+    headers = {'Host': 'localhost', 'Connection': 'close'}
+
+    for name, value in kwargs.items():
+        headers[name.replace('_', '-')] = value
+
+    return client.get(url=url, headers=headers)
+
+
+def test_cache_hit():
+    resp = get()
+    assert resp['status'] == 200, 'status'
+    assert resp['body'] == '1', 'miss'
+    assert resp['headers']['Content-Length'] == '1', 'content length'
+
+    resp = get()
+    assert resp['body'] == '1', 'hit'
+    assert resp['headers']['Content-Length'] == '1', 'hit content length'
+    assert 'Date' in resp['headers'], 'hit date'
+
+    assert get(url='/other')['body'] == '2', 'key'
+    assert get(url='/other')['body'] == '2', 'key hit'
+
+    assert len(list(Path(f'{option.temp_dir}/cache').iterdir())) == 2, 'files'
+
+
+def test_cache_key():
+    assert 'success' in client.conf('"$uri"', 'routes/0/action/cache/key')
+
+    assert get(url='/?a')['body'] == '1', 'miss'
+    assert get(url='/?b')['body'] == '1', 'hit'
+
+
+def test_cache_control():
+    assert get(X_Cache_Control='no-store')['body'] == '1', 'no-store'
+    assert get(X_Cache_Control='private')['body'] == '2', 'private'
+    assert get(X_Cache_Control='max-age=1')['body'] == '3', 'max-age'
+    assert get()['body'] == '3', 'max-age hit'
+
+    time.sleep(2)
+
+    assert get()['body'] == '4', 'max-age expired'
+    assert get()['body'] == '4', 'updated'
+
+
+def test_cache_valid():
+    assert 'success' in client.conf('0', 'routes/0/action/cache/valid')
+
+    assert get()['body'] == '1', 'not cached'
+    assert get()['body'] == '2', 'not cached 2'
+    assert get(X_Cache_Control='s-maxage=60')['body'] == '3', 's-maxage'
+    assert get()['body'] == '3', 's-maxage hit'
+
+
+def test_cache_head():
+    assert client.head(url='/')['status'] == 200, 'head miss'
+    assert get()['body'] == '2', 'head not cached'
+
+    resp = client.head(url='/')
+    assert resp['headers']['Content-Length'] == '1', 'head hit'
+    assert resp['body'] == '', 'head hit body'
+
+
+def test_cache_methods():
+    assert get()['body'] == '1', 'get'
+    assert client.post(url='/')['body'] == '2', 'post'
+    assert get(Authorization='Basic dXNlcjpwYXNz')['body'] == '3', 'auth'
+    assert get()['body'] == '1', 'hit'
+
+
+def test_cache_coalescing():
+    bodies = []
+
+    def request():
+        bodies.append(get(X_Delay='1', X_Cache_Control='max-age=60')['body'])
+
+    threads = [threading.Thread(target=request) for _ in range(4)]
+
+    for thread in threads:
+        thread.start()
+
+    for thread in threads:
+        thread.join()
+
+    assert bodies == ['1'] * 4, 'coalesced'
+
+
+def test_cache_coalescing_uncacheable():
+    bodies = []
+
+    def request():
+        bodies.append(get(X_Delay='1', X_Cache_Control='no-store')['body'])
+
+    threads = [threading.Thread(target=request) for _ in range(3)]
+
+    for thread in threads:
+        thread.start()
+
+    for thread in threads:
+        thread.join()
+
+    assert sorted(bodies) == ['1', '2', '3'], 'bypassed'
+
+
+def test_cache_lock_timeout():
+    assert 'success' in client.conf('1', 'routes/0/action/cache/lock_timeout')
+
+    bodies = []
+
+    def request():
+        bodies.append(get(X_Delay='3', X_Cache_Control='max-age=60')['body'])
+
+    thread = threading.Thread(target=request)
+    thread.start()
+
+    time.sleep(0.5)
+
+    start = time.monotonic()
+    assert get()['body'] == '2', 'bypassed'
+    assert time.monotonic() - start < 2.5, 'lock timeout'
+    assert not bodies, 'slow upstream'
+
+    thread.join()
+
+    assert bodies == ['1'], 'filled'
+    assert get()['body'] == '1', 'hit'
+
+
+def test_cache_reconfigure():
+    assert get()['body'] == '1', 'miss'
+
+    assert 'success' in client.conf('61', 'routes/0/action/cache/valid')
+
+    # The previous configuration is released asynchronously.
+    for _ in range(50):
+        if not list(Path(f'{option.temp_dir}/cache').iterdir()):
+            break
+
+        time.sleep(0.1)
+
+    assert not list(Path(f'{option.temp_dir}/cache').iterdir()), 'removed'
+    assert get()['body'] == '2', 'emptied'
+
+
+def test_cache_invalid():
+    assert 'error' in client.conf({}, 'settings/http/cache')
+    assert 'error' in client.conf('0', 'settings/http/cache/max_size')
+    assert 'error' in client.conf('-1', 'routes/0/action/cache/valid')
+    assert 'error' in client.conf(
+        '-1', 'routes/0/action/cache/lock_timeout'
+    )
+    assert 'error' in client.conf(
+        {"return": 200, "cache": {}}, 'routes/0/action'
+    )
+
+    assert 'success' in client.conf_delete('routes/0/action/cache')
+    assert 'success' in client.conf_delete('settings/http/cache')
+
+    assert 'error' in client.conf(
+        {"pass": "applications/cache", "cache": {}}, 'routes/0/action'
+    )
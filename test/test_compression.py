@@ -0,0 +1,234 @@
+import gzip
+from pathlib import Path
+
+import pytest
+
+from unit.applications.lang.python import ApplicationPython
+
+prerequisites = {'modules': {'python': 'any'}}
+
+client = ApplicationPython()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(require):
+    require({'modules': {'zlib': 'any'}})
+
+    client.load('compress')
+
+    assert 'success' in client.conf(
+        {"http": {"compression": {"gzip": {"level": 1}}}}, 'settings'
+    )
+
+
+def body(length=4096):
+    return (b'0123456789abcdef' * (length // 16 + 1))[:length]
+
+
+def get_compressed(accept_encoding='gzip', url='/', method='GET', **kwargs):
+    headers = {'Host': 'localhost', 'Connection': 'close'}
+
+    if accept_encoding is not None:
+        headers['Accept-Encoding'] = accept_encoding
+
+    for name, value in kwargs.items():
+        headers[name.replace('_', '-')] = value
+
+    resp = client.http(
+        method,
+        url=url,
+        headers=headers,
+        encoding='latin-1',
+        raw_resp=True,
+    )
+    resp = client._resp_to_dict(resp)
+
+    data = resp['body'].encode('latin-1')
+
+    if resp['headers'].get('Transfer-Encoding') == 'chunked':
+        data = client._parse_chunked_body(data)
+
+    if resp['headers'].get('Content-Encoding') == 'gzip':
+        data = gzip.decompress(data)
+
+    resp['body'] = data
+
+    return resp
+
+
+def check_compressed(resp, length=4096):
+    assert resp['status'] == 200, 'status'
+    assert resp['headers']['Content-Encoding'] == 'gzip', 'encoding'
+    assert resp['headers']['Vary'] == 'Accept-Encoding', 'vary'
+    assert 'Content-Length' not in resp['headers'], 'content length'
+    assert resp['body'] == body(length), 'body'
+
+
+def check_plain(resp, length=4096):
+    assert 'Content-Encoding' not in resp['headers'], 'encoding'
+    assert resp['body'] == body(length), 'body'
+
+
+def test_compression():
+    resp = get_compressed()
+    check_compressed(resp)
+    assert resp['headers']['Transfer-Encoding'] == 'chunked', 'chunked'
+
+    check_compressed(get_compressed('br;q=0.9, GZIP;q=0.1'))
+    check_compressed(get_compressed('*'))
+    check_compressed(get_compressed('br, *;q=0.5'))
+    check_compressed(get_compressed(X_Chunked='1'))
+    check_compressed(get_compressed(X_Length='1000000'), 1000000)
+    check_compressed(get_compressed(X_Type='application/json; charset=utf-8'))
+
+
+def test_compression_not_accepted():
+    for accept_encoding in [
+        None,
+        'br',
+        'gzip;q=0',
+        'identity',
+        '*;q=0',
+        'gzip;q=0, *',
+    ]:
+        resp = get_compressed(accept_encoding)
+        check_plain(resp)
+        assert resp['headers']['Content-Length'] == '4096', 'content length'
+        assert resp['headers']['Vary'] == 'Accept-Encoding', 'vary'
+
+
+def test_compression_skipped():
+    check_plain(get_compressed(X_Type='image/png'))
+    check_plain(get_compressed(X_Length='100'), 100)
+    check_plain(get_compressed(X_Status='500'))
+    check_plain(get_compressed(X_Cache_Control='public, no-transform'))
+
+    resp = get_compressed(X_Content_Encoding='identity')
+    assert resp['headers']['Content-Encoding'] == 'identity', 'encoded'
+    assert resp['body'] == body(), 'encoded body'
+
+    resp = get_compressed(method='HEAD')
+    assert 'Content-Encoding' not in resp['headers'], 'head'
+    assert resp['headers']['Content-Length'] == '4096', 'head length'
+
+
+def test_compression_etag():
+    resp = get_compressed(X_Etag='"abc"')
+    check_compressed(resp)
+    assert resp['headers']['ETag'] == 'W/"abc"', 'weak etag'
+
+    resp = get_compressed(X_Etag='W/"abc"')
+    assert resp['headers']['ETag'] == 'W/"abc"', 'already weak'
+
+
+def test_compression_settings():
+    assert 'success' in client.conf(
+        {
+            "gzip": {"level": 9},
+            "types": "image/*",
+            "min_length": 0,
+        },
+        'settings/http/compression',
+    )
+
+    check_plain(get_compressed())
+    check_compressed(get_compressed(X_Type='image/svg+xml'))
+    check_compressed(get_compressed(X_Type='image/png', X_Length='1'), 1)
+    check_plain(get_compressed(X_Type='image/png', X_Length='0'), 0)
+
+    assert 'success' in client.conf({}, 'settings/http/compression')
+    check_plain(get_compressed())
+
+
+def test_compression_keepalive():
+    (resp, sock) = client.get(
+        headers={
+            'Host': 'localhost',
+            'Accept-Encoding': 'gzip',
+            'Connection': 'keep-alive',
+        },
+        start=True,
+        read_timeout=1,
+        encoding='latin-1',
+        raw_resp=True,
+    )
+    assert 'Content-Encoding: gzip' in resp, 'compressed'
+
+    resp = client.get(sock=sock)
+    assert resp['body'] == body().decode(), 'keepalive'
+
+
+def test_compression_proxy(temp_dir):
+    Path(f'{temp_dir}/assets').mkdir()
+    Path(f'{temp_dir}/assets/file.txt').write_bytes(body())
+
+    assert 'success' in client.conf(
+        {
+            "front": [{"action": {"proxy": "http://127.0.0.1:8081"}}],
+            "backend": [{"action": {"share": f'{temp_dir}/assets$uri'}}],
+        },
+        'routes',
+    )
+    assert 'success' in client.conf(
+        {
+            "*:8080": {"pass": "routes/front"},
+            "*:8081": {"pass": "routes/backend"},
+        },
+        'listeners',
+    )
+
+    resp = client.http(
+        'GET',
+        url='/file.txt',
+        port=8081,
+        headers={
+            'Host': 'localhost',
+            'Accept-Encoding': 'gzip',
+            'Connection': 'close',
+        },
+    )
+    assert 'Content-Encoding' not in resp['headers'], 'static'
+
+    resp = get_compressed(url='/file.txt')
+    check_compressed(resp)
+
+
+def test_compression_sendfile(temp_dir):
+    Path(f'{temp_dir}/assets').mkdir()
+    Path(f'{temp_dir}/assets/file.txt').write_bytes(body())
+
+    client.load('sendfile')
+
+    assert 'success' in client.conf(
+        [
+            {
+                "action": {
+                    "pass": "applications/sendfile",
+                    "sendfile": {"share": f'{temp_dir}/assets$uri'},
+                }
+            }
+        ],
+        'routes',
+    )
+    assert 'success' in client.conf('"routes"', 'listeners/*:8080/pass')
+    assert 'success' in client.conf(
+        {"http": {"compression": {"gzip": {"level": 1}}}}, 'settings'
+    )
+
+    resp = get_compressed(x_redirect='/file.txt')
+    assert resp['status'] == 200, 'status'
+    check_plain(resp)
+
+
+def test_compression_invalid():
+    def check_error(conf):
+        assert 'error' in client.conf(conf, 'settings/http/compression')
+
+    check_error({"gzip": {"level": 0}})
+    check_error({"gzip": {"level": 10}})
+    check_error({"gzip": {"level": "1"}})
+    check_error({"gzip": {"window": 15}})
+    check_error({"gzip": True})
+    check_error({"min_length": -1})
+    check_error({"types": 1})
+    check_error({"unknown": {}})
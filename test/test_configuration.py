@@ -260,6 +260,24 @@ def test_listeners_addr():
     assert 'success' in try_addr("[::1]:8082"), 'explicit ipv6'
 
 
+def test_listeners_accept_batch():
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes", "accept_batch": 4}},
+            "routes": [{"action": {"return": 200}}],
+            "applications": {},
+        }
+    )
+    assert client.get()['status'] == 200, 'accept batch'
+
+    assert 'success' in client.conf('1', 'listeners/*:8080/accept_batch')
+    assert client.get()['status'] == 200, 'accept batch update'
+
+    assert 'error' in client.conf('0', 'listeners/*:8080/accept_batch')
+    assert 'error' in client.conf('-1', 'listeners/*:8080/accept_batch')
+    assert 'error' in client.conf('"4"', 'listeners/*:8080/accept_batch')
+
+
 def test_listeners_addr_error():
     assert 'error' in try_addr("127.0.0.1"), 'no port'
 
@@ -0,0 +1,324 @@
+import socket
+import struct
+
+import pytest
+
+from unit.applications.lang.python import ApplicationPython
+
+prerequisites = {'modules': {'python': 'any'}}
+
+client = ApplicationPython()
+
+PREFACE = b'PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n'
+
+DATA = 0x0
+HEADERS = 0x1
+RST_STREAM = 0x3
+SETTINGS = 0x4
+GOAWAY = 0x7
+WINDOW_UPDATE = 0x8
+
+INITIAL_WINDOW_SIZE = 0x4
+MAX_WINDOW = 0x7FFFFFFF
+
+END_STREAM = 0x1
+END_HEADERS = 0x4
+
+# RFC 7541, Appendix A.
+STATIC_TABLE = [
+    (':authority', ''), (':method', 'GET'), (':method', 'POST'),
+    (':path', '/'), (':path', '/index.html'), (':scheme', 'http'),
+    (':scheme', 'https'), (':status', '200'), (':status', '204'),
+    (':status', '206'), (':status', '304'), (':status', '400'),
+    (':status', '404'), (':status', '500'), ('accept-charset', ''),
+    ('accept-encoding', 'gzip, deflate'), ('accept-language', ''),
+    ('accept-ranges', ''), ('accept', ''),
+    ('access-control-allow-origin', ''), ('age', ''), ('allow', ''),
+    ('authorization', ''), ('cache-control', ''),
+    ('content-disposition', ''), ('content-encoding', ''),
+    ('content-language', ''), ('content-length', ''),
+    ('content-location', ''), ('content-range', ''), ('content-type', ''),
+    ('cookie', ''), ('date', ''), ('etag', ''), ('expect', ''),
+    ('expires', ''), ('from', ''), ('host', ''), ('if-match', ''),
+    ('if-modified-since', ''), ('if-none-match', ''), ('if-range', ''),
+    ('if-unmodified-since', ''), ('last-modified', ''), ('link', ''),
+    ('location', ''), ('max-forwards', ''), ('proxy-authenticate', ''),
+    ('proxy-authorization', ''), ('range', ''), ('referer', ''),
+    ('refresh', ''), ('retry-after', ''), ('server', ''),
+    ('set-cookie', ''), ('strict-transport-security', ''),
+    ('transfer-encoding', ''), ('user-agent', ''), ('vary', ''), ('via', ''),
+    ('www-authenticate', ''),
+]
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    client.load('mirror')
+
+    assert 'success' in client.conf({"http": {"http2": True}}, 'settings')
+
+
+def frame(ftype, flags, stream, payload=b''):
+    return (
+        struct.pack('>I', len(payload))[1:]
+        + struct.pack('>BBI', ftype, flags, stream)
+        + payload
+    )
+
+
+def hpack_int(value, prefix):
+    limit = (1 << prefix) - 1
+
+    if value < limit:
+        return bytes([value])
+
+    out = [limit]
+    value -= limit
+
+    while value >= 128:
+        out.append(value % 128 + 128)
+        value //= 128
+
+    out.append(value)
+
+    return bytes(out)
+
+
+def hpack_encode(fields):
+    block = b''
+
+    for name, value in fields:
+        # A literal field without indexing with a new name.
+        block += b'\x00' + hpack_int(len(name), 7) + name.encode()
+        block += hpack_int(len(value), 7) + value.encode()
+
+    return block
+
+
+def hpack_read_int(block, pos, prefix):
+    limit = (1 << prefix) - 1
+    value = block[pos] & limit
+    pos += 1
+
+    if value == limit:
+        shift = 0
+
+        while True:
+            value += (block[pos] & 127) << shift
+            shift += 7
+            pos += 1
+
+            if block[pos - 1] < 128:
+                break
+
+    return value, pos
+
+
+def hpack_decode(block):
+    # Unit never uses Huffman coding or the dynamic table.
+    fields = {}
+    pos = 0
+
+    while pos < len(block):
+        if block[pos] & 0x80:
+            index, pos = hpack_read_int(block, pos, 7)
+            name, value = STATIC_TABLE[index - 1]
+            fields[name] = value
+            continue
+
+        index, pos = hpack_read_int(block, pos, 4)
+
+        if index:
+            name = STATIC_TABLE[index - 1][0]
+
+        else:
+            length, pos = hpack_read_int(block, pos, 7)
+            name = block[pos : pos + length].decode()
+            pos += length
+
+        length, pos = hpack_read_int(block, pos, 7)
+        fields[name] = block[pos : pos + length].decode()
+        pos += length
+
+    return fields
+
+
+def h2_connect(port=8080):
+    sock = socket.create_connection(('127.0.0.1', port))
+    sock.settimeout(5)
+    # The windows are large enough for responses to be never blocked.
+    sock.sendall(
+        PREFACE
+        + frame(
+            SETTINGS, 0, 0, struct.pack('>HI', INITIAL_WINDOW_SIZE, MAX_WINDOW)
+        )
+        + frame(WINDOW_UPDATE, 0, 0, struct.pack('>I', MAX_WINDOW - 65535))
+    )
+
+    return sock
+
+
+def h2_request(sock, stream, method='GET', path='/', headers=None, body=None):
+    fields = [
+        (':method', method),
+        (':scheme', 'http'),
+        (':path', path),
+        (':authority', 'localhost'),
+    ]
+
+    if headers is not None:
+        fields += headers
+
+    data = frame(
+        HEADERS,
+        END_HEADERS | (END_STREAM if body is None else 0),
+        stream,
+        hpack_encode(fields),
+    )
+
+    if body:
+        data += frame(DATA, END_STREAM, stream, body)
+
+    sock.sendall(data)
+
+
+def recv_exact(sock, size):
+    data = b''
+
+    while len(data) < size:
+        chunk = sock.recv(size - len(data))
+        assert chunk, 'connection closed'
+        data += chunk
+
+    return data
+
+
+def h2_read(sock, streams):
+    responses = {s: {'headers': None, 'body': b''} for s in streams}
+    active = set(streams)
+
+    while active:
+        header = recv_exact(sock, 9)
+        length = struct.unpack('>I', b'\x00' + header[:3])[0]
+        ftype, flags, stream = struct.unpack('>BBI', header[3:])
+        payload = recv_exact(sock, length)
+
+        assert ftype != GOAWAY, 'goaway'
+
+        if stream not in responses:
+            continue
+
+        if ftype == HEADERS:
+            responses[stream]['headers'] = hpack_decode(payload)
+
+        elif ftype == DATA:
+            responses[stream]['body'] += payload
+
+        elif ftype == RST_STREAM:
+            responses[stream]['reset'] = struct.unpack('>I', payload)[0]
+            active.discard(stream)
+            continue
+
+        if ftype in (HEADERS, DATA) and flags & END_STREAM:
+            active.discard(stream)
+
+    return responses
+
+
+def test_http2_get():
+    sock = h2_connect()
+    h2_request(sock, 1, path='/path?query')
+
+    resp = h2_read(sock, [1])[1]
+
+    assert resp['headers'][':status'] == '200', 'status'
+    assert resp['headers']['content-length'] == '0', 'content length'
+    assert resp['body'] == b'', 'body'
+
+    h2_request(sock, 3)
+
+    assert h2_read(sock, [3])[3]['headers'][':status'] == '200', 'reuse'
+
+    sock.close()
+
+
+def test_http2_post():
+    body = b'0123456789' * 10000
+
+    sock = h2_connect()
+    h2_request(
+        sock,
+        1,
+        method='POST',
+        headers=[('content-length', str(len(body)))],
+        body=b'',
+    )
+
+    sock.sendall(
+        b''.join(
+            frame(DATA, 0, 1, body[i : i + 16384])
+            for i in range(0, len(body), 16384)
+        )
+        + frame(DATA, END_STREAM, 1)
+    )
+
+    resp = h2_read(sock, [1])[1]
+
+    assert resp['headers'][':status'] == '200', 'status'
+    assert resp['body'] == body, 'body'
+
+    sock.close()
+
+
+def test_http2_multiplexing():
+    sock = h2_connect()
+
+    for stream in (1, 3, 5):
+        h2_request(
+            sock, stream, method='POST', body=str(stream).encode() * 100
+        )
+
+    resp = h2_read(sock, [1, 3, 5])
+
+    for stream in (1, 3, 5):
+        assert resp[stream]['headers'][':status'] == '200', 'status'
+        assert resp[stream]['body'] == str(stream).encode() * 100, 'body'
+
+    sock.close()
+
+
+def test_http2_invalid_fields():
+    sock = h2_connect()
+    h2_request(sock, 1, headers=[('X-Upper', 'value')])
+    h2_request(sock, 3, headers=[('connection', 'close')])
+    h2_request(
+        sock, 5, method='POST', headers=[('content-length', '5')], body=b'abc'
+    )
+
+    resp = h2_read(sock, [1, 3, 5])
+
+    assert resp[1]['headers'][':status'] == '400', 'uppercase'
+    assert resp[3]['headers'][':status'] == '400', 'connection'
+    assert resp[5]['headers'][':status'] == '400', 'content length'
+
+    sock.close()
+
+
+def test_http2_http1():
+    assert client.get()['status'] == 200, 'http/1.1'
+
+
+def test_http2_disabled():
+    assert 'success' in client.conf('false', 'settings/http/http2')
+
+    sock = socket.create_connection(('127.0.0.1', 8080))
+    sock.settimeout(5)
+    sock.sendall(PREFACE)
+
+    assert sock.recv(12).startswith(b'HTTP/1.1'), 'http/1 response'
+
+    sock.close()
+
+
+def test_http2_settings_invalid():
+    assert 'error' in client.conf('"on"', 'settings/http/http2')
@@ -176,6 +176,40 @@ def test_python_idle_timeout():
     assert len(pids_for_process()) == 0, 'idle timed out'
 
 
+def test_python_processes_queue_time():
+    client.load(
+        'delayed',
+        client.app_name,
+        processes={"spare": 0, "max": 4, "idle_timeout": 1, "queue_time": 500},
+    )
+
+    socks = []
+    for _ in range(4):
+        sock = client.get(
+            headers={
+                'Host': 'localhost',
+                'X-Delay': '1',
+                'Connection': 'close',
+            },
+            start=True,
+            no_recv=True,
+        )
+        socks.append(sock)
+
+    assert len(pids_for_process()) == 4, 'queue time 4'
+
+    for sock in socks:
+        sock.close()
+
+    time.sleep(3)
+
+    assert 0 < len(pids_for_process()) < 4, 'queue time gradual stop'
+
+    time.sleep(3)
+
+    assert len(pids_for_process()) == 0, 'queue time stop idle'
+
+
 def test_python_processes_connection_keepalive():
     conf_proc({"spare": 0, "max": 6, "idle_timeout": 2})
 
@@ -210,6 +244,9 @@ def test_python_processes_invalid():
     assert 'error' in client.conf(
         {"idle_timeout": -1}, client.app_proc
     ), 'negative idle_timeout'
+    assert 'error' in client.conf(
+        {"queue_time": -1}, client.app_proc
+    ), 'negative queue_time'
     assert 'error' in client.conf(
         {"spare": 2}, client.app_proc
     ), 'spare gt max default'
@@ -1,5 +1,6 @@
 import re
 import socket
+import threading
 import time
 
 import pytest
@@ -94,6 +95,85 @@ Content-Length: 10
         connection.close()
 
 
+def run_server_keepalive(server_port):
+    sock = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+    sock.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+
+    server_address = ('', server_port)
+    sock.bind(server_address)
+    sock.listen(5)
+
+    def serve(connection, number):
+        data = b''
+
+        while True:
+            while b'\r\n\r\n' not in data:
+                part = connection.recv(4096)
+                if not part:
+                    connection.close()
+                    return
+
+                data += part
+
+            head, data = data.split(b'\r\n\r\n', 1)
+            head = head.decode()
+
+            close = 'Connection: close' in head or 'X-Close' in head
+
+            header = f'X-Conn: {number}\r\n'
+            if close:
+                header += 'Connection: close\r\n'
+
+            if 'X-No-Content' in head:
+                resp = f'HTTP/1.1 204 No Content\r\n{header}\r\n'
+
+            elif 'X-Chunked-Split' in head:
+                connection.sendall(
+                    f'HTTP/1.1 200 OK\r\n{header}'
+                    'Transfer-Encoding: chunked\r\n\r\n'
+                    '5\r\nchunk\r\n0\r\n\r'.encode()
+                )
+
+                time.sleep(0.2)
+
+                resp = '\n'
+                if 'X-Extra' in head:
+                    resp += 'extra'
+
+            elif 'X-Chunked' in head:
+                resp = (
+                    f'HTTP/1.1 200 OK\r\n{header}'
+                    'Transfer-Encoding: chunked\r\n\r\n'
+                    '5\r\nchunk\r\n0\r\n\r\n'
+                )
+
+            else:
+                resp = (
+                    f'HTTP/1.1 200 OK\r\n{header}'
+                    'Content-Length: 4\r\n\r\n'
+                )
+
+                if not head.startswith('HEAD'):
+                    resp += 'body'
+
+            connection.sendall(resp.encode())
+
+            if close:
+                connection.close()
+                return
+
+    number = 0
+
+    while True:
+        connection, _ = sock.accept()
+
+        number += 1
+
+        threading.Thread(
+            target=serve, args=(connection, number), daemon=True
+        ).start()
+
+
 def get_http10(*args, **kwargs):
     return client.get(*args, http_10=True, **kwargs)
 
@@ -324,6 +404,101 @@ def test_proxy_fragmented_body_close():
     sock.close()
 
 
+def test_proxy_keepalive():
+    run_process(run_server_keepalive, SERVER_PORT + 1)
+    waitforsocket(SERVER_PORT + 1)
+
+    assert 'success' in client.conf(
+        [{"action": {"proxy": f'http://127.0.0.1:{SERVER_PORT + 1}'}}],
+        'routes',
+    ), 'proxy keepalive backend configure'
+
+    def conn(headers=None):
+        headers = {'Host': 'localhost', **(headers or {})}
+        resp = get_http10(headers=headers)
+
+        assert resp['status'] in (200, 204), 'status'
+        return resp['headers']['X-Conn']
+
+    first = conn()
+    assert conn() != first, 'no keepalive'
+
+    assert 'success' in client.conf(
+        {'http': {'proxy_keepalive': 4, 'proxy_keepalive_timeout': 1}},
+        'settings',
+    ), 'keepalive configure'
+
+    first = conn()
+    for _ in range(4):
+        assert conn() == first, 'keepalive'
+
+    assert conn({'X-Chunked': '1'}) == first, 'keepalive chunked'
+    assert conn({'X-No-Content': '1'}) == first, 'keepalive no content'
+    assert client.head()['status'] == 200, 'keepalive head'
+    assert conn() == first, 'keepalive after head'
+
+    assert conn({'X-Close': '1'}) == first, 'upstream close'
+    second = conn()
+    assert second != first, 'new connection after close'
+
+    time.sleep(2)
+
+    assert conn() != second, 'keepalive timeout'
+
+    assert 'success' in client.conf(
+        '2', 'settings/http/proxy_keepalive_requests'
+    ), 'keepalive requests configure'
+
+    conns = [conn() for _ in range(6)]
+    assert len(set(conns)) in (3, 4), 'keepalive requests'
+    assert all(conns.count(c) <= 2 for c in conns), 'keepalive requests max'
+
+
+def test_proxy_keepalive_chunked_split():
+    run_process(run_server_keepalive, SERVER_PORT + 1)
+    waitforsocket(SERVER_PORT + 1)
+
+    assert 'success' in client.conf(
+        {
+            "settings": {"http": {"proxy_keepalive": 4}},
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [
+                {"action": {"proxy": f'http://127.0.0.1:{SERVER_PORT + 1}'}}
+            ],
+        }
+    ), 'proxy keepalive chunked configure'
+
+    def conn(headers=None):
+        headers = {'Host': 'localhost', **(headers or {})}
+        resp = get_http10(headers=headers)
+
+        assert resp['status'] == 200, 'status'
+        return resp
+
+    resp = conn({'X-Chunked-Split': '1'})
+    assert resp['body'] == 'chunk', 'split body'
+
+    first = resp['headers']['X-Conn']
+    assert conn()['headers']['X-Conn'] == first, 'keepalive split'
+
+    resp = conn({'X-Chunked-Split': '1', 'X-Extra': '1'})
+    assert resp['body'] == 'chunk', 'split body extra'
+    assert resp['headers']['X-Conn'] == first, 'split extra connection'
+
+    assert conn()['headers']['X-Conn'] != first, 'no keepalive after extra'
+
+
+def test_proxy_keepalive_invalid():
+    def check_keepalive(settings):
+        assert 'error' in client.conf(
+            {'http': settings}, 'settings'
+        ), 'keepalive invalid'
+
+    check_keepalive({'proxy_keepalive': '8'})
+    check_keepalive({'proxy_keepalive_timeout': 'blah'})
+    check_keepalive({'proxy_keepalive_requests': 1.5})
+
+
 def test_proxy_nowhere():
     assert 'success' in client.conf(
         [{"action": {"proxy": "http://127.0.0.1:8082"}}], 'routes'
@@ -520,6 +520,38 @@ def test_python_application_loading_error(skip_alert):
     assert client.get()['status'] == 503, 'loading error'
 
 
+def test_python_application_preload():
+    client.load('preload', processes=2)
+
+    resp = client.get()
+    assert resp['headers']['X-Import-Pid'] == resp['headers']['X-Pid']
+
+    client.load('preload', processes=2, preload=True)
+
+    import_pids = set()
+    pids = set()
+
+    for _ in range(10):
+        resp = client.get()
+        assert resp['status'] == 200, 'preload status'
+
+        import_pids.add(resp['headers']['X-Import-Pid'])
+        pids.add(resp['headers']['X-Pid'])
+
+    assert len(import_pids) == 1, 'preload imported once'
+    assert not import_pids & pids, 'preload imported in prototype'
+
+    assert 'error' in client.conf('"yes"', 'applications/preload/preload')
+
+
+def test_python_application_preload_loading_error(skip_alert):
+    skip_alert(r'Python failed to import module "blah"')
+
+    client.load('empty', module="blah", preload=True)
+
+    assert client.get()['status'] == 503, 'preload loading error'
+
+
 def test_python_application_close(wait_for_record):
     client.load('close')
 
@@ -0,0 +1,83 @@
+import os
+
+import pytest
+
+from unit.applications.proto import ApplicationProto
+
+prerequisites = {'features': {'reuseport': True}}
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes", "reuseport": True}},
+            "routes": [{"action": {"return": 200}}],
+            "applications": {},
+        }
+    )
+
+
+def listening_sockets(port):
+    sockets = 0
+
+    for name in ['/proc/net/tcp', '/proc/net/tcp6']:
+        if not os.path.exists(name):
+            continue
+
+        with open(name, encoding='utf-8') as f:
+            for line in f.readlines()[1:]:
+                fields = line.split()
+
+                if fields[1].endswith(f':{port:04X}') and fields[3] == '0A':
+                    sockets += 1
+
+    return sockets
+
+
+def test_reuseport():
+    for _ in range(10):
+        assert client.get()['status'] == 200, 'status'
+
+    threads = client.conf_get('/status')['threads']
+
+    assert listening_sockets(8080) == len(threads), 'sockets'
+
+
+def test_reuseport_keepalive():
+    (_, sock) = client.get(
+        headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+        start=True,
+        read_timeout=1,
+    )
+
+    assert client.get(sock=sock)['status'] == 200, 'keepalive'
+
+
+def test_reuseport_reconfigure():
+    assert 'success' in client.conf('false', 'listeners/*:8080/reuseport')
+    assert client.get()['status'] == 200, 'kept'
+
+    assert 'success' in client.conf(
+        {"*:8081": {"pass": "routes", "reuseport": False}}, 'listeners'
+    )
+    assert client.get(port=8081)['status'] == 200, 'disabled'
+    assert listening_sockets(8080) == 0, 'released'
+    assert listening_sockets(8081) == 1, 'single socket'
+
+
+def test_reuseport_unix(temp_dir):
+    addr = f'{temp_dir}/sock'
+
+    assert 'success' in client.conf(
+        {f'unix:{addr}': {"pass": "routes", "reuseport": True}}, 'listeners'
+    )
+
+    assert client.get(sock_type='unix', addr=addr)['status'] == 200, 'unix'
+
+
+def test_reuseport_invalid():
+    assert 'error' in client.conf('"on"', 'listeners/*:8080/reuseport')
+    assert 'error' in client.conf('1', 'listeners/*:8080/reuseport')
@@ -665,6 +665,67 @@ def test_routes_match_host_empty():
     assert client.get()['status'] == 404, 'match host empty 3'
 
 
+def test_routes_match_host_index():
+    routes = [
+        {
+            "match": {"host": f"host{i}.example.com"},
+            "action": {"return": 200 + i},
+        }
+        for i in range(16)
+    ]
+
+    routes.insert(8, {"match": {"uri": "/other"}, "action": {"return": 300}})
+    routes.insert(
+        3, {"match": {"host": "*.example.org"}, "action": {"return": 400}}
+    )
+    routes.append(
+        {"match": {"host": "host2.example.com"}, "action": {"return": 500}}
+    )
+    routes.append({"action": {"return": 404}})
+
+    assert 'success' in client.conf(routes, 'routes')
+
+    host('host0.example.com', 200)
+    host('host2.example.com', 202)
+    host('host15.example.com', 215)
+    host('HOST7.example.com', 207)
+    host('host16.example.com', 404)
+    host('www.example.org', 400)
+    host('', 404)
+
+    assert (
+        client.get(
+            url='/other',
+            headers={'Host': 'host9.example.com', 'Connection': 'close'},
+        )['status']
+        == 300
+    ), 'unindexed match before indexed'
+    assert (
+        client.get(
+            url='/other',
+            headers={'Host': 'host1.example.com', 'Connection': 'close'},
+        )['status']
+        == 201
+    ), 'indexed match before unindexed'
+
+
+def test_routes_match_method_index():
+    routes = [
+        {"match": {"method": m, "uri": f"/{m}"}, "action": {"return": 200 + i}}
+        for i, m in enumerate(["GET", "POST", "PUT", "DELETE"] * 3)
+    ]
+
+    routes.append({"match": {"method": "!GET"}, "action": {"return": 400}})
+
+    assert 'success' in client.conf(routes, 'routes')
+
+    assert client.get(url='/GET')['status'] == 200, 'GET'
+    assert client.post(url='/POST')['status'] == 201, 'POST'
+    assert client.delete(url='/DELETE')['status'] == 203, 'DELETE'
+    assert client.get(url='/POST')['status'] == 404, 'GET /POST'
+    assert client.post(url='/GET')['status'] == 400, 'POST /GET'
+
+
 def test_routes_match_uri_positive():
     route_match({"uri": ["/blah", "/slash/"]})
 
@@ -687,6 +748,75 @@ def test_routes_match_uri_positive():
     assert client.get(url='/slash/foo/..')['status'] == 200, 'trailing dot dot'
 
 
+def test_routes_match_uri_many():
+    uris = [f"/exact{i}" for i in range(10)]
+    uris += [f"/prefix{i}/*" for i in range(10)]
+    uris += ["!/prefix3/deny*", "*.php", "/"]
+
+    route_match({"uri": uris})
+
+    assert client.get()['status'] == 200, '/'
+    assert client.get(url='/exact0')['status'] == 200, 'exact'
+    assert client.get(url='/exact9')['status'] == 200, 'exact last'
+    assert client.get(url='/exact10')['status'] == 404, 'exact longer'
+    assert client.get(url='/exact')['status'] == 404, 'exact shorter'
+    assert client.get(url='/prefix5/')['status'] == 200, 'prefix'
+    assert client.get(url='/prefix5/a/b')['status'] == 200, 'prefix long'
+    assert client.get(url='/prefix5')['status'] == 404, 'prefix short'
+    assert client.get(url='/PREFIX5/')['status'] == 404, 'prefix case'
+    assert client.get(url='/prefix3/deny/x')['status'] == 404, 'negative'
+    assert client.get(url='/prefix3/allowed')['status'] == 200, 'allowed'
+    assert client.get(url='/index.php')['status'] == 200, 'suffix'
+
+
+def test_routes_match_headers_many():
+    route_match(
+        {"headers": {"X-Tenant": [f"Tenant{i}*" for i in range(10)]}}
+    )
+
+    def tenant(value, status):
+        assert (
+            client.get(
+                headers={
+                    'Host': 'localhost',
+                    'X-Tenant': value,
+                    'Connection': 'close',
+                }
+            )['status']
+            == status
+        ), 'match header'
+
+    tenant('tenant1', 200)
+    tenant('TENANT9-eu', 200)
+    tenant('tenant', 404)
+
+
+def test_routes_match_uri_index():
+    routes = [
+        {"match": {"uri": f"/app{i}/*"}, "action": {"return": 200 + i}}
+        for i in range(10)
+    ]
+
+    routes.insert(
+        2, {"match": {"uri": "/app5/admin/*"}, "action": {"return": 300}}
+    )
+    routes.insert(
+        0, {"match": {"uri": "/app7/health"}, "action": {"return": 301}}
+    )
+    routes.append({"match": {"uri": "/app1"}, "action": {"return": 302}})
+
+    assert 'success' in client.conf(routes, 'routes')
+
+    assert client.get(url='/app0/')['status'] == 200, 'prefix'
+    assert client.get(url='/app9/a')['status'] == 209, 'prefix last'
+    assert client.get(url='/app5/admin/x')['status'] == 300, 'longer first'
+    assert client.get(url='/app5/other')['status'] == 205, 'shorter'
+    assert client.get(url='/app7/health')['status'] == 301, 'exact first'
+    assert client.get(url='/app7/healthz')['status'] == 207, 'exact prefix'
+    assert client.get(url='/app1')['status'] == 302, 'exact last'
+    assert client.get(url='/app10/')['status'] == 404, 'not found'
+
+
 def test_routes_match_uri_case_sensitive():
     route_match({"uri": "/BLAH"})
 
@@ -1824,6 +1954,63 @@ def test_routes_source_cidr_ipv6():
     assert client.get(port=8081)['status'] == 404, '0 ipv4'
 
 
+def test_routes_source_many():
+    assert 'success' in client.conf(
+        {
+            "*:8080": {"pass": "routes"},
+            "[::1]:8081": {"pass": "routes"},
+        },
+        'listeners',
+    ), 'source listeners configure'
+
+    def get_ipv6():
+        return client.get(sock_type='ipv6', port=8081)
+
+    sources = [f'10.{i}.0.0/16' for i in range(32)]
+
+    route_match({"source": sources})
+    assert client.get()['status'] == 404, 'many'
+    assert get_ipv6()['status'] == 404, 'many ipv6'
+
+    route_match({"source": sources + ["127.0.0.0/8"]})
+    assert client.get()['status'] == 200, 'many cidr'
+    assert get_ipv6()['status'] == 404, 'many cidr ipv6'
+
+    route_match({"source": sources + ["126.0.0.0-127.0.0.1", "::1"]})
+    assert client.get()['status'] == 200, 'many range'
+    assert get_ipv6()['status'] == 200, 'many range ipv6'
+
+    route_match({"source": sources + ["127.0.0.2-127.0.0.3", "::2-::3"]})
+    assert client.get()['status'] == 404, 'many range 2'
+    assert get_ipv6()['status'] == 404, 'many range 2 ipv6'
+
+    route_match({"source": sources + ["*:1024-65535"]})
+    assert client.get()['status'] == 200, 'many port'
+    assert get_ipv6()['status'] == 200, 'many port ipv6'
+
+    route_match({"source": sources + ["127.0.0.1:1-1024", "[::1]:1-1024"]})
+    assert client.get()['status'] == 404, 'many port 2'
+    assert get_ipv6()['status'] == 404, 'many port 2 ipv6'
+
+    negative = [f'!10.{i}.0.0/16' for i in range(32)]
+
+    route_match({"source": negative})
+    assert client.get()['status'] == 200, 'many negative'
+    assert get_ipv6()['status'] == 200, 'many negative ipv6'
+
+    route_match({"source": negative + ["!127.0.0.1"]})
+    assert client.get()['status'] == 404, 'many negative 2'
+    assert get_ipv6()['status'] == 200, 'many negative 2 ipv6'
+
+    route_match({"source": negative + ["::/0"]})
+    assert client.get()['status'] == 404, 'many negative 3'
+    assert get_ipv6()['status'] == 200, 'many negative 3 ipv6'
+
+    route_match({"source": sources + negative + ["!::1", "*:1024-65535"]})
+    assert client.get()['status'] == 200, 'many mixed'
+    assert get_ipv6()['status'] == 404, 'many mixed ipv6'
+
+
 def test_routes_source_unix(temp_dir):
     addr = f'{temp_dir}/sock'
 
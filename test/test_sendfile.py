@@ -0,0 +1,127 @@
+from pathlib import Path
+
+import pytest
+
+from unit.applications.lang.python import ApplicationPython
+
+prerequisites = {'modules': {'python': 'any'}}
+
+client = ApplicationPython()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(f'{assets_dir}/dir').mkdir(parents=True)
+    Path(f'{assets_dir}/dir/file.txt').write_text('0123456789', encoding='utf-8')
+    Path(f'{assets_dir}/big').write_bytes(b'0123456789' * 100000)
+
+    client.load('sendfile')
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [
+                {
+                    "action": {
+                        "pass": "applications/sendfile",
+                        "sendfile": {"share": f'{assets_dir}$uri'},
+                    }
+                }
+            ],
+            "applications": client.conf_get('applications'),
+        }
+    )
+
+
+def get(redirect=None, **kwargs):
+    headers = {'Host': 'localhost', 'Connection': 'close'}
+
+    if redirect is not None:
+        headers['X-Redirect'] = redirect
+
+    return client.get(headers=headers, **kwargs)
+
+
+def test_sendfile():
+    resp = get('/dir/file.txt')
+    assert resp['status'] == 200, 'status'
+    assert resp['body'] == '0123456789', 'body'
+    assert resp['headers']['Content-Length'] == '10', 'content length'
+    assert resp['headers']['Content-Type'] == 'text/plain', 'content type'
+    assert (
+        resp['headers']['Content-Disposition'] == 'attachment'
+    ), 'application header'
+    assert 'X-Accel-Redirect' not in resp['headers'], 'redirect header'
+
+    resp = get('/big', read_buffer_size=1000000)
+    assert resp['status'] == 200, 'big status'
+    assert len(resp['body']) == 1000000, 'big body'
+
+    resp = get()
+    assert resp['status'] == 200, 'no redirect'
+    assert resp['body'] == 'body', 'application body'
+
+
+def test_sendfile_method():
+    def headers():
+        return {
+            'Host': 'localhost',
+            'Connection': 'close',
+            'X-Redirect': '/dir/file.txt',
+        }
+
+    resp = client.post(headers=headers(), body='data')
+    assert resp['status'] == 200, 'post'
+    assert resp['body'] == '0123456789', 'post body'
+
+    resp = client.head(headers=headers())
+    assert resp['status'] == 200, 'head'
+    assert resp['body'] == '', 'head body'
+
+
+def test_sendfile_not_found():
+    assert get('/blah')['status'] == 404, 'not found'
+    assert get('/dir/')['status'] == 404, 'no index'
+
+
+def test_sendfile_invalid(skip_alert):
+    skip_alert(r'invalid "X-Accel-Redirect" header field value')
+
+    assert get('dir/file.txt')['status'] == 503, 'relative'
+    assert get('/dir/../dir/file.txt')['status'] == 503, 'dot dot'
+    assert get('/./dir/file.txt')['status'] == 503, 'dot'
+
+    assert get()['status'] == 200, 'application after error'
+
+
+def test_sendfile_header():
+    assert 'success' in client.conf(
+        '"X-Sendfile"', 'routes/0/action/sendfile/header'
+    )
+
+    assert get('/dir/file.txt')['body'] == 'body', 'other header'
+
+    assert 'error' in client.conf('""', 'routes/0/action/sendfile/header')
+
+
+def test_sendfile_configuration():
+    assert 'error' in client.conf(
+        {"header": "X-Sendfile"}, 'routes/0/action/sendfile'
+    ), 'no share'
+    assert 'error' in client.conf(
+        {"share": "/tmp", "fallback": {"return": 404}},
+        'routes/0/action/sendfile',
+    ), 'fallback'
+
+
+def test_sendfile_chroot(require, temp_dir):
+    require({'features': {'chroot': True}})
+
+    assert 'success' in client.conf(
+        f'"{temp_dir}/assets/dir"', 'routes/0/action/sendfile/chroot'
+    )
+
+    assert get('/dir/file.txt')['status'] == 200, 'chroot'
+    assert get('/big')['status'] == 403, 'chroot 403'
@@ -433,6 +433,90 @@ def test_settings_body_buffer_size():
     assert resp['body'] == body, 'body 4'
 
 
+def test_settings_body_streaming():
+    client.load('mirror')
+
+    assert 'success' in client.conf(
+        {
+            'http': {
+                'max_body_size': 16 * 1024 * 1024,
+                'body_buffer_size': 8 * 1024,
+                'body_streaming': True,
+            }
+        },
+        'settings',
+    )
+
+    body = '0123456789abcdef'
+    resp = client.post(body=body)
+    assert resp['status'] == 200, 'status'
+    assert resp['body'] == body, 'body'
+
+    body = '0123456789abcdef' * 64 * 1024
+    resp = client.post(body=body, read_buffer_size=1024 * 1024)
+    assert resp['status'] == 200, 'status 2'
+    assert resp['body'] == body, 'body 2'
+
+    body = '0123456789abcdef' * 1024 * 1024
+    resp = client.post(body=body, read_buffer_size=1024 * 1024)
+    assert resp['status'] == 200, 'status 3'
+    assert resp['body'] == body, 'body 3'
+
+
+def test_settings_body_streaming_partial():
+    client.load('input_read_length')
+
+    assert 'success' in client.conf(
+        {'http': {'body_buffer_size': 1024, 'body_streaming': True}},
+        'settings',
+    )
+
+    body = '0123456789' * 32 * 1024
+    resp = client.post(
+        headers={
+            'Host': 'localhost',
+            'Input-Length': '10',
+            'Connection': 'keep-alive',
+        },
+        body=body,
+    )
+    assert resp['status'] == 200, 'status'
+    assert resp['body'] == '0123456789', 'body'
+    assert resp['headers']['Connection'] == 'close', 'connection close'
+
+    resp = client.post(
+        headers={
+            'Host': 'localhost',
+            'Input-Length': str(len(body)),
+            'Connection': 'close',
+        },
+        body=body,
+    )
+    assert resp['status'] == 200, 'status 2'
+    assert resp['body'] == body, 'body 2'
+
+
+def test_settings_body_streaming_readlines():
+    client.load('input_readlines')
+
+    assert 'success' in client.conf(
+        {'http': {'body_buffer_size': 1024, 'body_streaming': True}},
+        'settings',
+    )
+
+    body = ('0123456789' * 300 + '\n') * 100
+    resp = client.post(body=body)
+    assert resp['status'] == 200, 'status'
+    assert resp['headers']['X-Lines-Count'] == '100', 'lines count'
+    assert resp['body'] == body, 'body'
+
+
+def test_settings_body_streaming_invalid():
+    assert 'error' in client.conf(
+        {'http': {'body_streaming': 'yes'}}, 'settings'
+    ), 'body_streaming invalid'
+
+
 def test_settings_log_route(findall, search_in_file, wait_for_record):
     def count_fallbacks():
         return len(findall(r'"fallback" taken'))
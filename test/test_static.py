@@ -93,6 +93,25 @@ def test_static_large_file(temp_dir):
     ), 'large file'
 
 
+def test_static_large_file_content(temp_dir):
+    data = ''.join(f'{i:08x}' for i in range(512 * 1024))
+    Path(f'{temp_dir}/assets/large').write_text(data, encoding='utf-8')
+
+    (resp, sock) = client.get(
+        headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+        url='/large',
+        start=True,
+        read_buffer_size=1024 * 1024,
+        read_timeout=1,
+    )
+
+    assert resp['body'] == data, 'large file content'
+
+    resp = client.get(url='/index.html', sock=sock)
+
+    assert resp['body'] == '0123456789', 'large file keepalive'
+
+
 def test_static_etag(temp_dir):
     etag = client.get(url='/')['headers']['ETag']
     etag_2 = client.get(url='/README')['headers']['ETag']
@@ -0,0 +1,148 @@
+import os
+import time
+from pathlib import Path
+
+import pytest
+
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(assets_dir).mkdir(parents=True)
+    Path(f'{assets_dir}/index.html').write_text('0123456789', encoding='utf-8')
+    Path(f'{assets_dir}/a').write_text('aaa', encoding='utf-8')
+    Path(f'{assets_dir}/b').write_text('bbb', encoding='utf-8')
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": {"share": f'{assets_dir}$uri'}}],
+            "settings": {
+                "http": {"static": {"open_file_cache": {"max": 10, "valid": 3}}}
+            },
+        }
+    )
+
+
+def replace(temp_dir, name, content):
+    path = f'{temp_dir}/assets/{name}'
+
+    Path(f'{path}.tmp').write_text(content, encoding='utf-8')
+    os.replace(f'{path}.tmp', path)
+
+
+def get(url, sock=None):
+    kwargs = {} if sock is None else {'sock': sock}
+
+    return client.get(
+        url=url,
+        headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+        start=True,
+        read_timeout=0.2,
+        **kwargs,
+    )
+
+
+def test_static_cache(temp_dir):
+    resp, sock = get('/a')
+    assert resp['body'] == 'aaa', 'first'
+    etag = resp['headers']['ETag']
+
+    replace(temp_dir, 'a', 'changed')
+
+    resp, sock = get('/a', sock)
+    assert resp['body'] == 'aaa', 'cached'
+    assert resp['headers']['ETag'] == etag, 'cached etag'
+
+    Path(f'{temp_dir}/assets/a').unlink()
+
+    resp, sock = get('/a', sock)
+    assert resp['body'] == 'aaa', 'cached deleted'
+
+    time.sleep(3)
+
+    resp, sock = get('/a', sock)
+    assert resp['status'] == 404, 'expired'
+
+    resp, sock = get('/', sock)
+    assert resp['body'] == '0123456789', 'index'
+
+    sock.close()
+
+
+def test_static_cache_negative(temp_dir):
+    resp, sock = get('/c')
+    assert resp['status'] == 404, 'not found'
+
+    Path(f'{temp_dir}/assets/c').write_text('ccc', encoding='utf-8')
+
+    resp, sock = get('/c', sock)
+    assert resp['status'] == 404, 'not found cached'
+
+    time.sleep(3)
+
+    resp, sock = get('/c', sock)
+    assert resp['body'] == 'ccc', 'found'
+
+    sock.close()
+
+
+def test_static_cache_lru(temp_dir):
+    assert 'success' in client.conf(
+        {"max": 1, "valid": 60}, 'settings/http/static/open_file_cache'
+    )
+
+    resp, sock = get('/a')
+    assert resp['body'] == 'aaa', 'a'
+
+    resp, sock = get('/b', sock)
+    assert resp['body'] == 'bbb', 'b'
+
+    replace(temp_dir, 'a', 'new a')
+    replace(temp_dir, 'b', 'new b')
+
+    resp, sock = get('/b', sock)
+    assert resp['body'] == 'bbb', 'b cached'
+
+    resp, sock = get('/a', sock)
+    assert resp['body'] == 'new a', 'a evicted'
+
+    resp, sock = get('/b', sock)
+    assert resp['body'] == 'new b', 'b evicted'
+
+    sock.close()
+
+
+def test_static_cache_disabled(temp_dir):
+    assert 'success' in client.conf_delete(
+        'settings/http/static/open_file_cache'
+    )
+
+    resp, sock = get('/a')
+    assert resp['body'] == 'aaa', 'a'
+
+    replace(temp_dir, 'a', 'new a')
+
+    resp, sock = get('/a', sock)
+    assert resp['body'] == 'new a', 'not cached'
+
+    sock.close()
+
+
+def test_static_cache_invalid():
+    def check_error(conf):
+        assert 'error' in client.conf(
+            conf, 'settings/http/static/open_file_cache'
+        )
+
+    check_error({"max": 0})
+    check_error({"max": -1})
+    check_error({"max": "1"})
+    check_error({"valid": 0})
+    check_error({"valid": 1000001})
+    check_error({"blah": 1})
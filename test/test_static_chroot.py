@@ -163,3 +163,30 @@ def test_static_chroot_invalid(temp_dir):
 
     assert 'error' in update_action(f'{temp_dir}/assets/d$r$uri')
     assert 'error' in update_action(f'{temp_dir}/assets/$$uri')
+
+
+def test_static_chroot_precompressed(temp_dir):
+    Path(f'{temp_dir}/assets/dir/file.gz').write_text('gzip', encoding='utf-8')
+
+    for share in [f'{temp_dir}/assets$uri', f'{temp_dir}/assets/dir/file']:
+        assert 'success' in client.conf(
+            {
+                'chroot': f'{temp_dir}/assets/dir',
+                'share': share,
+                'precompressed': True,
+            },
+            'routes/0/action',
+        )
+
+        resp = client.get(
+            url='/dir/file',
+            headers={
+                'Host': 'localhost',
+                'Accept-Encoding': 'gzip',
+                'Connection': 'close',
+            },
+        )
+        assert resp['body'] == 'gzip', share
+        assert resp['headers']['Content-Encoding'] == 'gzip', share
+
+        assert client.get(url='/dir/file')['body'] == 'blah', share
@@ -0,0 +1,117 @@
+from pathlib import Path
+
+import pytest
+
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(assets_dir).mkdir(parents=True)
+    Path(f'{assets_dir}/index.html').write_text('0123456789', encoding='utf-8')
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": {"share": f'{assets_dir}$uri'}}],
+            "applications": {},
+        }
+    )
+
+
+def get_cond(headers, method='GET'):
+    return client.http(
+        method,
+        url='/index.html',
+        headers={'Host': 'localhost', 'Connection': 'close', **headers},
+    )
+
+
+def validators():
+    headers = client.get(url='/index.html')['headers']
+
+    return headers['ETag'], headers['Last-Modified']
+
+
+def check_not_modified(resp, etag):
+    assert resp['status'] == 304, 'status'
+    assert resp['body'] == '', 'body'
+    assert resp['headers']['ETag'] == etag, 'etag'
+    assert 'Content-Length' not in resp['headers'], 'content length'
+    assert 'Content-Type' not in resp['headers'], 'content type'
+
+
+def test_static_conditional_if_none_match():
+    etag, _ = validators()
+
+    check_not_modified(get_cond({'If-None-Match': etag}), etag)
+    check_not_modified(get_cond({'If-None-Match': f'W/{etag}'}), etag)
+    check_not_modified(get_cond({'If-None-Match': '*'}), etag)
+    check_not_modified(
+        get_cond({'If-None-Match': f'"a", "b" ,{etag}'}), etag
+    )
+    check_not_modified(get_cond({'If-None-Match': etag}, 'HEAD'), etag)
+
+    resp = get_cond({'If-None-Match': '"other"'})
+    assert resp['status'] == 200, 'mismatch'
+    assert resp['body'] == '0123456789', 'mismatch body'
+
+    assert get_cond({'If-None-Match': etag[:-1]})['status'] == 200, 'open'
+    assert get_cond({'If-None-Match': ''})['status'] == 200, 'empty'
+
+
+def test_static_conditional_if_modified_since():
+    etag, last_modified = validators()
+
+    check_not_modified(get_cond({'If-Modified-Since': last_modified}), etag)
+    check_not_modified(
+        get_cond({'If-Modified-Since': 'Fri, 01 Jan 2100 00:00:00 GMT'}), etag
+    )
+
+    resp = get_cond({'If-Modified-Since': 'Thu, 01 Jan 1970 00:00:00 GMT'})
+    assert resp['status'] == 200, 'modified'
+    assert resp['body'] == '0123456789', 'modified body'
+
+    for value in [
+        'invalid',
+        last_modified.replace('GMT', 'UTC'),
+        last_modified.replace(',', ''),
+        'Fri, 01 Foo 2100 00:00:00 GMT',
+        'Fri, 32 Jan 2100 00:00:00 GMT',
+    ]:
+        assert get_cond({'If-Modified-Since': value})['status'] == 200, value
+
+
+def test_static_conditional_precedence():
+    etag, last_modified = validators()
+
+    resp = get_cond(
+        {'If-None-Match': '"other"', 'If-Modified-Since': last_modified}
+    )
+    assert resp['status'] == 200, 'if-none-match precedence'
+
+    resp = get_cond({'If-None-Match': etag, 'Range': 'bytes=0-1'})
+    assert resp['status'] == 304, 'before range'
+
+
+def test_static_conditional_keepalive():
+    etag, _ = validators()
+
+    (resp, sock) = client.get(
+        url='/index.html',
+        headers={
+            'Host': 'localhost',
+            'If-None-Match': etag,
+            'Connection': 'keep-alive',
+        },
+        start=True,
+        read_timeout=1,
+    )
+    assert resp['status'] == 304, 'not modified'
+
+    resp = client.get(url='/index.html', sock=sock)
+    assert resp['body'] == '0123456789', 'keepalive'
@@ -0,0 +1,114 @@
+from pathlib import Path
+
+import pytest
+
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(f'{assets_dir}/dir.gz').mkdir(parents=True)
+    Path(f'{assets_dir}/app.js').write_text('plain', encoding='utf-8')
+    Path(f'{assets_dir}/app.js.gz').write_text('gzip', encoding='utf-8')
+    Path(f'{assets_dir}/app.js.br').write_text('brotli', encoding='utf-8')
+    Path(f'{assets_dir}/style.css').write_text('plain', encoding='utf-8')
+    Path(f'{assets_dir}/style.css.gz').write_text('gzip', encoding='utf-8')
+    Path(f'{assets_dir}/dir').write_text('plain', encoding='utf-8')
+    Path(f'{assets_dir}/only.gz').write_text('gzip', encoding='utf-8')
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [
+                {
+                    "action": {
+                        "share": f'{assets_dir}$uri',
+                        "precompressed": True,
+                    }
+                }
+            ],
+            "applications": {},
+        }
+    )
+
+
+def get_encoded(url, accept_encoding=None):
+    headers = {'Host': 'localhost', 'Connection': 'close'}
+
+    if accept_encoding is not None:
+        headers['Accept-Encoding'] = accept_encoding
+
+    return client.get(url=url, headers=headers)
+
+
+def check_encoded(url, accept_encoding, body, encoding=None):
+    resp = get_encoded(url, accept_encoding)
+
+    assert resp['status'] == 200, 'status'
+    assert resp['body'] == body, 'body'
+    assert resp['headers']['Vary'] == 'Accept-Encoding', 'vary'
+    assert resp['headers'].get('Content-Encoding') == encoding, 'encoding'
+
+    return resp
+
+
+def test_static_precompressed():
+    resp = check_encoded('/app.js', 'gzip, deflate, br', 'brotli', 'br')
+    assert (
+        resp['headers']['Content-Type'] == 'application/javascript'
+    ), 'content type'
+
+    check_encoded('/app.js', 'gzip', 'gzip', 'gzip')
+    check_encoded('/app.js', 'GZIP ; q=0.5', 'gzip', 'gzip')
+    check_encoded('/app.js', 'br;q=0, gzip', 'gzip', 'gzip')
+    check_encoded('/app.js', 'br;q=0.000,gzip;q=0.', 'plain')
+    check_encoded('/app.js', 'br;q=0.01', 'brotli', 'br')
+    check_encoded('/app.js', 'deflate', 'plain')
+    check_encoded('/app.js', 'xgzip, gzipx', 'plain')
+    check_encoded('/app.js', None, 'plain')
+
+    check_encoded('/style.css', 'br, gzip', 'gzip', 'gzip')
+
+
+def test_static_precompressed_fallback():
+    check_encoded('/dir', 'gzip', 'plain')
+    assert get_encoded('/none', 'gzip')['status'] == 404, 'not found'
+
+    check_encoded('/only', 'gzip', 'gzip', 'gzip')
+    assert get_encoded('/only', 'br')['status'] == 404, 'only compressed'
+
+
+def test_static_precompressed_etag():
+    plain = get_encoded('/app.js')
+    gzip = get_encoded('/app.js', 'gzip')
+
+    assert plain['headers']['ETag'] != gzip['headers']['ETag'], 'etag'
+
+    resp = client.get(
+        url='/app.js',
+        headers={
+            'Host': 'localhost',
+            'Accept-Encoding': 'gzip',
+            'If-None-Match': gzip['headers']['ETag'],
+            'Connection': 'close',
+        },
+    )
+    assert resp['status'] == 304, 'not modified'
+    assert resp['headers']['Vary'] == 'Accept-Encoding', 'not modified vary'
+
+
+def test_static_precompressed_disabled():
+    assert 'success' in client.conf('false', 'routes/0/action/precompressed')
+
+    resp = get_encoded('/app.js', 'br, gzip')
+    assert resp['body'] == 'plain', 'disabled'
+    assert 'Vary' not in resp['headers'], 'disabled vary'
+    assert 'Content-Encoding' not in resp['headers'], 'disabled encoding'
+
+
+def test_static_precompressed_invalid():
+    assert 'error' in client.conf('"on"', 'routes/0/action/precompressed')
@@ -0,0 +1,209 @@
+import re
+from pathlib import Path
+
+import pytest
+
+from unit.applications.proto import ApplicationProto
+
+client = ApplicationProto()
+
+data = '0123456789abcdefghijklmnopqrstuvwxyz'
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(assets_dir).mkdir(parents=True)
+    Path(f'{assets_dir}/file.txt').write_text(data, encoding='utf-8')
+    Path(f'{assets_dir}/index.html').write_text('0123456789', encoding='utf-8')
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes"}},
+            "routes": [{"action": {"share": f'{assets_dir}$uri'}}],
+            "applications": {},
+        }
+    )
+
+
+def get_range(value, url='/file.txt', headers=None):
+    headers = headers or {}
+
+    return client.get(
+        url=url,
+        headers={
+            'Host': 'localhost',
+            'Range': value,
+            'Connection': 'close',
+            **headers,
+        },
+    )
+
+
+def parse_multipart(resp):
+    boundary = re.search(
+        r'multipart/byteranges; boundary=(\d+)$', resp['headers']['Content-Type']
+    )
+    assert boundary, 'multipart content type'
+
+    body = resp['body']
+    parts = body.split(f'\r\n--{boundary.group(1)}')
+
+    assert parts[0] == '', 'preamble'
+    assert parts[-1] == '--\r\n', 'closing boundary'
+
+    result = []
+
+    for part in parts[1:-1]:
+        head, content = part.split('\r\n\r\n', 1)
+        fields = dict(
+            line.split(': ', 1) for line in head.split('\r\n') if line
+        )
+        result.append((fields, content))
+
+    return result
+
+
+def test_static_range():
+    resp = client.get(url='/file.txt')
+    assert resp['status'] == 200, 'no range'
+    assert resp['headers']['Accept-Ranges'] == 'bytes', 'accept ranges'
+    assert 'Content-Range' not in resp['headers'], 'no content range'
+
+    resp = get_range('bytes=0-9')
+    assert resp['status'] == 206, 'status'
+    assert resp['body'] == data[:10], 'body'
+    assert resp['headers']['Content-Length'] == '10', 'content length'
+    assert resp['headers']['Content-Range'] == f'bytes 0-9/{len(data)}'
+    assert resp['headers']['Content-Type'] == 'text/plain', 'content type'
+
+    assert get_range('bytes=10-')['body'] == data[10:], 'open end'
+    assert get_range('bytes=-5')['body'] == data[-5:], 'suffix'
+    assert get_range('bytes=-100')['body'] == data, 'suffix large'
+    assert get_range('bytes=30-100')['body'] == data[30:], 'end large'
+    assert get_range('bytes = 1-1')['status'] == 200, 'space before equals'
+    assert get_range('BYTES=1-1')['body'] == data[1], 'case'
+
+    resp = get_range('bytes=100-, 5-6')
+    assert resp['status'] == 206, 'unsatisfiable skipped'
+    assert resp['headers']['Content-Range'] == f'bytes 5-6/{len(data)}'
+    assert resp['body'] == data[5:7], 'unsatisfiable skipped body'
+
+
+def test_static_range_not_satisfiable():
+    resp = get_range(f'bytes={len(data)}-')
+    assert resp['status'] == 416, 'status'
+    assert resp['headers']['Content-Range'] == f'bytes */{len(data)}'
+    assert resp['headers']['Content-Length'] == '0', 'content length'
+    assert 'Content-Type' not in resp['headers'], 'content type'
+    assert resp['body'] == '', 'body'
+
+    assert get_range('bytes=100-200, 50-')['status'] == 416, 'several'
+    assert get_range('bytes=-0')['status'] == 416, 'zero suffix'
+
+
+def test_static_range_invalid():
+    for value in [
+        'bytes=',
+        'bytes=-',
+        'bytes=5-1',
+        'bytes=a-b',
+        'bytes=1-2;',
+        'items=1-2',
+        'bytes=1-2 3-4',
+        'bytes=99999999999999999999-',
+        'bytes=' + ','.join(['0-0'] * 17),
+    ]:
+        resp = get_range(value)
+        assert resp['status'] == 200, value
+        assert resp['body'] == data, value
+
+
+def test_static_range_multipart():
+    resp = get_range('bytes=0-1, 5-9,-3')
+    assert resp['status'] == 206, 'status'
+    assert 'Content-Range' not in resp['headers'], 'no content range'
+    assert int(resp['headers']['Content-Length']) == len(resp['body'])
+
+    parts = parse_multipart(resp)
+
+    assert [p[1] for p in parts] == [data[0:2], data[5:10], data[-3:]]
+    assert [p[0]['Content-Range'] for p in parts] == [
+        f'bytes 0-1/{len(data)}',
+        f'bytes 5-9/{len(data)}',
+        f'bytes 33-35/{len(data)}',
+    ], 'part content range'
+    assert all(
+        p[0]['Content-Type'] == 'text/plain' for p in parts
+    ), 'part content type'
+
+    resp = get_range('bytes=0-0,0-0', url='/index.html')
+    assert [p[1] for p in parse_multipart(resp)] == ['0', '0'], 'same range'
+
+
+def test_static_range_if_range():
+    resp = client.get(url='/file.txt')
+    etag = resp['headers']['ETag']
+    last_modified = resp['headers']['Last-Modified']
+
+    resp = get_range('bytes=1-2', headers={'If-Range': etag})
+    assert resp['status'] == 206, 'etag'
+    assert resp['body'] == data[1:3], 'etag body'
+
+    resp = get_range('bytes=1-2', headers={'If-Range': last_modified})
+    assert resp['status'] == 206, 'date'
+
+    resp = get_range('bytes=1-2', headers={'If-Range': '"other"'})
+    assert resp['status'] == 200, 'etag mismatch'
+    assert resp['body'] == data, 'etag mismatch body'
+
+    resp = get_range('bytes=1-2', headers={'If-Range': f'W/{etag}'})
+    assert resp['status'] == 200, 'weak etag'
+
+    resp = get_range(
+        'bytes=1-2', headers={'If-Range': 'Thu, 01 Jan 1970 00:00:00 GMT'}
+    )
+    assert resp['status'] == 200, 'date mismatch'
+
+
+def test_static_range_head():
+    resp = client.head(
+        url='/file.txt',
+        headers={
+            'Host': 'localhost',
+            'Range': 'bytes=0-1',
+            'Connection': 'close',
+        },
+    )
+    assert resp['status'] == 200, 'head'
+    assert resp['headers']['Content-Length'] == str(len(data))
+
+
+def test_static_range_keepalive():
+    (resp, sock) = client.get(
+        url='/file.txt',
+        headers={
+            'Host': 'localhost',
+            'Range': 'bytes=0-1,3-4',
+            'Connection': 'keep-alive',
+        },
+        start=True,
+        read_timeout=1,
+    )
+    assert [p[1] for p in parse_multipart(resp)] == ['01', '34']
+
+    resp = client.get(url='/index.html', sock=sock)
+    assert resp['body'] == '0123456789', 'keepalive'
+
+
+def test_static_range_large(temp_dir):
+    large = ''.join(f'{i:08x}' for i in range(128 * 1024))
+    Path(f'{temp_dir}/assets/large').write_text(large, encoding='utf-8')
+
+    resp = get_range('bytes=100000-400000,-300000', url='/large')
+    assert resp['status'] == 206, 'status'
+    assert [p[1] for p in parse_multipart(resp)] == [
+        large[100000:400001],
+        large[-300000:],
+    ], 'large ranges'
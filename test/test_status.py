@@ -146,6 +146,36 @@ def test_status_connections():
     check_connections(3, 0, 0, 3)
 
 
+def test_status_threads():
+    assert 'success' in client.conf(
+        {
+            "listeners": {"*:8080": {"pass": "routes", "accept_batch": 1}},
+            "routes": [{"action": {"return": 200}}],
+            "applications": {},
+        },
+    )
+
+    Status.init()
+
+    socks = [client.get(no_recv=True) for _ in range(10)]
+
+    for sock in socks:
+        assert client.recvall(sock).decode().startswith('HTTP/1.1 200')
+        sock.close()
+
+    threads = Status.get('/threads')
+
+    assert sum(thread['accepted'] for thread in threads) == 10, 'accepted'
+    assert Status.get('/connections/accepted') == 10, 'connections'
+
+    for thread in threads:
+        assert thread['accept_events'] >= thread['accepted'], 'batch'
+        assert (
+            thread['accept_latency']['total'] >= 0
+            and thread['accept_latency']['max'] >= 0
+        ), 'latency'
+
+
 def test_status_applications():
     def check_applications(expert):
         apps = list(client.conf_get('/status/applications').keys()).sort()
@@ -1,4 +1,6 @@
 import io
+import re
+import socket
 import ssl
 import subprocess
 import time
@@ -701,3 +703,124 @@ def test_tls_multi_listener():
     assert client.get_ssl()['status'] == 200, 'listener #1'
 
     assert client.get_ssl(port=8081)['status'] == 200, 'listener #2'
+
+
+def test_tls_static_large_file(temp_dir):
+    client.certificate()
+
+    data = ''.join(f'{i:08x}' for i in range(512 * 1024))
+    Path(f'{temp_dir}/large').write_text(data, encoding='utf-8')
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {
+                    "pass": "routes",
+                    "tls": {"certificate": "default"},
+                }
+            },
+            "routes": [{"action": {"share": f'{temp_dir}$uri'}}],
+            "applications": {},
+        }
+    )
+
+    assert (
+        client.get_ssl(url='/large', read_buffer_size=1024 * 1024)['body']
+        == data
+    ), 'large file content'
+
+    resp = client.get_ssl(
+        url='/large',
+        headers={
+            'Host': 'localhost',
+            'Range': 'bytes=1000-2000,200000-',
+            'Connection': 'close',
+        },
+        read_buffer_size=1024 * 1024,
+    )
+
+    boundary = resp['headers']['Content-Type'].split('boundary=')[1]
+
+    assert resp['status'] == 206, 'range status'
+    assert data[1000:2001] in resp['body'], 'first range'
+    assert resp['body'].endswith(
+        f'{data[200000:]}\r\n--{boundary}--\r\n'
+    ), 'second range'
+    assert int(resp['headers']['Content-Length']) == len(resp['body'])
+
+
+def test_tls_handshake_offload(unit_pid):
+    client.load('empty')
+    client.certificate()
+
+    # The same ticket key allows to resume a session on another listener.
+
+    ticket = 'U1oDTh11mMxODuw12gS0EXX1E/PkZG13cJNQ6m5+6BGlfPTjNlIEw7PSVU3X1gTE'
+
+    tls = {
+        "certificate": "default",
+        "session": {"cache_size": 0, "tickets": ticket},
+    }
+
+    assert 'success' in client.conf(
+        {
+            "*:8080": {
+                "pass": "applications/empty",
+                "tls": {**tls, "handshake_offload": True},
+            },
+            "*:8081": {"pass": "applications/empty", "tls": tls},
+        },
+        'listeners',
+    )
+
+    def router_threads():
+        output = subprocess.check_output(['ps', 'ax', '-O', 'ppid']).decode()
+        pid = re.search(fr'\s*(\d+)\s*{unit_pid}.*unit: router', output)
+        return len(list(Path(f'/proc/{pid.group(1)}/task').iterdir()))
+
+    context = ssl.create_default_context()
+    context.check_hostname = False
+    context.verify_mode = ssl.CERT_NONE
+    context.maximum_version = ssl.TLSVersion.TLSv1_2
+
+    def handshake(port, session=None):
+        with context.wrap_socket(
+            socket.create_connection(('127.0.0.1', port)), session=session
+        ) as sock:
+            return (sock.session, sock.session_reused)
+
+    threads = router_threads()
+
+    session, _ = handshake(8081)
+    assert router_threads() == threads, 'not offloaded'
+
+    _, reused = handshake(8080, session)
+    assert reused, 'resumed'
+    assert router_threads() == threads, 'resumed not offloaded'
+
+    assert client.get_ssl()['status'] == 200, 'offloaded'
+    assert router_threads() > threads, 'offload thread'
+
+    # Connections closed during the offloaded handshake.
+
+    socks = []
+
+    for _ in range(10):
+        sock = client._default_context.wrap_socket(
+            socket.create_connection(('127.0.0.1', 8080)),
+            do_handshake_on_connect=False,
+        )
+        sock.setblocking(False)
+
+        try:
+            sock.do_handshake()
+        except ssl.SSLWantReadError:
+            pass
+
+        socks.append(sock)
+
+    for sock in socks:
+        sock.close()
+
+    for _ in range(10):
+        assert client.get_ssl()['status'] == 200, 'offloaded again'
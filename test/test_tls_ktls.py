@@ -0,0 +1,86 @@
+from pathlib import Path
+
+import pytest
+
+from unit.applications.tls import ApplicationTLS
+
+prerequisites = {'modules': {'openssl': 'any'}}
+
+client = ApplicationTLS()
+
+data = ''.join(f'{i:08x}' for i in range(256 * 1024))
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture(temp_dir):
+    client.certificate()
+
+    assets_dir = f'{temp_dir}/assets'
+
+    Path(assets_dir).mkdir(parents=True)
+    Path(f'{assets_dir}/index.html').write_text('0123456789', encoding='utf-8')
+    Path(f'{assets_dir}/large').write_text(data, encoding='utf-8')
+
+    if 'success' not in client.conf(
+        {
+            "listeners": {
+                "*:8080": {
+                    "pass": "routes",
+                    "tls": {"certificate": "default", "ktls": True},
+                }
+            },
+            "routes": [{"action": {"share": f'{assets_dir}$uri'}}],
+            "applications": {},
+        }
+    ):
+        pytest.skip('kTLS is not supported')
+
+
+def test_tls_ktls():
+    assert client.get_ssl(url='/index.html')['body'] == '0123456789', 'small'
+
+    assert (
+        client.get_ssl(url='/large', read_buffer_size=1024 * 1024)['body']
+        == data
+    ), 'large file content'
+
+
+def test_tls_ktls_range():
+    resp = client.get_ssl(
+        url='/large',
+        headers={
+            'Host': 'localhost',
+            'Range': 'bytes=100000-400000',
+            'Connection': 'close',
+        },
+        read_buffer_size=1024 * 1024,
+    )
+    assert resp['status'] == 206, 'status'
+    assert resp['body'] == data[100000:400001], 'range'
+
+
+def test_tls_ktls_keepalive():
+    (resp, sock) = client.get_ssl(
+        url='/large',
+        headers={'Host': 'localhost', 'Connection': 'keep-alive'},
+        start=True,
+        read_timeout=1,
+        read_buffer_size=1024 * 1024,
+    )
+    assert resp['body'] == data, 'first'
+
+    resp = client.get_ssl(url='/index.html', sock=sock)
+    assert resp['body'] == '0123456789', 'keepalive'
+
+
+def test_tls_ktls_disabled():
+    assert 'success' in client.conf('false', 'listeners/*:8080/tls/ktls')
+
+    assert (
+        client.get_ssl(url='/large', read_buffer_size=1024 * 1024)['body']
+        == data
+    ), 'disabled'
+
+
+def test_tls_ktls_invalid():
+    assert 'error' in client.conf('"on"', 'listeners/*:8080/tls/ktls')
@@ -0,0 +1,262 @@
+import os
+import time
+
+import pytest
+
+from unit.applications.lang.python import ApplicationPython
+
+prerequisites = {'modules': {'python': 'any'}}
+
+client = ApplicationPython()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {"pass": "upstreams/one"},
+                "*:8081": {"pass": "routes/one"},
+                "*:8082": {"pass": "routes/two"},
+                "*:8083": {"pass": "routes/three"},
+            },
+            "upstreams": {
+                "one": {
+                    "servers": {
+                        "127.0.0.1:8081": {},
+                        "127.0.0.1:8082": {},
+                    },
+                },
+            },
+            "routes": {
+                "one": [{"action": {"return": 200}}],
+                "two": [{"action": {"return": 201}}],
+                "three": [{"action": {"return": 202}}],
+            },
+            "applications": {},
+        },
+    ), 'upstreams initial configuration'
+
+
+def get_hash_statuses(keys):
+    return [
+        client.get(
+            headers={'Host': 'localhost', 'X-Key': key, 'Connection': 'close'}
+        )['status']
+        for key in keys
+    ]
+
+
+def test_upstreams_balancing_least_connections():
+    client.load('delayed', processes=2)
+
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {"pass": "upstreams/one"},
+                "*:8081": {"pass": "routes/one"},
+                "*:8082": {"pass": "routes/two"},
+            },
+            "upstreams": {
+                "one": {
+                    "servers": {
+                        "127.0.0.1:8081": {},
+                        "127.0.0.1:8082": {},
+                    },
+                    "balancing": "least_connections",
+                },
+            },
+            "routes": {
+                "one": [
+                    {
+                        "action": {
+                            "pass": "applications/delayed",
+                            "response_headers": {"X-Server": "one"},
+                        }
+                    }
+                ],
+                "two": [
+                    {
+                        "action": {
+                            "pass": "applications/delayed",
+                            "response_headers": {"X-Server": "two"},
+                        }
+                    }
+                ],
+            },
+            "applications": client.conf_get('applications'),
+        },
+    ), 'least connections'
+
+    sock = client.post(
+        headers={
+            'Host': 'localhost',
+            'X-Parts': '3',
+            'X-Delay': '1',
+            'Connection': 'close',
+        },
+        body='012',
+        no_recv=True,
+    )
+
+    time.sleep(0.5)
+
+    servers = set()
+
+    for _ in range(10):
+        resp = client.get()
+        assert resp['status'] == 200, 'status'
+        servers.add(resp['headers']['X-Server'])
+
+    assert len(servers) == 1, 'least connections idle server'
+
+    resp = client.recvall(sock).decode()
+    sock.close()
+
+    assert f'X-Server: {servers.pop()}' not in resp, 'busy server'
+
+    servers = set()
+
+    for _ in range(10):
+        servers.add(client.get()['headers']['X-Server'])
+
+    assert len(servers) == 2, 'least connections all idle'
+
+
+def test_upstreams_balancing_least_connections_weight():
+    assert 'success' in client.conf(
+        {
+            "servers": {
+                "127.0.0.1:8081": {"weight": 3},
+                "127.0.0.1:8082": {"weight": 0},
+                "127.0.0.1:8083": {},
+            },
+            "balancing": "least_connections",
+        },
+        'upstreams/one',
+    ), 'least connections weight'
+
+    statuses = [client.get()['status'] for _ in range(40)]
+
+    assert 201 not in statuses, 'zero weight'
+    assert abs(statuses.count(200) - 30) <= os.cpu_count(), 'weight'
+
+
+def test_upstreams_balancing_hash():
+    assert 'success' in client.conf(
+        '"$header_x_key"', 'upstreams/one/hash'
+    ), 'hash'
+
+    keys = [f'key{i}' for i in range(50)]
+
+    statuses = get_hash_statuses(keys)
+
+    assert 200 in statuses, 'hash first server'
+    assert 201 in statuses, 'hash second server'
+
+    assert get_hash_statuses(keys) == statuses, 'hash consistent'
+
+    assert 'success' in client.conf(
+        {}, 'upstreams/one/servers/127.0.0.1:8083'
+    ), 'hash server add'
+
+    new = get_hash_statuses(keys)
+
+    assert 202 in new, 'hash new server'
+    assert all(
+        new[i] in (statuses[i], 202) for i in range(len(keys))
+    ), 'hash remap only to new server'
+
+    assert 'success' in client.conf_delete(
+        'upstreams/one/servers/127.0.0.1:8083'
+    ), 'hash server remove'
+
+    assert get_hash_statuses(keys) == statuses, 'hash restored'
+
+
+def test_upstreams_balancing_hash_weight():
+    assert 'success' in client.conf(
+        {
+            "servers": {
+                "127.0.0.1:8081": {"weight": 0},
+                "127.0.0.1:8082": {},
+            },
+            "balancing": "hash",
+            "hash": "$header_x_key",
+        },
+        'upstreams/one',
+    ), 'hash weight'
+
+    statuses = get_hash_statuses([f'key{i}' for i in range(20)])
+
+    assert statuses == [201] * 20, 'hash zero weight'
+
+
+def test_upstreams_balancing_hash_weight_remap():
+    assert 'success' in client.conf(
+        {
+            "servers": {
+                "127.0.0.1:8081": {"weight": 3},
+                "127.0.0.1:8082": {"weight": 0.5},
+            },
+            "balancing": "hash",
+            "hash": "$header_x_key",
+        },
+        'upstreams/one',
+    ), 'hash mixed weights'
+
+    keys = [f'key{i}' for i in range(100)]
+
+    statuses = get_hash_statuses(keys)
+
+    assert 'success' in client.conf(
+        {"weight": 4}, 'upstreams/one/servers/127.0.0.1:8083'
+    ), 'hash weighted server add'
+
+    new = get_hash_statuses(keys)
+
+    assert 202 in new, 'hash weighted new server'
+    assert all(
+        new[i] in (statuses[i], 202) for i in range(len(keys))
+    ), 'hash weighted remap only to new server'
+
+    assert 'success' in client.conf_delete(
+        'upstreams/one/servers/127.0.0.1:8082'
+    ), 'hash weighted server remove'
+
+    assert all(
+        status == new[i]
+        for i, status in enumerate(get_hash_statuses(keys))
+        if new[i] != 201
+    ), 'hash weighted remap only from removed server'
+
+
+def test_upstreams_balancing_hash_empty_key():
+    assert 'success' in client.conf(
+        '"$header_x_key"', 'upstreams/one/hash'
+    ), 'hash'
+
+    statuses = [client.get()['status'] for _ in range(10)]
+
+    assert len(set(statuses)) == 1, 'hash empty key'
+
+
+def test_upstreams_balancing_invalid():
+    assert 'error' in client.conf(
+        '"random"', 'upstreams/one/balancing'
+    ), 'invalid balancing'
+    assert 'error' in client.conf(
+        '"hash"', 'upstreams/one/balancing'
+    ), 'hash balancing without key'
+    assert 'error' in client.conf(
+        {
+            "servers": {"127.0.0.1:8081": {}},
+            "balancing": "least_connections",
+            "hash": "$remote_addr",
+        },
+        'upstreams/one',
+    ), 'hash with least connections'
+    assert 'error' in client.conf(
+        '"$unknown"', 'upstreams/one/hash'
+    ), 'hash unknown variable'
+    assert 'error' in client.conf('1', 'upstreams/one/hash'), 'hash number'
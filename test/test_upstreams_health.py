@@ -0,0 +1,159 @@
+import time
+
+import pytest
+
+from unit.control import Control
+
+client = Control()
+
+
+@pytest.fixture(autouse=True)
+def setup_method_fixture():
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {"pass": "upstreams/one"},
+                "*:8081": {"pass": "routes/one"},
+                "*:8082": {"pass": "routes/two"},
+            },
+            "upstreams": {
+                "one": {
+                    "servers": {
+                        "127.0.0.1:8081": {},
+                        "127.0.0.1:8082": {},
+                        "127.0.0.1:8084": {},
+                    },
+                },
+            },
+            "routes": {
+                "one": [{"action": {"return": 200}}],
+                "two": [{"action": {"return": 201}}],
+            },
+            "applications": {},
+        },
+    ), 'upstreams initial configuration'
+
+
+def server_status(server='127.0.0.1:8084'):
+    return client.conf_get('/status/upstreams/one/servers')[server]
+
+
+def get_statuses(n):
+    return [
+        client.get(headers={'Host': 'localhost', 'Connection': 'close'})[
+            'status'
+        ]
+        for _ in range(n)
+    ]
+
+
+def test_upstreams_health_passive():
+    assert 'success' in client.conf(
+        {"max_fails": 1, "fail_timeout": 30},
+        'upstreams/one/servers/127.0.0.1:8084',
+    ), 'max_fails'
+
+    statuses = get_statuses(12)
+
+    assert statuses.count(502) == 1, 'single failure'
+    assert statuses[-9:].count(502) == 0, 'failed server skipped'
+
+    status = server_status()
+    assert status['state'] == 'down', 'down state'
+    assert status['fails'] == 1, 'fails'
+
+    assert server_status('127.0.0.1:8081') == {
+        'state': 'up',
+        'fails': 0,
+    }, 'live server'
+
+
+def test_upstreams_health_passive_recover():
+    assert 'success' in client.conf(
+        {"max_fails": 1, "fail_timeout": 1},
+        'upstreams/one/servers/127.0.0.1:8084',
+    ), 'max_fails'
+
+    assert 502 in get_statuses(3), 'failure'
+    assert server_status()['state'] == 'down', 'down state'
+
+    assert 'success' in client.conf(
+        {"pass": "routes/one"}, 'listeners/*:8084'
+    ), 'server revived'
+
+    time.sleep(1.1)
+
+    assert 502 not in get_statuses(9), 'retry after fail timeout'
+    assert server_status() == {'state': 'up', 'fails': 0}, 'up state'
+
+
+def test_upstreams_health_active():
+    assert 'success' in client.conf(
+        {"uri": "/health", "interval": 1, "timeout": 1},
+        'upstreams/one/health_check',
+    ), 'health check'
+
+    time.sleep(1)
+
+    assert server_status()['state'] == 'unhealthy', 'unhealthy state'
+    assert 502 not in get_statuses(9), 'unhealthy server skipped'
+
+    assert 'success' in client.conf(
+        {"pass": "routes/one"}, 'listeners/*:8084'
+    ), 'server revived'
+
+    for _ in range(30):
+        if server_status()['state'] == 'up':
+            break
+
+        time.sleep(0.2)
+
+    assert server_status()['state'] == 'up', 'healthy again'
+    assert 502 not in get_statuses(9), 'healthy server'
+
+
+def test_upstreams_health_active_status():
+    assert 'success' in client.conf(
+        {
+            "listeners": {
+                "*:8080": {"pass": "upstreams/one"},
+                "*:8081": {"pass": "routes/one"},
+                "*:8082": {"pass": "routes/two"},
+            },
+            "upstreams": {
+                "one": {
+                    "servers": {
+                        "127.0.0.1:8081": {},
+                        "127.0.0.1:8082": {},
+                    },
+                    "health_check": {"interval": 1, "passes": 2},
+                },
+            },
+            "routes": {
+                "one": [{"action": {"return": 200}}],
+                "two": [{"action": {"return": 503}}],
+            },
+        },
+    ), 'health check status'
+
+    time.sleep(1)
+
+    assert server_status('127.0.0.1:8082')['state'] == 'unhealthy', '5xx'
+    assert server_status('127.0.0.1:8081')['state'] == 'up', '2xx'
+    assert get_statuses(6) == [200] * 6, 'only healthy server'
+
+
+def test_upstreams_health_invalid():
+    def check_error(conf, path):
+        assert 'error' in client.conf(conf, f'upstreams/one/{path}')
+
+    check_error('-1', 'servers/127.0.0.1:8081/max_fails')
+    check_error('"1"', 'servers/127.0.0.1:8081/max_fails')
+    check_error('0', 'servers/127.0.0.1:8081/fail_timeout')
+    check_error('{"uri": "health"}', 'health_check')
+    check_error('{"uri": "/a b"}', 'health_check')
+    check_error('{"interval": 0}', 'health_check')
+    check_error('{"timeout": -1}', 'health_check')
+    check_error('{"passes": 0}', 'health_check')
+    check_error('{"fails": 1.5}', 'health_check')
+    check_error('{"unknown": 1}', 'health_check')
@@ -45,6 +45,36 @@ def test_usr1_access_log(search_in_file, temp_dir, unit_pid, wait_for_record):
     assert search_in_file(r'/usr1', log_new) is None, 'rename new 2'
 
 
+def test_usr1_access_log_buffer(
+    search_in_file, temp_dir, unit_pid, wait_for_record
+):
+    client.load('empty')
+
+    log = 'access.log'
+    log_new = 'new.log'
+    log_path = f'{temp_dir}/{log}'
+
+    assert 'success' in client.conf(
+        {'path': log_path, 'format': '$uri', 'buffer': 4096, 'flush': 0},
+        'access_log',
+    ), 'access log configure'
+
+    assert waitforfiles(log_path), 'open'
+
+    assert client.get(url='/buffered')['status'] == 200
+
+    Path(log_path).rename(f'{temp_dir}/{log_new}')
+
+    assert search_in_file(r'/buffered', log_new) is None, 'buffered'
+
+    os.kill(unit_pid, signal.SIGUSR1)
+
+    assert waitforfiles(log_path), 'reopen'
+
+    assert wait_for_record(r'^/buffered$', log_new) is not None, 'flushed'
+    assert search_in_file(r'/buffered', log) is None, 'flushed old'
+
+
 def test_usr1_unit_log(search_in_file, temp_dir, unit_pid, wait_for_record):
     client.load('log_body')
 
@@ -47,6 +47,7 @@ class ApplicationPython(ApplicationProto):
             'home',
             'limits',
             'path',
+            'preload',
             'protocol',
             'targets',
             'threads',
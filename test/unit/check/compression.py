@@ -0,0 +1,5 @@
+import re
+
+
+def check_zlib(output_version):
+    return re.search('--zlib', output_version)
@@ -2,11 +2,13 @@ import subprocess
 import sys
 
 from unit.check.chroot import check_chroot
+from unit.check.compression import check_zlib
 from unit.check.go import check_go
 from unit.check.isolation import check_isolation
 from unit.check.njs import check_njs
 from unit.check.node import check_node
 from unit.check.regex import check_regex
+from unit.check.reuseport import check_reuseport
 from unit.check.tls import check_openssl
 from unit.check.unix_abstract import check_unix_abstract
 from unit.log import Log
@@ -40,10 +42,12 @@ def discover_available(unit):
     option.available['modules']['node'] = check_node()
     option.available['modules']['openssl'] = check_openssl(output_version)
     option.available['modules']['regex'] = check_regex(output_version)
+    option.available['modules']['zlib'] = check_zlib(output_version)
 
     # Discover features using check. Features should be discovered after
     # modules since some features can require modules.
 
     option.available['features']['chroot'] = check_chroot()
     option.available['features']['isolation'] = check_isolation()
+    option.available['features']['reuseport'] = check_reuseport()
     option.available['features']['unix_abstract'] = check_unix_abstract()
@@ -0,0 +1,25 @@
+import json
+
+from unit.http import HTTP1
+from unit.option import option
+
+http = HTTP1()
+
+
+def check_reuseport():
+    return (
+        'success'
+        in http.put(
+            url='/config',
+            sock_type='unix',
+            addr=f'{option.temp_dir}/control.unit.sock',
+            body=json.dumps(
+                {
+                    "listeners": {
+                        "*:8080": {"pass": "routes", "reuseport": True}
+                    },
+                    "routes": [],
+                }
+            ),
+        )['body']
+    )
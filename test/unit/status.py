@@ -6,7 +6,10 @@ class Status:
     control = Control()
 
     def _check_zeros():
-        assert Status.control.conf_get('/status') == {
+        status = Status.control.conf_get('/status')
+        threads = status.pop('threads')
+
+        assert status == {
             'connections': {
                 'accepted': 0,
                 'active': 0,
@@ -17,6 +20,13 @@ class Status:
             'applications': {},
         }
 
+        for thread in threads:
+            assert thread == {
+                'accepted': 0,
+                'accept_events': 0,
+                'accept_latency': {'total': 0, 'max': 0},
+            }
+
     def init(status=None):
         Status._status = (
             status if status is not None else Status.control.conf_get('/status')
@@ -31,6 +41,12 @@ class Status:
                     if k in d2
                 }
 
+            if isinstance(d1, list) and isinstance(d2, list):
+                return [find_diffs(v1, v2) for v1, v2 in zip(d1, d2)]
+
+            if isinstance(d1, str):
+                return d1
+
             return d1 - d2
 
         return find_diffs(Status.control.conf_get('/status'), Status._status)